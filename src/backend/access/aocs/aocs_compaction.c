@@ -28,9 +28,11 @@
 #include "catalog/pg_appendonly.h"
 #include "cdb/cdbaocsam.h"
 #include "cdb/cdbvars.h"
+#include "commands/progress.h"
 #include "commands/vacuum.h"
 #include "executor/executor.h"
 #include "nodes/execnodes.h"
+#include "pgstat.h"
 #include "storage/lmgr.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
@@ -224,15 +226,31 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 	AOTupleId  *aoTupleId;
 	int64		tupleCount = 0;
 	int64		tuplePerPage = INT_MAX;
+	int64		segeof = 0;
+	int64		bytesPerPage = 0;
+	int64		movedSinceLastPage = 0;
+	int64		segpages;
+	AppendOnlyCompactionIO io = {0};
+	int			i;
 
 	Assert(Gp_role == GP_ROLE_EXECUTE || Gp_role == GP_ROLE_UTILITY);
 	Assert(RelationIsAoCols(aorel));
 	Assert(insertDesc);
 
 	compact_segno = fsinfo->segno;
-	if (fsinfo->varblockcount > 0)
+	for (i = 0; i < fsinfo->vpinfo.nEntry; i++)
+		segeof += fsinfo->vpinfo.entry[i].eof;
+
+	/*
+	 * Column segment files don't track a varblock count, each column being
+	 * split into varblocks of its own.  Account the I/O in BLCKSZ pages of
+	 * the column files instead.
+	 */
+	segpages = segeof / BLCKSZ;
+	if (segpages > 0 && fsinfo->total_tupcount > 0)
 	{
-		tuplePerPage = fsinfo->total_tupcount / fsinfo->varblockcount;
+		tuplePerPage = Max(fsinfo->total_tupcount / segpages, 1);
+		bytesPerPage = segeof / segpages;
 	}
 	relname = RelationGetRelationName(aorel);
 
@@ -282,6 +300,7 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 						  resultRelInfo,
 						  estate);
 			movedTupleCount++;
+			movedSinceLastPage++;
 		}
 		else
 		{
@@ -290,16 +309,21 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 		}
 
 		/*
-		 * Check for vacuum delay point after approximatly a var block
+		 * Account for the I/O, and check for vacuum delay point, after
+		 * approximatly a var block.
 		 */
 		tupleCount++;
-		if (VacuumCostActive && tupleCount % tuplePerPage == 0)
+		if (tupleCount % tuplePerPage == 0)
 		{
-			vacuum_delay_point();
+			AppendOnlyCompaction_AccountIO(&io, bytesPerPage,
+										   bytesPerPage * movedSinceLastPage / tuplePerPage);
+			movedSinceLastPage = 0;
 		}
 	}
 
 	MarkAOCSFileSegInfoAwaitingDrop(aorel, compact_segno);
+	pgstat_progress_incr_param(PROGRESS_VACUUM_HEAP_BLKS_VACUUMED,
+							   segeof / BLCKSZ);
 
 	AppendOnlyVisimap_DeleteSegmentFile(&visiMap,
 										compact_segno);
@@ -55,6 +55,7 @@ static AOCSScanDesc aocs_beginscan_internal(Relation relation,
 						Snapshot snapshot,
 						Snapshot appendOnlyMetaDataSnapshot,
 						bool *proj,
+						ParallelTableScanDesc pscan,
 						uint32 flags);
 
 /*
@@ -328,10 +329,34 @@ aocs_initscan(AOCSScanDesc scan)
 	pgstat_count_heap_scan(scan->rs_base.rs_rd);
 }
 
+/*
+ * Advances cur_seg to the next segment file to scan.
+ *
+ * In a parallel scan, the segment files are handed out to the participants
+ * from the shared counter, so that each one is scanned by exactly one of them.
+ */
+static bool
+advance_cur_scan_seg(AOCSScanDesc scan)
+{
+	if (scan->rs_base.rs_parallel != NULL)
+	{
+		ParallelAppendOnlyScanDesc pscan =
+			(ParallelAppendOnlyScanDesc) scan->rs_base.rs_parallel;
+
+		scan->cur_seg = (int32) pg_atomic_fetch_add_u32(&pscan->next_segfile, 1);
+		if (scan->cur_seg >= scan->total_seg)
+			scan->cur_seg = scan->total_seg;
+	}
+	else
+		++scan->cur_seg;
+
+	return scan->cur_seg < scan->total_seg;
+}
+
 static int
 open_next_scan_seg(AOCSScanDesc scan)
 {
-	while (++scan->cur_seg < scan->total_seg)
+	while (advance_cur_scan_seg(scan))
 	{
 		AOCSFileSegInfo *curSegInfo = scan->seginfo[scan->cur_seg];
 
@@ -480,12 +505,14 @@ aocs_beginrangescan(Relation relation,
 								   snapshot,
 								   appendOnlyMetaDataSnapshot,
 								   NULL,
+								   NULL,
 								   0);
 }
 
 AOCSScanDesc
 aocs_beginscan(Relation relation,
 			   Snapshot snapshot,
+			   ParallelTableScanDesc pscan,
 			   bool *proj,
 			   uint32 flags)
 {
@@ -498,9 +525,15 @@ aocs_beginscan(Relation relation,
 	/*
 	 * the append-only meta data should never be fetched with
 	 * SnapshotAny as bogus results are returned.
+	 *
+	 * All the participants of a parallel scan must see the same segment
+	 * files. They use the active snapshot, which the leader passes on to
+	 * its workers.
 	 */
 	if (snapshot != SnapshotAny)
 		aocsMetaDataSnapshot = snapshot;
+	else if (pscan != NULL)
+		aocsMetaDataSnapshot = GetActiveSnapshot();
 	else
 		aocsMetaDataSnapshot = GetTransactionSnapshot();
 
@@ -511,9 +544,50 @@ aocs_beginscan(Relation relation,
 								   snapshot,
 								   aocsMetaDataSnapshot,
 								   proj,
+								   pscan,
 								   flags);
 }
 
+/*
+ * Restricts a scan that hasn't returned any tuples yet to the segment files
+ * holding the given range of block numbers, like
+ * appendonly_scan_restrict_blockrange().
+ *
+ * The scan still returns all the tuples of those segment files; the caller
+ * must filter out the ones outside the range.
+ */
+void
+aocs_scan_restrict_blockrange(AOCSScanDesc scan,
+							  BlockNumber start_blockno,
+							  BlockNumber numblocks)
+{
+	int			first_segno;
+	int			last_segno;
+	int			nkept = 0;
+	int			i;
+
+	Assert(scan->cur_seg == -1);
+	Assert(scan->rs_base.rs_parallel == NULL);
+
+	first_segno = start_blockno >> 25;
+	if (numblocks == InvalidBlockNumber ||
+		(uint64) start_blockno + numblocks > MaxBlockNumber)
+		last_segno = AOTupleId_MaxSegmentFileNum;
+	else
+		last_segno = (start_blockno + numblocks - 1) >> 25;
+
+	for (i = 0; i < scan->total_seg; i++)
+	{
+		AOCSFileSegInfo *seginfo = scan->seginfo[i];
+
+		if (seginfo->segno >= first_segno && seginfo->segno <= last_segno)
+			scan->seginfo[nkept++] = seginfo;
+		else
+			pfree(seginfo);
+	}
+	scan->total_seg = nkept;
+}
+
 /*
  * begin the scan over the given relation.
  */
@@ -524,6 +598,7 @@ aocs_beginscan_internal(Relation relation,
 						Snapshot snapshot,
 						Snapshot appendOnlyMetaDataSnapshot,
 						bool *proj,
+						ParallelTableScanDesc pscan,
 						uint32 flags)
 {
 	AOCSScanDesc	scan;
@@ -535,6 +610,7 @@ aocs_beginscan_internal(Relation relation,
 	scan->rs_base.rs_rd = relation;
 	scan->rs_base.rs_snapshot = snapshot;
 	scan->rs_base.rs_flags = flags;
+	scan->rs_base.rs_parallel = pscan;
 	scan->appendOnlyMetaDataSnapshot = appendOnlyMetaDataSnapshot;
 	scan->seginfo = seginfo;
 	scan->total_seg = total_seg;
@@ -994,79 +1070,85 @@ aocs_insert_init(Relation rel, int segno)
 }
 
 
-void
-aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId)
+/*
+ * Append one datum to the datum stream of column 'attno'. 'rowNum' is the
+ * row number of the tuple the datum belongs to.
+ */
+static void
+aocs_insert_datum(AOCSInsertDesc idesc, int attno, Datum datum, bool isnull,
+				  int64 rowNum)
 {
-	Relation	rel = idesc->aoi_rel;
-	int			i;
-
-#ifdef FAULT_INJECTOR
-	FaultInjector_InjectFaultIfSet(
-								   "appendonly_insert",
-								   DDLNotSpecified,
-								   "",	/* databaseName */
-								   RelationGetRelationName(idesc->aoi_rel));	/* tableName */
-#endif
+	DatumStreamWrite *ds = idesc->ds[attno];
+	void	   *toFree1;
+	int			err = datumstreamwrite_put(ds, datum, isnull, &toFree1);
 
-	/* As usual, at this moment, we assume one col per vp */
-	for (i = 0; i < RelationGetNumberOfAttributes(rel); ++i)
+	if (toFree1 != NULL)
+	{
+		/*
+		 * Use the de-toasted and/or de-compressed as datum instead.
+		 */
+		datum = PointerGetDatum(toFree1);
+	}
+	if (err < 0)
 	{
-		void	   *toFree1;
-		Datum		datum = d[i];
-		int			err = datumstreamwrite_put(idesc->ds[i], datum, null[i], &toFree1);
+		int			itemCount = datumstreamwrite_nth(ds);
+		void	   *toFree2;
 
-		if (toFree1 != NULL)
+		/* write the block up to this one */
+		datumstreamwrite_block(ds, &idesc->blockDirectory, attno, false);
+		if (itemCount > 0)
 		{
 			/*
-			 * Use the de-toasted and/or de-compressed as datum instead.
+			 * since we have written all up to the new tuple, the new
+			 * blockFirstRowNum is the inserted tuple's row number
 			 */
-			datum = PointerGetDatum(toFree1);
+			ds->blockFirstRowNum = rowNum;
 		}
-		if (err < 0)
-		{
-			int			itemCount = datumstreamwrite_nth(idesc->ds[i]);
-			void	   *toFree2;
 
-			/* write the block up to this one */
-			datumstreamwrite_block(idesc->ds[i], &idesc->blockDirectory, i, false);
-			if (itemCount > 0)
-			{
-				/*
-				 * since we have written all up to the new tuple, the new
-				 * blockFirstRowNum is the inserted tuple's row number
-				 */
-				idesc->ds[i]->blockFirstRowNum = idesc->lastSequence + 1;
-			}
-
-			Assert(idesc->ds[i]->blockFirstRowNum == idesc->lastSequence + 1);
+		Assert(ds->blockFirstRowNum == rowNum);
 
 
-			/* now write this new item to the new block */
-			err = datumstreamwrite_put(idesc->ds[i], datum, null[i], &toFree2);
-			Assert(toFree2 == NULL);
-			if (err < 0)
-			{
-				Assert(!null[i]);
-				err = datumstreamwrite_lob(idesc->ds[i],
-										   datum,
-										   &idesc->blockDirectory,
-										   i,
-										   false);
-				Assert(err >= 0);
+		/* now write this new item to the new block */
+		err = datumstreamwrite_put(ds, datum, isnull, &toFree2);
+		Assert(toFree2 == NULL);
+		if (err < 0)
+		{
+			Assert(!isnull);
+			err = datumstreamwrite_lob(ds,
+									   datum,
+									   &idesc->blockDirectory,
+									   attno,
+									   false);
+			Assert(err >= 0);
 
-				/*
-				 * A lob will live by itself in the block so this assignment
-				 * is for the block that contains tuples AFTER the one we are
-				 * inserting
-				 */
-				idesc->ds[i]->blockFirstRowNum = idesc->lastSequence + 2;
-			}
+			/*
+			 * A lob will live by itself in the block so this assignment
+			 * is for the block that contains tuples AFTER the one we are
+			 * inserting
+			 */
+			ds->blockFirstRowNum = rowNum + 1;
 		}
-
-		if (toFree1 != NULL)
-			pfree(toFree1);
 	}
 
+	if (toFree1 != NULL)
+		pfree(toFree1);
+}
+
+/*
+ * Assign the row number of the next tuple to insert, and return it in
+ * 'aoTupleId'.
+ */
+static void
+aocs_insert_next_rownum(AOCSInsertDesc idesc, AOTupleId *aoTupleId)
+{
+#ifdef FAULT_INJECTOR
+	FaultInjector_InjectFaultIfSet(
+								   "appendonly_insert",
+								   DDLNotSpecified,
+								   "",	/* databaseName */
+								   RelationGetRelationName(idesc->aoi_rel));	/* tableName */
+#endif
+
 	idesc->insertCount++;
 	idesc->lastSequence++;
 	if (idesc->numSequences > 0)
@@ -1095,6 +1177,60 @@ aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupl
 	}
 }
 
+void
+aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId)
+{
+	Relation	rel = idesc->aoi_rel;
+	int64		rowNum;
+	int			i;
+
+	aocs_insert_next_rownum(idesc, aoTupleId);
+	rowNum = AOTupleIdGet_rowNum(aoTupleId);
+
+	/* As usual, at this moment, we assume one col per vp */
+	for (i = 0; i < RelationGetNumberOfAttributes(rel); ++i)
+		aocs_insert_datum(idesc, i, d[i], null[i], rowNum);
+}
+
+/*
+ * Insert a batch of tuples, e.g. from COPY's multi-insert buffer.
+ *
+ * The result is the same as calling aocs_insert() for each slot in turn, but
+ * the datums are appended one column at a time, so that we stay within one
+ * column's datum stream buffer and compression state for the whole batch,
+ * instead of cycling through the buffers of every column for every tuple.
+ */
+void
+aocs_insert_multi(AOCSInsertDesc idesc, TupleTableSlot **slots, int ntuples)
+{
+	Relation	rel = idesc->aoi_rel;
+	int64		firstRowNum = idesc->lastSequence + 1;
+	int			natts = RelationGetNumberOfAttributes(rel);
+	int			i;
+	int			j;
+
+	/*
+	 * The tuples get consecutive row numbers, starting right after the last
+	 * one inserted. Assign them up front, so that the column loop below knows
+	 * the row number of every datum.
+	 */
+	for (j = 0; j < ntuples; j++)
+	{
+		slot_getallattrs(slots[j]);
+		aocs_insert_next_rownum(idesc, (AOTupleId *) &slots[j]->tts_tid);
+	}
+	Assert(idesc->lastSequence == firstRowNum + ntuples - 1);
+
+	for (i = 0; i < natts; i++)
+	{
+		for (j = 0; j < ntuples; j++)
+			aocs_insert_datum(idesc, i,
+							  slots[j]->tts_values[i],
+							  slots[j]->tts_isnull[i],
+							  firstRowNum + j);
+	}
+}
+
 void
 aocs_insert_finish(AOCSInsertDesc idesc)
 {
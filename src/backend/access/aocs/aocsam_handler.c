@@ -28,6 +28,7 @@
 #include "catalog/storage.h"
 #include "catalog/storage_xlog.h"
 #include "cdb/cdbaocsam.h"
+#include "cdb/cdbappendonlyam.h"
 #include "cdb/cdbvars.h"
 #include "commands/vacuum.h"
 #include "executor/executor.h"
@@ -443,6 +444,7 @@ aoco_beginscan_extractcolumns(Relation rel, Snapshot snapshot,
 
 	aoscan = aocs_beginscan(rel,
 							snapshot,
+							NULL,
 							cols,
 							flags);
 
@@ -516,11 +518,9 @@ aoco_beginscan(Relation relation,
 {
 	AOCSScanDesc	aoscan;
 
-	/* Parallel scan not supported for AO_COLUMN tables */
-	Assert(pscan == NULL);
-
 	aoscan = aocs_beginscan(relation,
 							snapshot,
+							pscan,
 							NULL,
 							flags);
 
@@ -580,22 +580,34 @@ aoco_getnextslot(TableScanDesc scan, ScanDirection direction, TupleTableSlot *sl
 	return false;
 }
 
+/*
+ * The scan is split between the participants by segment file, like for
+ * AO_ROW tables, see ParallelAppendOnlyScanDescData.
+ */
 static Size
 aoco_parallelscan_estimate(Relation rel)
 {
-	elog(ERROR, "parallel SeqScan not implemented for AO_COLUMN tables");
+	return sizeof(ParallelAppendOnlyScanDescData);
 }
 
 static Size
 aoco_parallelscan_initialize(Relation rel, ParallelTableScanDesc pscan)
 {
-	elog(ERROR, "parallel SeqScan not implemented for AO_COLUMN tables");
+	ParallelAppendOnlyScanDesc aopscan = (ParallelAppendOnlyScanDesc) pscan;
+
+	aopscan->base.phs_relid = RelationGetRelid(rel);
+	aopscan->base.phs_syncscan = false;
+	pg_atomic_init_u32(&aopscan->next_segfile, 0);
+
+	return sizeof(ParallelAppendOnlyScanDescData);
 }
 
 static void
 aoco_parallelscan_reinitialize(Relation rel, ParallelTableScanDesc pscan)
 {
-	elog(ERROR, "parallel SeqScan not implemented for AO_COLUMN tables");
+	ParallelAppendOnlyScanDesc aopscan = (ParallelAppendOnlyScanDesc) pscan;
+
+	pg_atomic_write_u32(&aopscan->next_segfile, 0);
 }
 
 static IndexFetchTableData *
@@ -726,18 +738,20 @@ aoco_tuple_complete_speculative(Relation relation, TupleTableSlot *slot,
  *
  * This is like aoco_tuple_insert(), but inserts multiple tuples in one
  * operation. Typicaly used by COPY. This is preferrable than calling
- * aoco_tuple_insert() in a loop because ... WAL??
+ * aoco_tuple_insert() in a loop, because the datums are appended to the
+ * column datum streams one column at a time, see aocs_insert_multi().
  */
 static void
 aoco_multi_insert(Relation relation, TupleTableSlot **slots, int ntuples,
                         CommandId cid, int options, BulkInsertState bistate)
 {
-	/*
-	* GPDB_12_MERGE_FIXME: Poor man's implementation for now in order to make
-		* the tests pass. Implement properly.
-		*/
-	for (int i = 0; i < ntuples; i++)
-		aoco_tuple_insert(relation, slots[i], cid, options, bistate);
+	AOCSInsertDesc          insertDesc;
+
+	insertDesc = get_insert_descriptor(relation);
+
+	aocs_insert_multi(insertDesc, slots, ntuples);
+
+	pgstat_count_heap_insert(relation, ntuples);
 }
 
 static TM_Result
@@ -1162,6 +1176,7 @@ aoco_relation_copy_for_cluster(Relation OldHeap, Relation NewHeap,
 	slot = table_slot_create(OldHeap, NULL);
 
 	scan = aocs_beginscan(OldHeap, GetActiveSnapshot(),
+						  NULL /* pscan */,
 						  NULL /* proj */,
 						  0 /* flags */);
 
@@ -1358,6 +1373,14 @@ aoco_index_build_range_scan(Relation heapRelation,
 		                             NULL,	/* scan key */
 		                             true,	/* buffer access strategy OK */
 		                             allow_sync);	/* syncscan OK? */
+
+		/*
+		 * For a partial scan, e.g. when BRIN summarizes a single range, skip
+		 * the segment files that cannot hold any tuples of the range.
+		 */
+		if (start_blockno != 0 || numblocks != InvalidBlockNumber)
+			aocs_scan_restrict_blockrange((AOCSScanDesc) scan,
+										  start_blockno, numblocks);
 	}
 	else
 	{
@@ -1395,6 +1418,15 @@ aoco_index_build_range_scan(Relation heapRelation,
 	Relation blkdir = relation_open(blkdirrelid, AccessShareLock);
 	if (RelationGetNumberOfBlocks(blkdir) == 0)
 	{
+		/*
+		 * Parallel workers cannot insert into the block directory.
+		 * plan_create_index_workers() doesn't plan a parallel build in this
+		 * case.
+		 */
+		if (aocoscan->rs_base.rs_parallel != NULL)
+			elog(ERROR, "cannot build block directory of append-optimized table \"%s\" in a parallel index build",
+				 RelationGetRelationName(heapRelation));
+
 		/*
 		 * Allocate blockDirectory in scan descriptor to let the access method
 		 * know that it needs to also build the block directory while
@@ -1462,12 +1494,12 @@ aoco_index_build_range_scan(Relation heapRelation,
 		CHECK_FOR_INTERRUPTS();
 
 		/*
-		 * GPDB_12_MERGE_FIXME: How to properly do a partial scan? Currently,
-		 * we scan the whole table, and throw away tuples that are not in the
-		 * range. That's clearly very inefficient.
+		 * In a partial scan, throw away the tuples of the scanned segment
+		 * files that are not in the range.
 		 */
 		if (ItemPointerGetBlockNumber(&slot->tts_tid) < start_blockno ||
-			(numblocks != InvalidBlockNumber && ItemPointerGetBlockNumber(&slot->tts_tid) >= numblocks))
+			(numblocks != InvalidBlockNumber &&
+			 ItemPointerGetBlockNumber(&slot->tts_tid) - start_blockno >= numblocks))
 			continue;
 
 		/* GPDB_12_MERGE_FIXME */
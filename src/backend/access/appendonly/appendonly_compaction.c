@@ -39,13 +39,16 @@
 #include "catalog/pg_appendonly.h"
 #include "cdb/cdbappendonlyam.h"
 #include "cdb/cdbvars.h"
+#include "commands/progress.h"
 #include "commands/vacuum.h"
 #include "executor/executor.h"
 #include "nodes/execnodes.h"
+#include "pgstat.h"
 #include "storage/procarray.h"
 #include "storage/lmgr.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/faultinjector.h"
 #include "utils/relcache.h"
 #include "utils/guc.h"
 #include "utils/snapmgr.h"
@@ -112,6 +115,50 @@ AppendOnlyCompaction_GetHideRatio(int64 hiddenTupcount, int64 totalTupcount)
 	return hideRatio;
 }
 
+/*
+ * Accounts for a chunk of compaction I/O.
+ *
+ * The AO storage layer reads and writes segment files directly, bypassing
+ * the buffer manager, so nothing else charges VacuumCostBalance while a
+ * segment file is being compacted, and vacuum_cost_delay would not throttle
+ * the compaction at all. Charge every BLCKSZ read as a page miss, and every
+ * BLCKSZ written as a dirtied page, and sleep if the cost limit has been
+ * reached. Also advance the heap_blks_scanned counter of
+ * pg_stat_progress_vacuum.
+ */
+void
+AppendOnlyCompaction_AccountIO(AppendOnlyCompactionIO *io,
+							   int64 bytesRead,
+							   int64 bytesWritten)
+{
+	int64		newBlksRead;
+	int64		newBlksWritten;
+
+	io->bytesRead += bytesRead;
+	io->bytesWritten += bytesWritten;
+
+	newBlksRead = io->bytesRead / BLCKSZ - io->blksRead;
+	newBlksWritten = io->bytesWritten / BLCKSZ - io->blksWritten;
+	io->blksRead += newBlksRead;
+	io->blksWritten += newBlksWritten;
+
+	if (newBlksRead > 0)
+		pgstat_progress_incr_param(PROGRESS_VACUUM_HEAP_BLKS_SCANNED,
+								   newBlksRead);
+
+	VacuumPageMiss += newBlksRead;
+	VacuumPageDirty += newBlksWritten;
+
+	if (VacuumCostActive)
+	{
+		VacuumCostBalance += newBlksRead * VacuumCostPageMiss +
+			newBlksWritten * VacuumCostPageDirty;
+		if (VacuumCostBalance >= VacuumCostLimit)
+			SIMPLE_FAULT_INJECTOR("appendonly_compaction_cost_delay");
+		vacuum_delay_point();
+	}
+}
+
 /*
  * Returns true iff the given segment file should be compacted.
  */
@@ -370,6 +417,9 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 	AOTupleId  *aoTupleId;
 	int64		tupleCount = 0;
 	int64		tuplePerPage = INT_MAX;
+	int64		bytesPerPage = 0;
+	int64		movedSinceLastPage = 0;
+	AppendOnlyCompactionIO io = {0};
     Oid         visimaprelid;
     Oid         visimapidxid;
     Oid         blkdirrelid;
@@ -381,7 +431,9 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 	compact_segno = fsinfo->segno;
 	if (fsinfo->varblockcount > 0)
 	{
-		tuplePerPage = fsinfo->total_tupcount / fsinfo->varblockcount;
+		/* a large tuple may span several varblocks */
+		tuplePerPage = Max(fsinfo->total_tupcount / fsinfo->varblockcount, 1);
+		bytesPerPage = fsinfo->eof / fsinfo->varblockcount;
 	}
 	relname = RelationGetRelationName(aorel);
 
@@ -445,6 +497,7 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 								resultRelInfo,
 								estate);
 			movedTupleCount++;
+			movedSinceLastPage++;
 		}
 		else
 		{
@@ -453,16 +506,22 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 		}
 
 		/*
-		 * Check for vacuum delay point after approximately a var block
+		 * Account for the I/O, and check for vacuum delay point, after
+		 * approximately a var block. The amount written is estimated from
+		 * the fraction of the tuples that were moved.
 		 */
 		tupleCount++;
-		if (VacuumCostActive && tupleCount % tuplePerPage == 0)
+		if (tupleCount % tuplePerPage == 0)
 		{
-			vacuum_delay_point();
+			AppendOnlyCompaction_AccountIO(&io, bytesPerPage,
+										   bytesPerPage * movedSinceLastPage / tuplePerPage);
+			movedSinceLastPage = 0;
 		}
 	}
 
 	MarkFileSegInfoAwaitingDrop(aorel, compact_segno);
+	pgstat_progress_incr_param(PROGRESS_VACUUM_HEAP_BLKS_VACUUMED,
+							   fsinfo->eof / BLCKSZ);
 
 	AppendOnlyVisimap_DeleteSegmentFile(&visiMap, compact_segno);
 
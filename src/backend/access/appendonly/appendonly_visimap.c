@@ -216,6 +216,65 @@ AppendOnlyVisimap_IsVisible(
 											aoTupleId);
 }
 
+/*
+ * Checks the visibility of 'nrows' consecutive rows of segment file 'segno',
+ * starting at row number 'firstRowNum', typically all the rows of a block.
+ * On return, visible[i] is true iff row (firstRowNum + i) is visible
+ * according to the visibility map. Returns the number of visible rows.
+ *
+ * This is equivalent to calling AppendOnlyVisimap_IsVisible() for every row,
+ * but each visimap entry covering the range is positioned only once.
+ *
+ * Assumes that the visibility has been initialized and not finished.
+ */
+int
+AppendOnlyVisimap_GetVisibleRows(
+								 AppendOnlyVisimap *visiMap,
+								 int segno,
+								 int64 firstRowNum,
+								 int nrows,
+								 bool *visible)
+{
+	int			nvisible = 0;
+	int			done = 0;
+
+	Assert(visiMap);
+	Assert(visible);
+
+	while (done < nrows)
+	{
+		AOTupleId	aoTupleId;
+		int64		rowNum = firstRowNum + done;
+		int64		entryEnd;
+		int			n;
+
+		AOTupleIdInit(&aoTupleId, segno, rowNum);
+
+		if (!AppendOnlyVisimapEntry_CoversTuple(&visiMap->visimapEntry,
+												&aoTupleId))
+		{
+			/* if necessary persist the current entry before moving. */
+			if (AppendOnlyVisimapEntry_HasChanged(&visiMap->visimapEntry))
+			{
+				AppendOnlyVisimap_Store(visiMap);
+			}
+
+			AppendOnlyVisimap_Find(visiMap, &aoTupleId);
+		}
+
+		/* check the rows up to the end of the range covered by the entry */
+		entryEnd = visiMap->visimapEntry.firstRowNum + APPENDONLY_VISIMAP_MAX_RANGE;
+		n = (int) Min((int64) (nrows - done), entryEnd - rowNum);
+
+		nvisible += AppendOnlyVisimapEntry_GetVisibleRows(&visiMap->visimapEntry,
+														  rowNum, n,
+														  visible + done);
+		done += n;
+	}
+
+	return nvisible;
+}
+
 /*
  * Stores the current visibility map entry information
  * in the relation either as update or delete.
@@ -333,19 +333,6 @@ AppendOnlyVisimapEntry_Write(
 	visiMapEntry->dirty = false;
 }
 
-/*
- * Returns true iff all entries in the visimap entry are visible.
- */
-static bool
-AppendOnlyVisimapEntry_AreAllVisible(
-									 AppendOnlyVisimapEntry *visiMapEntry)
-{
-	Assert(visiMapEntry);
-	Assert(AppendOnlyVisimapEntry_IsValid(visiMapEntry));
-
-	return bms_is_empty(visiMapEntry->bitmap);
-}
-
 /**
  * Helper function to get the rownum offset (from the beginning of the
  * visibility map entry).
@@ -448,7 +435,12 @@ AppendOnlyVisimapEntry_IsVisible(
 		   "firstRowNum " INT64_FORMAT ", rowNum " INT64_FORMAT,
 		   visiMapEntry->firstRowNum, rowNum);
 
-	if (AppendOnlyVisimapEntry_AreAllVisible(visiMapEntry))
+	/*
+	 * Only test for a NULL bitmap here. bms_is_empty() would walk the bitmap
+	 * words, which is too expensive to do for every row, and an all-zeros
+	 * bitmap is handled correctly by bms_is_member() below anyway.
+	 */
+	if (visiMapEntry->bitmap == NULL)
 	{
 		elogif(Debug_appendonly_print_visimap, LOG,
 			   "Append-only visi map entry: All entries are visibile: "
@@ -473,6 +465,58 @@ AppendOnlyVisimapEntry_IsVisible(
 	return visibilityBit;
 }
 
+/*
+ * Checks the visibility of 'nrows' consecutive rows, starting at row number
+ * 'rowNum', according to the bitmap. On return, visible[i] is true iff row
+ * (rowNum + i) is visible. Returns the number of visible rows.
+ *
+ * Should only be called if the current visimap entry covers all the rows.
+ */
+int
+AppendOnlyVisimapEntry_GetVisibleRows(
+									  AppendOnlyVisimapEntry *visiMapEntry,
+									  int64 rowNum,
+									  int nrows,
+									  bool *visible)
+{
+	Bitmapset  *bitmap = visiMapEntry->bitmap;
+	int64		rowNumOffset;
+	int			nvisible = 0;
+	int			i;
+
+	Assert(visiMapEntry);
+	Assert(AppendOnlyVisimapEntry_IsValid(visiMapEntry));
+	Assert(nrows >= 0);
+
+	AppendOnlyVisimapEntry_GetRownumOffset(visiMapEntry,
+										   rowNum, &rowNumOffset);
+	Assert(rowNumOffset + nrows <= APPENDONLY_VISIMAP_MAX_RANGE);
+
+	if (bitmap == NULL)
+	{
+		memset(visible, true, nrows * sizeof(bool));
+		return nrows;
+	}
+
+	for (i = 0; i < nrows; i++, rowNumOffset++)
+	{
+		int			wordnum = rowNumOffset / BITS_PER_BITMAPWORD;
+		int			bitnum = rowNumOffset % BITS_PER_BITMAPWORD;
+
+		visible[i] = (wordnum >= bitmap->nwords ||
+					  (bitmap->words[wordnum] & ((bitmapword) 1 << bitnum)) == 0);
+		if (visible[i])
+			nvisible++;
+	}
+
+	elogif(Debug_appendonly_print_visimap, LOG,
+		   "Append-only visi map entry: (firstRowNum, rowNum, nrows, visible) = "
+		   "(" INT64_FORMAT ", " INT64_FORMAT ", %d, %d)",
+		   visiMapEntry->firstRowNum, rowNum, nrows, nvisible);
+
+	return nvisible;
+}
+
 /*
  * The minimal size (in uint32's elements) the entry array needs to have to
  * cover the given offset
@@ -170,6 +170,26 @@ initscan(AppendOnlyScanDesc scan, ScanKey key)
 	pgstat_count_heap_scan(scan->aos_rd);
 }
 
+/*
+ * Returns the index in aos_segfile_arr of the next segment file to scan.
+ *
+ * In a parallel scan, the segment files are handed out to the participants
+ * from the shared counter, so that each one is scanned by exactly one of them.
+ */
+static int
+NextFileSegToRead(AppendOnlyScanDesc scan)
+{
+	if (scan->rs_base.rs_parallel != NULL)
+	{
+		ParallelAppendOnlyScanDesc pscan =
+			(ParallelAppendOnlyScanDesc) scan->rs_base.rs_parallel;
+
+		return (int) pg_atomic_fetch_add_u32(&pscan->next_segfile, 1);
+	}
+
+	return scan->aos_segfiles_processed;
+}
+
 /*
  * Open the next file segment to scan and allocate all resources needed for it.
  */
@@ -182,6 +202,7 @@ SetNextFileSegForRead(AppendOnlyScanDesc scan)
 	int			formatversion = -2; /* some invalid value */
 	bool		finished_all_files = true;	/* assume */
 	int32		fileSegNo;
+	int			segfile_idx;
 
 	Assert(scan->aos_need_new_segfile); /* only call me when last segfile
 										 * completed */
@@ -253,10 +274,10 @@ SetNextFileSegForRead(AppendOnlyScanDesc scan)
 	/*
 	 * Do we have more segment files to read or are we done?
 	 */
-	while (scan->aos_segfiles_processed < scan->aos_total_segfiles)
+	while ((segfile_idx = NextFileSegToRead(scan)) < scan->aos_total_segfiles)
 	{
 		/* still have more segment files to read. get info of the next one */
-		FileSegInfo *fsinfo = scan->aos_segfile_arr[scan->aos_segfiles_processed];
+		FileSegInfo *fsinfo = scan->aos_segfile_arr[segfile_idx];
 
 		segno = fsinfo->segno;
 		formatversion = fsinfo->formatversion;
@@ -803,6 +824,37 @@ AppendOnlyExecutorReadBlock_Finish(AppendOnlyExecutorReadBlock *executorReadBloc
 		pfree(executorReadBlock->mt_bind);
 		executorReadBlock->mt_bind = NULL;
 	}
+
+	if (executorReadBlock->visibleRows)
+	{
+		pfree(executorReadBlock->visibleRows);
+		executorReadBlock->visibleRows = NULL;
+		executorReadBlock->visibleRowsLen = 0;
+	}
+}
+
+/*
+ * Look up the visibility of all the rows of the current block at once.
+ */
+static void
+AppendOnlyExecutorReadBlock_SetVisibleRows(AppendOnlyExecutorReadBlock *executorReadBlock,
+										   AppendOnlyVisimap *visiMap)
+{
+	if (executorReadBlock->visibleRowsLen < executorReadBlock->rowCount)
+	{
+		if (executorReadBlock->visibleRows)
+			pfree(executorReadBlock->visibleRows);
+		executorReadBlock->visibleRows =
+			MemoryContextAlloc(executorReadBlock->memoryContext,
+							   executorReadBlock->rowCount * sizeof(bool));
+		executorReadBlock->visibleRowsLen = executorReadBlock->rowCount;
+	}
+
+	AppendOnlyVisimap_GetVisibleRows(visiMap,
+									 executorReadBlock->segmentFileNum,
+									 executorReadBlock->blockFirstRowNum,
+									 executorReadBlock->rowCount,
+									 executorReadBlock->visibleRows);
 }
 
 static void
@@ -1080,6 +1132,11 @@ AppendOnlyExecutorReadBlock_ScanNextTuple(AppendOnlyExecutorReadBlock *executorR
 
 				executorReadBlock->totalRowsScannned++;
 
+				/* skip invisible rows without deforming them */
+				if (executorReadBlock->visibleRows &&
+					!executorReadBlock->visibleRows[executorReadBlock->currentItemCount - 1])
+					continue;
+
 				if (itemLen > 0)
 				{
 					tuple = (MemTuple) itemPtr;
@@ -1133,6 +1190,10 @@ AppendOnlyExecutorReadBlock_ScanNextTuple(AppendOnlyExecutorReadBlock *executorR
 
 				executorReadBlock->totalRowsScannned++;
 
+				if (executorReadBlock->visibleRows &&
+					!executorReadBlock->visibleRows[0])
+					break;
+
 				if (AppendOnlyExecutorReadBlock_ProcessTuple(
 															 executorReadBlock,
 															 executorReadBlock->blockFirstRowNum,
@@ -1280,6 +1341,10 @@ getNextBlock(AppendOnlyScanDesc scan)
 	AppendOnlyExecutorReadBlock_GetContents(
 											&scan->executorReadBlock);
 
+	if (scan->filterInvisibleRows)
+		AppendOnlyExecutorReadBlock_SetVisibleRows(&scan->executorReadBlock,
+												   &scan->visibilityMap);
+
 	return true;
 }
 
@@ -1340,7 +1405,12 @@ appendonlygettup(AppendOnlyScanDesc scan,
 			 */
 			AOTupleId  *aoTupleId = (AOTupleId *) &slot->tts_tid;
 
-			if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&scan->visibilityMap, aoTupleId))
+			/*
+			 * With filterInvisibleRows, invisible rows were already skipped
+			 * by AppendOnlyExecutorReadBlock_ScanNextTuple().
+			 */
+			if (!isSnapshotAny && !scan->filterInvisibleRows &&
+				!AppendOnlyVisimap_IsVisible(&scan->visibilityMap, aoTupleId))
 			{
 				/*
 				 * The tuple is invisible.
@@ -1607,6 +1677,13 @@ appendonly_beginrangescan_internal(Relation relation,
 							   visimapidxid,
 							   AccessShareLock,
 							   appendOnlyMetaDataSnapshot);
+
+		/*
+		 * ANALYZE needs to see the invisible rows to count them, so it
+		 * checks the visibility row by row.
+		 */
+		scan->filterInvisibleRows = (snapshot != SnapshotAny &&
+									 (flags & SO_TYPE_ANALYZE) == 0);
 	}
 	return scan;
 }
@@ -1668,8 +1745,15 @@ appendonly_beginscan(Relation relation,
 		/*
 		 * the append-only meta data should never be fetched with
 		 * SnapshotAny as bogus results are returned.
+		 *
+		 * All the participants of a parallel scan must see the same segment
+		 * files. They use the active snapshot, which the leader passes on to
+		 * its workers.
 		 */
-		appendOnlyMetaDataSnapshot = GetTransactionSnapshot();
+		if (pscan != NULL)
+			appendOnlyMetaDataSnapshot = GetActiveSnapshot();
+		else
+			appendOnlyMetaDataSnapshot = GetTransactionSnapshot();
 	}
 
 	/*
@@ -1691,6 +1775,47 @@ appendonly_beginscan(Relation relation,
 	return (TableScanDesc) aoscan;
 }
 
+/*
+ * Restricts a scan that hasn't returned any tuples yet to the segment files
+ * holding the given range of block numbers. (A block number is the upper
+ * part of an AOTupleId interpreted as a heap TID; its 7 most significant
+ * bits are the segment file number.)
+ *
+ * The scan still returns all the tuples of those segment files; the caller
+ * must filter out the ones outside the range.
+ */
+void
+appendonly_scan_restrict_blockrange(AppendOnlyScanDesc scan,
+									BlockNumber start_blockno,
+									BlockNumber numblocks)
+{
+	int			first_segno;
+	int			last_segno;
+	int			nkept = 0;
+	int			i;
+
+	Assert(scan->aos_segfiles_processed == 0);
+	Assert(scan->rs_base.rs_parallel == NULL);
+
+	first_segno = start_blockno >> 25;
+	if (numblocks == InvalidBlockNumber ||
+		(uint64) start_blockno + numblocks > MaxBlockNumber)
+		last_segno = AOTupleId_MaxSegmentFileNum;
+	else
+		last_segno = (start_blockno + numblocks - 1) >> 25;
+
+	for (i = 0; i < scan->aos_total_segfiles; i++)
+	{
+		FileSegInfo *fsinfo = scan->aos_segfile_arr[i];
+
+		if (fsinfo->segno >= first_segno && fsinfo->segno <= last_segno)
+			scan->aos_segfile_arr[nkept++] = fsinfo;
+		else
+			pfree(fsinfo);
+	}
+	scan->aos_total_segfiles = nkept;
+}
+
 /* ----------------
  *		appendonly_rescan		- restart a relation scan
  *
@@ -376,22 +376,34 @@ ExecFetchSlotMemTuple(TupleTableSlot *slot, bool *shouldFree, MemTupleBinding *m
  * ------------------------------------------------------------------------
  */
 
+/*
+ * The scan is split between the participants by segment file, see
+ * ParallelAppendOnlyScanDescData.
+ */
 static Size
 appendonly_parallelscan_estimate(Relation rel)
 {
-	elog(ERROR, "parallel SeqScan not implemented for AO_ROW tables");
+	return sizeof(ParallelAppendOnlyScanDescData);
 }
 
 static Size
 appendonly_parallelscan_initialize(Relation rel, ParallelTableScanDesc pscan)
 {
-	elog(ERROR, "parallel SeqScan not implemented for AO_ROW tables");
+	ParallelAppendOnlyScanDesc aopscan = (ParallelAppendOnlyScanDesc) pscan;
+
+	aopscan->base.phs_relid = RelationGetRelid(rel);
+	aopscan->base.phs_syncscan = false;
+	pg_atomic_init_u32(&aopscan->next_segfile, 0);
+
+	return sizeof(ParallelAppendOnlyScanDescData);
 }
 
 static void
 appendonly_parallelscan_reinitialize(Relation rel, ParallelTableScanDesc pscan)
 {
-	elog(ERROR, "parallel SeqScan not implemented for AO_ROW tables");
+	ParallelAppendOnlyScanDesc aopscan = (ParallelAppendOnlyScanDesc) pscan;
+
+	pg_atomic_write_u32(&aopscan->next_segfile, 0);
 }
 
 /* ------------------------------------------------------------------------
@@ -1191,6 +1203,14 @@ appendonly_index_build_range_scan(Relation heapRelation,
 									 NULL,	/* scan key */
 									 true,	/* buffer access strategy OK */
 									 allow_sync);	/* syncscan OK? */
+
+		/*
+		 * For a partial scan, e.g. when BRIN summarizes a single range, skip
+		 * the segment files that cannot hold any tuples of the range.
+		 */
+		if (start_blockno != 0 || numblocks != InvalidBlockNumber)
+			appendonly_scan_restrict_blockrange((AppendOnlyScanDesc) scan,
+												start_blockno, numblocks);
 	}
 	else
 	{
@@ -1228,6 +1248,15 @@ appendonly_index_build_range_scan(Relation heapRelation,
 	Relation blkdir = relation_open(blkdirrelid, AccessShareLock);
 	if (RelationGetNumberOfBlocks(blkdir) == 0)
 	{
+		/*
+		 * Parallel workers cannot insert into the block directory.
+		 * plan_create_index_workers() doesn't plan a parallel build in this
+		 * case.
+		 */
+		if (aoscan->rs_base.rs_parallel != NULL)
+			elog(ERROR, "cannot build block directory of append-optimized table \"%s\" in a parallel index build",
+				 RelationGetRelationName(heapRelation));
+
 		/*
 		 * Allocate blockDirectory in scan descriptor to let the access method
 		 * know that it needs to also build the block directory while
@@ -1295,12 +1324,12 @@ appendonly_index_build_range_scan(Relation heapRelation,
 		CHECK_FOR_INTERRUPTS();
 
 		/*
-		 * GPDB_12_MERGE_FIXME: How to properly do a partial scan? Currently,
-		 * we scan the whole table, and throw away tuples that are not in the
-		 * range. That's clearly very inefficient.
+		 * In a partial scan, throw away the tuples of the scanned segment
+		 * files that are not in the range.
 		 */
 		if (ItemPointerGetBlockNumber(&slot->tts_tid) < start_blockno ||
-			(numblocks != InvalidBlockNumber && ItemPointerGetBlockNumber(&slot->tts_tid) >= numblocks))
+			(numblocks != InvalidBlockNumber &&
+			 ItemPointerGetBlockNumber(&slot->tts_tid) - start_blockno >= numblocks))
 			continue;
 
 	/* GPDB_12_MERGE_FIXME */
@@ -70,6 +70,43 @@ test__AppendOnlyVisimapEntry_CoversTuple(void **state)
 	assert_true(result);
 }
 
+static void
+test__AppendOnlyVisimapEntry_GetVisibleRows(void **state)
+{
+	int			nvisible;
+	bool		visible[100];
+	Bitmapset  *bitmap;
+	AppendOnlyVisimapEntry *visiMapEntry = malloc(sizeof(AppendOnlyVisimapEntry));
+
+	visiMapEntry->segmentFileNum = 1;
+	visiMapEntry->firstRowNum = 32768;
+
+	/* No bitmap, all rows are visible. */
+	visiMapEntry->bitmap = NULL;
+	nvisible = AppendOnlyVisimapEntry_GetVisibleRows(visiMapEntry, 32800, 100, visible);
+	assert_int_equal(nvisible, 100);
+	assert_true(visible[0]);
+	assert_true(visible[99]);
+
+	/* Rows 32768 + 40 and 32768 + 70 are hidden. */
+	bitmap = malloc(offsetof(Bitmapset, words) + 16);
+	bitmap->nwords = 16 / sizeof(bitmapword);
+	memset(bitmap->words, 0, 16);
+	bitmap->words[40 / BITS_PER_BITMAPWORD] |= (bitmapword) 1 << (40 % BITS_PER_BITMAPWORD);
+	bitmap->words[70 / BITS_PER_BITMAPWORD] |= (bitmapword) 1 << (70 % BITS_PER_BITMAPWORD);
+	visiMapEntry->bitmap = bitmap;
+
+	nvisible = AppendOnlyVisimapEntry_GetVisibleRows(visiMapEntry, 32800, 100, visible);
+	assert_int_equal(nvisible, 98);
+	assert_true(visible[0]);
+	assert_false(visible[40 - 32]);
+	assert_false(visible[70 - 32]);
+	/* Rows beyond the end of the bitmap words are visible. */
+	assert_true(visible[99]);
+
+	free(bitmap);
+	free(visiMapEntry);
+}
 
 int
 main(int argc, char *argv[])
@@ -78,7 +115,8 @@ main(int argc, char *argv[])
 
 	const		UnitTest tests[] = {
 		unit_test(test__AppendOnlyVisimapEntry_GetFirstRowNum),
-		unit_test(test__AppendOnlyVisimapEntry_CoversTuple)
+		unit_test(test__AppendOnlyVisimapEntry_CoversTuple),
+		unit_test(test__AppendOnlyVisimapEntry_GetVisibleRows)
 	};
 
 	MemoryContextInit();
@@ -18,6 +18,7 @@
 #include "access/transam.h"
 #include "access/tuptoaster.h"
 #include "catalog/pg_type.h"
+#include "port/pg_bitutils.h"
 #include "utils/expandeddatum.h"
 
 #include "cdb/cdbvars.h"
@@ -79,12 +80,16 @@ void destroy_memtuple_binding(MemTupleBinding *pbind)
 		pfree(pbind->bind.null_saves_aligned);
 	if(pbind->bind.bindings)
 		pfree(pbind->bind.bindings);
+	if(pbind->bind.deform_steps)
+		pfree(pbind->bind.deform_steps);
 	if(pbind->large_bind.null_saves)
 		pfree(pbind->large_bind.null_saves);
 	if(pbind->large_bind.null_saves_aligned)
 		pfree(pbind->large_bind.null_saves_aligned);
 	if(pbind->large_bind.bindings)
 		pfree(pbind->large_bind.bindings);
+	if(pbind->large_bind.deform_steps)
+		pfree(pbind->large_bind.deform_steps);
 	pfree(pbind);
 }
 
@@ -396,6 +401,30 @@ static void create_col_bind(MemTupleBindingCols *colbind, bool islarge, TupleDes
 		colbind->null_saves = NULL;
 	}
 
+	/*
+	 * Build the deform program. The null bits are assigned in physical
+	 * order, so that's the order of the steps, too.
+	 */
+	colbind->deform_steps = (MemTupleDeformStep *) palloc(sizeof(MemTupleDeformStep) * Max(tupdesc->natts, 1));
+	for(i=0; i<tupdesc->natts; ++i)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+		MemTupleAttrBinding *bind = &colbind->bindings[i];
+		int			physical = (bind->null_byte << 3) + pg_rightmost_one_pos32(bind->null_mask);
+		MemTupleDeformStep *step = &colbind->deform_steps[physical];
+
+		step->attnum = i;
+		step->offset = bind->offset;
+		/* the 1 byte aligned attributes were added to null_saves as 1 byte */
+		step->len = (attr->attlen > 0 && attr->attalign == 'c') ? 1 : bind->len;
+		step->len_aligned = bind->len_aligned;
+		step->offset_len = bind->len;
+		step->attlen = attr->attlen;
+		step->flag = bind->flag;
+		step->null_byte = bind->null_byte;
+		step->null_mask = bind->null_mask;
+	}
+
 #ifdef USE_DEBUG_ASSERT
 	for(i=0; i<tupdesc->natts; ++i)
 	{
@@ -919,11 +948,72 @@ memtuple_copy(MemTuple mtup)
 	return dest;
 }
 
+/* Fetch the value of a non-NULL attribute at 'ptr', for the deform program */
+static inline Datum
+memtuple_fetch_step(char *start, char *ptr, MemTupleDeformStep *step)
+{
+	switch (step->flag)
+	{
+		case MTB_ByVal_Native:
+			return fetch_att(ptr, true, step->attlen);
+
+		case MTB_ByVal_Ptr:
+			return PointerGetDatum(ptr);
+
+		case MTB_ByRef:
+		case MTB_ByRef_CStr:
+			if (step->offset_len == 2)
+				return PointerGetDatum(start + *(uint16 *) ptr);
+			Assert(step->offset_len == 4);
+			return PointerGetDatum(start + *(uint32 *) ptr);
+	}
+	pg_unreachable();
+}
+
+/*
+ * Deform all the attributes by running the binding's deform program. This
+ * walks the attributes in physical order, keeping a running total of the
+ * space saved by the NULLs so far, which is what memtuple_getattr() computes
+ * from scratch for each attribute.
+ */
 static void memtuple_get_values(MemTuple mtup, MemTupleBinding *pbind, Datum *datum, bool *isnull, bool use_null_saves_aligned)
 {
-	int i;
-	for(i=0; i<pbind->tupdesc->natts; ++i)
-		datum[i] = memtuple_getattr_by_alignment(mtup, pbind, i+1, &isnull[i], use_null_saves_aligned);
+	MemTupleBindingCols *colbind = memtuple_get_islarge(mtup) ? &pbind->large_bind : &pbind->bind;
+	MemTupleDeformStep *step = colbind->deform_steps;
+	int			natts = pbind->tupdesc->natts;
+	int			i;
+
+	if (!memtuple_get_hasnull(mtup))
+	{
+		char	   *start = (char *) mtup;
+
+		for (i = 0; i < natts; ++i, ++step)
+		{
+			datum[step->attnum] = memtuple_fetch_step(start, start + step->offset, step);
+			isnull[step->attnum] = false;
+		}
+	}
+	else
+	{
+		unsigned char *nullp = memtuple_get_nullp(mtup, pbind);
+		char	   *start = (char *) mtup + pbind->null_bitmap_extra_size;
+		int			saved = 0;
+
+		for (i = 0; i < natts; ++i, ++step)
+		{
+			if (nullp[step->null_byte] & step->null_mask)
+			{
+				datum[step->attnum] = 0;
+				isnull[step->attnum] = true;
+				saved += use_null_saves_aligned ? step->len_aligned : step->len;
+			}
+			else
+			{
+				datum[step->attnum] = memtuple_fetch_step(start, start + step->offset - saved, step);
+				isnull[step->attnum] = false;
+			}
+		}
+	}
 }
 
 void memtuple_deform(MemTuple mtup, MemTupleBinding *pbind, Datum *datum, bool *isnull)
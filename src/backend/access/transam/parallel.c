@@ -43,6 +43,12 @@
 #include "utils/snapmgr.h"
 #include "utils/typcache.h"
 
+#include "cdb/cdbtm.h"
+#include "cdb/cdbvars.h"
+#include "utils/resgroup.h"
+#include "utils/resource_manager.h"
+#include "utils/sharedsnapshot.h"
+
 
 /*
  * We don't want to waste a lot of memory on an error queue which, most of
@@ -74,6 +80,7 @@
 #define PARALLEL_KEY_REINDEX_STATE			UINT64CONST(0xFFFFFFFFFFFF000B)
 #define PARALLEL_KEY_RELMAPPER_STATE		UINT64CONST(0xFFFFFFFFFFFF000C)
 #define PARALLEL_KEY_ENUMBLACKLIST			UINT64CONST(0xFFFFFFFFFFFF000D)
+#define PARALLEL_KEY_GP_RESGROUP			UINT64CONST(0xFFFFFFFFFFFF000E)
 
 /* Fixed-size parallel state. */
 typedef struct FixedParallelState
@@ -148,6 +155,7 @@ static void HandleParallelMessage(ParallelContext *pcxt, int i, StringInfo msg);
 static void WaitForParallelWorkersToExit(ParallelContext *pcxt);
 static parallel_worker_main_type LookupParallelWorkerFunction(const char *libraryname, const char *funcname);
 static void ParallelWorkerShutdown(int code, Datum arg);
+static bool ReaderWriterHasXid(void);
 
 
 /*
@@ -206,6 +214,7 @@ InitializeParallelDSM(ParallelContext *pcxt)
 	Size		relmapperlen = 0;
 	Size		enumblacklistlen = 0;
 	Size		segsize = 0;
+	StringInfo	resgroupinfo = NULL;
 	int			i;
 	FixedParallelState *fps;
 	dsm_handle	session_dsm_handle = DSM_HANDLE_INVALID;
@@ -236,6 +245,14 @@ InitializeParallelDSM(ParallelContext *pcxt)
 		 */
 		if (session_dsm_handle == DSM_HANDLE_INVALID)
 			pcxt->nworkers = 0;
+
+		/*
+		 * GPDB: A reader QE sees the changes made by its writer QE's
+		 * transaction, but a worker only knows the transaction IDs of its
+		 * leader. Run without workers in that case.
+		 */
+		if (ReaderWriterHasXid())
+			pcxt->nworkers = 0;
 	}
 
 	if (pcxt->nworkers > 0)
@@ -263,6 +280,19 @@ InitializeParallelDSM(ParallelContext *pcxt)
 		/* If you add more chunks here, you probably need to add keys. */
 		shm_toc_estimate_keys(&pcxt->estimator, 10);
 
+		/*
+		 * GPDB: The workers join the leader's resource group, so that the
+		 * CPU they use counts against the group's limits.
+		 */
+		if (IsResGroupActivated() && ResGroupIsAssigned())
+		{
+			resgroupinfo = makeStringInfo();
+			SerializeResGroupInfo(resgroupinfo);
+			shm_toc_estimate_chunk(&pcxt->estimator,
+								   sizeof(int32) + resgroupinfo->len);
+			shm_toc_estimate_keys(&pcxt->estimator, 1);
+		}
+
 		/* Estimate space need for error queues. */
 		StaticAssertStmt(BUFFERALIGN(PARALLEL_ERROR_QUEUE_SIZE) ==
 						 PARALLEL_ERROR_QUEUE_SIZE,
@@ -394,6 +424,18 @@ InitializeParallelDSM(ParallelContext *pcxt)
 		shm_toc_insert(pcxt->toc, PARALLEL_KEY_ENUMBLACKLIST,
 					   enumblacklistspace);
 
+		/* GPDB: Serialize resource group information. */
+		if (resgroupinfo != NULL)
+		{
+			char	   *resgroupspace;
+			int32		len = resgroupinfo->len;
+
+			resgroupspace = shm_toc_allocate(pcxt->toc, sizeof(int32) + len);
+			memcpy(resgroupspace, &len, sizeof(int32));
+			memcpy(resgroupspace + sizeof(int32), resgroupinfo->data, len);
+			shm_toc_insert(pcxt->toc, PARALLEL_KEY_GP_RESGROUP, resgroupspace);
+		}
+
 		/* Allocate space for worker information. */
 		pcxt->worker = palloc0(sizeof(ParallelWorkerInfo) * pcxt->nworkers);
 
@@ -1224,6 +1266,7 @@ ParallelWorkerMain(Datum main_arg)
 	char	   *reindexspace;
 	char	   *relmapperspace;
 	char	   *enumblacklistspace;
+	char	   *resgroupspace;
 	StringInfoData msgbuf;
 	char	   *session_dsm_handle_space;
 
@@ -1418,6 +1461,16 @@ ParallelWorkerMain(Datum main_arg)
 	/* Attach to the leader's serializable transaction, if SERIALIZABLE. */
 	AttachSerializableXact(fps->serializable_xact_handle);
 
+	/* GPDB: Join the leader's resource group, if it's in one. */
+	resgroupspace = shm_toc_lookup(toc, PARALLEL_KEY_GP_RESGROUP, true);
+	if (resgroupspace != NULL && IsResGroupActivated())
+	{
+		int32		len;
+
+		memcpy(&len, resgroupspace, sizeof(int32));
+		ResGroupAssignParallelWorker(resgroupspace + sizeof(int32), len);
+	}
+
 	/*
 	 * We've initialized all of our state now; nothing should change
 	 * hereafter.
@@ -1519,3 +1572,31 @@ LookupParallelWorkerFunction(const char *libraryname, const char *funcname)
 	return (parallel_worker_main_type)
 		load_external_function(libraryname, funcname, true, NULL);
 }
+
+/*
+ * GPDB: Has the writer QE of this reader QE been assigned a transaction ID?
+ *
+ * A reader QE considers its writer's transaction IDs as current, see
+ * IsCurrentTransactionIdForReader(), but a parallel worker only gets the
+ * transaction IDs of its leader, which a reader doesn't have.
+ */
+static bool
+ReaderWriterHasXid(void)
+{
+	bool		result = false;
+
+	if (DistributedTransactionContext != DTX_CONTEXT_QE_READER &&
+		DistributedTransactionContext != DTX_CONTEXT_QE_ENTRY_DB_SINGLETON)
+		return false;
+
+	if (SharedLocalSnapshotSlot == NULL)
+		return false;
+
+	LWLockAcquire(SharedLocalSnapshotSlot->slotLock, LW_SHARED);
+	if (SharedLocalSnapshotSlot->writer_xact != NULL &&
+		TransactionIdIsValid(SharedLocalSnapshotSlot->writer_xact->xid))
+		result = true;
+	LWLockRelease(SharedLocalSnapshotSlot->slotLock);
+
+	return result;
+}
@@ -518,6 +518,9 @@ compresstype_is_valid(char *comptype)
 #ifdef HAVE_LIBQUICKLZ
 			"quicklz",
 #endif
+#ifdef HAVE_LIBLZ4
+			"lz4",
+#endif
 #ifdef HAVE_LIBZ
 			"zlib",
 #endif
@@ -1342,6 +1342,9 @@ CREATE VIEW pg_stat_progress_vacuum AS
                       WHEN 4 THEN 'cleaning up indexes'
                       WHEN 5 THEN 'truncating heap'
                       WHEN 6 THEN 'performing final cleanup'
+                      WHEN 7 THEN 'append-optimized pre-cleanup'
+                      WHEN 8 THEN 'append-optimized compact'
+                      WHEN 9 THEN 'append-optimized post-cleanup'
                       END AS phase,
         S.param2 AS heap_blks_total, S.param3 AS heap_blks_scanned,
         S.param4 AS heap_blks_vacuumed, S.param5 AS index_vacuum_count,
@@ -1781,3 +1784,7 @@ CREATE OR REPLACE VIEW gp_stat_archiver AS
     SELECT -1 AS gp_segment_id, * FROM pg_stat_archiver
     UNION
     SELECT gp_execution_segment() AS gp_segment_id, * FROM gp_dist_random('pg_stat_archiver');
+
+-- Timing of each QE of the last plan this backend dispatched
+CREATE VIEW gp_stat_dispatch AS
+    SELECT * FROM pg_catalog.gp_get_dispatch_stats();
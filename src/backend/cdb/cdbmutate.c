@@ -166,6 +166,49 @@ make_explicit_motion(PlannerInfo *root, Plan *lefttree, AttrNumber segidColIdx)
 	return (Plan *) motion;
 }
 
+/*
+ * motion_compress_tuples
+ *
+ * Decide whether a Motion that moves 'rows' rows of 'width' bytes should
+ * compress its tuples on the wire.  Compression trades CPU for network
+ * bandwidth, which pays off for wide rows, and only when the Motion moves
+ * enough data for the network to be the bottleneck.
+ */
+#define MOTION_COMPRESS_MIN_BYTES	(1024.0 * 1024.0)
+
+bool
+motion_compress_tuples(double rows, int width)
+{
+#ifdef USE_ZSTD
+	if (gp_motion_compress_min_width <= 0 ||
+		width < gp_motion_compress_min_width)
+		return false;
+
+	return rows * width >= MOTION_COMPRESS_MIN_BYTES;
+#else
+	/* Tuples are compressed with zstd, so there is nothing to do without it */
+	return false;
+#endif
+}
+
+/*
+ * motion_batch_size
+ *
+ * Decide how many tuples of 'width' bytes a Motion should pack into one
+ * column-wise batch, or 0 to send them one at a time.  Batching saves the
+ * per-tuple header and call overhead, which only dominates for narrow rows.
+ */
+#define MOTION_BATCH_MAX_WIDTH		64
+
+int
+motion_batch_size(int width)
+{
+	if (gp_motion_batch_size <= 1 || width > MOTION_BATCH_MAX_WIDTH)
+		return 0;
+
+	return gp_motion_batch_size;
+}
+
 /* --------------------------------------------------------------------
  *
  *	Static Helper routines
@@ -19,6 +19,7 @@
 #include "catalog/pg_amop.h"
 #include "catalog/pg_opclass.h"
 #include "catalog/pg_operator.h"
+#include "catalog/pg_statistic.h"
 #include "catalog/pg_trigger.h"
 #include "commands/trigger.h"
 #include "nodes/makefuncs.h"	/* makeFuncExpr() */
@@ -36,11 +37,13 @@
 #include "utils/catcache.h"
 #include "utils/guc.h"
 #include "utils/lsyscache.h"
+#include "utils/selfuncs.h"		/* examine_variable() */
 #include "utils/syscache.h"
 
 #include "cdb/cdbdef.h"			/* CdbSwap() */
 #include "cdb/cdbhash.h"
 #include "cdb/cdbpath.h"		/* me */
+#include "cdb/cdbpullup.h"		/* cdbpullup_findEclassInTargetList() */
 #include "cdb/cdbutil.h"
 #include "cdb/cdbvars.h"
 
@@ -59,6 +62,13 @@ typedef struct
 
 static bool try_redistribute(PlannerInfo *root, CdbpathMfjRel *g,
 							 CdbpathMfjRel *o, List *redistribution_clauses);
+static List *cdbpath_skew_hot_keys(PlannerInfo *root, CdbpathMfjRel *rel);
+
+/*
+ * Upper limit on the number of heavy hitters a redistribute motion handles
+ * specially.  The sender compares the hash of every row with all of them.
+ */
+#define MAX_SKEW_HOT_KEYS	16
 
 static SplitUpdatePath *make_splitupdate_path(PlannerInfo *root, Path *subpath, Index rti);
 
@@ -255,14 +265,10 @@ cdbpath_create_motion_path(PlannerInfo *root,
 			pathnode->path.locus = locus;
 			pathnode->path.rows = subpath->rows;
 
-			/* GPDB_96_MERGE_FIXME: When is a Motion path parallel-safe? I tried
-			 * setting this to 'false' initially, to play it safe, but somehow
-			 * the Paths with motions ended up in gather plans anyway, and tripped
-			 * assertion failures.
-			 */
+			/* A Motion can't run in a parallel worker, i.e. below a Gather. */
 			pathnode->path.parallel_aware = false;
-			pathnode->path.parallel_safe = subpath->parallel_safe;
-			pathnode->path.parallel_workers = subpath->parallel_workers;
+			pathnode->path.parallel_safe = false;
+			pathnode->path.parallel_workers = 0;
 			pathnode->path.pathkeys = pathkeys;
 
 			pathnode->subpath = subpath;
@@ -305,14 +311,10 @@ cdbpath_create_motion_path(PlannerInfo *root,
 			pathnode->path.rows = subpath->rows;
 			pathnode->path.pathkeys = pathkeys;
 
-			/* GPDB_96_MERGE_FIXME: When is a Motion path parallel-safe? I tried
-			 * setting this to 'false' initially, to play it safe, but somehow
-			 * the Paths with motions ended up in gather plans anyway, and tripped
-			 * assertion failures.
-			 */
+			/* A Motion can't run in a parallel worker, i.e. below a Gather. */
 			pathnode->path.parallel_aware = false;
-			pathnode->path.parallel_safe = subpath->parallel_safe;
-			pathnode->path.parallel_workers = subpath->parallel_workers;
+			pathnode->path.parallel_safe = false;
+			pathnode->path.parallel_workers = 0;
 
 			pathnode->subpath = subpath;
 
@@ -553,14 +555,10 @@ cdbpath_create_motion_path(PlannerInfo *root,
 	pathnode->path.rows = subpath->rows;
 	pathnode->path.pathkeys = pathkeys;
 
-	/* GPDB_96_MERGE_FIXME: When is a Motion path parallel-safe? I tried
-	 * setting this to 'false' initially, to play it safe, but somehow
-	 * the Paths with motions ended up in gather plans anyway, and tripped
-	 * assertion failures.
-	 */
+	/* A Motion can't run in a parallel worker, i.e. below a Gather. */
 	pathnode->path.parallel_aware = false;
-	pathnode->path.parallel_safe = subpath->parallel_safe;
-	pathnode->path.parallel_workers = subpath->parallel_workers;
+	pathnode->path.parallel_safe = false;
+	pathnode->path.parallel_workers = 0;
 
 	pathnode->subpath = subpath;
 	pathnode->is_explicit_motion = false;
@@ -608,14 +606,10 @@ cdbpath_create_explicit_motion_path(PlannerInfo *root,
 	pathnode->path.rows = subpath->rows;
 	pathnode->path.pathkeys = NIL;
 
-	/* GPDB_96_MERGE_FIXME: When is a Motion path parallel-safe? I tried
-	 * setting this to 'false' initially, to play it safe, but somehow
-	 * the Paths with motions ended up in gather plans anyway, and tripped
-	 * assertion failures.
-	 */
+	/* A Motion can't run in a parallel worker, i.e. below a Gather. */
 	pathnode->path.parallel_aware = false;
-	pathnode->path.parallel_safe = subpath->parallel_safe;
-	pathnode->path.parallel_workers = subpath->parallel_workers;
+	pathnode->path.parallel_safe = false;
+	pathnode->path.parallel_workers = 0;
 
 	pathnode->subpath = subpath;
 	pathnode->is_explicit_motion = true;
@@ -647,14 +641,10 @@ cdbpath_create_broadcast_motion_path(PlannerInfo *root,
 	pathnode->path.rows = subpath->rows;
 	pathnode->path.pathkeys = NIL;
 
-	/* GPDB_96_MERGE_FIXME: When is a Motion path parallel-safe? I tried
-	 * setting this to 'false' initially, to play it safe, but somehow
-	 * the Paths with motions ended up in gather plans anyway, and tripped
-	 * assertion failures.
-	 */
+	/* A Motion can't run in a parallel worker, i.e. below a Gather. */
 	pathnode->path.parallel_aware = false;
-	pathnode->path.parallel_safe = subpath->parallel_safe;
-	pathnode->path.parallel_workers = subpath->parallel_workers;
+	pathnode->path.parallel_safe = false;
+	pathnode->path.parallel_workers = 0;
 
 	pathnode->subpath = subpath;
 	pathnode->is_explicit_motion = false;
@@ -689,14 +679,10 @@ make_motion_path(PlannerInfo *root, Path *subpath,
 	pathnode->path.rows = subpath->rows;
 	pathnode->path.pathkeys = NIL;
 
-	/* GPDB_96_MERGE_FIXME: When is a Motion path parallel-safe? I tried
-	 * setting this to 'false' initially, to play it safe, but somehow
-	 * the Paths with motions ended up in gather plans anyway, and tripped
-	 * assertion failures.
-	 */
+	/* A Motion can't run in a parallel worker, i.e. below a Gather. */
 	pathnode->path.parallel_aware = false;
-	pathnode->path.parallel_safe = subpath->parallel_safe;
-	pathnode->path.parallel_workers = subpath->parallel_workers;
+	pathnode->path.parallel_safe = false;
+	pathnode->path.parallel_workers = 0;
 
 	pathnode->subpath = subpath;
 
@@ -1262,6 +1248,8 @@ cdbpath_motion_for_join(PlannerInfo *root,
 {
 	CdbpathMfjRel outer;
 	CdbpathMfjRel inner;
+	CdbpathMfjRel *spray_rel = NULL;
+	List	   *hot_keys = NIL;
 	int			numsegments;
 	bool		join_quals_contain_outer_references;
 	ListCell   *lc;
@@ -2008,7 +1996,22 @@ cdbpath_motion_for_join(PlannerInfo *root,
 											 &large_rel->move_to,
 											 &small_rel->move_to))
 		{
-			/* ok */
+			/*
+			 * If a few join key values make up much of the larger rel, don't
+			 * send each of them to a single segment.  Spray the larger rel's
+			 * rows with those keys across the segments instead, and
+			 * broadcast the smaller rel's, so that they still meet.  That
+			 * duplicates rows of the smaller rel, so it must be ok to
+			 * replicate.
+			 */
+			if (small_rel->ok_to_replicate &&
+				(jointype == JOIN_INNER || jointype == JOIN_LEFT ||
+				 jointype == JOIN_RIGHT || jointype == JOIN_SEMI ||
+				 jointype == JOIN_ANTI))
+			{
+				hot_keys = cdbpath_skew_hot_keys(root, large_rel);
+				spray_rel = large_rel;
+			}
 		}
 
 		/*
@@ -2073,6 +2076,31 @@ cdbpath_motion_for_join(PlannerInfo *root,
 			goto fail;
 	}
 
+	/*
+	 * Both motions must agree on the heavy hitters, or rows would miss each
+	 * other.  The rows of the join are then not distributed by the join key.
+	 */
+	if (hot_keys != NIL &&
+		IsA(outer.path, CdbMotionPath) &&
+		IsA(inner.path, CdbMotionPath))
+	{
+		CdbMotionPath *outer_motion = (CdbMotionPath *) outer.path;
+		CdbMotionPath *inner_motion = (CdbMotionPath *) inner.path;
+		CdbPathLocus locus;
+
+		outer_motion->hotKeyHashes = hot_keys;
+		outer_motion->broadcastHotKeys = (spray_rel != &outer);
+		inner_motion->hotKeyHashes = hot_keys;
+		inner_motion->broadcastHotKeys = (spray_rel != &inner);
+
+		*p_outer_path = outer.path;
+		*p_inner_path = inner.path;
+
+		CdbPathLocus_MakeStrewn(&locus,
+								CdbPathLocus_NumSegments(outer.path->locus));
+		return locus;
+	}
+
 	/*
 	 * Ok to join.  Give modified subpaths to caller.
 	 */
@@ -2087,6 +2115,79 @@ fail:							/* can't do this join */
 	return outer.move_to;
 }								/* cdbpath_motion_for_join */
 
+/*
+ * cdbpath_skew_hot_keys
+ *    Find the heavy hitters of the join key that 'rel' is about to be
+ *    redistributed on.
+ *
+ * A key value is a heavy hitter if, according to the MCV statistics, it has
+ * more than gp_motion_skew_factor times a segment's fair share of the rows.
+ * They are returned as a List of the cdbhash() values that the redistribute
+ * motion will compute for them, so that both inputs of the join recognize
+ * equal keys even if their datatypes differ.  Returns NIL if there are none,
+ * or if the key is not a single column with statistics.
+ */
+static List *
+cdbpath_skew_hot_keys(PlannerInfo *root, CdbpathMfjRel *rel)
+{
+	DistributionKey *distkey;
+	EquivalenceClass *eclass;
+	Expr	   *expr;
+	VariableStatData vardata;
+	AttStatsSlot sslot;
+	int			numsegments;
+	List	   *result = NIL;
+
+	if (gp_motion_skew_factor <= 0)
+		return NIL;
+
+	numsegments = CdbPathLocus_NumSegments(rel->move_to);
+	if (numsegments <= 1 || list_length(rel->move_to.distkey) != 1)
+		return NIL;
+
+	distkey = (DistributionKey *) linitial(rel->move_to.distkey);
+	eclass = (EquivalenceClass *) linitial(distkey->dk_eclasses);
+	expr = cdbpullup_findEclassInTargetList(eclass, rel->path->pathtarget->exprs,
+											distkey->dk_opfamily);
+	if (!expr)
+		return NIL;
+
+	examine_variable(root, (Node *) expr, 0, &vardata);
+
+	if (HeapTupleIsValid(vardata.statsTuple) &&
+		get_attstatsslot(&sslot, vardata.statsTuple,
+						 STATISTIC_KIND_MCV, InvalidOid,
+						 ATTSTATSSLOT_VALUES | ATTSTATSSLOT_NUMBERS))
+	{
+		double		threshold = gp_motion_skew_factor / numsegments;
+		Oid			hashfunc;
+		CdbHash    *h;
+
+		/* Hash like the Motion will, see make_hashed_motion() */
+		hashfunc = cdb_hashproc_in_opfamily(distkey->dk_opfamily,
+											exprType((Node *) expr));
+		h = makeCdbHash(numsegments, 1, &hashfunc);
+
+		/* The MCVs are sorted by decreasing frequency */
+		for (int i = 0; i < sslot.nvalues && i < sslot.nnumbers; i++)
+		{
+			if (sslot.numbers[i] <= threshold ||
+				list_length(result) >= MAX_SKEW_HOT_KEYS)
+				break;
+
+			cdbhashinit(h);
+			cdbhash(h, 1, sslot.values[i], false);
+			result = list_append_unique_int(result, (int) h->hash);
+		}
+
+		free_attstatsslot(&sslot);
+	}
+
+	ReleaseVariableStats(vardata);
+
+	return result;
+}
+
 /*
  * Does the path contain WorkTableScan?
  */
@@ -2120,6 +2221,56 @@ cdbpath_contains_wts(Path *path)
 	return path->pathtype == T_WorkTableScan;
 }
 
+/*
+ * cdbpath_join_is_colocated
+ *
+ * Can outer_rel and inner_rel be joined in place, without moving either side?
+ * That's the case when the cheapest paths of both are hashed on the same
+ * segments, and the join clauses equate their distribution keys.
+ *
+ * Used to decide whether to join co-partitioned tables partition by
+ * partition: if the parents are co-located, each pair of matching partitions
+ * can be joined without a Motion, so the child joins don't each need a slice
+ * of their own.
+ */
+bool
+cdbpath_join_is_colocated(PlannerInfo *root, JoinType jointype,
+						  RelOptInfo *outer_rel, RelOptInfo *inner_rel,
+						  List *restrictlist)
+{
+	Path	   *outer_path = outer_rel->cheapest_total_path;
+	Path	   *inner_path = inner_rel->cheapest_total_path;
+	List	   *mergeclause_list = NIL;
+	ListCell   *lc;
+
+	if (!outer_path || !inner_path)
+		return false;
+
+	if (!(CdbPathLocus_IsHashed(outer_path->locus) ||
+		  CdbPathLocus_IsHashedOJ(outer_path->locus)) ||
+		!(CdbPathLocus_IsHashed(inner_path->locus) ||
+		  CdbPathLocus_IsHashedOJ(inner_path->locus)))
+		return false;
+
+	foreach(lc, restrictlist)
+	{
+		RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+
+		/* Like select_cdb_redistribute_clauses(), but without the frills */
+		if (IS_OUTER_JOIN(jointype) && rinfo->is_pushed_down)
+			continue;
+		if (!has_redistributable_clause(rinfo) ||
+			!rinfo->can_join ||
+			rinfo->mergeopfamilies == NIL)
+			continue;
+
+		mergeclause_list = lappend(mergeclause_list, rinfo);
+	}
+
+	return cdbpath_match_preds_to_both_distkeys(root, mergeclause_list,
+												outer_path->locus,
+												inner_path->locus);
+}
 
 /*
  * has_redistributable_clause
@@ -655,6 +655,21 @@ plan_tree_mutator(Node *node,
 			}
 			break;
 
+		case T_GatherMerge:
+			{
+				GatherMerge *gm = (GatherMerge *) node;
+				GatherMerge *newgm;
+
+				FLATCOPY(newgm, gm, GatherMerge);
+				PLANMUTATE(newgm, gm);
+				COPYARRAY(newgm, gm, numCols, sortColIdx);
+				COPYARRAY(newgm, gm, numCols, sortOperators);
+				COPYARRAY(newgm, gm, numCols, collations);
+				COPYARRAY(newgm, gm, numCols, nullsFirst);
+				return (Node *) newgm;
+			}
+			break;
+
 		case T_Hash:
 			{
 				Hash	   *hash = (Hash *) node;
@@ -525,6 +525,7 @@ DirectDispatchUpdateContentIdsFromPlan(PlannerInfo *root, Plan *plan)
 		case T_TupleSplit:
 		case T_Unique:
 		case T_Gather:
+		case T_GatherMerge:
 		case T_Hash:
 		case T_SetOp:
 		case T_Limit:
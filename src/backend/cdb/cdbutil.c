@@ -820,6 +820,42 @@ cdbcomponent_allocateIdleQE(int contentId, SegmentType segmentType)
 	return segdbDesc;
 }
 
+/*
+ * Create a new, not yet connected segdb and put it straight into the
+ * freelist of the given segment, for cdbgang_prewarm() to start connecting.
+ *
+ * Like in cdbcomponent_allocateIdleQE(), the first QE of a primary segment
+ * is the writer.
+ */
+SegmentDatabaseDescriptor *
+cdbcomponent_createIdleQE(int contentId)
+{
+	SegmentDatabaseDescriptor	*segdbDesc;
+	CdbComponentDatabaseInfo	*cdbinfo;
+	MemoryContext 				oldContext;
+	bool						isWriter;
+
+	cdbinfo = cdbcomponent_getComponentInfo(contentId);
+
+	oldContext = MemoryContextSwitchTo(CdbComponentsContext);
+
+	isWriter = contentId == -1 ? false: (cdbinfo->numIdleQEs == 0 && cdbinfo->numActiveQEs == 0);
+	segdbDesc = cdbconn_createSegmentDescriptor(cdbinfo, nextQEIdentifer(cdbinfo->cdbs), isWriter);
+	cdbconn_setQEIdentifier(segdbDesc, -1);
+
+	/* writer is always the header of freelist */
+	if (isWriter)
+		cdbinfo->freelist = lcons(segdbDesc, cdbinfo->freelist);
+	else
+		cdbinfo->freelist = lappend(cdbinfo->freelist, segdbDesc);
+
+	INCR_COUNT(cdbinfo, numIdleQEs);
+
+	MemoryContextSwitchTo(oldContext);
+
+	return segdbDesc;
+}
+
 static bool
 cleanupQE(SegmentDatabaseDescriptor *segdbDesc)
 {
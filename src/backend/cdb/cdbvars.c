@@ -160,6 +160,13 @@ int			gp_dtx_recovery_prepared_period = 300;
 int			gp_gang_creation_retry_count = 5;	/* disable by default */
 int			gp_gang_creation_retry_timer = 2000;	/* 2000ms */
 
+/*
+ * Number of QEs per segment that the QD starts connecting to at session start
+ * (and again after idle QEs were released), so that the connection setup
+ * overlaps with the client's think time and with planning.
+ */
+int			gp_gang_prewarm_size = 0;
+
 /*
  * gp_enable_slow_writer_testmode
  *
@@ -211,6 +218,10 @@ bool		gp_interconnect_log_stats = false;	/* emit stats at log-level */
 
 bool		gp_interconnect_cache_future_packets = true;
 
+bool		gp_interconnect_collect_stats = false;	/* cumulative ic stats */
+
+bool		gp_interconnect_local_shm = false;	/* same-host packets via shmem */
+
 /*
  * format: dbid:content:address:port,dbid:content:address:port ...
  * example: 1:-1:10.0.0.1:2000 2:0:10.0.0.2:2000 3:1:10.0.0.2:2001
@@ -247,6 +258,10 @@ uint32		gp_interconnect_id = 0;
  */
 
 double		gp_motion_cost_per_row = 0;
+int			gp_motion_compress_min_width = 0;
+int			gp_motion_batch_size = 0;
+double		gp_motion_skew_factor = 0;
+int			gp_motion_merge_abbrev_min_senders = 16;
 int			gp_segments_for_planner = 0;
 
 int			gp_hashagg_default_nbatches = 32;
@@ -258,7 +273,15 @@ double		gp_selectivity_damping_factor = 1;
 bool		gp_selectivity_damping_sigsort = true;
 
 int			gp_hashjoin_tuples_per_bucket = 5;
+int			gp_hashjoin_probe_batch_size = 16;
 int			gp_hashagg_groups_per_bucket = 5;
+bool		gp_hashagg_streambottom = false;
+double		gp_hashagg_passthrough_ratio = 0.8;
+bool		gp_enable_vectorized_agg = false;
+bool		gp_enable_radix_sort = true;
+bool		gp_enable_window_segment_tree = true;
+bool		gp_enable_colocated_partitionwise = false;
+bool		gp_enable_intra_segment_parallel = false;
 
 /* Analyzing aid */
 int			gp_motion_slice_noop = 0;
@@ -279,6 +302,8 @@ int			gp_segworker_relative_priority = PRIO_MAX;
 /* Max size of dispatched plans; 0 if no limit */
 int			gp_max_plan_size = 0;
 
+bool		gp_dispatch_cache_plans = false;
+
 /* Disable setting of tuple hints while reading */
 bool		gp_disable_tuple_hints = false;
 
@@ -293,6 +318,12 @@ int			gp_workfile_limit_per_segment = 0;
 /* Maximum disk space to use for workfiles per query on a segment, in kilobytes */
 int			gp_workfile_limit_per_query = 0;
 
+/* Maximum I/O buffer size of a sequentially accessed workfile, in kilobytes */
+int			gp_workfile_buffer_size = 128;
+
+/* Maximum size of a cross-slice ShareInputScan result kept in memory, in kilobytes */
+int			gp_shareinput_inmem_size = 1024;
+
 /* Maximum number of workfiles to be created by a query */
 int			gp_workfile_limit_files_per_query = 0;
 
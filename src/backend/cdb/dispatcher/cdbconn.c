@@ -84,6 +84,7 @@ cdbconn_createSegmentDescriptor(struct CdbComponentDatabaseInfo *cdbinfo, int id
 	segdbDesc->conn = NULL;
 	segdbDesc->motionListener = 0;
 	segdbDesc->backendPid = 0;
+	segdbDesc->prewarming = false;
 
 	/* whoami */
 	segdbDesc->whoami = NULL;
@@ -135,6 +136,9 @@ cdbconn_doConnectStart(SegmentDatabaseDescriptor *segdbDesc,
 	char		portstr[MAX_INT_STRING_LEN];
 	int			nkeywords = 0;
 
+	/* A new QE has no dispatched plans cached, see cdbdisp_plancache.c */
+	segdbDesc->numCachedPlans = 0;
+
 	keywords[nkeywords] = "gpqeid";
 	values[nkeywords] = gpqeid;
 	nkeywords++;
@@ -16,6 +16,8 @@
 
 #include "postgres.h"
 
+#include "funcapi.h"
+#include "miscadmin.h"
 #include "storage/ipc.h"		/* For proc_exit_inprogress */
 #include "tcop/tcopprot.h"
 #include "cdb/cdbdisp.h"
@@ -28,7 +30,30 @@
 #include "cdb/cdbgang.h"
 #include "cdb/cdbsreh.h"
 #include "cdb/cdbvars.h"
+#include "utils/builtins.h"
 #include "utils/resowner.h"
+#include "utils/tuplestore.h"
+
+/*
+ * Timing of one QE of the last plan dispatched by this backend, kept for
+ * the gp_stat_dispatch view.  Times are in milliseconds; negative if the
+ * event didn't happen.
+ */
+typedef struct QEDispatchStats
+{
+	int			sliceIndex;
+	int			segindex;
+	int			pid;
+	double		sendTime;			/* after dispatching started */
+	double		firstResultLatency;	/* after sendTime */
+	double		finishLatency;		/* after sendTime */
+	double		processTime;
+	bool		planCached;		/* only the plan's key was sent */
+} QEDispatchStats;
+
+static QEDispatchStats *lastDispatchStats = NULL;
+static int	numLastDispatchStats = 0;
+static int	maxLastDispatchStats = 0;
 
 static int numNonExtendedDispatcherState = 0;
 
@@ -39,6 +64,7 @@ static dispatcher_handle_t *find_dispatcher_handle(CdbDispatcherState *ds);
 static dispatcher_handle_t *allocate_dispatcher_handle(void);
 static void destroy_dispatcher_handle(dispatcher_handle_t *h);
 static char * segmentsListToString(const char *prefix, List *segments);
+static void saveDispatchStats(CdbDispatchResults *results);
 
 static DispatcherInternalFuncs *pDispatchFuncs = &DispatcherAsyncFuncs;
 
@@ -361,6 +387,9 @@ cdbdisp_destroyDispatcherState(CdbDispatcherState *ds)
 	{
 		int			i;
 
+		if (results->saveStats)
+			saveDispatchStats(results);
+
 		for (i = 0; i < results->resultCount; i++)
 		{
 			cdbdisp_termResult(&results->resultArray[i]);
@@ -388,6 +417,8 @@ cdbdisp_destroyDispatcherState(CdbDispatcherState *ds)
 		cdbcomponent_cleanupIdleQEs(false);
 
 	ds->allocatedGangs = NIL;
+	if (ds->dispatchParams != NULL && pDispatchFuncs->destroyDispatchParams != NULL)
+		(pDispatchFuncs->destroyDispatchParams) (ds);
 	ds->dispatchParams = NULL;
 	ds->primaryResults = NULL;
 	ds->largestGangSize= 0;
@@ -606,3 +637,131 @@ segmentsToContentStr(List *segments)
 	else
 		return segmentsListToString("ALL contents", segments);
 }
+
+/*
+ * Milliseconds from 'start' to 'end', or -1 if 'end' never happened.
+ */
+double
+cdbdisp_elapsedMs(instr_time end, instr_time start)
+{
+	if (INSTR_TIME_IS_ZERO(end) || INSTR_TIME_IS_ZERO(start))
+		return -1;
+
+	INSTR_TIME_SUBTRACT(end, start);
+	return INSTR_TIME_GET_MILLISEC(end);
+}
+
+/*
+ * Remember the timing of each QE of a finished dispatch, for
+ * gp_get_dispatch_stats().
+ */
+static void
+saveDispatchStats(CdbDispatchResults *results)
+{
+	int			i;
+	int			sliceIndex;
+
+	if (results->resultCount > maxLastDispatchStats)
+	{
+		if (lastDispatchStats)
+			pfree(lastDispatchStats);
+		lastDispatchStats = MemoryContextAlloc(TopMemoryContext,
+											   results->resultCount * sizeof(QEDispatchStats));
+		maxLastDispatchStats = results->resultCount;
+	}
+
+	for (i = 0; i < results->resultCount; i++)
+	{
+		CdbDispatchResult *dispatchResult = &results->resultArray[i];
+		QEDispatchStats *stats = &lastDispatchStats[i];
+
+		stats->sliceIndex = -1;
+		stats->segindex = dispatchResult->segdbDesc->segindex;
+		stats->pid = dispatchResult->segdbDesc->backendPid;
+		stats->sendTime = cdbdisp_elapsedMs(dispatchResult->sendTime,
+											results->startTime);
+		stats->firstResultLatency = cdbdisp_elapsedMs(dispatchResult->firstResultTime,
+													  dispatchResult->sendTime);
+		stats->finishLatency = cdbdisp_elapsedMs(dispatchResult->finishTime,
+												 dispatchResult->sendTime);
+		stats->processTime = INSTR_TIME_GET_MILLISEC(dispatchResult->processTime);
+		stats->planCached = results->planCached;
+	}
+
+	for (sliceIndex = 0; sliceIndex < results->sliceCapacity; sliceIndex++)
+	{
+		CdbDispatchResults_SliceInfo *si = &results->sliceMap[sliceIndex];
+
+		for (i = si->resultBegin; i < si->resultEnd; i++)
+			lastDispatchStats[i].sliceIndex = sliceIndex;
+	}
+
+	numLastDispatchStats = results->resultCount;
+}
+
+/*
+ * gp_get_dispatch_stats
+ *		Return the timing of each QE of the last plan this backend dispatched.
+ */
+Datum
+gp_get_dispatch_stats(PG_FUNCTION_ARGS)
+{
+#define GP_DISPATCH_STATS_COLS	8
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	int			i;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not allowed in this context")));
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	for (i = 0; i < numLastDispatchStats; i++)
+	{
+		QEDispatchStats *stats = &lastDispatchStats[i];
+		Datum		values[GP_DISPATCH_STATS_COLS];
+		bool		nulls[GP_DISPATCH_STATS_COLS];
+
+		MemSet(nulls, 0, sizeof(nulls));
+
+		values[0] = Int32GetDatum(stats->sliceIndex);
+		nulls[0] = stats->sliceIndex < 0;
+		values[1] = Int32GetDatum(stats->segindex);
+		values[2] = Int32GetDatum(stats->pid);
+		values[3] = Float8GetDatum(stats->sendTime);
+		nulls[3] = stats->sendTime < 0;
+		values[4] = Float8GetDatum(stats->firstResultLatency);
+		nulls[4] = stats->firstResultLatency < 0;
+		values[5] = Float8GetDatum(stats->finishLatency);
+		nulls[5] = stats->finishLatency < 0;
+		values[6] = Float8GetDatum(stats->processTime);
+		values[7] = BoolGetDatum(stats->planCached);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
@@ -4,10 +4,9 @@
  *	  Functions for asynchronous implementation of dispatching
  *	  commands to QExecutors.
  *
- * GPDB_12_MERGE_FIXME: We should switch to using WaitEventSetWait() instead
- * of straight poll() in this file. WaitEventSetWait() would report the status
- * using the new wait event infrastructure, so that it would show up as a
- * separate state in pg_stat_activity. It's also potentially more efficient.
+ * Results are collected with a WaitEventSet, which uses epoll where
+ * available, so that each wakeup only visits the QEs that have data.  The
+ * wait shows up as the DispatchResult wait event in pg_stat_activity.
  *
  *
  * Portions Copyright (c) 2005-2008, Greenplum inc
@@ -29,10 +28,13 @@
 #include <sys/poll.h>
 #endif
 
+#include "pgstat.h"
 #include "storage/ipc.h"		/* For proc_exit_inprogress  */
+#include "storage/latch.h"
 #include "tcop/tcopprot.h"
 #include "cdb/cdbdisp.h"
 #include "cdb/cdbdisp_async.h"
+#include "cdb/cdbdisp_plancache.h"
 #include "cdb/cdbdispatchresult.h"
 #include "libpq-fe.h"
 #include "libpq-int.h"
@@ -84,6 +86,18 @@ typedef struct CdbDispatchCmdAsync
 	char	   *query_text;
 	int			query_text_len;
 
+	/*
+	 * The QE connections that checkDispatchResult() waits on, plus our latch.
+	 * Each socket event's user_data is its CdbDispatchResult.  A WaitEventSet
+	 * can't drop events, so finished QEs stay in it until it is rebuilt; see
+	 * prepareWaitSet().
+	 */
+	WaitEventSet *waitSet;
+	WaitEvent  *waitEvents;
+	int			waitSetSize;	/* number of QE connections in waitSet */
+	int			waitSetDispatchCount;	/* dispatchCount when it was built */
+	bool		waitSetStale;	/* a finished QE reported an event */
+
 } CdbDispatchCmdAsync;
 
 static void *cdbdisp_makeDispatchParams_async(int maxSlices, int largestGangSize, char *queryText, int len);
@@ -98,6 +112,7 @@ static void	cdbdisp_waitDispatchFinish_async(struct CdbDispatcherState *ds);
 
 static bool	cdbdisp_checkForCancel_async(struct CdbDispatcherState *ds);
 static int cdbdisp_getWaitSocketFd_async(struct CdbDispatcherState *ds);
+static void cdbdisp_destroyDispatchParams_async(struct CdbDispatcherState *ds);
 
 DispatcherInternalFuncs DispatcherAsyncFuncs =
 {
@@ -106,7 +121,8 @@ DispatcherInternalFuncs DispatcherAsyncFuncs =
 	cdbdisp_makeDispatchParams_async,
 	cdbdisp_checkDispatchResult_async,
 	cdbdisp_dispatchToGang_async,
-	cdbdisp_waitDispatchFinish_async
+	cdbdisp_waitDispatchFinish_async,
+	cdbdisp_destroyDispatchParams_async
 };
 
 
@@ -126,10 +142,10 @@ static void
 			checkSegmentAlive(CdbDispatchCmdAsync *pParms);
 
 static void
-			handlePollError(CdbDispatchCmdAsync *pParms);
+			prepareWaitSet(CdbDispatchCmdAsync *pParms, int nrunning);
 
 static void
-			handlePollSuccess(CdbDispatchCmdAsync *pParms, struct pollfd *fds);
+			handleReadyQEs(CdbDispatchCmdAsync *pParms, int nready);
 
 /*
  * Check dispatch result.
@@ -200,6 +216,10 @@ cdbdisp_waitDispatchFinish_async(struct CdbDispatcherState *ds)
 				i;
 	CdbDispatchCmdAsync *pParms = (CdbDispatchCmdAsync *) ds->dispatchParams;
 	int			dispatchCount = pParms->dispatchCount;
+	instr_time	starttime;
+	instr_time	endtime;
+
+	INSTR_TIME_SET_CURRENT(starttime);
 
 	fds = (struct pollfd *) palloc(dispatchCount * sizeof(struct pollfd));
 
@@ -269,6 +289,9 @@ cdbdisp_waitDispatchFinish_async(struct CdbDispatcherState *ds)
 	}
 
 	pfree(fds);
+
+	INSTR_TIME_SET_CURRENT(endtime);
+	INSTR_TIME_ACCUM_DIFF(ds->primaryResults->flushTime, endtime, starttime);
 }
 
 /*
@@ -283,9 +306,13 @@ cdbdisp_dispatchToGang_async(struct CdbDispatcherState *ds,
 							 int sliceIndex)
 {
 	int			i;
+	instr_time	starttime;
+	instr_time	endtime;
 
 	CdbDispatchCmdAsync *pParms = (CdbDispatchCmdAsync *) ds->dispatchParams;
 
+	INSTR_TIME_SET_CURRENT(starttime);
+
 	/*
 	 * Start the dispatching
 	 */
@@ -309,6 +336,15 @@ cdbdisp_dispatchToGang_async(struct CdbDispatcherState *ds,
 
 		dispatchCommand(qeResult, pParms->query_text, pParms->query_text_len);
 	}
+
+	INSTR_TIME_SET_CURRENT(endtime);
+	if (sliceIndex >= 0 && sliceIndex < ds->primaryResults->sliceCapacity)
+	{
+		CdbDispatchResults_SliceInfo *si = &ds->primaryResults->sliceMap[sliceIndex];
+
+		INSTR_TIME_ACCUM_DIFF(si->dispatchTime, endtime, starttime);
+		si->dispatchBytes += (uint64) pParms->query_text_len * gp->size;
+	}
 }
 
 /*
@@ -367,10 +403,26 @@ cdbdisp_makeDispatchParams_async(int maxSlices, int largestGangSize, char *query
 	pParms->waitMode = DISPATCH_WAIT_NONE;
 	pParms->query_text = queryText;
 	pParms->query_text_len = len;
+	pParms->waitEvents = (WaitEvent *) palloc((maxResults + 1) * sizeof(WaitEvent));
 
 	return (void *) pParms;
 }
 
+/*
+ * Release the resources of a CdbDispatchCmdAsync that aren't memory.
+ */
+static void
+cdbdisp_destroyDispatchParams_async(struct CdbDispatcherState *ds)
+{
+	CdbDispatchCmdAsync *pParms = (CdbDispatchCmdAsync *) ds->dispatchParams;
+
+	if (pParms->waitSet != NULL)
+	{
+		FreeWaitEventSet(pParms->waitSet);
+		pParms->waitSet = NULL;
+	}
+}
+
 /*
  * Receive and process results from all running QEs.
  *
@@ -392,11 +444,9 @@ checkDispatchResult(CdbDispatcherState *ds,
 	int			db_count = 0;
 	int			timeout = 0;
 	bool		sentSignal = false;
-	struct pollfd *fds;
 	uint8 ftsVersion = 0;
 
 	db_count = pParms->dispatchCount;
-	fds = (struct pollfd *) palloc(db_count * sizeof(struct pollfd));
 
 	/*
 	 * OK, we are finished submitting the command to the segdbs. Now, we have
@@ -404,10 +454,11 @@ checkDispatchResult(CdbDispatcherState *ds,
 	 */
 	for (;;)
 	{
-		int			sock;
 		int			n;
-		int			nfds = 0;
+		int			nrunning = 0;
 		PGconn		*conn;
+		instr_time	starttime;
+		instr_time	endtime;
 
 		/*
 		 * bail-out if we are dying. Once QD dies, QE will recognize it
@@ -449,7 +500,7 @@ checkDispatchResult(CdbDispatcherState *ds,
 			if (conn->outCount > 0)
 			{
 				/*
-				 * Don't error out here, let following poll() routine to
+				 * Don't error out here, let following wait routine to
 				 * handle it.
 				 */
 				if (pqFlush(conn) < 0)
@@ -457,20 +508,13 @@ checkDispatchResult(CdbDispatcherState *ds,
 						 segdbDesc->whoami, PQerrorMessage(conn));
 			}
 
-			/*
-			 * Add socket to fd_set if still connected.
-			 */
-			sock = PQsocket(conn);
-			Assert(sock >= 0);
-			fds[nfds].fd = sock;
-			fds[nfds].events = POLLIN;
-			nfds++;
+			nrunning++;
 		}
 
 		/*
 		 * Break out when no QEs still running.
 		 */
-		if (nfds <= 0)
+		if (nrunning <= 0)
 			break;
 
 		/*
@@ -488,42 +532,16 @@ checkDispatchResult(CdbDispatcherState *ds,
 		else
 			timeout = DISPATCH_WAIT_CANCEL_TIMEOUT_MSEC;
 
-		n = poll(fds, nfds, timeout);
-
-		/*
-		 * poll returns with an error, including one due to an interrupted
-		 * call
-		 */
-		if (n < 0)
-		{
-			int			sock_errno = SOCK_ERRNO;
-
-			if (sock_errno == EINTR)
-				continue;
-
-			elog(LOG, "handlePollError poll() failed; errno=%d", sock_errno);
+		prepareWaitSet(pParms, nrunning);
 
-			handlePollError(pParms);
+		INSTR_TIME_SET_CURRENT(starttime);
+		n = WaitEventSetWait(pParms->waitSet, timeout, pParms->waitEvents,
+							 pParms->waitSetSize + 1, WAIT_EVENT_DISPATCH_RESULT);
+		INSTR_TIME_SET_CURRENT(endtime);
+		INSTR_TIME_ACCUM_DIFF(meleeResults->waitTime, endtime, starttime);
 
-			/*
-			 * Since an error was detected for the segment, request
-			 * FTS to perform a probe before checking the segment
-			 * state.
-			 */
-			FtsNotifyProber();
-			checkSegmentAlive(pParms);
-
-			if (pParms->waitMode != DISPATCH_WAIT_NONE)
-			{
-				signalQEs(pParms);
-				sentSignal = true;
-			}
-
-			if (!wait)
-				break;
-		}
-		/* If the time limit expires, poll() returns 0 */
-		else if (n == 0)
+		/* If the time limit expires, WaitEventSetWait() returns 0 */
+		if (n == 0)
 		{
 			if (pParms->waitMode != DISPATCH_WAIT_NONE)
 			{
@@ -549,10 +567,56 @@ checkDispatchResult(CdbDispatcherState *ds,
 		}
 		/* We have data waiting on one or more of the connections. */
 		else
-			handlePollSuccess(pParms, fds);
+		{
+			meleeResults->numWakeups++;
+			handleReadyQEs(pParms, n);
+		}
 	}
+}
 
-	pfree(fds);
+/*
+ * Make sure pParms->waitSet holds the connections of the running QEs and
+ * our latch, so that an interrupt wakes up the wait too.
+ *
+ * QEs that finish are left in the set, because a WaitEventSet can't drop
+ * events; their events are ignored.  The set is rebuilt from the running QEs
+ * when more commands were dispatched since it was built, when at least half
+ * of its QEs have finished, or when a finished QE reported an event (e.g.
+ * its connection was closed), which it would keep doing.  This keeps the
+ * total cost of building the set linear in the number of QEs.
+ */
+static void
+prepareWaitSet(CdbDispatchCmdAsync *pParms, int nrunning)
+{
+	int			i;
+
+	if (pParms->waitSet != NULL &&
+		!pParms->waitSetStale &&
+		pParms->waitSetDispatchCount == pParms->dispatchCount &&
+		nrunning * 2 > pParms->waitSetSize)
+		return;
+
+	if (pParms->waitSet != NULL)
+		FreeWaitEventSet(pParms->waitSet);
+
+	pParms->waitSet = CreateWaitEventSet(GetMemoryChunkContext(pParms), nrunning + 1);
+	AddWaitEventToSet(pParms->waitSet, WL_LATCH_SET, PGINVALID_SOCKET, MyLatch, NULL);
+
+	for (i = 0; i < pParms->dispatchCount; i++)
+	{
+		CdbDispatchResult *dispatchResult = pParms->dispatchResultPtrArray[i];
+
+		if (!dispatchResult->stillRunning)
+			continue;
+
+		AddWaitEventToSet(pParms->waitSet, WL_SOCKET_READABLE,
+						  PQsocket(dispatchResult->segdbDesc->conn),
+						  NULL, dispatchResult);
+	}
+
+	pParms->waitSetSize = nrunning;
+	pParms->waitSetDispatchCount = pParms->dispatchCount;
+	pParms->waitSetStale = false;
 }
 
 /*
@@ -570,6 +634,8 @@ dispatchCommand(CdbDispatchResult *dispatchResult,
 	if (DEBUG1 >= log_min_messages)
 		beforeSend = GetCurrentTimestamp();
 
+	INSTR_TIME_SET_CURRENT(dispatchResult->sendTime);
+
 	/*
 	 * Submit the command asynchronously.
 	 */
@@ -606,107 +672,70 @@ dispatchCommand(CdbDispatchResult *dispatchResult,
 }
 
 /*
- * Helper function to checkDispatchResult that handles errors that occur
- * during the poll() call.
- *
- * NOTE: The cleanup of the connections will be performed by handlePollTimeout().
+ * Receive and process results from the QEs that WaitEventSetWait() reported
+ * ready.
  */
 static void
-handlePollError(CdbDispatchCmdAsync *pParms)
+handleReadyQEs(CdbDispatchCmdAsync *pParms, int nready)
 {
-	int			i;
-
-	for (i = 0; i < pParms->dispatchCount; i++)
-	{
-		CdbDispatchResult *dispatchResult = pParms->dispatchResultPtrArray[i];
-		SegmentDatabaseDescriptor *segdbDesc = dispatchResult->segdbDesc;
-
-		/* Skip if already finished or didn't dispatch. */
-		if (!dispatchResult->stillRunning)
-			continue;
-
-		/* We're done with this QE, sadly. */
-		if (PQstatus(segdbDesc->conn) == CONNECTION_BAD)
-		{
-			char	   *msg = PQerrorMessage(segdbDesc->conn);
-
-			if (msg)
-				elog(LOG, "Dispatcher encountered connection error on %s: %s", segdbDesc->whoami, msg);
-
-			elog(LOG, "Dispatcher noticed bad connection in handlePollError()");
-
-			/* Save error info for later. */
-			cdbdisp_appendMessageNonThread(dispatchResult, LOG,
-										   "Error after dispatch from %s: %s",
-										   segdbDesc->whoami,
-										   msg ? msg : "unknown error");
-
-			PQfinish(segdbDesc->conn);
-			segdbDesc->conn = NULL;
-			dispatchResult->stillRunning = false;
-		}
-	}
-	forwardQENotices();
-
-	return;
-}
-
-/*
- * Receive and process results from QEs.
- */
-static void
-handlePollSuccess(CdbDispatchCmdAsync *pParms,
-				  struct pollfd *fds)
-{
-	int			currentFdNumber = 0;
 	int			i = 0;
 
-	/*
-	 * We have data waiting on one or more of the connections.
-	 */
-	for (i = 0; i < pParms->dispatchCount; i++)
+	for (i = 0; i < nready; i++)
 	{
+		WaitEvent  *event = &pParms->waitEvents[i];
+		CdbDispatchResult *dispatchResult;
+		SegmentDatabaseDescriptor *segdbDesc;
 		bool		finished;
-		int			sock;
-		CdbDispatchResult *dispatchResult = pParms->dispatchResultPtrArray[i];
-		SegmentDatabaseDescriptor *segdbDesc = dispatchResult->segdbDesc;
+		instr_time	starttime;
+		instr_time	endtime;
 
-		/*
-		 * Skip if already finished or didn't dispatch.
-		 */
-		if (!dispatchResult->stillRunning)
+		if (event->events & WL_LATCH_SET)
+		{
+			/* Interrupt; the caller's loop checks InterruptPending */
+			ResetLatch(MyLatch);
 			continue;
+		}
 
-		ELOG_DISPATCHER_DEBUG("looking for results from %d of %d (%s)",
-							  i + 1, pParms->dispatchCount, segdbDesc->whoami);
-
-		sock = PQsocket(segdbDesc->conn);
-		Assert(sock >= 0);
-		Assert(sock == fds[currentFdNumber].fd);
+		dispatchResult = (CdbDispatchResult *) event->user_data;
+		segdbDesc = dispatchResult->segdbDesc;
 
 		/*
-		 * Skip this connection if it has no input available.
+		 * Skip if already finished, and get rid of it before the next wait.
 		 */
-		if (!(fds[currentFdNumber++].revents & POLLIN))
+		if (!dispatchResult->stillRunning)
+		{
+			pParms->waitSetStale = true;
 			continue;
+		}
 
 		ELOG_DISPATCHER_DEBUG("PQsocket says there are results from %d of %d (%s)",
-							  i + 1, pParms->dispatchCount, segdbDesc->whoami);
+							  dispatchResult->meleeIndex + 1, pParms->dispatchCount,
+							  segdbDesc->whoami);
 
 		/*
 		 * Receive and process results from this QE.
 		 */
+		INSTR_TIME_SET_CURRENT(starttime);
+		if (INSTR_TIME_IS_ZERO(dispatchResult->firstResultTime))
+			dispatchResult->firstResultTime = starttime;
+
 		finished = processResults(dispatchResult);
 
+		INSTR_TIME_SET_CURRENT(endtime);
+		INSTR_TIME_ACCUM_DIFF(dispatchResult->processTime, endtime, starttime);
+		INSTR_TIME_ACCUM_DIFF(dispatchResult->meleeResults->processTime, endtime, starttime);
+
 		/*
 		 * Are we through with this QE now?
 		 */
 		if (finished)
 		{
 			dispatchResult->stillRunning = false;
+			dispatchResult->finishTime = endtime;
 
 			ELOG_DISPATCHER_DEBUG("processResults says we are finished with %d of %d (%s)",
-								  i + 1, pParms->dispatchCount, segdbDesc->whoami);
+								  dispatchResult->meleeIndex + 1, pParms->dispatchCount,
+								  segdbDesc->whoami);
 
 			if (DEBUG1 >= log_min_messages)
 			{
@@ -717,7 +746,7 @@ handlePollSuccess(CdbDispatchCmdAsync *pParms,
 					case 1:
 					case 2:
 						elog(LOG, "duration to dispatch result received from %d (seg %d): %s ms",
-							 i + 1, dispatchResult->segdbDesc->segindex, msec_str);
+							 dispatchResult->meleeIndex + 1, segdbDesc->segindex, msec_str);
 						break;
 				}
 			}
@@ -727,7 +756,8 @@ handlePollSuccess(CdbDispatchCmdAsync *pParms,
 		}
 		else
 			ELOG_DISPATCHER_DEBUG("processResults says we have more to do with %d of %d (%s)",
-								  i + 1, pParms->dispatchCount, segdbDesc->whoami);
+								  dispatchResult->meleeIndex + 1, pParms->dispatchCount,
+								  segdbDesc->whoami);
 	}
 }
 
@@ -1017,7 +1047,19 @@ processResults(CdbDispatchResult *dispatchResult)
 	 * to call nextval_qd() again.
 	 */
 	PGnotify *nextval = PQnotifies(segdbDesc->conn);
-	if ((elog_geterrcode() == 0) && nextval &&
+
+	/*
+	 * A QE that was sent only the key of the plan, but doesn't have it
+	 * cached, asks for the plan.
+	 */
+	if (nextval && strcmp(nextval->relname, DISPATCH_PLAN_REQUEST_CHANNEL) == 0)
+	{
+		CdbDispatchResults *meleeResults = dispatchResult->meleeResults;
+
+		cdbdisp_sendRequestedPlan(segdbDesc, meleeResults->cachedPlan,
+								  meleeResults->cachedPlanLen, nextval->extra);
+	}
+	else if ((elog_geterrcode() == 0) && nextval &&
 		strcmp(nextval->relname, "nextval") == 0)
 	{
 		int64 last;
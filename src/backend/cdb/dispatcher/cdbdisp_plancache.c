@@ -0,0 +1,451 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbdisp_plancache.c
+ *	  Caching of dispatched plans on the QEs.
+ *
+ * Dispatching a plan means serializing and compressing it on the QD, and
+ * decompressing and deserializing it on every QE.  For short queries that
+ * are executed over and over, like the executions of a prepared statement,
+ * that can take longer than running the query.
+ *
+ * So each QE keeps the last DISPATCH_PLAN_CACHE_SIZE plans it received,
+ * keyed by a fingerprint of the serialized plan.  To make a hash collision a
+ * practical impossibility, the key also includes a CRC of the serialized
+ * plan and its length, see DispatchPlanKey.  The QD keeps a copy of the list
+ * of keys of each QE in its SegmentDatabaseDescriptor.  When all the QEs of
+ * a query have the plan, the QD sends just the key, and the QEs copy the
+ * plan out of their cache.  Otherwise the QD sends the whole plan along with
+ * the key, and the QEs add it to their cache.
+ *
+ * There's no need for the QE to tell the QD what it has cached.  Both sides
+ * see the same sequence of keys, and use the same replacement policy: a key
+ * that is used moves to the front of the list, and the one at the end falls
+ * off when the list is full.  A QE updates its cache as soon as it has read
+ * the message, before anything can fail.  The QD's list is therefore always
+ * a subset of the QE's, as long as the QE received every message that the QD
+ * recorded.  The other way round is harmless, the QD just sends the plan
+ * again.  If a QE ever doesn't have a plan that the QD thought it had, the
+ * QE asks the QD for it, with a NOTIFY like the one nextval() uses, and the
+ * QD replies with the plan, within the same dispatch.  The QD also forgets
+ * the QE's list whenever the QE reports an error, see cdbdisp_seterrcode(),
+ * so that the two are back in step.  A new QE connection starts out with an
+ * empty list on both sides.
+ *
+ * Portions Copyright (c) 2012-Present VMware, Inc. or its affiliates.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/dispatcher/cdbdisp_plancache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "libpq-fe.h"
+#include "libpq-int.h"
+#include "libpq/libpq.h"
+#include "libpq/pqformat.h"
+#include "miscadmin.h"
+#include "nodes/plannodes.h"
+#include "port/pg_crc32c.h"
+#include "utils/faultinjector.h"
+#include "utils/hashutils.h"
+#include "utils/memutils.h"
+
+#include "cdb/cdbconn.h"
+#include "cdb/cdbdisp_plancache.h"	/* me */
+#include "cdb/cdbsrlz.h"
+#include "cdb/cdbvars.h"
+
+/*
+ * A plan cached on a QE.  Until the plan is first used, we just keep the
+ * serialized form that came with the message.
+ */
+typedef struct QEPlanCacheEntry
+{
+	DispatchPlanKey key;
+	MemoryContext context;		/* holds everything below */
+	char	   *splan;			/* serialized plan, or NULL */
+	int			splan_len;
+	PlannedStmt *plan;			/* deserialized plan, or NULL */
+} QEPlanCacheEntry;
+
+/* Cached plans of this QE, most recently used first */
+static QEPlanCacheEntry qePlanCache[DISPATCH_PLAN_CACHE_SIZE];
+static int	qePlanCacheCount = 0;
+
+static MemoryContext qePlanCacheContext = NULL;
+
+static void qePlanCacheAdd(const DispatchPlanKey *key,
+						   const char *splan, int splan_len);
+static void qePlanCacheRequest(const DispatchPlanKey *key);
+
+static inline bool
+planKeysEqual(const DispatchPlanKey *a, const DispatchPlanKey *b)
+{
+	return a->fingerprint == b->fingerprint &&
+		a->check == b->check &&
+		a->length == b->length;
+}
+
+/* The key of a plan, as the QE asks for it in a NOTIFY */
+static void
+planKeyToString(const DispatchPlanKey *key, char *buf, Size len)
+{
+	snprintf(buf, len, UINT64_FORMAT ":%u:%d",
+			 key->fingerprint, key->check, key->length);
+}
+
+/*
+ * Move a key to the front of a most recently used list.  If it's not in the
+ * list, it is added, and the one at the end falls off if the list is full.
+ * Returns the index it was found at, or -1.
+ */
+static int
+touchPlanKey(DispatchPlanKey *list, int *count, const DispatchPlanKey *key)
+{
+	int			i;
+
+	for (i = 0; i < *count; i++)
+	{
+		if (planKeysEqual(&list[i], key))
+			break;
+	}
+
+	if (i == *count)
+	{
+		if (*count < DISPATCH_PLAN_CACHE_SIZE)
+			(*count)++;
+		memmove(&list[1], &list[0], (*count - 1) * sizeof(DispatchPlanKey));
+		list[0] = *key;
+		return -1;
+	}
+
+	memmove(&list[1], &list[0], i * sizeof(DispatchPlanKey));
+	list[0] = *key;
+	return i;
+}
+
+/*
+ * Compute the key of a serialized plan.  The fingerprint is never 0, which
+ * means "no plan key" in the dispatch message.
+ */
+void
+cdbdisp_planKey(const char *splan, int splan_len, DispatchPlanKey *key)
+{
+	uint64		fingerprint;
+	pg_crc32c	crc;
+
+	fingerprint = DatumGetUInt64(hash_any_extended((const unsigned char *) splan,
+												   splan_len,
+												   (uint64) splan_len));
+	INIT_CRC32C(crc);
+	COMP_CRC32C(crc, splan, splan_len);
+	FIN_CRC32C(crc);
+
+	key->fingerprint = fingerprint != 0 ? fingerprint : 1;
+	key->check = crc;
+	key->length = splan_len;
+}
+
+/*
+ * Does the QE have the plan with this key cached?
+ */
+bool
+cdbdisp_segdbHasPlan(SegmentDatabaseDescriptor *segdbDesc,
+					 const DispatchPlanKey *key)
+{
+	for (int i = 0; i < segdbDesc->numCachedPlans; i++)
+	{
+		if (planKeysEqual(&segdbDesc->cachedPlans[i], key))
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Record that a dispatch message with this key has been sent to the QE.
+ * Keep this in sync with qePlanCacheReceive().
+ */
+void
+cdbdisp_segdbRememberPlan(SegmentDatabaseDescriptor *segdbDesc,
+						  const DispatchPlanKey *key)
+{
+	touchPlanKey(segdbDesc->cachedPlans, &segdbDesc->numCachedPlans, key);
+}
+
+/*
+ * Forget what the QE has cached, so that the next plan dispatched to it is
+ * sent in full.  This is always safe, see the comment at the top.
+ */
+void
+cdbdisp_segdbForgetPlans(SegmentDatabaseDescriptor *segdbDesc)
+{
+	segdbDesc->numCachedPlans = 0;
+}
+
+/*
+ * Answer a QE's request for a plan that it was sent only the key of.
+ *
+ * 'request' is the key that the QE asked for.  If there's no plan, or the
+ * QE asked for a different one, an empty reply tells the QE to give up.
+ */
+void
+cdbdisp_sendRequestedPlan(SegmentDatabaseDescriptor *segdbDesc,
+						  const char *splan, int splan_len,
+						  const char *request)
+{
+	PGconn	   *conn = segdbDesc->conn;
+	DispatchPlanKey key;
+	char		expected[64];
+	int			rc;
+
+	if (splan != NULL)
+	{
+		cdbdisp_planKey(splan, splan_len, &key);
+		planKeyToString(&key, expected, sizeof(expected));
+	}
+	if (splan == NULL || strcmp(request, expected) != 0)
+	{
+		splan = "";
+		splan_len = 0;
+	}
+
+	elog(DEBUG1, "sending dispatched plan %s to %s, which does not have it cached",
+		 request, segdbDesc->whoami);
+
+	if (pqPutMsgStart(DISPATCH_PLAN_RESPONSE, false, conn) < 0 ||
+		pqPutnchar(splan, splan_len, conn) < 0 ||
+		pqPutMsgEnd(conn) < 0)
+		elog(ERROR, "failed to send plan to %s: %s",
+			 segdbDesc->whoami, PQerrorMessage(conn));
+
+	while ((rc = pqFlush(conn)) > 0)
+	{
+		if (pqWait(false, true, conn) < 0)
+		{
+			rc = -1;
+			break;
+		}
+	}
+	if (rc < 0)
+		elog(ERROR, "failed to send plan to %s: %s",
+			 segdbDesc->whoami, PQerrorMessage(conn));
+}
+
+/*
+ * Update the QE's cache for a dispatch message with a plan key.  If the plan
+ * came with the message, it is added to the cache, otherwise the cached plan
+ * becomes the most recently used.  This only copies the serialized plan, so
+ * it can't fail except for running out of memory.
+ */
+void
+qePlanCacheReceive(const DispatchPlanKey *key, const char *splan, int splan_len)
+{
+	QEPlanCacheEntry entry;
+	int			i;
+
+	Assert(key->fingerprint != 0);
+
+#ifdef FAULT_INJECTOR
+	/* Simulate a QE that lost its cache behind the QD's back */
+	if (SIMPLE_FAULT_INJECTOR("qe_plan_cache_receive") == FaultInjectorTypeSkip)
+	{
+		for (i = 0; i < qePlanCacheCount; i++)
+			MemoryContextDelete(qePlanCache[i].context);
+		qePlanCacheCount = 0;
+		return;
+	}
+#endif
+
+	/*
+	 * If the QD didn't send the plan, it thinks we have it.  If we don't,
+	 * qePlanCacheFetch() will ask for it.
+	 */
+	if (splan == NULL)
+	{
+		for (i = 0; i < qePlanCacheCount; i++)
+		{
+			if (planKeysEqual(&qePlanCache[i].key, key))
+			{
+				entry = qePlanCache[i];
+				memmove(&qePlanCache[1], &qePlanCache[0], i * sizeof(QEPlanCacheEntry));
+				qePlanCache[0] = entry;
+				break;
+			}
+		}
+		return;
+	}
+
+	qePlanCacheAdd(key, splan, splan_len);
+}
+
+/*
+ * Add a plan to the QE's cache, as the most recently used.
+ */
+static void
+qePlanCacheAdd(const DispatchPlanKey *key, const char *splan, int splan_len)
+{
+	DispatchPlanKey keys[DISPATCH_PLAN_CACHE_SIZE];
+	QEPlanCacheEntry entry;
+	QEPlanCacheEntry evicted = {0};
+	int			count = qePlanCacheCount;
+	int			i;
+
+	if (splan_len != key->length)
+		elog(ERROR, "dispatched plan has length %d, expected %d",
+			 splan_len, key->length);
+
+	if (qePlanCacheContext == NULL)
+		qePlanCacheContext = AllocSetContextCreate(TopMemoryContext,
+												   "QE plan cache",
+												   ALLOCSET_SMALL_SIZES);
+
+	for (i = 0; i < count; i++)
+		keys[i] = qePlanCache[i].key;
+
+	/* Already cached?  Then it just becomes the most recently used. */
+	i = touchPlanKey(keys, &count, key);
+	if (i >= 0)
+	{
+		entry = qePlanCache[i];
+		memmove(&qePlanCache[1], &qePlanCache[0], i * sizeof(QEPlanCacheEntry));
+		qePlanCache[0] = entry;
+		return;
+	}
+
+	entry.key = *key;
+	entry.context = AllocSetContextCreate(qePlanCacheContext,
+										  "QE cached plan",
+										  ALLOCSET_DEFAULT_SIZES);
+	entry.splan = MemoryContextAlloc(entry.context, splan_len);
+	memcpy(entry.splan, splan, splan_len);
+	entry.splan_len = splan_len;
+	entry.plan = NULL;
+
+	if (qePlanCacheCount == DISPATCH_PLAN_CACHE_SIZE)
+		evicted = qePlanCache[DISPATCH_PLAN_CACHE_SIZE - 1];
+	memmove(&qePlanCache[1], &qePlanCache[0],
+			(count - 1) * sizeof(QEPlanCacheEntry));
+	qePlanCache[0] = entry;
+	qePlanCacheCount = count;
+
+	if (evicted.context)
+		MemoryContextDelete(evicted.context);
+}
+
+/*
+ * Get a copy of a cached plan, in the current memory context.
+ *
+ * The executor and exec_mpp_query() modify the plan they're given, so the
+ * cached copy is never handed out.  Copying a plan is still a lot cheaper
+ * than decompressing and deserializing it.
+ */
+PlannedStmt *
+qePlanCacheFetch(const DispatchPlanKey *key)
+{
+	QEPlanCacheEntry *entry = NULL;
+
+	for (int i = 0; i < qePlanCacheCount; i++)
+	{
+		if (planKeysEqual(&qePlanCache[i].key, key))
+		{
+			entry = &qePlanCache[i];
+			break;
+		}
+	}
+
+	/* The QD thought we had it, but we don't.  Ask for it. */
+	if (entry == NULL)
+	{
+		qePlanCacheRequest(key);
+		entry = &qePlanCache[0];
+	}
+
+	/* Deserialize it on first use */
+	if (entry->plan == NULL)
+	{
+		MemoryContext oldcxt = MemoryContextSwitchTo(entry->context);
+		PlannedStmt *plan;
+
+		plan = (PlannedStmt *) deserializeNode(entry->splan, entry->splan_len);
+		if (!plan || !IsA(plan, PlannedStmt))
+			elog(ERROR, "MPPEXEC: receive invalid planned statement");
+
+		pfree(entry->splan);
+		entry->splan = NULL;
+		entry->plan = plan;
+		MemoryContextSwitchTo(oldcxt);
+	}
+
+	return copyObject(entry->plan);
+}
+
+/*
+ * Ask the QD for a plan that we were sent only the key of, but don't have
+ * cached, and add it to the cache as the most recently used.
+ *
+ * This is the same exchange that cdb_sequence_nextval_qe() uses: a NOTIFY
+ * to the QD, which is busy waiting for the results of the dispatch, and a
+ * reply on the same connection.
+ */
+static void
+qePlanCacheRequest(const DispatchPlanKey *key)
+{
+	StringInfoData buf;
+	char		request[64];
+	unsigned char qtype;
+	int			retval;
+	DispatchPlanKey received;
+
+	planKeyToString(key, request, sizeof(request));
+	elog(DEBUG1, "dispatched plan %s is not cached, requesting it from the QD",
+		 request);
+
+	pq_beginmessage(&buf, 'A');
+	pq_sendint(&buf, gp_session_id, sizeof(int32));
+	pq_sendstring(&buf, DISPATCH_PLAN_REQUEST_CHANNEL);
+	pq_sendstring(&buf, request);
+	pq_endmessage(&buf);
+	pq_flush();
+
+	do
+	{
+		pq_startmsgread();
+		retval = pq_getbyte_if_available(&qtype);
+		if (retval == 0)
+		{
+			pq_endmsgread();
+			CHECK_FOR_INTERRUPTS();
+		}
+
+		if (retval == EOF)
+			ereport(ERROR,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("dispatched plan: connection is gone unexpectedly")));
+	} while (retval != 1);
+	if (qtype == 'X')
+		ereport(ERROR, (errcode(ERRCODE_INTERNAL_ERROR),
+						errmsg("dispatched plan: QD closed the connection")));
+	if (qtype != DISPATCH_PLAN_RESPONSE)
+		ereport(ERROR, (errcode(ERRCODE_INTERNAL_ERROR),
+						errmsg("dispatched plan: unexpected message type='%c'", qtype)));
+
+	initStringInfo(&buf);
+	if (pq_getmessage(&buf, 0) != 0)
+		elog(ERROR, "dispatched plan: unable to read the plan from the QD");
+
+	if (buf.len == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("dispatched plan %s is not cached", request),
+				 errdetail("The query dispatcher could not send the plan again.")));
+
+	cdbdisp_planKey(buf.data, buf.len, &received);
+	if (!planKeysEqual(&received, key))
+		elog(ERROR, "dispatched plan: the QD sent a different plan than %s",
+			 request);
+
+	qePlanCacheAdd(key, buf.data, buf.len);
+	pfree(buf.data);
+}
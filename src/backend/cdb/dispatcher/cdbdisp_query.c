@@ -43,6 +43,7 @@
 
 #include "cdb/cdbdisp.h"
 #include "cdb/cdbdisp_query.h"
+#include "cdb/cdbdisp_plancache.h"
 #include "cdb/cdbdisp_dtx.h"	/* for qdSerializeDtxContextInfo() */
 #include "cdb/cdbdispatchresult.h"
 #include "cdb/cdbcopy.h"
@@ -82,6 +83,8 @@ typedef struct DispatchCommandQueryParms
 	int			strCommandlen;
 	char	   *serializedPlantree;
 	int			serializedPlantreelen;
+	DispatchPlanKey planKey;	/* fingerprint 0 if the QEs shouldn't cache
+								 * the plan */
 	char	   *serializedQueryDispatchDesc;
 	int			serializedQueryDispatchDesclen;
 
@@ -98,6 +101,8 @@ typedef struct DispatchCommandQueryParms
 	int			serializedDtxContextInfolen;
 } DispatchCommandQueryParms;
 
+static bool planCachedOnAllQEs(SliceVec *sliceVector, int nSlices,
+							   const DispatchPlanKey *key);
 static int fillSliceVector(SliceTable *sliceTable,
 				int sliceIndex,
 				SliceVec *sliceVector,
@@ -658,6 +663,11 @@ cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 	pQueryParms->strCommand = queryDesc->sourceText;
 	pQueryParms->serializedPlantree = splan;
 	pQueryParms->serializedPlantreelen = splan_len;
+
+	/* Let the QEs cache the plan, if it's not too big. */
+	if (gp_dispatch_cache_plans &&
+		splan_len_uncompressed <= DISPATCH_PLAN_CACHE_MAX_SIZE)
+		cdbdisp_planKey(splan, splan_len, &pQueryParms->planKey);
 	pQueryParms->serializedQueryDispatchDesc = sddesc;
 	pQueryParms->serializedQueryDispatchDesclen = sddesc_len;
 
@@ -841,6 +851,31 @@ fillSliceVector(SliceTable *sliceTbl, int rootIdx,
 	return top_count;
 }
 
+/*
+ * Do all the QEs that a plan is dispatched to have it cached?
+ */
+static bool
+planCachedOnAllQEs(SliceVec *sliceVector, int nSlices,
+				   const DispatchPlanKey *key)
+{
+	for (int iSlice = 0; iSlice < nSlices; iSlice++)
+	{
+		ExecSlice  *slice = sliceVector[iSlice].slice;
+		Gang	   *gang;
+
+		if (slice->gangType == GANGTYPE_UNALLOCATED)
+			continue;
+
+		gang = slice->primaryGang;
+		for (int i = 0; i < gang->size; i++)
+		{
+			if (!cdbdisp_segdbHasPlan(gang->db_descriptors[i], key))
+				return false;
+		}
+	}
+	return true;
+}
+
 /*
  * Build a query string to be dispatched to QE.
  */
@@ -852,6 +887,7 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 	int			command_len;
 	const char *plantree = pQueryParms->serializedPlantree;
 	int			plantree_len = pQueryParms->serializedPlantreelen;
+	const DispatchPlanKey *planKey = &pQueryParms->planKey;
 	const char *sddesc = pQueryParms->serializedQueryDispatchDesc;
 	int			sddesc_len = pQueryParms->serializedQueryDispatchDesclen;
 	const char *dtxContextInfo = pQueryParms->serializedDtxContextInfo;
@@ -888,7 +924,7 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 	 * character.
 	 */
 	command_len = strlen(command) + 1;
-	if (plantree && command_len > QUERY_STRING_TRUNCATE_SIZE)
+	if ((plantree || planKey->fingerprint) && command_len > QUERY_STRING_TRUNCATE_SIZE)
 		command_len = pg_mbcliplen(command, command_len,
 								   QUERY_STRING_TRUNCATE_SIZE-1) + 1;
 
@@ -905,6 +941,7 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 		sizeof(n32) * 2 /* currentStatementStartTimestamp */ +
 		sizeof(command_len) +
 		sizeof(plantree_len) +
+		sizeof(n32) * 4 /* planKey */ +
 		sizeof(sddesc_len) +
 		sizeof(dtxContextInfo_len) +
 		dtxContextInfo_len +
@@ -963,6 +1000,19 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 	memcpy(pos, &tmp, sizeof(plantree_len));
 	pos += sizeof(plantree_len);
 
+	n32 = htonl((uint32) (planKey->fingerprint >> 32));
+	memcpy(pos, &n32, sizeof(n32));
+	pos += sizeof(n32);
+	n32 = htonl((uint32) planKey->fingerprint);
+	memcpy(pos, &n32, sizeof(n32));
+	pos += sizeof(n32);
+	n32 = htonl(planKey->check);
+	memcpy(pos, &n32, sizeof(n32));
+	pos += sizeof(n32);
+	n32 = htonl((uint32) planKey->length);
+	memcpy(pos, &n32, sizeof(n32));
+	pos += sizeof(n32);
+
 	tmp = htonl(sddesc_len);
 	memcpy(pos, &tmp, sizeof(tmp));
 	pos += sizeof(tmp);
@@ -1047,6 +1097,9 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 	CdbDispatcherState *ds;
 	ErrorData *qeError = NULL;
 	DispatchCommandQueryParms *pQueryParms;
+	bool		planCached;
+	const char *splan = NULL;
+	int			splan_len = 0;
 
 	if (log_dispatch_stats)
 		ResetUsage();
@@ -1080,7 +1133,26 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 	/* Each slice table has a unique-id. */
 	sliceTbl->ic_instance_id = ++gp_interconnect_id;
 
+	/* The shared-memory rings are named after this, see ic_shm.c */
+	if (gp_interconnect_local_shm &&
+		!pg_strong_random(&sliceTbl->ic_shm_nonce, sizeof(sliceTbl->ic_shm_nonce)))
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not generate random interconnect shared memory ring name")));
+
 	pQueryParms = cdbdisp_buildPlanQueryParms(queryDesc, planRequiresTxn);
+
+	/* If all the QEs have the plan cached already, send just its key */
+	planCached = (pQueryParms->planKey.fingerprint != 0 &&
+				  planCachedOnAllQEs(sliceVector, nSlices, &pQueryParms->planKey));
+	if (planCached)
+	{
+		splan = pQueryParms->serializedPlantree;
+		splan_len = pQueryParms->serializedPlantreelen;
+		pQueryParms->serializedPlantree = NULL;
+		pQueryParms->serializedPlantreelen = 0;
+	}
+
 	queryText = buildGpQueryString(pQueryParms, &queryTextLength);
 
 	/*
@@ -1088,6 +1160,17 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 	 */
 	cdbdisp_makeDispatchResults(ds, nTotalSlices, cancelOnError);
 	cdbdisp_makeDispatchParams(ds, nTotalSlices, queryText, queryTextLength);
+	ds->primaryResults->saveStats = true;
+	ds->primaryResults->planCached = planCached;
+
+	/* Keep the plan for a QE that turns out not to have it after all */
+	if (planCached)
+	{
+		ds->primaryResults->cachedPlan =
+			MemoryContextAlloc(DispatcherContext, splan_len);
+		memcpy(ds->primaryResults->cachedPlan, splan, splan_len);
+		ds->primaryResults->cachedPlanLen = splan_len;
+	}
 
 	cdb_total_plans++;
 	cdb_total_slices += nSlices;
@@ -1161,6 +1244,14 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 		if (planRequiresTxn || isDtxExplicitBegin())
 			addToGxactDtxSegments(primaryGang);
 
+		/* The QEs update their plan cache when they read the message */
+		if (pQueryParms->planKey.fingerprint != 0)
+		{
+			for (int i = 0; i < primaryGang->size; i++)
+				cdbdisp_segdbRememberPlan(primaryGang->db_descriptors[i],
+										  &pQueryParms->planKey);
+		}
+
 		SIMPLE_FAULT_INJECTOR("after_one_slice_dispatched");
 	}
 
@@ -223,6 +223,14 @@ cdbdisp_seterrcode(int errcode, /* ERRCODE_xxx or 0 */
 		dispatchResult->errcode = errcode;
 	}
 
+	/*
+	 * The QE might not have read our last message, or it might not have the
+	 * plan that we thought it had.  Either way, don't trust our record of
+	 * its plan cache anymore; the next plan is sent to it in full.
+	 */
+	if (dispatchResult->segdbDesc)
+		cdbdisp_segdbForgetPlans(dispatchResult->segdbDesc);
+
 	if (!meleeResults)
 		return;
 
@@ -840,6 +848,7 @@ cdbdisp_makeDispatchResults(CdbDispatcherState *ds,
 	results->iFirstError = -1;
 	results->errcode = 0;
 	results->cancelOnError = cancelOnError;
+	INSTR_TIME_SET_CURRENT(results->startTime);
 
 	results->sliceMap = NULL;
 	results->sliceCapacity = sliceCapacity;
@@ -701,6 +701,9 @@ void DisconnectAndDestroyUnusedQEs(void)
 		 */
 		cdbcomponent_cleanupIdleQEs(true);
 	}
+
+	/* Connect them again ahead of the next query, see cdbgang_prewarm() */
+	NeedGangPrewarm = true;
 }
 
 /*
@@ -36,7 +36,15 @@
 #include "cdb/cdbtm.h"
 #include "cdb/cdbvars.h"
 #include "miscadmin.h"
+#include "replication/walsender.h"
 
+/*
+ * Set when the QD should start connecting QEs ahead of time at the next
+ * opportunity: at session start, and after idle QEs were released.
+ */
+bool		NeedGangPrewarm = true;
+
+static void startQEConnection(SegmentDatabaseDescriptor *segdbDesc, int totalSegs);
 static int	getPollTimeout(const struct timeval *startTS);
 
 /*
@@ -121,10 +129,6 @@ create_gang_retry:
 	{
 		for (i = 0; i < size; i++)
 		{
-			bool		ret;
-			char		gpqeid[100];
-			char	   *options;
-
 			/*
 			 * Create the connection requests.	If we find a segment without a
 			 * valid segdb we error out.  Also, if this segdb is invalid, we
@@ -132,6 +136,17 @@ create_gang_retry:
 			 */
 			segdbDesc = newGangDefinition->db_descriptors[i];
 
+			/*
+			 * If cdbgang_prewarm() already started the connection, pick up
+			 * polling where it left off.
+			 */
+			if (segdbDesc->prewarming)
+			{
+				connStatusDone[i] = false;
+				pollingStatus[i] = segdbDesc->prewarmPollStatus;
+				continue;
+			}
+
 			/* if it's a cached QE, skip */
 			if (segdbDesc->conn != NULL && !cdbconn_isBadConnection(segdbDesc))
 			{
@@ -140,26 +155,7 @@ create_gang_retry:
 				continue;
 			}
 
-			/*
-			 * Build the connection string.  Writer-ness needs to be processed
-			 * early enough now some locks are taken before command line
-			 * options are recognized.
-			 */
-			ret = build_gpqeid_param(gpqeid, sizeof(gpqeid),
-									 segdbDesc->isWriter,
-									 segdbDesc->identifier,
-									 segdbDesc->segment_database_info->hostSegs,
-									 totalSegs * 2);
-
-			if (!ret)
-				ereport(ERROR,
-						(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-						 errmsg("failed to construct connectionstring")));
-
-			options = makeOptions();
-
-			/* start connection in asynchronous way */
-			cdbconn_doConnectStart(segdbDesc, gpqeid, options);
+			startQEConnection(segdbDesc, totalSegs);
 
 			if (cdbconn_isBadConnection(segdbDesc))
 				ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
@@ -205,6 +201,7 @@ create_gang_retry:
 				switch (pollingStatus[i])
 				{
 					case PGRES_POLLING_OK:
+						segdbDesc->prewarming = false;
 						cdbconn_doConnectComplete(segdbDesc);
 						if (segdbDesc->motionListener == 0)
 							ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
@@ -228,6 +225,31 @@ create_gang_retry:
 						break;
 
 					case PGRES_POLLING_FAILED:
+						if (segdbDesc->prewarming)
+						{
+							/*
+							 * The pre-warmed connection went stale while the
+							 * session was idle, e.g. authentication_timeout
+							 * expired on the segment.  Start over with a
+							 * fresh one.
+							 */
+							PQfinish(segdbDesc->conn);
+							segdbDesc->conn = NULL;
+							segdbDesc->prewarming = false;
+
+							startQEConnection(segdbDesc, totalSegs);
+							if (cdbconn_isBadConnection(segdbDesc))
+								ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+												errmsg("failed to acquire resources on one or more segments"),
+												errdetail("%s (%s)", PQerrorMessage(segdbDesc->conn), segdbDesc->whoami)));
+
+							pollingStatus[i] = PGRES_POLLING_WRITING;
+							fds[nfds].fd = PQsocket(segdbDesc->conn);
+							fds[nfds].events = POLLOUT;
+							nfds++;
+							break;
+						}
+
 						if (segment_failure_due_to_recovery(PQerrorMessage(segdbDesc->conn)))
 						{
 							in_recovery_mode_count++;
@@ -352,6 +374,152 @@ create_gang_retry:
 	return newGangDefinition;
 }
 
+/*
+ * Start connecting QEs before a query needs them.
+ *
+ * Called on the QD at the start of a transaction when NeedGangPrewarm is set.
+ * For every primary segment that is up, create idle QEs until there are
+ * gp_gang_prewarm_size of them, and start their connections.  We only wait
+ * until the startup packets are on the wire: the segments then fork and
+ * initialize the QEs while this backend parses and plans, or waits for the
+ * client, and cdbgang_createGang_async() finishes the handshake when the QEs
+ * are allocated to a gang.
+ *
+ * Nothing is reported here if a connection can't be started; the QE is just
+ * connected again the usual way when it's allocated, and that reports it.
+ */
+void
+cdbgang_prewarm(void)
+{
+	SegmentDatabaseDescriptor **started;
+	SegmentDatabaseDescriptor *segdbDesc;
+	struct pollfd *fds;
+	struct timeval startTS;
+	int			nstarted = 0;
+	int			totalSegs;
+	int			content;
+	int			i;
+
+	if (Gp_role != GP_ROLE_DISPATCH || am_walsender || !IsTransactionState())
+		return;
+
+	NeedGangPrewarm = false;
+
+	if (gp_gang_prewarm_size <= 0)
+		return;
+
+	SIMPLE_FAULT_INJECTOR("cdbgang_prewarm");
+
+	totalSegs = getgpsegmentCount();
+	started = palloc(sizeof(SegmentDatabaseDescriptor *) * totalSegs * gp_gang_prewarm_size);
+
+	for (content = 0; content < totalSegs; content++)
+	{
+		CdbComponentDatabaseInfo *cdi = cdbcomponent_getComponentInfo(content);
+
+		if (FtsIsSegmentDown(cdi))
+			continue;
+
+		while (cdi->numIdleQEs + cdi->numActiveQEs < gp_gang_prewarm_size)
+		{
+			segdbDesc = cdbcomponent_createIdleQE(content);
+
+			startQEConnection(segdbDesc, totalSegs);
+			if (cdbconn_isBadConnection(segdbDesc))
+			{
+				PQfinish(segdbDesc->conn);
+				segdbDesc->conn = NULL;
+				break;
+			}
+
+			segdbDesc->prewarming = true;
+			segdbDesc->prewarmPollStatus = PGRES_POLLING_WRITING;
+			started[nstarted++] = segdbDesc;
+		}
+	}
+
+	ELOG_DISPATCHER_DEBUG("cdbgang_prewarm: started %d connections", nstarted);
+
+	/* Push the startup packets out */
+	gettimeofday(&startTS, NULL);
+	fds = palloc(sizeof(struct pollfd) * Max(nstarted, 1));
+
+	for (;;)
+	{
+		int			poll_timeout = getPollTimeout(&startTS);
+		int			nfds = 0;
+		int			nready;
+
+		for (i = 0; i < nstarted; i++)
+		{
+			if (started[i]->prewarmPollStatus != PGRES_POLLING_WRITING)
+				continue;
+			fds[nfds].fd = PQsocket(started[i]->conn);
+			fds[nfds].events = POLLOUT;
+			nfds++;
+		}
+
+		if (nfds == 0 || poll_timeout == 0)
+			break;
+
+		CHECK_FOR_INTERRUPTS();
+
+		nready = poll(fds, nfds, poll_timeout);
+		if (nready < 0)
+		{
+			if (SOCK_ERRNO == EINTR)
+				continue;
+			break;
+		}
+
+		nfds = 0;
+		for (i = 0; i < nstarted; i++)
+		{
+			if (started[i]->prewarmPollStatus != PGRES_POLLING_WRITING)
+				continue;
+
+			if (fds[nfds].revents & (POLLOUT | POLLERR | POLLHUP | POLLNVAL))
+				started[i]->prewarmPollStatus = PQconnectPoll(started[i]->conn);
+			nfds++;
+		}
+	}
+
+	pfree(fds);
+	pfree(started);
+}
+
+/*
+ * Start connecting to the QE in asynchronous way.  The caller checks for a
+ * bad connection and drives it with PQconnectPoll().
+ */
+static void
+startQEConnection(SegmentDatabaseDescriptor *segdbDesc, int totalSegs)
+{
+	bool		ret;
+	char		gpqeid[100];
+	char	   *options;
+
+	/*
+	 * Build the connection string.  Writer-ness needs to be processed early
+	 * enough now some locks are taken before command line options are
+	 * recognized.
+	 */
+	ret = build_gpqeid_param(gpqeid, sizeof(gpqeid),
+							 segdbDesc->isWriter,
+							 segdbDesc->identifier,
+							 segdbDesc->segment_database_info->hostSegs,
+							 totalSegs * 2);
+
+	if (!ret)
+		ereport(ERROR,
+				(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+				 errmsg("failed to construct connectionstring")));
+
+	options = makeOptions();
+
+	cdbconn_doConnectStart(segdbDesc, gpqeid, options);
+}
+
 static int
 getPollTimeout(const struct timeval *startTS)
 {
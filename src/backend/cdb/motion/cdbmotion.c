@@ -69,6 +69,22 @@ static void processIncomingChunks(MotionLayerState *mlStates,
 					  int16 srcRoute);
 
 static inline void reconstructTuple(MotionNodeEntry *pMNEntry, ChunkSorterEntry *pCSEntry, TupleRemapper *remapper);
+static SendReturnCode sendTupleToBatch(MotionLayerState *mlStates,
+									   ChunkTransportState *transportStates,
+									   MotionNodeEntry *pMNEntry,
+									   int16 motNodeID,
+									   TupleTableSlot *slot,
+									   int16 targetRoute);
+static bool sendTupleBatch(MotionLayerState *mlStates,
+						   ChunkTransportState *transportStates,
+						   MotionNodeEntry *pMNEntry,
+						   int16 motNodeID,
+						   int16 targetRoute,
+						   TupleBatch *batch);
+static void flushTupleBatches(MotionLayerState *mlStates,
+							  ChunkTransportState *transportStates,
+							  MotionNodeEntry *pMNEntry,
+							  int16 motNodeID);
 
 /* Stats-function declarations. */
 static void statSendTuple(MotionLayerState *mlStates, MotionNodeEntry *pMNEntry, TupleChunkList tcList);
@@ -101,7 +117,17 @@ reconstructTuple(MotionNodeEntry *pMNEntry, ChunkSorterEntry *pCSEntry, TupleRem
 	clearTCList(NULL, &pCSEntry->chunk_list);
 
 	if (!tup)
+	{
+		/* It might have been a batch of tuples */
+		for (int i = 0; i < pSerInfo->nrecvTuples; i++)
+		{
+			tup = TRCheckAndRemap(remapper, pSerInfo->tupdesc, pSerInfo->recvTuples[i]);
+			htfifo_addtuple(pCSEntry->ready_tuples, tup);
+			statNewTupleArrived(pMNEntry, pCSEntry);
+		}
+		pSerInfo->nrecvTuples = 0;
 		return;
+	}
 
 	tup = TRCheckAndRemap(remapper, pSerInfo->tupdesc, tup);
 
@@ -122,18 +148,27 @@ reconstructTuple(MotionNodeEntry *pMNEntry, ChunkSorterEntry *pCSEntry, TupleRem
 void
 RemoveMotionLayer(MotionLayerState *mlStates)
 {
+	InterconnectStats stats;
+
 	if (!mlStates)
 		return;
 
 	if (Gp_role == GP_ROLE_UTILITY)
 		return;
 
+	memset(&stats, 0, sizeof(stats));
+	stats.chunksSent = mlStates->stat_total_chunks_sent;
+	stats.bytesSent = mlStates->stat_total_bytes_sent;
+	stats.chunksRecvd = mlStates->stat_total_chunks_recvd;
+	stats.bytesRecvd = mlStates->stat_total_bytes_recvd;
+	AddInterconnectStats(&stats);
+
 #ifdef AMS_VERBOSE_LOGGING
 	/* Emit statistics to log */
 	if (gp_log_interconnect >= GPVARS_VERBOSITY_VERBOSE)
 		elog(LOG, "RemoveMotionLayer(): dumping stats\n"
-			 "      Sent: %9u chunks %9u total bytes %9u tuple bytes\n"
-			 "  Received: %9u chunks %9u total bytes %9u tuple bytes; "
+			 "      Sent: " UINT64_FORMAT " chunks " UINT64_FORMAT " total bytes " UINT64_FORMAT " tuple bytes\n"
+			 "  Received: " UINT64_FORMAT " chunks " UINT64_FORMAT " total bytes " UINT64_FORMAT " tuple bytes; "
 			 "%9u chunkproc calls\n",
 			 mlStates->stat_total_chunks_sent,
 			 mlStates->stat_total_bytes_sent,
@@ -247,7 +282,8 @@ createMotionLayerState(int maxMotNodeID)
  * This function is called from:  ExecInitMotion()
  */
 void
-UpdateMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool preserveOrder, TupleDesc tupDesc)
+UpdateMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool preserveOrder,
+					  bool compressTuples, int batchSize, TupleDesc tupDesc)
 {
 	MemoryContext oldCtxt;
 	MotionNodeEntry *pEntry;
@@ -273,6 +309,17 @@ UpdateMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool preserve
 	pEntry->preserve_order = preserveOrder;
 	pEntry->tuple_desc = CreateTupleDescCopy(tupDesc);
 	InitSerTupInfo(pEntry->tuple_desc, &pEntry->ser_tup_info);
+	pEntry->ser_tup_info.compress = compressTuples;
+
+	/*
+	 * The planner asks for batches when the rows are narrow, but only some
+	 * data types can be packed column-wise.  Receivers decode whatever
+	 * arrives, so this is for the sender alone to decide.
+	 */
+	if (batchSize > 1 && SerTupInfoCanBatch(&pEntry->ser_tup_info))
+		pEntry->ser_tup_info.batchSize = batchSize;
+	pEntry->send_batches = NULL;
+	pEntry->num_send_batches = 0;
 
 	if (!preserveOrder)
 	{
@@ -460,6 +507,10 @@ SendTuple(MotionLayerState *mlStates,
 	 */
 	pMNEntry = getMotionNodeEntry(mlStates, motNodeID);
 
+	if (pMNEntry->ser_tup_info.batchSize > 0)
+		return sendTupleToBatch(mlStates, transportStates, pMNEntry,
+								motNodeID, slot, targetRoute);
+
 #ifdef AMS_VERBOSE_LOGGING
 	elog(DEBUG5, "Serializing HeapTuple for sending.");
 #endif
@@ -521,6 +572,113 @@ SendTuple(MotionLayerState *mlStates,
 	return rc;
 }
 
+/*
+ * Add a tuple to the batch for its route, and send the batch if it is full.
+ */
+static SendReturnCode
+sendTupleToBatch(MotionLayerState *mlStates,
+				 ChunkTransportState *transportStates,
+				 MotionNodeEntry *pMNEntry,
+				 int16 motNodeID,
+				 TupleTableSlot *slot,
+				 int16 targetRoute)
+{
+	TupleBatch *batch;
+	MemoryContext oldCtxt;
+	int			idx;
+	bool		full;
+
+	oldCtxt = MemoryContextSwitchTo(mlStates->motion_layer_mctx);
+
+	if (pMNEntry->send_batches == NULL)
+	{
+		ChunkTransportStateEntry *pEntry = NULL;
+
+		/* One batch per connection, plus one for broadcasts */
+		getChunkTransportState(transportStates, motNodeID, &pEntry);
+		pMNEntry->num_send_batches = pEntry->numConns + 1;
+		pMNEntry->send_batches =
+			palloc0(pMNEntry->num_send_batches * sizeof(TupleBatch *));
+	}
+
+	if (targetRoute == BROADCAST_SEGIDX)
+		idx = pMNEntry->num_send_batches - 1;
+	else
+	{
+		Assert(targetRoute >= 0 && targetRoute < pMNEntry->num_send_batches - 1);
+		idx = targetRoute;
+	}
+
+	batch = pMNEntry->send_batches[idx];
+	if (batch == NULL)
+		batch = pMNEntry->send_batches[idx] = CreateTupleBatch(&pMNEntry->ser_tup_info);
+
+	full = AddTupleToBatch(batch, slot, &pMNEntry->ser_tup_info);
+
+	MemoryContextSwitchTo(oldCtxt);
+
+	if (full &&
+		!sendTupleBatch(mlStates, transportStates, pMNEntry, motNodeID, targetRoute, batch))
+		return STOP_SENDING;
+
+	return SEND_COMPLETE;
+}
+
+/*
+ * Serialize a batch of tuples and send it.  Returns false if the receiver
+ * asked us to stop sending.
+ */
+static bool
+sendTupleBatch(MotionLayerState *mlStates,
+			   ChunkTransportState *transportStates,
+			   MotionNodeEntry *pMNEntry,
+			   int16 motNodeID,
+			   int16 targetRoute,
+			   TupleBatch *batch)
+{
+	TupleChunkListData tcList;
+	MemoryContext oldCtxt;
+	bool		ok;
+
+	oldCtxt = MemoryContextSwitchTo(mlStates->motion_layer_mctx);
+	SerializeTupleBatch(batch, &pMNEntry->ser_tup_info, &tcList);
+	MemoryContextSwitchTo(oldCtxt);
+
+	ok = SendTupleChunkToAMS(mlStates, transportStates, motNodeID, targetRoute, tcList.p_first);
+	if (!ok)
+		pMNEntry->stopped = true;
+	else
+		statSendTuple(mlStates, pMNEntry, &tcList);
+
+	clearTCList(&pMNEntry->ser_tup_info.chunkCache, &tcList);
+
+	return ok;
+}
+
+/*
+ * Send out any partially filled batches of tuples.
+ */
+static void
+flushTupleBatches(MotionLayerState *mlStates,
+				  ChunkTransportState *transportStates,
+				  MotionNodeEntry *pMNEntry,
+				  int16 motNodeID)
+{
+	for (int i = 0; i < pMNEntry->num_send_batches; i++)
+	{
+		TupleBatch *batch = pMNEntry->send_batches[i];
+		int16		targetRoute;
+
+		if (batch == NULL || batch->ntuples == 0)
+			continue;
+
+		targetRoute = (i == pMNEntry->num_send_batches - 1) ? BROADCAST_SEGIDX : i;
+		if (!sendTupleBatch(mlStates, transportStates, pMNEntry, motNodeID,
+							targetRoute, batch))
+			break;
+	}
+}
+
 TupleChunkListItem
 get_eos_tuplechunklist(void)
 {
@@ -545,6 +703,10 @@ SendEndOfStream(MotionLayerState *mlStates,
 	 */
 	pMNEntry = getMotionNodeEntry(mlStates, motNodeID);
 
+	/* The receivers must get all batched tuples before end-of-stream */
+	if (pMNEntry->send_batches != NULL && !pMNEntry->stopped)
+		flushTupleBatches(mlStates, transportStates, pMNEntry, motNodeID);
+
 	transportStates->SendEos(transportStates, motNodeID, s_eos_chunk_data);
 
 	/*
@@ -851,6 +1013,46 @@ EndMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool flushCommLa
 	pMNEntry->valid = false;
 }
 
+void
+GetMotionCompressionStats(MotionLayerState *mlStates, int16 motNodeID,
+						  uint64 *rawBytes, uint64 *compressedBytes)
+{
+	MotionNodeEntry *pMNEntry;
+
+	*rawBytes = 0;
+	*compressedBytes = 0;
+
+	/* The node may already have been cleaned up */
+	if (mlStates == NULL || motNodeID < 1 || motNodeID > mlStates->mneCount)
+		return;
+	pMNEntry = &mlStates->mnEntries[motNodeID - 1];
+	if (!pMNEntry->valid)
+		return;
+
+	*rawBytes = pMNEntry->ser_tup_info.rawBytes;
+	*compressedBytes = pMNEntry->ser_tup_info.compressedBytes;
+}
+
+void
+GetMotionBatchStats(MotionLayerState *mlStates, int16 motNodeID,
+					uint64 *batches, uint64 *batchedTuples)
+{
+	MotionNodeEntry *pMNEntry;
+
+	*batches = 0;
+	*batchedTuples = 0;
+
+	/* The node may already have been cleaned up */
+	if (mlStates == NULL || motNodeID < 1 || motNodeID > mlStates->mneCount)
+		return;
+	pMNEntry = &mlStates->mnEntries[motNodeID - 1];
+	if (!pMNEntry->valid)
+		return;
+
+	*batches = pMNEntry->ser_tup_info.batches;
+	*batchedTuples = pMNEntry->ser_tup_info.batchedTuples;
+}
+
 /*
  * Helper function to get the motion node entry for a given ID.  NULL
  * is returned if the ID is unrecognized.
@@ -19,8 +19,11 @@
 #include "nodes/execnodes.h"	/* ExecSlice, SliceTable */
 #include "miscadmin.h"
 #include "libpq/libpq-be.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
 #include "utils/builtins.h"
 #include "utils/memutils.h"
+#include "utils/timestamp.h"
 
 #include "cdb/ml_ipc.h"
 #include "cdb/cdbvars.h"
@@ -28,6 +31,7 @@
 
 #include <unistd.h>
 #include <arpa/inet.h>
+#include <sys/resource.h>
 #include <sys/time.h>
 #include <netinet/in.h>
 
@@ -45,8 +49,18 @@ typedef struct interconnect_handle_t
 	ResourceOwner owner;	/* owner of this handle */
 	struct interconnect_handle_t *next;
 	struct interconnect_handle_t *prev;
+
+	/* For InterconnectStats: when the interconnect was set up */
+	TimestampTz setupTime;
+	uint64		setupCpuUsecs;
 } interconnect_handle_t;
 
+typedef struct InterconnectStatsShared
+{
+	slock_t		mutex;
+	InterconnectStats stats;
+} InterconnectStatsShared;
+
 /*=========================================================================
  * GLOBAL STATE VARIABLES
  */
@@ -58,6 +72,11 @@ int			UDP_listenerFd;
 static interconnect_handle_t *open_interconnect_handles;
 static bool interconnect_resowner_callback_registered;
 
+static InterconnectStatsShared *interconnectStats = NULL;
+
+/* the same statistics, for the interconnects of this backend alone */
+static InterconnectStats backendInterconnectStats;
+
 /*=========================================================================
  * FUNCTIONS PROTOTYPES
  */
@@ -70,6 +89,8 @@ static void cleanup_interconnect_handle(interconnect_handle_t *h);
 static interconnect_handle_t *allocate_interconnect_handle(void);
 static void destroy_interconnect_handle(interconnect_handle_t *h);
 static interconnect_handle_t *find_interconnect_handle(ChunkTransportState *icContext);
+static uint64 getCpuUsecs(void);
+static void addStats(InterconnectStats *sum, const InterconnectStats *stats);
 
 static void
 logChunkParseDetails(MotionConn *conn, uint32 ic_instance_id)
@@ -546,6 +567,11 @@ SetupInterconnect(EState *estate)
 	MemoryContextSwitchTo(oldContext);
 
 	h->interconnect_context = estate->interconnect_context;
+	if (gp_interconnect_collect_stats)
+	{
+		h->setupTime = GetCurrentTimestamp();
+		h->setupCpuUsecs = getCpuUsecs();
+	}
 }
 
 /* TeardownInterconnect() function is used to cleanup interconnect resources that
@@ -569,7 +595,89 @@ TeardownInterconnect(ChunkTransportState *transportStates, bool hasErrors)
 	}
 
 	if (h != NULL)
+	{
+		InterconnectStats stats;
+
+		memset(&stats, 0, sizeof(stats));
+		stats.teardowns = 1;
+		if (h->setupTime != 0)
+		{
+			long		secs;
+			int			usecs;
+
+			TimestampDifference(h->setupTime, GetCurrentTimestamp(), &secs, &usecs);
+			stats.elapsedUsecs = (uint64) secs * USECS_PER_SEC + usecs;
+			stats.cpuUsecs = getCpuUsecs() - h->setupCpuUsecs;
+		}
+		AddInterconnectStats(&stats);
+
 		destroy_interconnect_handle(h);
+	}
+}
+
+Size
+InterconnectStatsShmemSize(void)
+{
+	return sizeof(InterconnectStatsShared);
+}
+
+void
+InterconnectStatsShmemInit(void)
+{
+	bool		found;
+
+	interconnectStats = (InterconnectStatsShared *)
+		ShmemInitStruct("Interconnect statistics", sizeof(InterconnectStatsShared), &found);
+	if (!found)
+	{
+		SpinLockInit(&interconnectStats->mutex);
+		memset(&interconnectStats->stats, 0, sizeof(InterconnectStats));
+	}
+}
+
+/*
+ * Add to the cumulative interconnect statistics of this backend and of this
+ * segment.  This is a no-op unless gp_interconnect_collect_stats is on, so
+ * that the teardowns of ordinary queries don't contend for the spinlock.
+ */
+void
+AddInterconnectStats(const InterconnectStats *stats)
+{
+	InterconnectStats *shared;
+
+	if (!gp_interconnect_collect_stats)
+		return;
+
+	addStats(&backendInterconnectStats, stats);
+
+	if (interconnectStats == NULL)
+		return;
+
+	shared = &interconnectStats->stats;
+
+	SpinLockAcquire(&interconnectStats->mutex);
+	addStats(shared, stats);
+	SpinLockRelease(&interconnectStats->mutex);
+}
+
+void
+GetInterconnectStats(InterconnectStats *stats)
+{
+	if (interconnectStats == NULL)
+	{
+		memset(stats, 0, sizeof(InterconnectStats));
+		return;
+	}
+
+	SpinLockAcquire(&interconnectStats->mutex);
+	*stats = interconnectStats->stats;
+	SpinLockRelease(&interconnectStats->mutex);
+}
+
+void
+GetBackendInterconnectStats(InterconnectStats *stats)
+{
+	*stats = backendInterconnectStats;
 }
 
 /*=========================================================================
@@ -639,6 +747,7 @@ createChunkTransportState(ChunkTransportState *transportStates,
 	pEntry->scanStart = 0;
 	pEntry->sendSlice = sendSlice;
 	pEntry->recvSlice = recvSlice;
+	pEntry->numShmConns = 0;
 
 	pEntry->conns = palloc0(pEntry->numConns * sizeof(pEntry->conns[0]));
 
@@ -657,6 +766,7 @@ createChunkTransportState(ChunkTransportState *transportStates,
 		conn->cdbProc = NULL;
 		conn->sent_record_typmod = 0;
 		conn->remapper = NULL;
+		conn->shmRing = NULL;
 	}
 
 	return pEntry;
@@ -790,6 +900,42 @@ destroy_interconnect_handle(interconnect_handle_t *h)
 		MemoryContextReset(InterconnectContext);
 }
 
+/*
+ * Add the counters of 'stats' to 'sum'.
+ */
+static void
+addStats(InterconnectStats *sum, const InterconnectStats *stats)
+{
+	sum->teardowns += stats->teardowns;
+	sum->chunksSent += stats->chunksSent;
+	sum->bytesSent += stats->bytesSent;
+	sum->chunksRecvd += stats->chunksRecvd;
+	sum->bytesRecvd += stats->bytesRecvd;
+	sum->pktsSent += stats->pktsSent;
+	sum->pktsRecvd += stats->pktsRecvd;
+	sum->retransmits += stats->retransmits;
+	sum->crcErrors += stats->crcErrors;
+	sum->duplicatedPkts += stats->duplicatedPkts;
+	sum->cpuUsecs += stats->cpuUsecs;
+	sum->elapsedUsecs += stats->elapsedUsecs;
+}
+
+/*
+ * CPU time, user and system, used by this process so far.  This includes
+ * the UDP interconnect's receive thread.
+ */
+static uint64
+getCpuUsecs(void)
+{
+	struct rusage ru;
+
+	if (getrusage(RUSAGE_SELF, &ru) != 0)
+		return 0;
+
+	return (uint64) (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * USECS_PER_SEC +
+		ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
 static interconnect_handle_t *
 find_interconnect_handle(ChunkTransportState *icContext)
 {
@@ -0,0 +1,612 @@
+/*-------------------------------------------------------------------------
+ *
+ * ic_shm.c
+ *	  Shared-memory rings for motion connections between processes on the
+ *	  same host.
+ *
+ * When the sender and the receiver of a UDP interconnect connection run on
+ * the same host, the packets don't need to go through the kernel at all.
+ * Instead, the two processes map a POSIX shared memory object holding a
+ * single-producer single-consumer ring of packet-sized slots.  The sender
+ * builds its packets directly in the ring slots, and the receiver parses
+ * the tuple chunks in place, so a packet is never copied.
+ *
+ * The segments on a host run under different postmasters, so the ring can't
+ * live in the main shared memory segment, or in a DSM segment.  Instead, it
+ * is named after the connection and a random nonce that the QD puts in the
+ * slice table, and whichever side gets there first creates it, with O_EXCL.
+ * Like the random handles of POSIX DSM segments, the nonce keeps other
+ * processes from creating a ring under the name ahead of us.  The
+ * all-zeroes state is an empty ring, so neither side needs to wait for the
+ * other to initialize it.  The name is removed when both
+ * sides have detached, or by either side on error.  A backend that crashes
+ * never detaches, so each backend also registers its rings in the main
+ * shared memory segment, and the postmaster removes the leftover names
+ * before it reinitializes shared memory.
+ *
+ * The ring is lock-free: the sender only advances 'head', the receiver only
+ * advances 'tail'.  This module doesn't know how to sleep or wake up a peer;
+ * the *_sleep() functions advertise that the caller is about to sleep, and
+ * the functions that make progress report whether the peer needs to be
+ * woken up.  See ic_udpifc.c for how that is done.
+ *
+ * Portions Copyright (c) 2012-Present VMware, Inc. or its affiliates.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/motion/ic_shm.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cdb/ml_ipc.h"
+#include "common/file_perm.h"
+#include "lib/ilist.h"
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "portability/mem.h"
+#include "storage/backendid.h"
+#include "storage/dsm_impl.h"
+#include "storage/ipc.h"
+#include "storage/shmem.h"
+#include "utils/memutils.h"
+
+#include "ic_shm.h"
+
+/*
+ * The part of a ring that lives in shared memory, followed by the slots.
+ *
+ * 'head' and 'tail' are kept on cache lines of their own, so that the sender
+ * and the receiver don't keep stealing the same line from each other.
+ */
+typedef struct ICShmRingControl
+{
+	pg_atomic_uint32 head;		/* number of packets published */
+	char		pad1[PG_CACHE_LINE_SIZE - sizeof(pg_atomic_uint32)];
+
+	pg_atomic_uint32 tail;		/* number of packets consumed */
+	char		pad2[PG_CACHE_LINE_SIZE - sizeof(pg_atomic_uint32)];
+
+	pg_atomic_uint32 receiverWaiting;	/* receiver is about to sleep */
+	pg_atomic_uint32 senderWaiting; /* sender is about to sleep */
+	pg_atomic_uint32 stopRequested; /* receiver needs no more data */
+	pg_atomic_uint32 senderPort;	/* where to wake up the sender */
+	pg_atomic_uint32 detached;	/* number of sides that have detached */
+} ICShmRingControl;
+
+/*
+ * What a ring is named after.  'srcPid' is 0 in a free registry slot.
+ */
+typedef struct ICShmRingId
+{
+	uint64		nonce;			/* SliceTable->ic_shm_nonce */
+	int32		sessionId;
+	uint32		icId;
+	int32		motNodeId;
+	int32		srcPid;
+	int32		dstPid;
+} ICShmRingId;
+
+/*
+ * The rings attached by the backends of this postmaster, in the main shared
+ * memory segment, for the postmaster to clean up after a crash.  This plays
+ * the part of the DSM control segment for DSM segments.
+ *
+ * Each backend has a fixed number of slots of its own, so that registering
+ * a ring needs no locking.  A ring that doesn't fit works all the same, but
+ * its name is left behind if the backend crashes.
+ */
+#define IC_SHM_SLOTS_PER_BACKEND	128
+
+/* "/gpic." followed by the five ids and the nonce, in hex */
+#define IC_SHM_RING_NAME_LEN		80
+
+static ICShmRingId *ring_registry = NULL;
+
+/*
+ * Backend-local state of an attached ring.
+ */
+struct ICShmRing
+{
+	dlist_node	node;			/* in attached_rings */
+	char		name[IC_SHM_RING_NAME_LEN];
+	uint32		icId;			/* interconnect instance that owns it */
+	ICShmRingId *regslot;		/* registry slot, or NULL if none */
+
+	ICShmRingControl *ctl;
+	char	   *slots;
+	uint32		mask;			/* number of slots - 1 */
+	Size		slotSize;
+	Size		mappedSize;
+
+	/*
+	 * Sender: the packet being filled, always equal to ctl->head.
+	 * Receiver: the next packet to read, always equal to ctl->tail.
+	 */
+	uint32		pos;
+};
+
+/* All the rings attached by this backend, to clean up on exit. */
+static dlist_head attached_rings = DLIST_STATIC_INIT(attached_rings);
+static bool atexit_registered = false;
+
+static void ic_shm_atexit(int code, Datum arg);
+static void ic_shm_registry_cleanup(int code, Datum arg);
+
+#define RING_SLOT(ring, p) \
+	((uint8 *) ((ring)->slots + ((p) & (ring)->mask) * (ring)->slotSize))
+
+/*
+ * Can rings be used on this platform?
+ *
+ * The atomics must work across processes that share nothing but the mapped
+ * memory, which rules out the emulated ones.
+ */
+bool
+ic_shm_supported(void)
+{
+#if defined(USE_DSM_POSIX) && !defined(PG_HAVE_ATOMIC_U32_SIMULATION)
+	return true;
+#else
+	return false;
+#endif
+}
+
+static void
+ic_shm_ring_name(char *name, Size len, const ICShmRingId *id)
+{
+	snprintf(name, len, "/gpic.%x.%x.%x.%x.%x.%" INT64_MODIFIER "x",
+			 id->sessionId, id->icId, id->motNodeId, id->srcPid, id->dstPid,
+			 id->nonce);
+}
+
+/*
+ * Register a ring that this backend is about to attach.  Returns the slot,
+ * or NULL if the backend's slots are all taken.
+ */
+static ICShmRingId *
+ic_shm_register_ring(const ICShmRingId *id)
+{
+	ICShmRingId *slots;
+	int			i;
+
+	if (ring_registry == NULL || MyBackendId == InvalidBackendId)
+		return NULL;
+
+	slots = &ring_registry[(MyBackendId - 1) * IC_SHM_SLOTS_PER_BACKEND];
+	for (i = 0; i < IC_SHM_SLOTS_PER_BACKEND; i++)
+	{
+		if (slots[i].srcPid == 0)
+		{
+			slots[i] = *id;
+			return &slots[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void
+ic_shm_unregister_ring(ICShmRingId *regslot)
+{
+	if (regslot != NULL)
+		regslot->srcPid = 0;
+}
+
+Size
+InterconnectShmRingsShmemSize(void)
+{
+	return mul_size(mul_size(MaxBackends, IC_SHM_SLOTS_PER_BACKEND),
+					sizeof(ICShmRingId));
+}
+
+void
+InterconnectShmRingsShmemInit(void)
+{
+	bool		found;
+
+	ring_registry = (ICShmRingId *)
+		ShmemInitStruct("Interconnect shared memory rings",
+						InterconnectShmRingsShmemSize(), &found);
+	if (!found)
+	{
+		memset(ring_registry, 0, InterconnectShmRingsShmemSize());
+
+		if (!IsUnderPostmaster)
+			on_shmem_exit(ic_shm_registry_cleanup, 0);
+	}
+}
+
+/*
+ * Remove the rings left behind by backends that didn't detach them, when
+ * the postmaster reinitializes shared memory after a crash, or shuts down.
+ * All the backends are gone by then.
+ */
+static void
+ic_shm_registry_cleanup(int code, Datum arg)
+{
+#ifdef USE_DSM_POSIX
+	Size		nslots = (Size) MaxBackends * IC_SHM_SLOTS_PER_BACKEND;
+	Size		i;
+
+	for (i = 0; i < nslots; i++)
+	{
+		char		name[IC_SHM_RING_NAME_LEN];
+
+		if (ring_registry[i].srcPid == 0)
+			continue;
+
+		ic_shm_ring_name(name, sizeof(name), &ring_registry[i]);
+		if (shm_unlink(name) == 0)
+			elog(LOG, "removed leftover interconnect shared memory ring \"%s\"",
+				 name);
+		else if (errno != ENOENT)
+			elog(LOG, "could not remove interconnect shared memory ring \"%s\": %m",
+				 name);
+	}
+#endif
+
+	ring_registry = NULL;
+}
+
+/*
+ * Create or attach the ring of the connection from srcPid to dstPid.
+ *
+ * Both sides must pass the same 'nonce', 'nslots' and 'slotSize'.  'nslots' is
+ * rounded up to a power of two, so that the slot of a packet doesn't change
+ * when the counters wrap around.
+ */
+ICShmRing *
+ic_shm_ring_attach(uint64 nonce, int32 sessionId, uint32 icId, int32 motNodeId,
+				   int32 srcPid, int32 dstPid, int nslots, int slotSize)
+{
+#ifdef USE_DSM_POSIX
+	ICShmRing  *ring;
+	ICShmRingId id;
+	ICShmRingId *regslot;
+	char		name[IC_SHM_RING_NAME_LEN];
+	uint32		n = 1;
+	Size		ctlSize;
+	Size		size;
+	struct stat st;
+	char	   *address;
+	int			fd;
+
+	while (n < nslots)
+		n <<= 1;
+
+	ctlSize = CACHELINEALIGN(sizeof(ICShmRingControl));
+	size = ctlSize + (Size) n * CACHELINEALIGN(slotSize);
+
+	id.nonce = nonce;
+	id.sessionId = sessionId;
+	id.icId = icId;
+	id.motNodeId = motNodeId;
+	id.srcPid = srcPid;
+	id.dstPid = dstPid;
+	ic_shm_ring_name(name, sizeof(name), &id);
+
+	/* register before creating it, so that a crash can't leave it behind */
+	regslot = ic_shm_register_ring(&id);
+
+	/*
+	 * Create the ring, or attach the one the peer created.  If neither
+	 * works, the peer might have detached and removed the name in between,
+	 * after an error; creating a fresh ring then is harmless.
+	 */
+	for (;;)
+	{
+		fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, PG_FILE_MODE_OWNER);
+		if (fd != -1 || errno != EEXIST)
+			break;
+		fd = shm_open(name, O_RDWR, 0);
+		if (fd != -1 || errno != ENOENT)
+			break;
+		CHECK_FOR_INTERRUPTS();
+	}
+	if (fd == -1)
+	{
+		ic_shm_unregister_ring(regslot);
+		ereport(ERROR,
+				(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+				 errmsg("could not open interconnect shared memory ring \"%s\": %m",
+						name)));
+	}
+
+	/*
+	 * If the peer got here first, it has already sized the object.  A
+	 * different size means that we disagree about the geometry, and using
+	 * the ring would corrupt the data.
+	 */
+	if (fstat(fd, &st) != 0 ||
+		(st.st_size != 0 && st.st_size != size) ||
+		(st.st_size == 0 && ftruncate(fd, size) != 0))
+	{
+		int			save_errno = errno;
+
+		close(fd);
+		shm_unlink(name);
+		ic_shm_unregister_ring(regslot);
+		errno = save_errno;
+
+		ereport(ERROR,
+				(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+				 errmsg("could not size interconnect shared memory ring \"%s\" to %zu bytes: %m",
+						name, size)));
+	}
+
+	address = mmap(NULL, size, PROT_READ | PROT_WRITE,
+				   MAP_SHARED | MAP_HASSEMAPHORE | MAP_NOSYNC, fd, 0);
+	if (address == MAP_FAILED)
+	{
+		int			save_errno = errno;
+
+		close(fd);
+		shm_unlink(name);
+		ic_shm_unregister_ring(regslot);
+		errno = save_errno;
+
+		ereport(ERROR,
+				(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+				 errmsg("could not map interconnect shared memory ring \"%s\": %m",
+						name)));
+	}
+	close(fd);
+
+	if (!atexit_registered)
+	{
+		on_proc_exit(ic_shm_atexit, 0);
+		atexit_registered = true;
+	}
+
+	ring = MemoryContextAllocZero(TopMemoryContext, sizeof(ICShmRing));
+	strlcpy(ring->name, name, sizeof(ring->name));
+	ring->icId = icId;
+	ring->regslot = regslot;
+	ring->ctl = (ICShmRingControl *) address;
+	ring->slots = address + ctlSize;
+	ring->mask = n - 1;
+	ring->slotSize = CACHELINEALIGN(slotSize);
+	ring->mappedSize = size;
+	ring->pos = 0;
+
+	dlist_push_tail(&attached_rings, &ring->node);
+
+	return ring;
+#else
+	elog(ERROR, "interconnect shared memory rings are not supported on this platform");
+	return NULL;				/* keep compiler quiet */
+#endif
+}
+
+/*
+ * Detach a ring.
+ *
+ * The last side to detach removes the name.  With 'destroy', the name is
+ * removed anyway; that is used on error, when the peer might never come to
+ * detach.
+ *
+ * This is called during interconnect teardown, so it must not throw.
+ */
+void
+ic_shm_ring_detach(ICShmRing *ring, bool destroy)
+{
+	if (pg_atomic_fetch_add_u32(&ring->ctl->detached, 1) > 0)
+		destroy = true;
+
+	if (munmap(ring->ctl, ring->mappedSize) != 0)
+		elog(LOG, "could not unmap interconnect shared memory ring \"%s\": %m",
+			 ring->name);
+
+#ifdef USE_DSM_POSIX
+	if (destroy && shm_unlink(ring->name) != 0 && errno != ENOENT)
+		elog(LOG, "could not remove interconnect shared memory ring \"%s\": %m",
+			 ring->name);
+#endif
+
+	ic_shm_unregister_ring(ring->regslot);
+
+	dlist_delete(&ring->node);
+	pfree(ring);
+}
+
+/*
+ * Destroy all the rings of an interconnect instance, after its setup failed
+ * half-way.
+ */
+void
+ic_shm_ring_detach_instance(uint32 icId)
+{
+	dlist_mutable_iter iter;
+
+	dlist_foreach_modify(iter, &attached_rings)
+	{
+		ICShmRing  *ring = dlist_container(ICShmRing, node, iter.cur);
+
+		if (ring->icId == icId)
+			ic_shm_ring_detach(ring, true);
+	}
+}
+
+static void
+ic_shm_atexit(int code, Datum arg)
+{
+	dlist_mutable_iter iter;
+
+	dlist_foreach_modify(iter, &attached_rings)
+	{
+		ICShmRing  *ring = dlist_container(ICShmRing, node, iter.cur);
+
+		ic_shm_ring_detach(ring, true);
+	}
+}
+
+/*
+ * Get the slot to build the next packet in, or NULL if the ring is full.
+ */
+uint8 *
+ic_shm_ring_get_slot(ICShmRing *ring)
+{
+	if (ring->pos - pg_atomic_read_u32(&ring->ctl->tail) > ring->mask)
+		return NULL;
+
+	/* don't write the slot before the receiver is done reading it */
+	pg_memory_barrier();
+
+	return RING_SLOT(ring, ring->pos);
+}
+
+/*
+ * Publish the packet built in the current slot.
+ *
+ * Returns true if the receiver went to sleep, and must be woken up.
+ */
+bool
+ic_shm_ring_publish(ICShmRing *ring)
+{
+	ICShmRingControl *ctl = ring->ctl;
+
+	pg_write_barrier();
+	pg_atomic_write_u32(&ctl->head, ++ring->pos);
+
+	/* pairs with the barrier in ic_shm_ring_receiver_sleep() */
+	pg_memory_barrier();
+
+	return pg_atomic_read_u32(&ctl->receiverWaiting) != 0 &&
+		pg_atomic_exchange_u32(&ctl->receiverWaiting, 0) != 0;
+}
+
+/*
+ * The sender is about to sleep until the ring has room.
+ *
+ * Returns false if the ring got room, or the receiver asked us to stop, in
+ * the meantime.  Otherwise the receiver will wake us up when that happens.
+ */
+bool
+ic_shm_ring_sender_sleep(ICShmRing *ring)
+{
+	ICShmRingControl *ctl = ring->ctl;
+
+	pg_atomic_write_u32(&ctl->senderWaiting, 1);
+	pg_memory_barrier();
+
+	if (ring->pos - pg_atomic_read_u32(&ctl->tail) <= ring->mask ||
+		pg_atomic_read_u32(&ctl->stopRequested) != 0)
+	{
+		pg_atomic_write_u32(&ctl->senderWaiting, 0);
+		return false;
+	}
+
+	return true;
+}
+
+bool
+ic_shm_ring_stop_requested(ICShmRing *ring)
+{
+	return pg_atomic_read_u32(&ring->ctl->stopRequested) != 0;
+}
+
+/*
+ * Tell the receiver which UDP port to poke to wake us up.
+ */
+void
+ic_shm_ring_set_sender_port(ICShmRing *ring, uint16 port)
+{
+	pg_atomic_write_u32(&ring->ctl->senderPort, port);
+	/* before we ever ask the receiver to wake us up */
+	pg_write_barrier();
+}
+
+/*
+ * Get the next published packet, or NULL if there is none.
+ *
+ * The packet stays valid until ic_shm_ring_release().
+ */
+uint8 *
+ic_shm_ring_peek(ICShmRing *ring)
+{
+	if (pg_atomic_read_u32(&ring->ctl->head) == ring->pos)
+		return NULL;
+
+	/* don't read the slot before the sender is done writing it */
+	pg_read_barrier();
+
+	return RING_SLOT(ring, ring->pos);
+}
+
+/*
+ * Give the slot returned by ic_shm_ring_peek() back to the sender.
+ *
+ * Returns true if the sender went to sleep, and must be woken up.
+ */
+bool
+ic_shm_ring_release(ICShmRing *ring)
+{
+	ICShmRingControl *ctl = ring->ctl;
+
+	pg_memory_barrier();
+	pg_atomic_write_u32(&ctl->tail, ++ring->pos);
+
+	/* pairs with the barrier in ic_shm_ring_sender_sleep() */
+	pg_memory_barrier();
+
+	return pg_atomic_read_u32(&ctl->senderWaiting) != 0 &&
+		pg_atomic_exchange_u32(&ctl->senderWaiting, 0) != 0;
+}
+
+/*
+ * The receiver is about to sleep until a packet is published.
+ *
+ * Returns false if a packet got published in the meantime.  Otherwise the
+ * sender will wake us up when that happens.
+ */
+bool
+ic_shm_ring_receiver_sleep(ICShmRing *ring)
+{
+	ICShmRingControl *ctl = ring->ctl;
+
+	pg_atomic_write_u32(&ctl->receiverWaiting, 1);
+	pg_memory_barrier();
+
+	if (pg_atomic_read_u32(&ctl->head) != ring->pos)
+	{
+		pg_atomic_write_u32(&ctl->receiverWaiting, 0);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Ask the sender to stop sending.
+ *
+ * Returns true if the sender went to sleep, and must be woken up to notice.
+ */
+bool
+ic_shm_ring_request_stop(ICShmRing *ring)
+{
+	ICShmRingControl *ctl = ring->ctl;
+
+	pg_atomic_write_u32(&ctl->stopRequested, 1);
+	pg_memory_barrier();
+
+	return pg_atomic_read_u32(&ctl->senderWaiting) != 0 &&
+		pg_atomic_exchange_u32(&ctl->senderWaiting, 0) != 0;
+}
+
+/*
+ * Get the UDP port to poke to wake up the sender, or 0 if the sender hasn't
+ * attached yet.
+ */
+uint16
+ic_shm_ring_get_sender_port(ICShmRing *ring)
+{
+	return (uint16) pg_atomic_read_u32(&ring->ctl->senderPort);
+}
@@ -0,0 +1,43 @@
+/*-------------------------------------------------------------------------
+ *
+ * ic_shm.h
+ *	  Shared-memory rings for motion connections between processes on the
+ *	  same host.
+ *
+ * Portions Copyright (c) 2012-Present VMware, Inc. or its affiliates.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/motion/ic_shm.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef IC_SHM_H
+#define IC_SHM_H
+
+typedef struct ICShmRing ICShmRing;
+
+extern bool ic_shm_supported(void);
+
+extern ICShmRing *ic_shm_ring_attach(uint64 nonce, int32 sessionId, uint32 icId,
+									 int32 motNodeId, int32 srcPid, int32 dstPid,
+									 int nslots, int slotSize);
+extern void ic_shm_ring_detach(ICShmRing *ring, bool destroy);
+extern void ic_shm_ring_detach_instance(uint32 icId);
+
+/* sender side */
+extern uint8 *ic_shm_ring_get_slot(ICShmRing *ring);
+extern bool ic_shm_ring_publish(ICShmRing *ring);
+extern bool ic_shm_ring_sender_sleep(ICShmRing *ring);
+extern bool ic_shm_ring_stop_requested(ICShmRing *ring);
+extern void ic_shm_ring_set_sender_port(ICShmRing *ring, uint16 port);
+
+/* receiver side */
+extern uint8 *ic_shm_ring_peek(ICShmRing *ring);
+extern bool ic_shm_ring_release(ICShmRing *ring);
+extern bool ic_shm_ring_receiver_sleep(ICShmRing *ring);
+extern bool ic_shm_ring_request_stop(ICShmRing *ring);
+extern uint16 ic_shm_ring_get_sender_port(ICShmRing *ring);
+
+#endif   /* IC_SHM_H */
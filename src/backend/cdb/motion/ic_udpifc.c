@@ -57,6 +57,8 @@
 #include "cdb/cdbdispatchresult.h"
 #include "cdb/cdbicudpfaultinjection.h"
 
+#include "ic_shm.h"
+
 #ifdef WIN32
 #define WIN32_LEAN_AND_MEAN
 #ifndef _WIN32_WINNT
@@ -138,6 +140,22 @@ int
 /* 1/4 sec in msec */
 #define RX_THREAD_POLL_TIMEOUT (250)
 
+/*
+ * Max number of packets handed to the kernel in one sendmmsg()/recvmmsg()
+ * call. Without those calls, every packet costs one sendto()/recvfrom().
+ */
+#ifdef HAVE_SENDMMSG
+#define UDPIC_SEND_BATCH_SIZE (32)
+#else
+#define UDPIC_SEND_BATCH_SIZE (1)
+#endif
+
+#ifdef HAVE_RECVMMSG
+#define UDPIC_RECV_BATCH_SIZE (16)
+#else
+#define UDPIC_RECV_BATCH_SIZE (1)
+#endif
+
 /*
  * Flags definitions for flag-field of UDP-messages
  *
@@ -151,6 +169,16 @@ int
 #define UDPIC_FLAGS_DISORDER    		(32)
 #define UDPIC_FLAGS_DUPLICATE   		(64)
 #define UDPIC_FLAGS_CAPACITY    		(128)
+#define UDPIC_FLAGS_SHM_DOORBELL		(256)
+
+/*
+ * Number of packets in the shared-memory ring of a connection between two
+ * processes on the same host: as many as a UDP connection can have in
+ * flight, but at least 16 so that the two sides rarely have to wake each
+ * other up.  Both sides compute it from the same (synced) GUCs.
+ */
+#define IC_SHM_RING_SLOTS \
+	Max(Gp_interconnect_queue_depth + Gp_interconnect_snd_queue_depth, 16)
 
 /*
  * ConnHtabBin
@@ -323,10 +351,11 @@ struct RxBufferPool
 /*
  * The buffer pool used for keeping data packets.
  *
- * maxCount is set to 1 to make sure there is always a buffer
- * for picking packets from OS buffer.
+ * maxCount starts at UDPIC_RECV_BATCH_SIZE to make sure the rx thread
+ * always has a buffer for every packet of a batch it picks from the OS
+ * buffer.
  */
-static RxBufferPool rx_buffer_pool = {1, 0, NULL};
+static RxBufferPool rx_buffer_pool = {UDPIC_RECV_BATCH_SIZE, 0, NULL};
 
 /*
  * SendBufferPool
@@ -613,10 +642,17 @@ typedef struct AckSendParam
  * crcErrors                 - the number of crc errors.
  * sndPktNum                 - the number of packets sent by sender.
  * recvPktNum                - the number of packets received by receiver.
+ * shmSndPktNum              - the number of packets sent through shared memory.
+ * shmRecvPktNum             - the number of packets received through shared memory.
  * disorderedPktNum          - disordered packet number.
  * duplicatedPktNum          - duplicate packet number.
  * recvAckNum                - the number of Acks received.
  * statusQueryMsgNum         - the number of status query messages sent.
+ * sndSyscallNum             - the number of syscalls used to send data packets.
+ * sndBytes                  - the number of data packet bytes sent.
+ * recvSyscallNum            - the number of syscalls used to receive packets.
+ * recvBytes                 - the number of packet bytes received.
+ * startTime                 - the time the interconnect was set up.
  *
  */
 typedef struct ICStatistics
@@ -634,10 +670,17 @@ typedef struct ICStatistics
 	int32		crcErrors;
 	int32		sndPktNum;
 	int32		recvPktNum;
+	int32		shmSndPktNum;
+	int32		shmRecvPktNum;
 	int32		disorderedPktNum;
 	int32		duplicatedPktNum;
 	int32		recvAckNum;
 	int32		statusQueryMsgNum;
+	uint64		sndSyscallNum;
+	uint64		sndBytes;
+	uint64		recvSyscallNum;
+	uint64		recvBytes;
+	uint64		startTime;
 } ICStatistics;
 
 /* Statistics for UDP interconnect. */
@@ -674,6 +717,21 @@ static ChunkTransportStateEntry *startOutgoingUDPConnections(ChunkTransportState
 static void setupOutgoingUDPConnection(ChunkTransportState *transportStates,
 						   ChunkTransportStateEntry *pEntry, MotionConn *conn);
 
+/* Shared-memory connection functions. */
+static const char *getShmLocalAddr(ExecSlice *mySlice);
+static bool useShmRing(const char *localAddr, CdbProcess *peer);
+static void attachShmRing(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
+			  MotionConn *conn, int32 srcPid, int32 dstPid);
+static void sendShmDoorbell(MotionConn *conn, int fd);
+static void wakeShmSender(MotionConn *conn);
+static void publishShmPacket(ChunkTransportStateEntry *pEntry, MotionConn *conn);
+static bool getShmSndBuffer(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
+				MotionConn *conn, int16 motionId);
+static void handleShmStop(MotionConn *conn);
+static bool prepareShmConnForRead(MotionConn *conn);
+static MotionConn *pollShmConns(ChunkTransportStateEntry *pEntry, MotionConn *conn, bool arm);
+static void releaseShmRxBuffer(MotionConn *conn);
+
 /* Connection hash table functions. */
 static bool initConnHashTable(ConnHashTable *ht, MemoryContext ctx);
 static bool connAddHash(ConnHashTable *ht, MotionConn *conn);
@@ -737,6 +795,7 @@ static void checkQDConnectionAlive(void);
 
 
 static void *rxThreadFunc(void *arg);
+static bool handleRxPacket(icpkthdr *pkt, int read_count, struct sockaddr_storage *peer, socklen_t peerlen);
 
 static bool handleMismatch(icpkthdr *pkt, struct sockaddr_storage *peer, int peer_len);
 static void handleAckedPacket(MotionConn *ackConn, ICBuffer *buf, uint64 now);
@@ -752,6 +811,7 @@ static inline void addCRC(icpkthdr *pkt);
 static inline bool checkCRC(icpkthdr *pkt);
 static void sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn);
 static void sendOnce(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, ICBuffer *buf, MotionConn *conn);
+static void sendBatch(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, ICBuffer **bufs, int nbufs, MotionConn *conn);
 static inline uint64 computeExpirationPeriod(MotionConn *conn, uint32 retry);
 
 static ICBuffer *getSndBuffer(MotionConn *conn);
@@ -762,6 +822,8 @@ static void initUnackQueueRing(UnackQueueRing *uqr);
 
 static void checkExpiration(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *triggerConn, uint64 now);
 static void checkDeadlock(ChunkTransportStateEntry *pEntry, MotionConn *conn);
+static void checkExceptions(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
+				MotionConn *conn, int retry, int timeout);
 
 static bool cacheFuturePacket(icpkthdr *pkt, struct sockaddr_storage *peer, int peer_len);
 static void cleanupStartupCache(void);
@@ -1456,9 +1518,12 @@ InitMotionUDPIFC(int *listenerSocketFd, uint16 *listenerPort)
 	rx_control_info.lastTornIcId = 0;
 	initCursorICHistoryTable(&rx_control_info.cursorHistoryTable);
 
-	/* Initialize receive buffer pool */
+	/*
+	 * Initialize receive buffer pool. The rx thread holds on to up to
+	 * UDPIC_RECV_BATCH_SIZE buffers to receive into.
+	 */
 	rx_buffer_pool.count = 0;
-	rx_buffer_pool.maxCount = 1;
+	rx_buffer_pool.maxCount = UDPIC_RECV_BATCH_SIZE;
 	rx_buffer_pool.freeList = NULL;
 
 	/* Initialize send control data */
@@ -1994,6 +2059,12 @@ MlPutRxBufferIFC(ChunkTransportState *transportStates, int motNodeID, int route)
 
 	conn = pEntry->conns + route;
 
+	if (conn->shmRing != NULL)
+	{
+		releaseShmRxBuffer(conn);
+		return;
+	}
+
 	memset(&param, 0, sizeof(AckSendParam));
 
 	pthread_mutex_lock(&ic_control_info.lock);
@@ -2655,6 +2726,7 @@ startOutgoingUDPConnections(ChunkTransportState *transportStates,
 	ListCell   *cell;
 	ExecSlice  *recvSlice;
 	CdbProcess *cdbProc;
+	const char *localAddr;
 	int			i;
 
 	*pOutgoingCount = 0;
@@ -2672,6 +2744,8 @@ startOutgoingUDPConnections(ChunkTransportState *transportStates,
 
 	Assert(pEntry && pEntry->valid);
 
+	localAddr = getShmLocalAddr(sendSlice);
+
 	/*
 	 * Setup a MotionConn entry for each of our outbound connections. Request
 	 * a connection to each receiving backend's listening port. NB: Some
@@ -2690,13 +2764,29 @@ startOutgoingUDPConnections(ChunkTransportState *transportStates,
 			icBufferListInit(&conn->unackQueue, ICBufferListType_Primary);
 			conn->capacity = Gp_interconnect_queue_depth;
 
-			/* send buffer pool must be initialized before this. */
-			snd_buffer_pool.maxCount += Gp_interconnect_snd_queue_depth;
-			snd_control_info.cwnd += 1;
-			conn->curBuff = getSndBuffer(conn);
-
-			/* should have at least one buffer for each connection */
-			Assert(conn->curBuff != NULL);
+			if (useShmRing(localAddr, cdbProc))
+			{
+				/*
+				 * Packets are built directly in the slots of the ring, so
+				 * the connection takes no send buffers.
+				 */
+				attachShmRing(transportStates, pEntry, conn, MyProcPid, cdbProc->pid);
+				ic_shm_ring_set_sender_port(conn->shmRing, ICSenderPort);
+				conn->curBuff = NULL;
+				conn->pBuff = ic_shm_ring_get_slot(conn->shmRing);
+				Assert(conn->pBuff != NULL);
+			}
+			else
+			{
+				/* send buffer pool must be initialized before this. */
+				snd_buffer_pool.maxCount += Gp_interconnect_snd_queue_depth;
+				snd_control_info.cwnd += 1;
+				conn->curBuff = getSndBuffer(conn);
+
+				/* should have at least one buffer for each connection */
+				Assert(conn->curBuff != NULL);
+				conn->pBuff = (uint8 *) conn->curBuff->pkt;
+			}
 
 			conn->rtt = DEFAULT_RTT;
 			conn->dev = DEFAULT_DEV;
@@ -2706,7 +2796,6 @@ startOutgoingUDPConnections(ChunkTransportState *transportStates,
 			conn->sentSeq = 0;
 			conn->receivedAckSeq = 0;
 			conn->consumedSeq = 0;
-			conn->pBuff = (uint8 *) conn->curBuff->pkt;
 			conn->state = mcsSetupOutgoingConnection;
 			conn->route = i++;
 
@@ -2941,6 +3030,264 @@ setupOutgoingUDPConnection(ChunkTransportState *transportStates, ChunkTransportS
 
 }								/* setupOutgoingUDPConnection */
 
+/*
+ * getShmLocalAddr
+ * 		Get the address that the peers know this process by, if connections
+ * 		to and from processes on the same host should go through shared
+ * 		memory.  Returns NULL otherwise.
+ */
+static const char *
+getShmLocalAddr(ExecSlice *mySlice)
+{
+	ListCell   *cell;
+
+	if (!gp_interconnect_local_shm || !ic_shm_supported())
+		return NULL;
+
+	foreach(cell, mySlice->primaryProcesses)
+	{
+		CdbProcess *cdbProc = (CdbProcess *) lfirst(cell);
+
+		if (cdbProc && cdbProc->pid == MyProcPid)
+			return cdbProc->listenerAddr;
+	}
+
+	return NULL;
+}
+
+/*
+ * useShmRing
+ * 		Should the connection with 'peer' go through a shared-memory ring?
+ *
+ * Both ends of a connection decide this on their own, so the decision may
+ * only depend on things that they agree on: the (synced) GUC, and the
+ * addresses in the slice table.
+ */
+static bool
+useShmRing(const char *localAddr, CdbProcess *peer)
+{
+	return localAddr != NULL && peer->listenerAddr != NULL &&
+		strcmp(localAddr, peer->listenerAddr) == 0;
+}
+
+/*
+ * attachShmRing
+ * 		Attach the shared-memory ring of a connection, creating it if the
+ * 		other end has not yet.
+ */
+static void
+attachShmRing(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
+			  MotionConn *conn, int32 srcPid, int32 dstPid)
+{
+	conn->shmRing = ic_shm_ring_attach(transportStates->sliceTable->ic_shm_nonce,
+									   gp_session_id,
+									   transportStates->sliceTable->ic_instance_id,
+									   pEntry->motNodeId, srcPid, dstPid,
+									   IC_SHM_RING_SLOTS, Gp_max_packet_size);
+	pEntry->numShmConns++;
+
+	if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
+		elog(DEBUG1, "Interconnect using shared memory for node %d route %d srcpid %d dstpid %d",
+			 pEntry->motNodeId, conn->route, srcPid, dstPid);
+}
+
+/*
+ * sendShmDoorbell
+ * 		Wake up the other end of a shared-memory connection.
+ *
+ * The doorbell is an empty control message to the UDP socket that the
+ * other end waits on anyway, so neither end has to wait on anything else.
+ */
+static void
+sendShmDoorbell(MotionConn *conn, int fd)
+{
+	icpkthdr	msg;
+
+	memcpy(&msg, &conn->conn_info, sizeof(msg));
+	msg.flags = UDPIC_FLAGS_SHM_DOORBELL;
+	msg.len = sizeof(msg);
+	msg.crc = 0;
+
+	sendControlMessage(&msg, fd, (struct sockaddr *) &conn->peer, conn->peer_len);
+}
+
+/*
+ * wakeShmSender
+ * 		Wake up the sender of an incoming shared-memory connection.
+ */
+static void
+wakeShmSender(MotionConn *conn)
+{
+	uint16		port = ic_shm_ring_get_sender_port(conn->shmRing);
+
+	/* the sender can't be asleep before it has attached */
+	if (port == 0)
+		return;
+
+	if (conn->peer.ss_family == AF_INET6)
+		((struct sockaddr_in6 *) &conn->peer)->sin6_port = htons(port);
+	else
+		((struct sockaddr_in *) &conn->peer)->sin_port = htons(port);
+
+	sendShmDoorbell(conn, UDP_listenerFd);
+}
+
+/*
+ * publishShmPacket
+ * 		Hand the packet built in the current slot over to the receiver.
+ */
+static void
+publishShmPacket(ChunkTransportStateEntry *pEntry, MotionConn *conn)
+{
+	prepareXmit(conn);
+	ic_statistics.shmSndPktNum++;
+
+	SIMPLE_FAULT_INJECTOR("interconnect_shm_publish");
+
+	if (ic_shm_ring_publish(conn->shmRing))
+		sendShmDoorbell(conn, pEntry->txfd);
+
+	conn->pBuff = NULL;
+}
+
+/*
+ * getShmSndBuffer
+ * 		Get the next slot of a shared-memory connection to build a packet in.
+ *
+ * While the ring is full, we wait like SendChunkUDPIFC() does for a send
+ * buffer, minding the acks of our UDP connections.  Returns false if the
+ * receiver asked us to stop instead, the connection is inactive then.
+ */
+static bool
+getShmSndBuffer(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
+				MotionConn *conn, int16 motionId)
+{
+	int			retry = 0;
+	bool		gotStops = false;
+
+	while (!ic_shm_ring_stop_requested(conn->shmRing) &&
+		   (conn->pBuff = ic_shm_ring_get_slot(conn->shmRing)) == NULL)
+	{
+		/* ask the receiver for a doorbell, unless a slot was just freed */
+		if (ic_shm_ring_sender_sleep(conn->shmRing) &&
+			pollAcks(transportStates, pEntry->txfd, TIMER_CHECKING_PERIOD) &&
+			handleAcks(transportStates, pEntry))
+			gotStops = true;
+
+		checkExceptions(transportStates, pEntry, conn, retry++, TIMER_CHECKING_PERIOD);
+	}
+
+	/* as in SendChunkUDPIFC(), stops are only handled once we are done */
+	if (gotStops)
+		handleStopMsgs(transportStates, pEntry, motionId);
+
+	if (conn->pBuff == NULL)
+	{
+		handleShmStop(conn);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * handleShmStop
+ * 		Stop sending on a shared-memory connection, at the receiver's request.
+ *
+ * Unlike handleStopMsgs(), there is no need to send a stop-ack EOS: the
+ * receiver doesn't wait for one.
+ */
+static void
+handleShmStop(MotionConn *conn)
+{
+	if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
+		elog(DEBUG1, "handleShmStop: node %d route %d, seq %d",
+			 conn->conn_info.motNodeId, conn->route, conn->conn_info.seq);
+
+	conn->tupleCount = 0;
+	conn->msgSize = sizeof(conn->conn_info);
+
+	conn->state = mcsEosSent;
+	conn->pBuff = NULL;
+	conn->stillActive = false;
+	conn->stopRequested = false;
+}
+
+/*
+ * prepareShmConnForRead
+ * 		Prepare a shared-memory connection for reading its next packet,
+ * 		in place in the ring.  Returns false if there is none yet.
+ */
+static bool
+prepareShmConnForRead(MotionConn *conn)
+{
+	icpkthdr   *pkt = (icpkthdr *) ic_shm_ring_peek(conn->shmRing);
+
+	if (pkt == NULL)
+		return false;
+
+	if (pkt->flags & UDPIC_FLAGS_EOS)
+		conn->conn_info.flags |= UDPIC_FLAGS_EOS;
+
+	conn->pBuff = (uint8 *) pkt;
+	conn->msgPos = conn->pBuff;
+	conn->msgSize = pkt->len;
+	conn->recvBytes = conn->msgSize;
+
+	ic_statistics.shmRecvPktNum++;
+
+	return true;
+}
+
+/*
+ * pollShmConns
+ * 		Look for a packet on the shared-memory connections of a motion node,
+ * 		or only on 'conn' if it's given.
+ *
+ * With 'arm', the senders that have nothing for us are asked to ring the
+ * doorbell when they publish their next packet.  Returns the connection,
+ * prepared for reading, or NULL.
+ */
+static MotionConn *
+pollShmConns(ChunkTransportStateEntry *pEntry, MotionConn *conn, bool arm)
+{
+	int			first = (conn != NULL ? conn->route : 0);
+	int			last = (conn != NULL ? conn->route + 1 : pEntry->numConns);
+	int			i;
+
+	for (i = first; i < last; i++)
+	{
+		MotionConn *rxconn = pEntry->conns + i;
+
+		if (rxconn->shmRing == NULL || !rxconn->stillActive)
+			continue;
+
+		if (arm && ic_shm_ring_receiver_sleep(rxconn->shmRing))
+			continue;
+
+		if (prepareShmConnForRead(rxconn))
+			return rxconn;
+	}
+
+	return NULL;
+}
+
+/*
+ * releaseShmRxBuffer
+ * 		Give the slot of the packet we are done with back to the sender.
+ */
+static void
+releaseShmRxBuffer(MotionConn *conn)
+{
+	if (conn->pBuff == NULL)
+		elog(FATAL, "Interconnect error: tried to release a NULL buffer");
+
+	conn->pBuff = NULL;
+
+	if (ic_shm_ring_release(conn->shmRing))
+		wakeShmSender(conn);
+}
+
 /*
  * handleCachedPackets
  * 		Deal with cached packets.
@@ -3024,6 +3371,7 @@ SetupUDPIFCInterconnect_Internal(SliceTable *sliceTable)
 	ExecSlice  *mySlice;
 	ExecSlice  *aSlice;
 	MotionConn *conn = NULL;
+	const char *localAddr;
 	int			incoming_count = 0;
 	int			outgoing_count = 0;
 	int			expectedTotalIncoming = 0;
@@ -3053,6 +3401,8 @@ SetupUDPIFCInterconnect_Internal(SliceTable *sliceTable)
 		ic_control_info.ic_instance_id = sliceTable->ic_instance_id;
 	}
 
+	ic_statistics.startTime = getCurrentTime();
+
 	interconnect_context = palloc0(sizeof(ChunkTransportState));
 
 	/* initialize state variables */
@@ -3109,6 +3459,8 @@ SetupUDPIFCInterconnect_Internal(SliceTable *sliceTable)
 		rx_control_info.lastDXatId = distTransId;
 	}
 
+	localAddr = getShmLocalAddr(mySlice);
+
 	/* now we'll do some setup for each of our Receiving Motion Nodes. */
 	foreach(cell, mySlice->children)
 	{
@@ -3149,6 +3501,18 @@ SetupUDPIFCInterconnect_Internal(SliceTable *sliceTable)
 				/* update the max buffer count of our rx buffer pool.  */
 				rx_buffer_pool.maxCount += conn->pkt_q_capacity;
 
+				if (useShmRing(localAddr, conn->cdbProc))
+				{
+					attachShmRing(interconnect_context, pEntry, conn,
+								  conn->cdbProc->pid, MyProcPid);
+
+					/*
+					 * The port of the sender is only known once it has
+					 * attached, see wakeShmSender().
+					 */
+					getSockAddr(&conn->peer, &conn->peer_len, conn->cdbProc->listenerAddr, 0);
+				}
+
 
 				/*
 				 * connection header info (defining characteristics of this
@@ -3290,6 +3654,7 @@ SetupUDPIFCInterconnect(EState *estate)
 				connDelHash(ht, conn);
 			}
 		}
+		ic_shm_ring_detach_instance(estate->es_sliceTable->ic_instance_id);
 		pthread_mutex_unlock(&ic_control_info.lock);
 
 		PG_RE_THROW();
@@ -3395,6 +3760,12 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 
 	bool		isReceiver = false;
 
+	double		elapsedSecs;
+	double		sndMBytes;
+	double		recvMBytes;
+
+	InterconnectStats icStats;
+
 	if (transportStates == NULL || transportStates->sliceTable == NULL)
 	{
 		elog(LOG, "TeardownUDPIFCInterconnect: missing slice table.");
@@ -3494,6 +3865,16 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 					icBufferListReturn(&conn->sndQueue, false);
 					icBufferListReturn(&conn->unackQueue, Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_CAPACITY ? false : true);
 
+					/*
+					 * The receiver may still be reading the packets we
+					 * published, it keeps its own mapping of the ring.
+					 */
+					if (conn->shmRing != NULL)
+					{
+						ic_shm_ring_detach(conn->shmRing, hasErrors);
+						conn->shmRing = NULL;
+					}
+
 					connDelHash(&ic_control_info.connHtab, conn);
 				}
 				avgRtt = avgRtt / pEntry->numConns;
@@ -3562,6 +3943,15 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 					if (!conn->pkt_q)
 						break;
 
+					/* a sender that is still at it must not wait for us */
+					if (conn->shmRing != NULL)
+					{
+						if (ic_shm_ring_request_stop(conn->shmRing))
+							wakeShmSender(conn);
+						ic_shm_ring_detach(conn->shmRing, hasErrors);
+						conn->shmRing = NULL;
+					}
+
 					rx_buffer_pool.maxCount -= conn->pkt_q_capacity;
 
 					connDelHash(&ic_control_info.connHtab, conn);
@@ -3623,6 +4013,13 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 		rx_control_info.lastTornIcId = transportStates->sliceTable->ic_instance_id;
 	}
 
+	/* syscalls per MB and packets per second, over the life of this setup */
+	elapsedSecs = (double) (getCurrentTime() - ic_statistics.startTime) / USECS_PER_SECOND;
+	if (elapsedSecs <= 0)
+		elapsedSecs = 1.0 / USECS_PER_SECOND;
+	sndMBytes = (double) ic_statistics.sndBytes / (1024 * 1024);
+	recvMBytes = (double) ic_statistics.recvBytes / (1024 * 1024);
+
 	elog((gp_interconnect_log_stats ? LOG : DEBUG1), "Interconnect State: "
 		 "isSender %d isReceiver %d "
 		 "snd_queue_depth %d recv_queue_depth %d Gp_max_packet_size %d "
@@ -3636,7 +4033,10 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 		 " freebuf_avg %f "
 		 "mismatch_pkt_num %d disordered_pkt_num %d duplicated_pkt_num %d"
 		 " rtt/dev [" UINT64_FORMAT "/" UINT64_FORMAT ", %f/%f, " UINT64_FORMAT "/" UINT64_FORMAT "] "
-		 " cwnd %f status_query_msg_num %d",
+		 " cwnd %f status_query_msg_num %d"
+		 " snd_syscalls_per_mb %f recv_syscalls_per_mb %f"
+		 " snd_pkts_per_sec %f recv_pkts_per_sec %f"
+		 " shm_snd_pkt_count %d shm_recv_pkt_count %d",
 		 ic_control_info.isSender, isReceiver,
 		 Gp_interconnect_snd_queue_depth, Gp_interconnect_queue_depth, Gp_max_packet_size,
 		 UNACK_QUEUE_RING_SLOTS_NUM, TIMER_SPAN, DEFAULT_RTT,
@@ -3649,7 +4049,20 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 		 (double) ((double) ic_statistics.totalBuffers) / ((double) ic_statistics.bufferCountingTime),
 		 ic_statistics.mismatchNum, ic_statistics.disorderedPktNum, ic_statistics.duplicatedPktNum,
 		 (minRtt == ~((uint64) 0) ? 0 : minRtt), (minDev == ~((uint64) 0) ? 0 : minDev), avgRtt, avgDev, maxRtt, maxDev,
-		 snd_control_info.cwnd, ic_statistics.statusQueryMsgNum);
+		 snd_control_info.cwnd, ic_statistics.statusQueryMsgNum,
+		 (sndMBytes > 0 ? (double) ic_statistics.sndSyscallNum / sndMBytes : 0),
+		 (recvMBytes > 0 ? (double) ic_statistics.recvSyscallNum / recvMBytes : 0),
+		 (double) ic_statistics.sndPktNum / elapsedSecs,
+		 (double) ic_statistics.recvPktNum / elapsedSecs,
+		 ic_statistics.shmSndPktNum, ic_statistics.shmRecvPktNum);
+
+	memset(&icStats, 0, sizeof(icStats));
+	icStats.pktsSent = ic_statistics.sndPktNum;
+	icStats.pktsRecvd = ic_statistics.recvPktNum;
+	icStats.retransmits = ic_statistics.retransmits;
+	icStats.crcErrors = ic_statistics.crcErrors;
+	icStats.duplicatedPkts = ic_statistics.duplicatedPktNum;
+	AddInterconnectStats(&icStats);
 
 	ic_control_info.isSender = false;
 	memset(&ic_statistics, 0, sizeof(ICStatistics));
@@ -3770,6 +4183,19 @@ receiveChunksUDPIFC(ChunkTransportState *pTransportStates, ChunkTransportStateEn
 			resetMainThreadWaiting(&rx_control_info.mainWaitingState);
 		}
 
+		/*
+		 * Arm the latch before looking at the shared-memory connections, so
+		 * that a doorbell rung after we looked still wakes us up below.
+		 */
+		ResetLatch(&ic_control_info.latch);
+
+		if (rxconn == NULL && pEntry->numShmConns > 0)
+		{
+			rxconn = pollShmConns(pEntry, conn, true);
+			if (rxconn != NULL)
+				resetMainThreadWaiting(&rx_control_info.mainWaitingState);
+		}
+
 		aggregateStatistics(pEntry);
 
 		if (rxconn != NULL)
@@ -3791,11 +4217,10 @@ receiveChunksUDPIFC(ChunkTransportState *pTransportStates, ChunkTransportStateEn
 		retries++;
 
 		/*
-		 * Ok, we've processed all the items currently in the queue. Arm the
-		 * latch (before releasing the mutex), and wait for more messages to
-		 * arrive. The RX thread will wake us up using the latch.
+		 * Ok, we've processed all the items currently in the queue. The
+		 * latch was armed above (before releasing the mutex), wait for more
+		 * messages to arrive. The RX thread will wake us up using the latch.
 		 */
-		ResetLatch(&ic_control_info.latch);
 		pthread_mutex_unlock(&ic_control_info.lock);
 
 		/*
@@ -3911,7 +4336,15 @@ RecvTupleChunkFromAnyUDPIFC_Internal(ChunkTransportState *transportStates,
 		ic_statistics.totalRecvQueueSize += conn->pkt_q_size;
 		ic_statistics.recvQueueSizeCountingTime++;
 
-		if (conn->pkt_q_size > 0)
+		if (conn->shmRing != NULL)
+		{
+			if (conn->stillActive && prepareShmConnForRead(conn))
+			{
+				found = true;
+				break;
+			}
+		}
+		else if (conn->pkt_q_size > 0)
 		{
 			found = true;
 			prepareRxConnForRead(conn);
@@ -3989,6 +4422,7 @@ RecvTupleChunkFromUDPIFC_Internal(ChunkTransportState *transportStates,
 	ChunkTransportStateEntry *pEntry = NULL;
 	MotionConn *conn = NULL;
 	int16		route;
+	bool		found = false;
 
 	if (!transportStates)
 	{
@@ -4031,10 +4465,16 @@ RecvTupleChunkFromUDPIFC_Internal(ChunkTransportState *transportStates,
 	ic_statistics.totalRecvQueueSize += conn->pkt_q_size;
 	ic_statistics.recvQueueSizeCountingTime++;
 
-	if (conn->pkt_q[conn->pkt_q_head] != NULL)
+	if (conn->shmRing != NULL)
+		found = prepareShmConnForRead(conn);
+	else if (conn->pkt_q[conn->pkt_q_head] != NULL)
 	{
 		prepareRxConnForRead(conn);
+		found = true;
+	}
 
+	if (found)
+	{
 		pthread_mutex_unlock(&ic_control_info.lock);
 
 		TupleChunkListItem tcItem = NULL;
@@ -4329,6 +4769,13 @@ handleAcks(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntr
 			}
 		}
 
+		/*
+		 * A doorbell from the receiver of a shared-memory connection only
+		 * had to wake us up.
+		 */
+		if (pkt->flags & UDPIC_FLAGS_SHM_DOORBELL)
+			continue;
+
 		/*
 		 * read packet, is this the ack we want ?
 		 */
@@ -4568,6 +5015,7 @@ sendOnce(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
 xmit_retry:
 	n = sendto(pEntry->txfd, buf->pkt, buf->pkt->len, 0,
 			   (struct sockaddr *) &conn->peer, conn->peer_len);
+	ic_statistics.sndSyscallNum++;
 	if (n < 0)
 	{
 		int			save_errno = errno;
@@ -4614,9 +5062,141 @@ xmit_retry:
 #endif
 	}
 
+	ic_statistics.sndBytes += n;
+
 	return;
 }
 
+/*
+ * sendBatch
+ * 		Send a batch of packets to the same connection.
+ *
+ * With sendmmsg(), the whole batch usually goes out in a single syscall.
+ * Errors are handled per packet, the same way sendOnce does: a packet that
+ * could not be sent is left for the retransmit logic.
+ */
+static void
+sendBatch(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
+		  ICBuffer **bufs, int nbufs, MotionConn *conn)
+{
+#ifdef HAVE_SENDMMSG
+	struct mmsghdr msgs[UDPIC_SEND_BATCH_SIZE];
+	struct iovec iovs[UDPIC_SEND_BATCH_SIZE];
+	int			nmsgs = 0;
+	int			sent = 0;
+	int			i;
+
+	Assert(nbufs <= UDPIC_SEND_BATCH_SIZE);
+
+	if (nbufs == 1)
+	{
+		sendOnce(transportStates, pEntry, bufs[0], conn);
+		return;
+	}
+
+#ifdef FAULT_INJECTOR
+	/* Send one packet per syscall, like builds without sendmmsg() do */
+	if (FaultInjector_InjectFaultIfSet(
+									   "interconnect_send_batch_fallback",
+									   DDLNotSpecified,
+									   "" /* databaseName */ ,
+									   "" /* tableName */ ) == FaultInjectorTypeSkip)
+	{
+		for (i = 0; i < nbufs; i++)
+			sendOnce(transportStates, pEntry, bufs[i], conn);
+		return;
+	}
+#endif
+
+	for (i = 0; i < nbufs; i++)
+	{
+		icpkthdr   *pkt = bufs[i]->pkt;
+
+#ifdef USE_ASSERT_CHECKING
+		if (testmode_inject_fault(gp_udpic_dropxmit_percent))
+		{
+#ifdef AMS_VERBOSE_LOGGING
+			write_log("THROW PKT with seq %d srcpid %d despid %d", pkt->seq, pkt->srcPid, pkt->dstPid);
+#endif
+			continue;
+		}
+#endif
+
+		iovs[nmsgs].iov_base = pkt;
+		iovs[nmsgs].iov_len = pkt->len;
+
+		memset(&msgs[nmsgs], 0, sizeof(struct mmsghdr));
+		msgs[nmsgs].msg_hdr.msg_name = &conn->peer;
+		msgs[nmsgs].msg_hdr.msg_namelen = conn->peer_len;
+		msgs[nmsgs].msg_hdr.msg_iov = &iovs[nmsgs];
+		msgs[nmsgs].msg_hdr.msg_iovlen = 1;
+		nmsgs++;
+	}
+
+	while (sent < nmsgs)
+	{
+		int			n;
+
+		n = sendmmsg(pEntry->txfd, msgs + sent, nmsgs - sent, 0);
+		ic_statistics.sndSyscallNum++;
+		if (n < 0)
+		{
+			int			save_errno = errno;
+
+			if (errno == EINTR)
+				continue;
+
+			/* no space ? not an error, skip the packet that failed. */
+			if (errno == EAGAIN)
+			{
+				sent++;
+				continue;
+			}
+
+			/* See sendOnce */
+			if (errno == EPERM)
+			{
+				ereport(LOG,
+						(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+						 errmsg("Interconnect error writing an outgoing packet: %m"),
+						 errdetail("error during sendmmsg() for Remote Connection: contentId=%d at %s",
+								   conn->remoteContentId, conn->remoteHostAndPort)));
+				sent++;
+				continue;
+			}
+
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("Interconnect error writing an outgoing packet: %m"),
+							errdetail("error during sendmmsg() call (error:%d).\n"
+									  "For Remote Connection: contentId=%d at %s",
+									  save_errno, conn->remoteContentId,
+									  conn->remoteHostAndPort)));
+			/* not reached */
+		}
+
+		for (i = sent; i < sent + n; i++)
+		{
+			if (msgs[i].msg_len != iovs[i].iov_len)
+			{
+				if (DEBUG1 >= log_min_messages)
+					write_log("Interconnect error writing an outgoing packet [seq %d]: short transmit (given %d sent %d) during sendmmsg() call."
+							  "For Remote Connection: contentId=%d at %s", ((icpkthdr *) iovs[i].iov_base)->seq,
+							  (int) iovs[i].iov_len, (int) msgs[i].msg_len,
+							  conn->remoteContentId,
+							  conn->remoteHostAndPort);
+			}
+			ic_statistics.sndBytes += msgs[i].msg_len;
+		}
+		sent += n;
+	}
+#else
+	int			i;
+
+	for (i = 0; i < nbufs; i++)
+		sendOnce(transportStates, pEntry, bufs[i], conn);
+#endif
+}
+
 
 /*
  * handleStopMsgs
@@ -4726,6 +5306,9 @@ handleStopMsgs(ChunkTransportState *transportStates, ChunkTransportStateEntry *p
 static void
 sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn)
 {
+	ICBuffer   *batch[UDPIC_SEND_BATCH_SIZE];
+	int			nbatch = 0;
+
 	while (conn->capacity > 0 && icBufferListLength(&conn->sndQueue) > 0)
 	{
 		ICBuffer   *buf = NULL;
@@ -4764,9 +5347,9 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 		}
 
 		/*
-		 * Note the place of sendOnce here. If we send before appending it to
+		 * Note the place of sendBatch here. If we send before appending it to
 		 * the unack queue and putting it into unack queue ring, and there is
-		 * a network error occurred in the sendOnce function, error message
+		 * a network error occurred in the sendBatch function, error message
 		 * will be output. In the time of error message output, interrupts is
 		 * potentially checked, if there is a pending query cancel, it will
 		 * lead to a dangled buffer (memory leak).
@@ -4775,7 +5358,7 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 		updateStats(TPE_DATA_PKT_SEND, conn, buf->pkt);
 #endif
 
-		sendOnce(transportStates, pEntry, buf, conn);
+		batch[nbatch++] = buf;
 		ic_statistics.sndPktNum++;
 
 #ifdef AMS_VERBOSE_LOGGING
@@ -4783,7 +5366,16 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 #endif
 
 		buf->conn->sentSeq = buf->pkt->seq;
+
+		if (nbatch == UDPIC_SEND_BATCH_SIZE)
+		{
+			sendBatch(transportStates, pEntry, batch, nbatch, conn);
+			nbatch = 0;
+		}
 	}
+
+	if (nbatch > 0)
+		sendBatch(transportStates, pEntry, batch, nbatch, conn);
 }
 
 /*
@@ -5441,6 +6033,26 @@ SendChunkUDPIFC(ChunkTransportState *transportStates,
 		return true;
 	}
 
+	/* hand the packet over to a receiver on the same host */
+	if (conn->shmRing != NULL)
+	{
+		publishShmPacket(pEntry, conn);
+
+		if (!getShmSndBuffer(transportStates, pEntry, conn, motionId))
+			return true;
+
+		/* reinitialize connection */
+		conn->tupleCount = 0;
+		conn->msgSize = sizeof(conn->conn_info);
+
+		memcpy(conn->pBuff + conn->msgSize, tcItem->chunk_data, tcItem->chunk_length);
+		conn->msgSize += length;
+
+		conn->tupleCount++;
+
+		return true;
+	}
+
 	/* prepare this for transmit */
 
 	ic_statistics.totalCapacity += conn->capacity;
@@ -5579,6 +6191,21 @@ SendEosUDPIFC(ChunkTransportState *transportStates,
 			if (pEntry->sendingEos)
 				conn->conn_info.flags |= UDPIC_FLAGS_EOS;
 
+			/*
+			 * A shared-memory connection is done once the EOS is published:
+			 * the receiver can't lose it, so there is no ack to wait for.
+			 */
+			if (conn->shmRing != NULL)
+			{
+				publishShmPacket(pEntry, conn);
+
+				conn->tupleCount = 0;
+				conn->msgSize = sizeof(conn->conn_info);
+				conn->state = mcsEosSent;
+				conn->stillActive = false;
+				continue;
+			}
+
 			prepareXmit(conn);
 
 			/* place it into the send queue */
@@ -5702,6 +6329,16 @@ doSendStopMessageUDPIFC(ChunkTransportState *transportStates, int16 motNodeID)
 					putRxBufferAndSendAck(conn, NULL);
 				}
 			}
+			else if (conn->shmRing != NULL)
+			{
+				/*
+				 * The sender notices the next time it needs a slot.  It
+				 * doesn't answer with a stop-ack EOS, so we're done too.
+				 */
+				if (ic_shm_ring_request_stop(conn->shmRing))
+					wakeShmSender(conn);
+				conn->stillActive = false;
+			}
 			else
 			{
 				conn->stopRequested = true;
@@ -6133,8 +6770,19 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 static void *
 rxThreadFunc(void *arg)
 {
-	icpkthdr   *pkt = NULL;
+	icpkthdr   *pkts[UDPIC_RECV_BATCH_SIZE] = {0};
+	int			read_counts[UDPIC_RECV_BATCH_SIZE];
+	struct sockaddr_storage peers[UDPIC_RECV_BATCH_SIZE];
+	socklen_t	peerlens[UDPIC_RECV_BATCH_SIZE];
+#ifdef HAVE_RECVMMSG
+	struct mmsghdr msgs[UDPIC_RECV_BATCH_SIZE];
+	struct iovec iovs[UDPIC_RECV_BATCH_SIZE];
+#endif
+	int			npkts = 0;
+	uint64		recvSyscalls = 0;
+	uint64		recvBytes = 0;
 	bool		skip_poll = false;
+	int			i;
 
 	for (;;)
 	{
@@ -6151,14 +6799,29 @@ rxThreadFunc(void *arg)
 			break;
 		}
 
-		/* Try to get a buffer */
-		if (pkt == NULL)
+		/*
+		 * Try to top up our receive buffers, and publish the syscall
+		 * statistics while we hold the lock anyway.
+		 */
+		if (npkts < UDPIC_RECV_BATCH_SIZE || recvSyscalls > 0)
 		{
 			pthread_mutex_lock(&ic_control_info.lock);
-			pkt = getRxBuffer(&rx_buffer_pool);
+			while (npkts < UDPIC_RECV_BATCH_SIZE)
+			{
+				icpkthdr   *buf = getRxBuffer(&rx_buffer_pool);
+
+				if (buf == NULL)
+					break;
+				pkts[npkts++] = buf;
+			}
+			ic_statistics.recvSyscallNum += recvSyscalls;
+			ic_statistics.recvBytes += recvBytes;
 			pthread_mutex_unlock(&ic_control_info.lock);
 
-			if (pkt == NULL)
+			recvSyscalls = 0;
+			recvBytes = 0;
+
+			if (npkts == 0)
 			{
 				setRxThreadError(ENOMEM);
 				continue;
@@ -6208,15 +6871,37 @@ rxThreadFunc(void *arg)
 			/* we've got something interesting to read */
 			/* handle incoming */
 			/* ready to read on our socket */
-			MotionConn *conn = NULL;
-			int			read_count = 0;
+			int			nrecv;
+			int			nkept;
+
+#ifdef HAVE_RECVMMSG
+			for (i = 0; i < npkts; i++)
+			{
+				iovs[i].iov_base = pkts[i];
+				iovs[i].iov_len = Gp_max_packet_size;
+
+				memset(&msgs[i], 0, sizeof(struct mmsghdr));
+				msgs[i].msg_hdr.msg_name = &peers[i];
+				msgs[i].msg_hdr.msg_namelen = sizeof(peers[i]);
+				msgs[i].msg_hdr.msg_iov = &iovs[i];
+				msgs[i].msg_hdr.msg_iovlen = 1;
+			}
 
-			struct sockaddr_storage peer;
-			socklen_t	peerlen;
+			/* the socket is non-blocking, so this returns what is queued */
+			nrecv = recvmmsg(UDP_listenerFd, msgs, npkts, 0, NULL);
 
-			peerlen = sizeof(peer);
-			read_count = recvfrom(UDP_listenerFd, (char *) pkt, Gp_max_packet_size, 0,
-								  (struct sockaddr *) &peer, &peerlen);
+			for (i = 0; i < nrecv; i++)
+			{
+				read_counts[i] = msgs[i].msg_len;
+				peerlens[i] = msgs[i].msg_hdr.msg_namelen;
+			}
+#else
+			peerlens[0] = sizeof(peers[0]);
+			read_counts[0] = recvfrom(UDP_listenerFd, (char *) pkts[0], Gp_max_packet_size, 0,
+									  (struct sockaddr *) &peers[0], &peerlens[0]);
+			nrecv = (read_counts[0] < 0 ? -1 : 1);
+#endif
+			recvSyscalls++;
 
 			if (pg_atomic_read_u32(&ic_control_info.shutdown) == 1)
 			{
@@ -6227,10 +6912,7 @@ rxThreadFunc(void *arg)
 				break;
 			}
 
-			if (DEBUG5 >= log_min_messages)
-				write_log("received inbound len %d", read_count);
-
-			if (read_count < 0)
+			if (nrecv < 0)
 			{
 				skip_poll = false;
 
@@ -6251,126 +6933,179 @@ rxThreadFunc(void *arg)
 				continue;
 			}
 
-			if (read_count < sizeof(icpkthdr))
-			{
-				if (DEBUG1 >= log_min_messages)
-					write_log("Interconnect error: short conn receive (%d)", read_count);
-				continue;
-			}
-
 			/*
-			 * when we get a "good" recvfrom() result, we can skip poll()
-			 * until we get a bad one.
+			 * when we get a "good" receive result, we can skip poll() until
+			 * we get a bad one.
 			 */
 			skip_poll = true;
 
-			/* length must be >= 0 */
-			if (pkt->len < 0)
+			for (i = 0; i < nrecv; i++)
 			{
-				if (DEBUG3 >= log_min_messages)
-					write_log("received inbound with negative length");
-				continue;
-			}
+				recvBytes += read_counts[i];
 
-			if (pkt->len != read_count)
-			{
-				if (DEBUG3 >= log_min_messages)
-					write_log("received inbound packet [%d], short: read %d bytes, pkt->len %d", pkt->seq, read_count, pkt->len);
-				continue;
+				if (handleRxPacket(pkts[i], read_counts[i], &peers[i], peerlens[i]))
+					pkts[i] = NULL;
 			}
 
-			/*
-			 * check the CRC of the payload.
-			 */
-			if (gp_interconnect_full_crc)
+			/* keep the buffers that were not consumed for the next round */
+			nkept = 0;
+			for (i = 0; i < npkts; i++)
 			{
-				if (!checkCRC(pkt))
-				{
-					pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.crcErrors, 1);
-					if (DEBUG2 >= log_min_messages)
-						write_log("received network data error, dropping bad packet, user data unaffected.");
-					continue;
-				}
+				if (pkts[i] != NULL)
+					pkts[nkept++] = pkts[i];
 			}
+			npkts = nkept;
+		}
 
-#ifdef AMS_VERBOSE_LOGGING
-			logPkt("GOT MESSAGE", pkt);
-#endif
+		/* pthread_yield(); */
+	}
 
-			bool		wakeup_mainthread = false;
-			AckSendParam param;
+	/* Before return, we release the packets. */
+	if (npkts > 0)
+	{
+		pthread_mutex_lock(&ic_control_info.lock);
+		for (i = 0; i < npkts; i++)
+			freeRxBuffer(&rx_buffer_pool, pkts[i]);
+		npkts = 0;
+		pthread_mutex_unlock(&ic_control_info.lock);
+	}
 
-			memset(&param, 0, sizeof(AckSendParam));
+	/* nothing to return */
+	return NULL;
+}
 
-			/*
-			 * Get the connection for the pkt.
-			 *
-			 * The connection hash table should be locked until finishing the
-			 * processing of the packet to avoid the connection
-			 * addition/removal from the hash table during the mean time.
-			 */
+/*
+ * handleRxPacket
+ * 		Called by rx thread to handle one received packet.
+ *
+ * Returns true if the packet buffer was consumed, i.e. it was queued on a
+ * connection, or it was put back into the free list.
+ *
+ * NOTE: This function MUST NOT contain elog or ereport statements.
+ * elog is NOT thread-safe.  Developers should instead use something like:
+ *
+ *	if (DEBUG3 >= log_min_messages)
+ *		write_log("my brilliant log statement here.");
+ *
+ * NOTE: In threads, we cannot use palloc/pfree, because it's not thread safe.
+ */
+static bool
+handleRxPacket(icpkthdr *pkt, int read_count, struct sockaddr_storage *peer, socklen_t peerlen)
+{
+	MotionConn *conn = NULL;
+	bool		consumed = false;
+	bool		wakeup_mainthread = false;
+	AckSendParam param;
 
-			pthread_mutex_lock(&ic_control_info.lock);
-			conn = findConnByHeader(&ic_control_info.connHtab, pkt);
+	if (DEBUG5 >= log_min_messages)
+		write_log("received inbound len %d", read_count);
 
-			if (conn != NULL)
-			{
-				/* Handling a regular packet */
-				if (handleDataPacket(conn, pkt, &peer, &peerlen, &param, &wakeup_mainthread))
-					pkt = NULL;
-				ic_statistics.recvPktNum++;
-			}
-			else
-			{
-				/*
-				 * There may have two kinds of Mismatched packets: a) Past
-				 * packets from previous command after I was torn down b)
-				 * Future packets from current command before my connections
-				 * are built.
-				 *
-				 * The handling logic is to "Ack the past and Nak the future".
-				 */
-				if ((pkt->flags & UDPIC_FLAGS_RECEIVER_TO_SENDER) == 0)
-				{
-					if (DEBUG1 >= log_min_messages)
-						write_log("mismatched packet received, seq %d, srcpid %d, dstpid %d, icid %d, sid %d", pkt->seq, pkt->srcPid, pkt->dstPid, pkt->icId, pkt->sessionId);
+	if (read_count < sizeof(icpkthdr))
+	{
+		if (DEBUG1 >= log_min_messages)
+			write_log("Interconnect error: short conn receive (%d)", read_count);
+		return false;
+	}
+
+	/* length must be >= 0 */
+	if (pkt->len < 0)
+	{
+		if (DEBUG3 >= log_min_messages)
+			write_log("received inbound with negative length");
+		return false;
+	}
+
+	if (pkt->len != read_count)
+	{
+		if (DEBUG3 >= log_min_messages)
+			write_log("received inbound packet [%d], short: read %d bytes, pkt->len %d", pkt->seq, read_count, pkt->len);
+		return false;
+	}
+
+	/*
+	 * check the CRC of the payload.
+	 */
+	if (gp_interconnect_full_crc)
+	{
+		if (!checkCRC(pkt))
+		{
+			pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.crcErrors, 1);
+			if (DEBUG2 >= log_min_messages)
+				write_log("received network data error, dropping bad packet, user data unaffected.");
+			return false;
+		}
+	}
+
+	/*
+	 * A doorbell carries no data, the sender of a shared-memory connection
+	 * published a packet: wake up the main thread to read it.
+	 */
+	if (pkt->flags & UDPIC_FLAGS_SHM_DOORBELL)
+	{
+		SetLatch(&ic_control_info.latch);
+		return false;
+	}
 
 #ifdef AMS_VERBOSE_LOGGING
-					logPkt("Got a Mismatched Packet", pkt);
+	logPkt("GOT MESSAGE", pkt);
 #endif
 
-					if (handleMismatch(pkt, &peer, peerlen))
-						pkt = NULL;
-					ic_statistics.mismatchNum++;
-				}
-			}
-			pthread_mutex_unlock(&ic_control_info.lock);
+	memset(&param, 0, sizeof(AckSendParam));
 
-			if (wakeup_mainthread)
-				SetLatch(&ic_control_info.latch);
+	/*
+	 * Get the connection for the pkt.
+	 *
+	 * The connection hash table should be locked until finishing the
+	 * processing of the packet to avoid the connection addition/removal from
+	 * the hash table during the mean time.
+	 */
 
-			/*
-			 * real ack sending is after lock release to decrease the lock
-			 * holding time.
-			 */
-			if (param.msg.len != 0)
-				sendAckWithParam(&param);
-		}
+	pthread_mutex_lock(&ic_control_info.lock);
+	conn = findConnByHeader(&ic_control_info.connHtab, pkt);
 
-		/* pthread_yield(); */
+	if (conn != NULL)
+	{
+		/* Handling a regular packet */
+		if (handleDataPacket(conn, pkt, peer, &peerlen, &param, &wakeup_mainthread))
+			consumed = true;
+		ic_statistics.recvPktNum++;
 	}
-
-	/* Before return, we release the packet. */
-	if (pkt)
+	else
 	{
-		pthread_mutex_lock(&ic_control_info.lock);
-		freeRxBuffer(&rx_buffer_pool, pkt);
-		pkt = NULL;
-		pthread_mutex_unlock(&ic_control_info.lock);
+		/*
+		 * There may have two kinds of Mismatched packets: a) Past packets
+		 * from previous command after I was torn down b) Future packets from
+		 * current command before my connections are built.
+		 *
+		 * The handling logic is to "Ack the past and Nak the future".
+		 */
+		if ((pkt->flags & UDPIC_FLAGS_RECEIVER_TO_SENDER) == 0)
+		{
+			if (DEBUG1 >= log_min_messages)
+				write_log("mismatched packet received, seq %d, srcpid %d, dstpid %d, icid %d, sid %d", pkt->seq, pkt->srcPid, pkt->dstPid, pkt->icId, pkt->sessionId);
+
+#ifdef AMS_VERBOSE_LOGGING
+			logPkt("Got a Mismatched Packet", pkt);
+#endif
+
+			if (handleMismatch(pkt, peer, peerlen))
+				consumed = true;
+			ic_statistics.mismatchNum++;
+		}
 	}
+	pthread_mutex_unlock(&ic_control_info.lock);
 
-	/* nothing to return */
-	return NULL;
+	if (wakeup_mainthread)
+		SetLatch(&ic_control_info.latch);
+
+	/*
+	 * real ack sending is after lock release to decrease the lock holding
+	 * time.
+	 */
+	if (param.msg.len != 0)
+		sendAckWithParam(&param);
+
+	return consumed;
 }
 
 /*
@@ -39,6 +39,26 @@
  */
 #define RECORD_CACHE_MAGIC_TUPLEN	-1
 
+/*
+ * A compressed tuple is sent with a special "tuple length", followed by the
+ * uncompressed length and the zstd-compressed tuple body.  Only tuple bodies
+ * of at least TUPSER_COMPRESS_MIN_LEN bytes are worth compressing.
+ */
+#define COMPRESSED_MAGIC_TUPLEN		-2
+#define TUPSER_COMPRESS_MIN_LEN		128
+
+/* zstd compression level for tuples; the fastest one */
+#define TUPSER_COMPRESS_LEVEL		1
+
+/*
+ * A batch of tuples, packed column-wise, is sent with a special "tuple
+ * length" too.  A batch is flushed early once it holds about
+ * TUPLE_BATCH_MAX_BYTES of data, so that a few wide values don't make it
+ * grow without bound.
+ */
+#define BATCH_MAGIC_TUPLEN			-3
+#define TUPLE_BATCH_MAX_BYTES		(256 * 1024)
+
 /* A MemoryContext used within the tuple serialize code, so that freeing of
  * space is SUPAFAST.  It is initialized in the first call to InitSerTupInfo()
  * since that must be called before any tuple serialization or deserialization
@@ -187,6 +207,23 @@ CleanupSerTupInfo(SerTupInfo *pSerInfo)
 		pfree(pSerInfo->nulls);
 	pSerInfo->nulls = NULL;
 
+	if (pSerInfo->compressBuf != NULL)
+		pfree(pSerInfo->compressBuf);
+	pSerInfo->compressBuf = NULL;
+	pSerInfo->compressBufLen = 0;
+
+	if (pSerInfo->recvTuples != NULL)
+		pfree(pSerInfo->recvTuples);
+	pSerInfo->recvTuples = NULL;
+	pSerInfo->nrecvTuples = 0;
+	pSerInfo->recvTuplesLen = 0;
+
+#ifdef USE_ZSTD
+	if (pSerInfo->zstd != NULL)
+		zstd_free_context(pSerInfo->zstd);
+	pSerInfo->zstd = NULL;
+#endif
+
 	pSerInfo->tupdesc = NULL;
 
 	while (pSerInfo->chunkCache.items != NULL)
@@ -349,6 +386,72 @@ SerializeRecordCacheIntoChunks(SerTupInfo *pSerInfo,
 	return;
 }
 
+#ifdef USE_ZSTD
+static zstd_context *
+getZstdContext(SerTupInfo *pSerInfo)
+{
+	if (pSerInfo->zstd == NULL)
+		pSerInfo->zstd = zstd_alloc_context();
+
+	return pSerInfo->zstd;
+}
+#endif
+
+/*
+ * Try to compress a tuple body into pSerInfo->compressBuf.
+ *
+ * Returns the compressed length, or 0 if the tuple should be sent
+ * uncompressed.
+ */
+static int
+compressTupleBody(SerTupInfo *pSerInfo, char *tupbody, int tupbodylen)
+{
+#ifdef USE_ZSTD
+	zstd_context *zstd;
+	size_t		bound;
+	size_t		compressedlen;
+
+	if (tupbodylen < TUPSER_COMPRESS_MIN_LEN)
+		return 0;
+
+	zstd = getZstdContext(pSerInfo);
+	if (zstd->cctx == NULL)
+	{
+		zstd->cctx = ZSTD_createCCtx();
+		if (zstd->cctx == NULL)
+			elog(ERROR, "out of memory");
+	}
+
+	bound = ZSTD_compressBound(tupbodylen);
+	if (pSerInfo->compressBufLen < bound)
+	{
+		if (pSerInfo->compressBuf)
+			pfree(pSerInfo->compressBuf);
+		pSerInfo->compressBuf = palloc(bound);
+		pSerInfo->compressBufLen = bound;
+	}
+
+	compressedlen = ZSTD_compressCCtx(zstd->cctx,
+									  pSerInfo->compressBuf, bound,
+									  tupbody, tupbodylen,
+									  TUPSER_COMPRESS_LEVEL);
+	if (ZSTD_isError(compressedlen))
+		elog(ERROR, "could not compress tuple: %s",
+			 ZSTD_getErrorName(compressedlen));
+
+	/* Not worth it, if we don't save at least the extra length word */
+	if (compressedlen + sizeof(int32) >= tupbodylen)
+		return 0;
+
+	pSerInfo->rawBytes += tupbodylen;
+	pSerInfo->compressedBytes += compressedlen;
+
+	return (int) compressedlen;
+#else
+	return 0;
+#endif
+}
+
 static bool
 CandidateForSerializeDirect(int16 targetRoute, struct directTransportBuffer *b)
 {
@@ -379,6 +482,11 @@ SerializeTuple(TupleTableSlot *slot, SerTupInfo *pSerInfo, struct directTranspor
 	unsigned int       tupbodylen;
 	unsigned int       tuplen;
 	bool               hasExternalAttr = false;
+	int32              lenwords[2];
+	int                lenwordslen;
+	char               *payload;
+	int                payloadlen;
+	int                compressedlen = 0;
 
 	AssertArg(pSerInfo != NULL);
 	AssertArg(b != NULL);
@@ -461,8 +569,28 @@ SerializeTuple(TupleTableSlot *slot, SerTupInfo *pSerInfo, struct directTranspor
 	tupbody = (char *) mintuple + MINIMAL_TUPLE_DATA_OFFSET;
 	tupbodylen = mintuple->t_len - MINIMAL_TUPLE_DATA_OFFSET;
 
+	if (pSerInfo->compress)
+		compressedlen = compressTupleBody(pSerInfo, tupbody, tupbodylen);
+
+	if (compressedlen > 0)
+	{
+		/* magic length, uncompressed length, compressed body */
+		lenwords[0] = COMPRESSED_MAGIC_TUPLEN;
+		lenwords[1] = tupbodylen;
+		lenwordslen = 2 * sizeof(int32);
+		payload = pSerInfo->compressBuf;
+		payloadlen = compressedlen;
+	}
+	else
+	{
+		lenwords[0] = tupbodylen;
+		lenwordslen = sizeof(int32);
+		payload = tupbody;
+		payloadlen = tupbodylen;
+	}
+
 	/* total on-wire footprint: */
-	tuplen = tupbodylen + sizeof(int);
+	tuplen = lenwordslen + payloadlen;
 
 	if (CandidateForSerializeDirect(targetRoute, b) &&
 		tuplen + TUPLE_CHUNK_HEADER_SIZE <= b->prilen)
@@ -470,8 +598,8 @@ SerializeTuple(TupleTableSlot *slot, SerTupInfo *pSerInfo, struct directTranspor
 		/*
 		 * The tuple fits in the direct transport buffer.
 		 */
-		memcpy(b->pri + TUPLE_CHUNK_HEADER_SIZE, &tupbodylen, sizeof(tupbodylen));
-		memcpy(b->pri + TUPLE_CHUNK_HEADER_SIZE + sizeof(int), tupbody, tupbodylen);
+		memcpy(b->pri + TUPLE_CHUNK_HEADER_SIZE, lenwords, lenwordslen);
+		memcpy(b->pri + TUPLE_CHUNK_HEADER_SIZE + lenwordslen, payload, payloadlen);
 
 		dataSize += tuplen;
 
@@ -494,8 +622,8 @@ SerializeTuple(TupleTableSlot *slot, SerTupInfo *pSerInfo, struct directTranspor
 
 	AssertState(s_tupSerMemCtxt != NULL);
 
-	addByteStringToChunkList(tcList, (char *) &tupbodylen, sizeof(tupbodylen), &pSerInfo->chunkCache);
-	addByteStringToChunkList(tcList, tupbody, tupbodylen, &pSerInfo->chunkCache);
+	addByteStringToChunkList(tcList, (char *) lenwords, lenwordslen, &pSerInfo->chunkCache);
+	addByteStringToChunkList(tcList, payload, payloadlen, &pSerInfo->chunkCache);
 
 	/*
 	 * GPDB_12_MERGE_FIXME: This function does not use this context. This context
@@ -538,6 +666,465 @@ SerializeTuple(TupleTableSlot *slot, SerTupInfo *pSerInfo, struct directTranspor
 	return 0;
 }
 
+/*
+ * Column-wise tuple batches.
+ *
+ * Narrow tuples are dominated by per-tuple overhead: a chunk header and a
+ * length word on the wire, and a SerializeTuple()/CvtChunksToTup() call on
+ * each side.  A batch instead carries many tuples in one message, laid out
+ * column by column.  After the BATCH_MAGIC_TUPLEN length word comes:
+ *
+ *	int32	ntuples
+ *	int32	natts
+ *
+ * and then, for each attribute:
+ *
+ *	int32	hasnulls
+ *	int32	length of the varlena data area, or 0
+ *	null bitmap, BITMAPLEN(ntuples) bytes, if hasnulls
+ *	fixed-width attribute: ntuples * typlen bytes of values
+ *	varlena attribute: ntuples + 1 int32 offsets, then the data area
+ *
+ * Each section is padded to MAXALIGN, relative to the start of the batch,
+ * so that the receiver can fetch values in place once the batch is aligned.
+ * Slots of NULL values are left in place, so that value 'i' of a column is
+ * always found at index 'i'.
+ */
+
+static void
+addPaddingToChunkList(TupleChunkList tcList, int *offset, TupleChunkListCache *cache)
+{
+	static const char zeros[MAXIMUM_ALIGNOF] = {0};
+	int			padding = MAXALIGN(*offset) - *offset;
+
+	if (padding > 0)
+		addByteStringToChunkList(tcList, (char *) zeros, padding, cache);
+	*offset += padding;
+}
+
+/*
+ * Batching only supports fixed-width and varlena attributes.  Record types
+ * are excluded too, because the record cache must be sent ahead of the first
+ * tuple that uses it.
+ */
+bool
+SerTupInfoCanBatch(SerTupInfo *pSerInfo)
+{
+	TupleDesc	tupdesc = pSerInfo->tupdesc;
+
+	if (tupdesc->natts == 0 || pSerInfo->has_record_types)
+		return false;
+
+	for (int i = 0; i < tupdesc->natts; i++)
+	{
+		SerAttrInfo *attrInfo = &pSerInfo->myinfo[i];
+
+		if (attrInfo->typlen <= 0 && attrInfo->typlen != -1)
+			return false;
+	}
+
+	return true;
+}
+
+static void
+resetTupleBatch(TupleBatch *batch, SerTupInfo *pSerInfo)
+{
+	int			natts = pSerInfo->tupdesc->natts;
+
+	for (int i = 0; i < natts; i++)
+	{
+		TupleBatchColumn *col = &batch->columns[i];
+
+		col->hasnulls = false;
+		memset(col->nullbitmap, 0, BITMAPLEN(batch->maxtuples));
+		if (pSerInfo->myinfo[i].typlen == -1)
+			resetStringInfo(&col->data);
+	}
+	batch->ntuples = 0;
+	batch->nbytes = 0;
+}
+
+TupleBatch *
+CreateTupleBatch(SerTupInfo *pSerInfo)
+{
+	TupleBatch *batch;
+	int			natts = pSerInfo->tupdesc->natts;
+	int			maxtuples = pSerInfo->batchSize;
+
+	Assert(maxtuples > 0);
+
+	batch = palloc0(sizeof(TupleBatch));
+	batch->maxtuples = maxtuples;
+	batch->columns = palloc0(natts * sizeof(TupleBatchColumn));
+
+	for (int i = 0; i < natts; i++)
+	{
+		TupleBatchColumn *col = &batch->columns[i];
+		int16		typlen = pSerInfo->myinfo[i].typlen;
+
+		col->nullbitmap = palloc(BITMAPLEN(maxtuples));
+		if (typlen == -1)
+		{
+			col->offsets = palloc((maxtuples + 1) * sizeof(int32));
+			initStringInfo(&col->data);
+		}
+		else
+			col->values = palloc0(maxtuples * typlen);
+	}
+	resetTupleBatch(batch, pSerInfo);
+
+	return batch;
+}
+
+bool
+AddTupleToBatch(TupleBatch *batch, TupleTableSlot *slot, SerTupInfo *pSerInfo)
+{
+	TupleDesc	tupdesc = pSerInfo->tupdesc;
+	int			natts = tupdesc->natts;
+	int			row = batch->ntuples;
+
+	Assert(row < batch->maxtuples);
+
+	slot_getallattrs(slot);
+
+	for (int i = 0; i < natts; i++)
+	{
+		TupleBatchColumn *col = &batch->columns[i];
+		SerAttrInfo *attrInfo = &pSerInfo->myinfo[i];
+		Datum		val = slot->tts_values[i];
+
+		if (slot->tts_isnull[i] || TupleDescAttr(tupdesc, i)->attisdropped)
+		{
+			col->hasnulls = true;
+			if (attrInfo->typlen == -1)
+				col->offsets[row] = col->data.len;
+			continue;
+		}
+		col->nullbitmap[row >> 3] |= (1 << (row & 0x07));
+
+		if (attrInfo->typlen == -1)
+		{
+			struct varlena *attr = (struct varlena *) DatumGetPointer(val);
+			struct varlena *detoasted = NULL;
+
+			/* Like SerializeTuple(), don't send toast pointers */
+			if (VARATT_IS_EXTERNAL(attr))
+				attr = detoasted = heap_tuple_fetch_attr(attr);
+
+			/* Values with a 4-byte header must stay aligned, for VARSIZE */
+			if (!VARATT_IS_SHORT(attr))
+			{
+				while (col->data.len != INTALIGN(col->data.len))
+					appendStringInfoCharMacro(&col->data, '\0');
+			}
+			col->offsets[row] = col->data.len;
+			appendBinaryStringInfo(&col->data, (char *) attr, VARSIZE_ANY(attr));
+			batch->nbytes += VARSIZE_ANY(attr);
+
+			if (detoasted)
+				pfree(detoasted);
+		}
+		else
+		{
+			char	   *dst = col->values + row * attrInfo->typlen;
+
+			if (attrInfo->typbyval)
+				store_att_byval(dst, val, attrInfo->typlen);
+			else
+				memcpy(dst, DatumGetPointer(val), attrInfo->typlen);
+			batch->nbytes += attrInfo->typlen;
+		}
+	}
+
+	batch->ntuples++;
+
+	return batch->ntuples >= batch->maxtuples ||
+		batch->nbytes >= TUPLE_BATCH_MAX_BYTES;
+}
+
+/*
+ * Convert a batch of tuples into a byte-sequence, and store it in a
+ * chunklist for transmission.  The batch is emptied, ready for reuse.
+ */
+void
+SerializeTupleBatch(TupleBatch *batch, SerTupInfo *pSerInfo, TupleChunkList tcList)
+{
+	TupleChunkListCache *cache = &pSerInfo->chunkCache;
+	TupleChunkListItem tcItem;
+	int			natts = pSerInfo->tupdesc->natts;
+	int			ntuples = batch->ntuples;
+	int32		header[2];
+	int			offset;
+
+	AssertArg(ntuples > 0);
+
+	tcList->p_first = NULL;
+	tcList->p_last = NULL;
+	tcList->num_chunks = 0;
+	tcList->serialized_data_length = 0;
+	tcList->max_chunk_length = Gp_max_tuple_chunk_size;
+
+	tcItem = getChunkFromCache(cache);
+	SetChunkType(tcItem->chunk_data, TC_WHOLE);
+	tcItem->chunk_length = TUPLE_CHUNK_HEADER_SIZE;
+	appendChunkToTCList(tcList, tcItem);
+
+	addInt32ToChunkList(tcList, BATCH_MAGIC_TUPLEN, cache);
+
+	/* Offsets for alignment are counted from here on */
+	header[0] = ntuples;
+	header[1] = natts;
+	addByteStringToChunkList(tcList, (char *) header, sizeof(header), cache);
+	offset = sizeof(header);
+
+	for (int i = 0; i < natts; i++)
+	{
+		TupleBatchColumn *col = &batch->columns[i];
+		int16		typlen = pSerInfo->myinfo[i].typlen;
+
+		header[0] = col->hasnulls;
+		header[1] = (typlen == -1) ? col->data.len : 0;
+		addByteStringToChunkList(tcList, (char *) header, sizeof(header), cache);
+		offset += sizeof(header);
+
+		if (col->hasnulls)
+		{
+			addByteStringToChunkList(tcList, (char *) col->nullbitmap,
+									 BITMAPLEN(ntuples), cache);
+			offset += BITMAPLEN(ntuples);
+			addPaddingToChunkList(tcList, &offset, cache);
+		}
+
+		if (typlen == -1)
+		{
+			col->offsets[ntuples] = col->data.len;
+			addByteStringToChunkList(tcList, (char *) col->offsets,
+									 (ntuples + 1) * sizeof(int32), cache);
+			offset += (ntuples + 1) * sizeof(int32);
+			addPaddingToChunkList(tcList, &offset, cache);
+
+			if (col->data.len > 0)
+				addByteStringToChunkList(tcList, col->data.data, col->data.len, cache);
+			offset += col->data.len;
+		}
+		else
+		{
+			addByteStringToChunkList(tcList, col->values, ntuples * typlen, cache);
+			offset += ntuples * typlen;
+		}
+		addPaddingToChunkList(tcList, &offset, cache);
+	}
+
+	if (tcList->num_chunks > 1)
+	{
+		SetChunkType(tcList->p_first->chunk_data, TC_PARTIAL_START);
+		SetChunkType(tcList->p_last->chunk_data, TC_PARTIAL_END);
+	}
+
+	pSerInfo->batches++;
+	pSerInfo->batchedTuples += ntuples;
+
+	resetTupleBatch(batch, pSerInfo);
+}
+
+/*
+ * Decode a batch of tuples sent by SerializeTupleBatch() into
+ * pSerInfo->recvTuples.  'pos' points just past the magic length word.
+ */
+static void
+deserializeTupleBatch(SerTupInfo *pSerInfo, char *pos, int len)
+{
+	TupleDesc	tupdesc = pSerInfo->tupdesc;
+	int			natts = tupdesc->natts;
+	char	   *buf = pos;
+	bool		mustfree = false;
+	char	   *end;
+	int32		header[2];
+	int			ntuples;
+	Datum	   *values;
+	bool	   *nulls;
+
+#define BATCH_CHECK_SPACE(p, n) \
+	do { \
+		if ((n) < 0 || (p) + (n) > end) \
+			ereport(ERROR, \
+					(errcode(ERRCODE_PROTOCOL_VIOLATION), \
+					 errmsg("tuple batch is truncated"))); \
+	} while (0)
+
+	/*
+	 * The sender aligned each section relative to the start of the batch.
+	 * Make sure the batch itself is aligned too, so that values can be
+	 * fetched in place.
+	 */
+	if (pos != (char *) MAXALIGN(pos))
+	{
+		buf = palloc(len);
+		memcpy(buf, pos, len);
+		mustfree = true;
+	}
+	end = buf + len;
+	pos = buf;
+
+	BATCH_CHECK_SPACE(pos, (int) sizeof(header));
+	memcpy(header, pos, sizeof(header));
+	pos += sizeof(header);
+	ntuples = header[0];
+	if (ntuples <= 0 || ntuples > MaxAllocSize / sizeof(Datum) / Max(natts, 1) ||
+		header[1] != natts)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("invalid tuple batch header: %d tuples, %d attributes",
+						ntuples, header[1])));
+
+	/*
+	 * Decode the values column by column, into row-major arrays that
+	 * heap_form_minimal_tuple() can use directly.
+	 */
+	values = palloc(ntuples * natts * sizeof(Datum));
+	nulls = palloc(ntuples * natts * sizeof(bool));
+
+	for (int i = 0; i < natts; i++)
+	{
+		SerAttrInfo *attrInfo = &pSerInfo->myinfo[i];
+		int16		typlen = attrInfo->typlen;
+		bits8	   *nullbitmap = NULL;
+		int			datalen;
+
+		BATCH_CHECK_SPACE(pos, (int) sizeof(header));
+		memcpy(header, pos, sizeof(header));
+		pos += sizeof(header);
+		datalen = header[1];
+
+		if (header[0])
+		{
+			BATCH_CHECK_SPACE(pos, BITMAPLEN(ntuples));
+			nullbitmap = (bits8 *) pos;
+			pos += MAXALIGN(BITMAPLEN(ntuples));
+		}
+
+		if (typlen == -1)
+		{
+			int32	   *offsets = (int32 *) pos;
+			char	   *data;
+
+			BATCH_CHECK_SPACE(pos, (ntuples + 1) * (int) sizeof(int32));
+			pos += MAXALIGN((ntuples + 1) * sizeof(int32));
+			BATCH_CHECK_SPACE(pos, datalen);
+			data = pos;
+			pos += MAXALIGN(datalen);
+
+			for (int row = 0; row < ntuples; row++)
+			{
+				int			idx = row * natts + i;
+
+				if (nullbitmap && att_isnull(row, nullbitmap))
+				{
+					values[idx] = (Datum) 0;
+					nulls[idx] = true;
+					continue;
+				}
+
+				if (offsets[row] < 0 || offsets[row] >= offsets[row + 1] ||
+					offsets[row + 1] > datalen ||
+					VARSIZE_ANY(data + offsets[row]) > offsets[row + 1] - offsets[row])
+					ereport(ERROR,
+							(errcode(ERRCODE_PROTOCOL_VIOLATION),
+							 errmsg("invalid varlena offset in tuple batch")));
+
+				values[idx] = PointerGetDatum(data + offsets[row]);
+				nulls[idx] = false;
+			}
+		}
+		else
+		{
+			char	   *colvalues = pos;
+
+			BATCH_CHECK_SPACE(pos, ntuples * typlen);
+			pos += MAXALIGN(ntuples * typlen);
+
+			for (int row = 0; row < ntuples; row++)
+			{
+				int			idx = row * natts + i;
+
+				if (nullbitmap && att_isnull(row, nullbitmap))
+				{
+					values[idx] = (Datum) 0;
+					nulls[idx] = true;
+					continue;
+				}
+
+				values[idx] = fetch_att(colvalues + row * typlen,
+										attrInfo->typbyval, typlen);
+				nulls[idx] = false;
+			}
+		}
+	}
+
+	if (pSerInfo->recvTuplesLen < ntuples)
+	{
+		if (pSerInfo->recvTuples)
+			pfree(pSerInfo->recvTuples);
+		pSerInfo->recvTuples = palloc(ntuples * sizeof(MinimalTuple));
+		pSerInfo->recvTuplesLen = ntuples;
+	}
+
+	for (int row = 0; row < ntuples; row++)
+		pSerInfo->recvTuples[row] =
+			heap_form_minimal_tuple(tupdesc, &values[row * natts], &nulls[row * natts]);
+	pSerInfo->nrecvTuples = ntuples;
+
+	pSerInfo->batches++;
+	pSerInfo->batchedTuples += ntuples;
+
+	pfree(values);
+	pfree(nulls);
+	if (mustfree)
+		pfree(buf);
+
+#undef BATCH_CHECK_SPACE
+}
+
+/*
+ * Decompress a tuple body sent by compressTupleBody().
+ */
+static void
+decompressTupleBody(SerTupInfo *pSerInfo, char *src, int srclen,
+					char *dst, int dstlen)
+{
+#ifdef USE_ZSTD
+	zstd_context *zstd;
+	size_t		decompressedlen;
+
+	zstd = getZstdContext(pSerInfo);
+	if (zstd->dctx == NULL)
+	{
+		zstd->dctx = ZSTD_createDCtx();
+		if (zstd->dctx == NULL)
+			elog(ERROR, "out of memory");
+	}
+
+	decompressedlen = ZSTD_decompressDCtx(zstd->dctx, dst, dstlen, src, srclen);
+	if (ZSTD_isError(decompressedlen))
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("could not decompress tuple: %s",
+						ZSTD_getErrorName(decompressedlen))));
+	if (decompressedlen != dstlen)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("decompressed tuple has length %zu, expected %d",
+						decompressedlen, dstlen)));
+
+	pSerInfo->rawBytes += dstlen;
+	pSerInfo->compressedBytes += srclen;
+#else
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("received a compressed tuple, but zstd is not supported by this build")));
+#endif
+}
+
 /*
  * Reassemble and deserialize a list of tuple chunks, into a tuple.
  */
@@ -694,6 +1281,38 @@ CvtChunksToTup(TupleChunkList tcList, SerTupInfo *pSerInfo, TupleRemapper *remap
 
 			return NULL;
 		}
+		else if (tupbodylen == BATCH_MAGIC_TUPLEN)
+		{
+			/* A batch of tuples; the caller collects them from pSerInfo */
+			deserializeTupleBatch(pSerInfo, pos, serData.len - sizeof(int32));
+
+			if (serDataMustFree)
+				pfree(serData.data);
+
+			return NULL;
+		}
+		else if (tupbodylen == COMPRESSED_MAGIC_TUPLEN)
+		{
+			/* A compressed MinimalTuple */
+			int			rawlen;
+			int			compressedlen;
+
+			memcpy(&rawlen, pos, sizeof(rawlen));
+			pos += sizeof(rawlen);
+			compressedlen = serData.len - 2 * sizeof(int32);
+
+			if (rawlen < 0 || rawlen > MaxAllocSize - MINIMAL_TUPLE_DATA_OFFSET ||
+				compressedlen <= 0)
+				ereport(ERROR,
+						(errcode(ERRCODE_PROTOCOL_VIOLATION),
+						 errmsg("invalid compressed tuple length %d", rawlen)));
+
+			tup = palloc(rawlen + MINIMAL_TUPLE_DATA_OFFSET);
+			tup->t_len = rawlen + MINIMAL_TUPLE_DATA_OFFSET;
+
+			decompressTupleBody(pSerInfo, pos, compressedlen,
+								(char *) tup + MINIMAL_TUPLE_DATA_OFFSET, rawlen);
+		}
 		else
 		{
 			/* A normal MinimalTuple */
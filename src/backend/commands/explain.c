@@ -227,6 +227,8 @@ ExplainQuery(ParseState *pstate, ExplainStmt *stmt, const char *queryString,
 			es->dxl = defGetBoolean(opt);
 		else if (strcmp(opt->defname, "slicetable") == 0)
 			es->slicetable = defGetBoolean(opt);
+		else if (strcmp(opt->defname, "dispatch") == 0)
+			es->dispatch = defGetBoolean(opt);
 		else
 			ereport(ERROR,
 					(errcode(ERRCODE_SYNTAX_ERROR),
@@ -252,6 +254,11 @@ ExplainQuery(ParseState *pstate, ExplainStmt *stmt, const char *queryString,
 	/* if the summary was not set explicitly, set default value */
 	es->summary = (summary_set) ? es->summary : es->analyze;
 
+	if (es->dispatch && !es->analyze)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("EXPLAIN option DISPATCH requires ANALYZE")));
+
 	if (explain_memory_verbosity >= EXPLAIN_MEMORY_VERBOSITY_DETAIL)
 		es->memory_detail = true;
 
@@ -678,6 +685,10 @@ ExplainOnePlan(PlannedStmt *plannedstmt, IntoClause *into, ExplainState *es,
 	if (es->slicetable)
 		ExplainPrintSliceTable(es, queryDesc);
 
+	/* Print how long it took to dispatch the plan and collect the results */
+	if (es->dispatch)
+		cdbexplain_showDispatchStats(queryDesc, es);
+
 	/* Print info about runtime of triggers */
 	if (es->analyze)
 		ExplainPrintTriggers(es, queryDesc);
@@ -2330,6 +2341,8 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			show_agg_keys(castNode(AggState, planstate), ancestors, es);
 			show_upper_qual(plan->qual, "Filter", planstate, ancestors, es);
 			show_hashagg_info((AggState *) planstate, es);
+			if (((AggState *) planstate)->vecstate)
+				ExplainPropertyBool("Vectorized", true, es);
 			if (plan->qual)
 				show_instrumentation_count("Rows Removed by Filter", 1,
 										   planstate, es);
@@ -2401,6 +2414,14 @@ ExplainNode(PlanState *planstate, List *ancestors,
 									 "Hash Module: %d\n",
 									 pMotion->numHashSegments);
 				}
+				if (pMotion->hotKeyHashes != NIL)
+				{
+					ExplainPropertyInteger("Skewed Keys", NULL,
+										   list_length(pMotion->hotKeyHashes), es);
+					ExplainPropertyText("Skewed Key Routing",
+										pMotion->broadcastHotKeys ? "broadcast" : "spread",
+										es);
+				}
 			}
 			break;
 		case T_AssertOp:
@@ -61,9 +61,14 @@ typedef struct CdbExplain_StatInst
 	bool		workfileCreated;	/* workfile created in this node */
 	instr_time	firststart;		/* Start time of first iteration of node */
 	int			numPartScanned; /* Number of part tables scanned */
+	double		workfileWritten;	/* bytes written to workfiles */
+	double		workfileRead;	/* bytes read from workfiles */
+	double		workfileWriteTime;	/* time spent writing workfiles (ms) */
+	double		workfileReadTime;	/* time spent reading workfiles (ms) */
 
 	TuplesortInstrumentation sortstats; /* Sort stats, if this is a Sort node */
 	HashInstrumentation hashstats; /* Hash stats, if this is a Hash node */
+	int			nworkers_launched;	/* Parallel workers, if this is a Gather */
 	int			bnotes;			/* Offset to beginning of node's extra text */
 	int			enotes;			/* Offset to end of node's extra text */
 } CdbExplain_StatInst;
@@ -122,6 +127,11 @@ typedef struct CdbExplain_NodeSummary
 	CdbExplain_Agg workmemused;
 	CdbExplain_Agg workmemwanted;
 	CdbExplain_Agg totalWorkfileCreated;
+	/* Workfile I/O done by the node */
+	CdbExplain_Agg workfileWritten;
+	CdbExplain_Agg workfileRead;
+	CdbExplain_Agg workfileWriteTime;
+	CdbExplain_Agg workfileReadTime;
 	/* Used for DynamicSeqScan, DynamicIndexScan and DynamicBitmapHeapScan */
 	CdbExplain_Agg totalPartTableScanned;
 	/* Summary of space used by sort */
@@ -262,6 +272,8 @@ cdbexplain_showExecStatsEnd(struct PlannedStmt *stmt,
 
 static void cdbexplain_showExecStats(struct PlanState *planstate,
 									 ExplainState *es);
+static void cdbexplain_showDispatchStats(QueryDesc *queryDesc,
+										 ExplainState *es);
 static CdbVisitOpt cdbexplain_localStatWalker(PlanState *planstate,
 											  void *context);
 static CdbVisitOpt cdbexplain_sendStatWalker(PlanState *planstate,
@@ -834,6 +846,10 @@ cdbexplain_collectStatsFromNode(PlanState *planstate, CdbExplain_SendStatCtx *ct
 	si->workfileCreated = instr->workfileCreated;
 	si->firststart = instr->firststart;
 	si->numPartScanned = instr->numPartScanned;
+	si->workfileWritten = (double) instr->workfileusage.bytes_written;
+	si->workfileRead = (double) instr->workfileusage.bytes_read;
+	si->workfileWriteTime = INSTR_TIME_GET_MILLISEC(instr->workfileusage.write_time);
+	si->workfileReadTime = INSTR_TIME_GET_MILLISEC(instr->workfileusage.read_time);
 
 	if (IsA(planstate, SortState))
 	{
@@ -848,6 +864,10 @@ cdbexplain_collectStatsFromNode(PlanState *planstate, CdbExplain_SendStatCtx *ct
 		if (hashstate->hashtable)
 			ExecHashGetInstrumentation(&si->hashstats, hashstate->hashtable);
 	}
+	if (IsA(planstate, GatherState))
+		si->nworkers_launched = ((GatherState *) planstate)->nworkers_launched;
+	if (IsA(planstate, GatherMergeState))
+		si->nworkers_launched = ((GatherMergeState *) planstate)->nworkers_launched;
 }								/* cdbexplain_collectStatsFromNode */
 
 
@@ -973,6 +993,7 @@ cdbexplain_depositStatsToNode(PlanState *planstate, CdbExplain_RecvStatCtx *ctx)
 	CdbExplain_DepStatAcc vmem_reserved;
 	CdbExplain_DepStatAcc totalPartTableScanned;
 	CdbExplain_DepStatAcc sortSpaceUsed[NUM_SORT_SPACE_TYPE][NUM_SORT_METHOD];
+	int			nworkers_launched = 0;
 	int			imsgptr;
 	int			nInst;
 
@@ -1041,6 +1062,10 @@ cdbexplain_depositStatsToNode(PlanState *planstate, CdbExplain_RecvStatCtx *ctx)
 		cdbexplain_depStatAcc_upd(&workmemwanted, rsi->workmemwanted, rsh, rsi, nsi);
 		cdbexplain_depStatAcc_upd(&totalWorkfileCreated, (rsi->workfileCreated ? 1 : 0), rsh, rsi, nsi);
 		cdbexplain_depStatAcc_upd(&totalPartTableScanned, rsi->numPartScanned, rsh, rsi, nsi);
+		cdbexplain_agg_upd(&ns->workfileWritten, rsi->workfileWritten, rsh->segindex);
+		cdbexplain_agg_upd(&ns->workfileRead, rsi->workfileRead, rsh->segindex);
+		cdbexplain_agg_upd(&ns->workfileWriteTime, rsi->workfileWriteTime, rsh->segindex);
+		cdbexplain_agg_upd(&ns->workfileReadTime, rsi->workfileReadTime, rsh->segindex);
 		Assert(rsi->sortstats.sortMethod < NUM_SORT_METHOD);
 		Assert(rsi->sortstats.spaceType < NUM_SORT_SPACE_TYPE);
 		if (rsi->sortstats.sortMethod != SORT_TYPE_STILL_IN_PROGRESS)
@@ -1057,11 +1082,22 @@ cdbexplain_depositStatsToNode(PlanState *planstate, CdbExplain_RecvStatCtx *ctx)
 									  (double) rsi->sortstats.spaceUsed, rsh, rsi, nsi);
 		}
 
+		nworkers_launched = Max(nworkers_launched, rsi->nworkers_launched);
+
 		/* Update per-slice accumulators. */
 		cdbexplain_depStatAcc_upd(&peakmemused, rsh->worker.peakmemused, rsh, rsi, nsi);
 		cdbexplain_depStatAcc_upd(&vmem_reserved, rsh->worker.vmem_reserved, rsh, rsi, nsi);
 	}
 
+	/*
+	 * A Gather runs its workers in the qExecs, so show the most workers that
+	 * any of them launched, rather than the qDisp's own count of zero.
+	 */
+	if (IsA(planstate, GatherState))
+		((GatherState *) planstate)->nworkers_launched = nworkers_launched;
+	if (IsA(planstate, GatherMergeState))
+		((GatherMergeState *) planstate)->nworkers_launched = nworkers_launched;
+
 	/* Save per-node accumulated stats in NodeSummary. */
 	ns->ntuples = ntuples.agg;
 	ns->execmemused = execmemused.agg;
@@ -1562,6 +1598,44 @@ cdbexplain_showExecStats(struct PlanState *planstate, ExplainState *es)
 		}
 	}
 
+	/*
+	 * Workfile I/O done by this node, summed over all segments
+	 */
+	if (es->analyze && es->verbose &&
+		(ns->workfileWritten.vcnt > 0 || ns->workfileRead.vcnt > 0))
+	{
+		int			nsegs = Max(ns->workfileWritten.vcnt, ns->workfileRead.vcnt);
+
+		if (es->format == EXPLAIN_FORMAT_TEXT)
+		{
+			appendStringInfoSpaces(es->str, es->indent * 2);
+			appendStringInfo(es->str, "Workfile I/O: written %ldkB",
+							 (long) kb(ns->workfileWritten.vsum));
+			if (es->timing)
+				appendStringInfo(es->str, " in %.3f ms",
+								 ns->workfileWriteTime.vsum);
+			appendStringInfo(es->str, ", read %ldkB",
+							 (long) kb(ns->workfileRead.vsum));
+			if (es->timing)
+				appendStringInfo(es->str, " in %.3f ms",
+								 ns->workfileReadTime.vsum);
+			appendStringInfo(es->str, "  Segments: %d\n", nsegs);
+		}
+		else
+		{
+			ExplainOpenGroup("Workfile I/O", "Workfile I/O", true, es);
+			ExplainPropertyInteger("Written", "kB", kb(ns->workfileWritten.vsum), es);
+			ExplainPropertyInteger("Read", "kB", kb(ns->workfileRead.vsum), es);
+			if (es->timing)
+			{
+				ExplainPropertyFloat("Write Time", "ms", ns->workfileWriteTime.vsum, 3, es);
+				ExplainPropertyFloat("Read Time", "ms", ns->workfileReadTime.vsum, 3, es);
+			}
+			ExplainPropertyInteger("Segments", NULL, nsegs, es);
+			ExplainCloseGroup("Workfile I/O", "Workfile I/O", true, es);
+		}
+	}
+
 	bool 			haveExtraText = false;
 	StringInfoData	extraData;
 
@@ -2093,3 +2167,130 @@ show_motion_keys(PlanState *planstate, List *hashExpr, int nkeys, AttrNumber *ke
 		ExplainPropertyText("Hash Key", exprstr, es);
     }
 }
+
+/*
+ * cdbexplain_showDispatchStats
+ *	  Show the dispatcher's timing for the query, for EXPLAIN (ANALYZE,
+ *	  DISPATCH): per slice, the time and bytes it took to hand the command to
+ *	  its QEs and the latency until the QEs' first result data and
+ *	  completion; for the whole query, the time spent sending, waiting for
+ *	  and processing results.
+ */
+static void
+cdbexplain_showDispatchStats(QueryDesc *queryDesc, ExplainState *es)
+{
+	CdbDispatcherState *ds = queryDesc->estate->dispatcherState;
+	CdbDispatchResults *results;
+	int			sliceIndex;
+
+	if (ds == NULL || ds->primaryResults == NULL)
+		return;
+	results = ds->primaryResults;
+
+	ExplainOpenGroup("Dispatch statistics", "Dispatch statistics", true, es);
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+		appendStringInfoString(es->str, "Dispatch statistics:\n");
+
+	ExplainOpenGroup("Slices", "Slices", false, es);
+	for (sliceIndex = 0; sliceIndex < results->sliceCapacity; sliceIndex++)
+	{
+		CdbDispatchResults_SliceInfo *si = &results->sliceMap[sliceIndex];
+		double		dispatchTime = INSTR_TIME_GET_MILLISEC(si->dispatchTime);
+		double		firstSum = 0;
+		double		firstMax = -1;
+		double		finishMax = -1;
+		int			firstMaxSeg = -1;
+		int			finishMaxSeg = -1;
+		int			nfirst = 0;
+		int			i;
+
+		if (si->resultBegin == si->resultEnd)
+			continue;
+
+		for (i = si->resultBegin; i < si->resultEnd; i++)
+		{
+			CdbDispatchResult *dispatchResult = &results->resultArray[i];
+			double		first = cdbdisp_elapsedMs(dispatchResult->firstResultTime,
+												  dispatchResult->sendTime);
+			double		finish = cdbdisp_elapsedMs(dispatchResult->finishTime,
+												   dispatchResult->sendTime);
+
+			if (first >= 0)
+			{
+				firstSum += first;
+				nfirst++;
+				if (first > firstMax)
+				{
+					firstMax = first;
+					firstMaxSeg = dispatchResult->segdbDesc->segindex;
+				}
+			}
+			if (finish > finishMax)
+			{
+				finishMax = finish;
+				finishMaxSeg = dispatchResult->segdbDesc->segindex;
+			}
+		}
+
+		if (es->format == EXPLAIN_FORMAT_TEXT)
+		{
+			appendStringInfo(es->str,
+							 "  (slice%d)    Dispatch: %.3f ms, " UINT64_FORMAT " bytes to %d QEs",
+							 sliceIndex, dispatchTime, si->dispatchBytes,
+							 si->resultEnd - si->resultBegin);
+			if (nfirst > 0)
+				appendStringInfo(es->str,
+								 ".  First result: %.3f ms avg x %d workers, %.3f ms max (seg%d)",
+								 firstSum / nfirst, nfirst, firstMax, firstMaxSeg);
+			if (finishMax >= 0)
+				appendStringInfo(es->str, ".  Finished: %.3f ms max (seg%d)",
+								 finishMax, finishMaxSeg);
+			appendStringInfoString(es->str, ".\n");
+		}
+		else
+		{
+			ExplainOpenGroup("Slice", NULL, true, es);
+			ExplainPropertyInteger("Slice", NULL, sliceIndex, es);
+			ExplainPropertyFloat("Dispatch Time", "ms", dispatchTime, 3, es);
+			ExplainPropertyInteger("Dispatch Bytes", "bytes", si->dispatchBytes, es);
+			ExplainPropertyInteger("Workers", NULL, si->resultEnd - si->resultBegin, es);
+			if (nfirst > 0)
+			{
+				ExplainPropertyFloat("Average First Result Latency", "ms",
+									 firstSum / nfirst, 3, es);
+				ExplainPropertyFloat("Maximum First Result Latency", "ms",
+									 firstMax, 3, es);
+				ExplainPropertyInteger("Maximum First Result Latency Segment", NULL,
+									   firstMaxSeg, es);
+			}
+			if (finishMax >= 0)
+			{
+				ExplainPropertyFloat("Maximum Finish Latency", "ms", finishMax, 3, es);
+				ExplainPropertyInteger("Maximum Finish Latency Segment", NULL,
+									   finishMaxSeg, es);
+			}
+			ExplainCloseGroup("Slice", NULL, true, es);
+		}
+	}
+	ExplainCloseGroup("Slices", "Slices", false, es);
+
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+		appendStringInfo(es->str,
+						 "  Flush: %.3f ms.  Wait: %.3f ms, %d wakeups.  Result processing: %.3f ms.\n",
+						 INSTR_TIME_GET_MILLISEC(results->flushTime),
+						 INSTR_TIME_GET_MILLISEC(results->waitTime),
+						 results->numWakeups,
+						 INSTR_TIME_GET_MILLISEC(results->processTime));
+	else
+	{
+		ExplainPropertyFloat("Flush Time", "ms",
+							 INSTR_TIME_GET_MILLISEC(results->flushTime), 3, es);
+		ExplainPropertyFloat("Wait Time", "ms",
+							 INSTR_TIME_GET_MILLISEC(results->waitTime), 3, es);
+		ExplainPropertyInteger("Wakeups", NULL, results->numWakeups, es);
+		ExplainPropertyFloat("Result Processing Time", "ms",
+							 INSTR_TIME_GET_MILLISEC(results->processTime), 3, es);
+	}
+
+	ExplainCloseGroup("Dispatch statistics", "Dispatch statistics", true, es);
+}
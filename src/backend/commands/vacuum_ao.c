@@ -37,6 +37,13 @@
  * The orchestration of the phases mostly happens in vacuum_rel() (vacuum.c).
  * This file contains functions implementing the phases.
  *
+ * Each phase reports its progress in pg_stat_progress_vacuum, with phase
+ * 'append-optimized pre-cleanup', 'append-optimized compact' or
+ * 'append-optimized post-cleanup'. During compaction, heap_blks_total is the
+ * size of all the segment files of the table, heap_blks_scanned is the amount
+ * of segment file data read so far, and heap_blks_vacuumed is the size of the
+ * segment files that have been compacted, all in BLCKSZ units.
+ *
  * The pre-cleanup and post-cleanup phases could run in a local transaction,
  * but the compaction phase needs a distributed transaction.
  * Currently, though, we run each phase in a distributed transaction; there's
@@ -125,6 +132,7 @@
 #include "cdb/cdbappendonlyam.h"
 #include "cdb/cdbtm.h"
 #include "cdb/cdbvars.h"
+#include "commands/progress.h"
 #include "commands/vacuum.h"
 #include "pgstat.h"
 #include "postmaster/autovacuum.h"
@@ -199,6 +207,11 @@ ao_vacuum_rel_pre_cleanup(Relation onerel, int options, VacuumParams *params,
 					get_namespace_name(RelationGetNamespace(onerel)),
 					relname)));
 
+	pgstat_progress_start_command(PROGRESS_COMMAND_VACUUM,
+								  RelationGetRelid(onerel));
+	pgstat_progress_update_param(PROGRESS_VACUUM_PHASE,
+								 PROGRESS_VACUUM_PHASE_AO_PRE_CLEANUP);
+
 	AppendOnlyRecycleDeadSegments(onerel);
 
 	/*
@@ -206,6 +219,8 @@ ao_vacuum_rel_pre_cleanup(Relation onerel, int options, VacuumParams *params,
 	 * This releases space left behind by aborted inserts.
 	 */
 	AppendOnlyTruncateToEOF(onerel);
+
+	pgstat_progress_end_command();
 }
 
 
@@ -242,6 +257,11 @@ ao_vacuum_rel_post_cleanup(Relation onerel, int options, VacuumParams *params,
 	 */
 	Assert(RelationIsAoRows(onerel) || RelationIsAoCols(onerel));
 
+	pgstat_progress_start_command(PROGRESS_COMMAND_VACUUM,
+								  RelationGetRelid(onerel));
+	pgstat_progress_update_param(PROGRESS_VACUUM_PHASE,
+								 PROGRESS_VACUUM_PHASE_AO_POST_CLEANUP);
+
 	AppendOnlyRecycleDeadSegments(onerel);
 
 	vacuum_appendonly_indexes(onerel, options, bstrategy);
@@ -271,6 +291,8 @@ ao_vacuum_rel_post_cleanup(Relation onerel, int options, VacuumParams *params,
 						MultiXactCutoff,
 						false,
 						true /* isvacuum */);
+
+	pgstat_progress_end_command();
 }
 
 void
@@ -284,6 +306,7 @@ ao_vacuum_rel_compact(Relation onerel, int options, VacuumParams *params,
 	Snapshot	appendOnlyMetaDataSnapshot = RegisterSnapshot(GetCatalogSnapshot(InvalidOid));
 	char	   *relname;
 	int			elevel;
+	FileSegTotals *totals;
 
 	/*
 	 * This should run in a distributed transaction. But also allow utility
@@ -310,6 +333,19 @@ ao_vacuum_rel_compact(Relation onerel, int options, VacuumParams *params,
 					get_namespace_name(RelationGetNamespace(onerel)),
 					relname)));
 
+	pgstat_progress_start_command(PROGRESS_COMMAND_VACUUM,
+								  RelationGetRelid(onerel));
+	pgstat_progress_update_param(PROGRESS_VACUUM_PHASE,
+								 PROGRESS_VACUUM_PHASE_AO_COMPACT);
+
+	if (RelationIsAoRows(onerel))
+		totals = GetSegFilesTotals(onerel, appendOnlyMetaDataSnapshot);
+	else
+		totals = GetAOCSSSegFilesTotals(onerel, appendOnlyMetaDataSnapshot);
+	pgstat_progress_update_param(PROGRESS_VACUUM_TOTAL_HEAP_BLKS,
+								 totals->totalbytes / BLCKSZ);
+	pfree(totals);
+
 	/*
 	 * Compact all the segfiles. Repeat as many times as required.
 	 *
@@ -317,7 +353,10 @@ ao_vacuum_rel_compact(Relation onerel, int options, VacuumParams *params,
 	 * require up 2x the disk space. Alternatively, we could split this into
 	 * multiple transactions. The problem with that is that the updates to
 	 * pg_aoseg needs to happen in a distributed transaction (Problem 3), so
-	 * we would need to coordinate the transactions from the QD.
+	 * we would need to coordinate the transactions from the QD. For the same
+	 * reason, the segfiles (or the column files of an AOCS segfile) are not
+	 * compacted in background workers: they would all have to write to the
+	 * insert segfile, the block directory and pg_aoseg in this transaction.
 	 */
 	insert_segno = -1;
 	while ((compaction_segno = ChooseSegnoForCompaction(onerel, compacted_and_inserted_segments)) != -1)
@@ -354,6 +393,13 @@ ao_vacuum_rel_compact(Relation onerel, int options, VacuumParams *params,
 			compacted_and_inserted_segments = list_append_unique_int(compacted_and_inserted_segments,
 																	 insert_segno);
 
+#ifdef FAULT_INJECTOR
+		FaultInjector_InjectFaultIfSet("vacuum_ao_after_compact_segfile",
+									   DDLNotSpecified,
+									   "",	/* databaseName */
+									   relname);	/* tableName */
+#endif
+
 		/*
 		 * AppendOnlyCompact() updates pg_aoseg. Increment the command counter, so
 		 * that we can update the insertion target pg_aoseg row again.
@@ -361,6 +407,8 @@ ao_vacuum_rel_compact(Relation onerel, int options, VacuumParams *params,
 		CommandCounterIncrement();
 	}
 
+	pgstat_progress_end_command();
+
 	UnregisterSnapshot(appendOnlyMetaDataSnapshot);
 }
 
@@ -426,7 +474,7 @@ static int
 vacuum_appendonly_indexes(Relation aoRelation, int options,
 						  BufferAccessStrategy bstrategy)
 {
-	int			reindex_count = 1;
+	int			num_index_vacuums = 0;
 	int			i;
 	Relation   *Irel;
 	int			nindexes;
@@ -514,7 +562,8 @@ vacuum_appendonly_indexes(Relation aoRelation, int options,
 										elevel,
 										bstrategy);
 			}
-			reindex_count++;
+			pgstat_progress_update_param(PROGRESS_VACUUM_NUM_INDEX_VACUUMS,
+										 ++num_index_vacuums);
 		}
 		else
 		{
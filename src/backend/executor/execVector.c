@@ -0,0 +1,1118 @@
+/*-------------------------------------------------------------------------
+ *
+ * execVector.c
+ *	  Batch-at-a-time execution of simple aggregates over sequential scans.
+ *
+ * The executor normally processes one tuple per ExecProcNode() call, and
+ * evaluates quals and aggregate transitions one tuple at a time with the
+ * expression interpreter. For a big aggregation over a scan, that per-tuple
+ * overhead costs several times more than reading the data.
+ *
+ * When gp_enable_vectorized_agg is on, a plain (non-grouped) Agg directly
+ * on top of a SeqScan, which is the shape of the partial aggregate of most
+ * aggregation queries on the segments, can instead pull rows from the
+ * scan's table access method a batch of VECTOR_BATCH_SIZE rows at a time.
+ * The needed columns are gathered into column vectors, the scan's quals
+ * filter the batch into a selection vector, and the aggregate transitions
+ * run over the selected rows in tight loops, updating the transition states
+ * the same way as the transition functions would.
+ *
+ * Only a small set of expressions is supported:
+ *
+ * - Columns and constants of type int4, int8, float8 and date.
+ * - +, - and * of int4, int8 and float8.
+ * - Comparisons of int4, int8, float8 and date, including the int4/int8
+ *	 cross-type ones, and IS [NOT] NULL, ANDed together.
+ * - count(*), count(x), sum and avg of int4 and float8, min and max of
+ *	 int4, int8, float8 and date, and the float8 variance and stddev
+ *	 aggregates.
+ *
+ * If the quals or aggregates use anything else, ExecInitVectorAgg() returns
+ * NULL and the Agg runs a tuple at a time as usual.
+ *
+ * Portions Copyright (c) 2012-Present VMware, Inc. or its affiliates.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/executor/execVector.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "catalog/pg_aggregate.h"
+#include "catalog/pg_type.h"
+#include "cdb/cdbvars.h"
+#include "common/int.h"
+#include "executor/execVector.h"
+#include "executor/executor.h"
+#include "executor/instrument.h"
+#include "executor/nodeAgg.h"
+#include "executor/nodeSeqscan.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "utils/array.h"
+#include "utils/fmgroids.h"
+#include "utils/float.h"
+
+typedef enum VecExprKind
+{
+	VEXPR_COLUMN,				/* a column of the batch */
+	VEXPR_CONST,				/* a constant */
+	VEXPR_ARITH					/* +, - or * of two expressions */
+} VecExprKind;
+
+typedef enum VecOp
+{
+	VOP_ADD,
+	VOP_SUB,
+	VOP_MUL,
+	VOP_EQ,
+	VOP_NE,
+	VOP_LT,
+	VOP_LE,
+	VOP_GT,
+	VOP_GE
+} VecOp;
+
+/* A vectorized expression */
+typedef struct VecExpr
+{
+	VecExprKind kind;
+	VecType		type;
+	int			column;			/* VEXPR_COLUMN: index into the batch */
+	VecOp		op;				/* VEXPR_ARITH: the operator */
+	struct VecExpr *left;
+	struct VecExpr *right;
+	VecColumn	result;			/* VEXPR_CONST, VEXPR_ARITH: the values */
+} VecExpr;
+
+typedef enum VecQualKind
+{
+	VQUAL_COMPARE,
+	VQUAL_ISNULL,
+	VQUAL_ISNOTNULL
+} VecQualKind;
+
+/* A vectorized qual clause */
+typedef struct VecQual
+{
+	VecQualKind kind;
+	VecOp		op;				/* VQUAL_COMPARE: the operator */
+	VecExpr    *left;
+	VecExpr    *right;			/* VQUAL_COMPARE only */
+} VecQual;
+
+typedef enum VecAggKind
+{
+	VAGG_COUNT,					/* count(*): int8inc */
+	VAGG_COUNT_ANY,				/* count(x): int8inc_any */
+	VAGG_SUM_INT4,				/* sum(int4): int4_sum */
+	VAGG_SUM_FLOAT8,			/* sum(float8): float8pl */
+	VAGG_AVG_INT4,				/* avg(int4): int4_avg_accum */
+	VAGG_ACCUM_FLOAT8,			/* avg, variance, stddev(float8): float8_accum */
+	VAGG_MIN,					/* min(x): int4smaller and friends */
+	VAGG_MAX					/* max(x): int4larger and friends */
+} VecAggKind;
+
+/* A vectorized aggregate transition, one for each pertrans of the Agg */
+typedef struct VecAggTrans
+{
+	VecAggKind	kind;
+	VecExpr    *arg;			/* NULL for count(*) */
+} VecAggTrans;
+
+struct VectorAggState
+{
+	SeqScanState *scanstate;
+	Index		scanrelid;
+	List	   *scantlist;		/* targetlist of the scan */
+
+	VectorBatch batch;
+	AttrNumber	maxattnum;		/* highest table column needed */
+
+	int			nquals;
+	VecQual    *quals;
+
+	int			ntrans;
+	VecAggTrans *trans;
+};
+
+static VecExpr *vec_translate_expr(VectorAggState *vstate, Expr *expr,
+								   bool any_ok);
+static bool vec_translate_qual(VectorAggState *vstate, Expr *clause,
+							   List **quals);
+static bool vec_translate_trans(VectorAggState *vstate,
+								AggStatePerTrans pertrans,
+								VecAggTrans *trans);
+static void vec_alloc_column(VecColumn *col, VecType type);
+static VecColumn *vec_eval(VectorBatch *batch, VecExpr *expr);
+static int	vec_filter(VectorBatch *batch, VecQual *qual);
+
+/*
+ * Map a data type to the type of the vector holding it. Dates are kept as
+ * integers.
+ */
+static bool
+vec_type_for(Oid typid, VecType *type)
+{
+	switch (typid)
+	{
+		case INT4OID:
+		case DATEOID:
+			*type = VEC_INT4;
+			return true;
+		case INT8OID:
+			*type = VEC_INT8;
+			return true;
+		case FLOAT8OID:
+			*type = VEC_FLOAT8;
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*
+ * Find the batch column holding a table column, adding one if needed.
+ */
+static int
+vec_batch_column(VectorAggState *vstate, AttrNumber attnum, VecType type)
+{
+	VectorBatch *batch = &vstate->batch;
+	int			i;
+
+	for (i = 0; i < batch->ncolumns; i++)
+	{
+		if (batch->attnums[i] == attnum)
+		{
+			/* a column first needed only for its NULLs may need its values */
+			if (batch->columns[i].type == VEC_ANY)
+				batch->columns[i].type = type;
+			return i;
+		}
+	}
+
+	if (batch->ncolumns == 0)
+	{
+		batch->columns = palloc(sizeof(VecColumn));
+		batch->attnums = palloc(sizeof(AttrNumber));
+	}
+	else
+	{
+		batch->columns = repalloc(batch->columns,
+								  sizeof(VecColumn) * (batch->ncolumns + 1));
+		batch->attnums = repalloc(batch->attnums,
+								  sizeof(AttrNumber) * (batch->ncolumns + 1));
+	}
+	memset(&batch->columns[i], 0, sizeof(VecColumn));
+	batch->columns[i].type = type;
+	batch->attnums[i] = attnum;
+	batch->ncolumns++;
+
+	vstate->maxattnum = Max(vstate->maxattnum, attnum);
+
+	return i;
+}
+
+/*
+ * Translate an expression into a VecExpr, or return NULL if it can't be
+ * vectorized.
+ *
+ * Vars referring to the Agg's input are looked up in the scan's targetlist.
+ * If 'any_ok', a bare column of any type is accepted, but only whether its
+ * values are NULL is available.
+ */
+static VecExpr *
+vec_translate_expr(VectorAggState *vstate, Expr *expr, bool any_ok)
+{
+	VecExpr    *result;
+	VecType		type;
+
+	if (IsA(expr, Var))
+	{
+		Var		   *var = (Var *) expr;
+
+		if (var->varno == OUTER_VAR)
+		{
+			TargetEntry *tle;
+
+			if (var->varattno <= 0 ||
+				var->varattno > list_length(vstate->scantlist))
+				return NULL;
+			tle = list_nth(vstate->scantlist, var->varattno - 1);
+			return vec_translate_expr(vstate, tle->expr, any_ok);
+		}
+
+		if (var->varno != vstate->scanrelid || var->varlevelsup != 0 ||
+			var->varattno <= 0)
+			return NULL;
+		if (!vec_type_for(var->vartype, &type))
+		{
+			if (!any_ok)
+				return NULL;
+			type = VEC_ANY;
+		}
+
+		result = palloc0(sizeof(VecExpr));
+		result->kind = VEXPR_COLUMN;
+		result->type = type;
+		result->column = vec_batch_column(vstate, var->varattno, type);
+		return result;
+	}
+	else if (IsA(expr, Const))
+	{
+		Const	   *con = (Const *) expr;
+		int			i;
+
+		if (!vec_type_for(con->consttype, &type))
+			return NULL;
+
+		/* Fill in the constant for every row once, up front */
+		result = palloc0(sizeof(VecExpr));
+		result->kind = VEXPR_CONST;
+		result->type = type;
+		vec_alloc_column(&result->result, type);
+		for (i = 0; i < VECTOR_BATCH_SIZE; i++)
+		{
+			result->result.isnull[i] = con->constisnull;
+			if (con->constisnull)
+				continue;
+			if (type == VEC_FLOAT8)
+				result->result.fvalues[i] = DatumGetFloat8(con->constvalue);
+			else if (type == VEC_INT8)
+				result->result.ivalues[i] = DatumGetInt64(con->constvalue);
+			else
+				result->result.ivalues[i] = DatumGetInt32(con->constvalue);
+		}
+		return result;
+	}
+	else if (IsA(expr, OpExpr) && list_length(((OpExpr *) expr)->args) == 2)
+	{
+		OpExpr	   *op = (OpExpr *) expr;
+		VecOp		vop;
+		VecExpr    *left;
+		VecExpr    *right;
+
+		switch (op->opfuncid)
+		{
+			case F_INT4PL:
+				type = VEC_INT4;
+				vop = VOP_ADD;
+				break;
+			case F_INT4MI:
+				type = VEC_INT4;
+				vop = VOP_SUB;
+				break;
+			case F_INT4MUL:
+				type = VEC_INT4;
+				vop = VOP_MUL;
+				break;
+			case F_INT8PL:
+				type = VEC_INT8;
+				vop = VOP_ADD;
+				break;
+			case F_INT8MI:
+				type = VEC_INT8;
+				vop = VOP_SUB;
+				break;
+			case F_INT8MUL:
+				type = VEC_INT8;
+				vop = VOP_MUL;
+				break;
+			case F_FLOAT8PL:
+				type = VEC_FLOAT8;
+				vop = VOP_ADD;
+				break;
+			case F_FLOAT8MI:
+				type = VEC_FLOAT8;
+				vop = VOP_SUB;
+				break;
+			case F_FLOAT8MUL:
+				type = VEC_FLOAT8;
+				vop = VOP_MUL;
+				break;
+			default:
+				return NULL;
+		}
+
+		left = vec_translate_expr(vstate, linitial(op->args), false);
+		right = vec_translate_expr(vstate, lsecond(op->args), false);
+		if (!left || !right || left->type != type || right->type != type)
+			return NULL;
+
+		result = palloc0(sizeof(VecExpr));
+		result->kind = VEXPR_ARITH;
+		result->type = type;
+		result->op = vop;
+		result->left = left;
+		result->right = right;
+		vec_alloc_column(&result->result, type);
+		return result;
+	}
+
+	return NULL;
+}
+
+/*
+ * Translate a qual clause, appending VecQuals to *quals. Returns false if
+ * it can't be vectorized.
+ */
+static bool
+vec_translate_qual(VectorAggState *vstate, Expr *clause, List **quals)
+{
+	VecQual    *qual;
+
+	if (is_andclause(clause))
+	{
+		ListCell   *lc;
+
+		foreach(lc, ((BoolExpr *) clause)->args)
+		{
+			if (!vec_translate_qual(vstate, lfirst(lc), quals))
+				return false;
+		}
+		return true;
+	}
+	else if (IsA(clause, NullTest))
+	{
+		NullTest   *ntest = (NullTest *) clause;
+
+		if (ntest->argisrow)
+			return false;
+
+		qual = palloc0(sizeof(VecQual));
+		qual->kind = (ntest->nulltesttype == IS_NULL) ? VQUAL_ISNULL : VQUAL_ISNOTNULL;
+		qual->left = vec_translate_expr(vstate, ntest->arg, true);
+		if (!qual->left)
+			return false;
+	}
+	else if (IsA(clause, OpExpr) && list_length(((OpExpr *) clause)->args) == 2)
+	{
+		OpExpr	   *op = (OpExpr *) clause;
+		VecType		ltype;
+		VecType		rtype;
+		VecOp		vop;
+
+		switch (op->opfuncid)
+		{
+#define VEC_CMP_CASES(EQ, NE, LT, LE, GT, GE, L, R) \
+			case EQ: vop = VOP_EQ; ltype = L; rtype = R; break; \
+			case NE: vop = VOP_NE; ltype = L; rtype = R; break; \
+			case LT: vop = VOP_LT; ltype = L; rtype = R; break; \
+			case LE: vop = VOP_LE; ltype = L; rtype = R; break; \
+			case GT: vop = VOP_GT; ltype = L; rtype = R; break; \
+			case GE: vop = VOP_GE; ltype = L; rtype = R; break;
+
+			VEC_CMP_CASES(F_INT4EQ, F_INT4NE, F_INT4LT, F_INT4LE, F_INT4GT, F_INT4GE,
+						  VEC_INT4, VEC_INT4)
+			VEC_CMP_CASES(F_INT8EQ, F_INT8NE, F_INT8LT, F_INT8LE, F_INT8GT, F_INT8GE,
+						  VEC_INT8, VEC_INT8)
+			VEC_CMP_CASES(F_INT48EQ, F_INT48NE, F_INT48LT, F_INT48LE, F_INT48GT, F_INT48GE,
+						  VEC_INT4, VEC_INT8)
+			VEC_CMP_CASES(F_INT84EQ, F_INT84NE, F_INT84LT, F_INT84LE, F_INT84GT, F_INT84GE,
+						  VEC_INT8, VEC_INT4)
+			VEC_CMP_CASES(F_FLOAT8EQ, F_FLOAT8NE, F_FLOAT8LT, F_FLOAT8LE, F_FLOAT8GT, F_FLOAT8GE,
+						  VEC_FLOAT8, VEC_FLOAT8)
+			VEC_CMP_CASES(F_DATE_EQ, F_DATE_NE, F_DATE_LT, F_DATE_LE, F_DATE_GT, F_DATE_GE,
+						  VEC_INT4, VEC_INT4)
+#undef VEC_CMP_CASES
+
+			default:
+				return false;
+		}
+
+		qual = palloc0(sizeof(VecQual));
+		qual->kind = VQUAL_COMPARE;
+		qual->op = vop;
+		qual->left = vec_translate_expr(vstate, linitial(op->args), false);
+		qual->right = vec_translate_expr(vstate, lsecond(op->args), false);
+		if (!qual->left || !qual->right ||
+			qual->left->type != ltype || qual->right->type != rtype)
+			return false;
+	}
+	else
+		return false;
+
+	*quals = lappend(*quals, qual);
+	return true;
+}
+
+/*
+ * Translate the transition of an aggregate. Returns false if it can't be
+ * vectorized.
+ */
+static bool
+vec_translate_trans(VectorAggState *vstate, AggStatePerTrans pertrans,
+					VecAggTrans *trans)
+{
+	Aggref	   *aggref = pertrans->aggref;
+	VecType		argtype;
+	bool		any_ok = false;
+
+	if (aggref->aggkind != AGGKIND_NORMAL ||
+		aggref->aggdistinct != NIL ||
+		aggref->aggorder != NIL ||
+		aggref->aggfilter != NULL ||
+		pertrans->numSortCols > 0)
+		return false;
+
+	switch (pertrans->transfn_oid)
+	{
+		case F_INT8INC:
+			trans->kind = VAGG_COUNT;
+			return pertrans->numInputs == 0;
+
+		case F_INT8INC_ANY:
+			trans->kind = VAGG_COUNT_ANY;
+			argtype = VEC_ANY;
+			any_ok = true;
+			break;
+		case F_INT4_SUM:
+			trans->kind = VAGG_SUM_INT4;
+			argtype = VEC_INT4;
+			break;
+		case F_FLOAT8PL:
+			trans->kind = VAGG_SUM_FLOAT8;
+			argtype = VEC_FLOAT8;
+			break;
+		case F_INT4_AVG_ACCUM:
+			trans->kind = VAGG_AVG_INT4;
+			argtype = VEC_INT4;
+			break;
+		case F_FLOAT8_ACCUM:
+			trans->kind = VAGG_ACCUM_FLOAT8;
+			argtype = VEC_FLOAT8;
+			break;
+		case F_INT4SMALLER:
+		case F_DATE_SMALLER:
+			trans->kind = VAGG_MIN;
+			argtype = VEC_INT4;
+			break;
+		case F_INT4LARGER:
+		case F_DATE_LARGER:
+			trans->kind = VAGG_MAX;
+			argtype = VEC_INT4;
+			break;
+		case F_INT8SMALLER:
+			trans->kind = VAGG_MIN;
+			argtype = VEC_INT8;
+			break;
+		case F_INT8LARGER:
+			trans->kind = VAGG_MAX;
+			argtype = VEC_INT8;
+			break;
+		case F_FLOAT8SMALLER:
+			trans->kind = VAGG_MIN;
+			argtype = VEC_FLOAT8;
+			break;
+		case F_FLOAT8LARGER:
+			trans->kind = VAGG_MAX;
+			argtype = VEC_FLOAT8;
+			break;
+		default:
+			return false;
+	}
+
+	if (pertrans->numInputs != 1 || list_length(aggref->args) != 1)
+		return false;
+
+	trans->arg = vec_translate_expr(vstate,
+									((TargetEntry *) linitial(aggref->args))->expr,
+									any_ok);
+	if (!trans->arg)
+		return false;
+
+	return any_ok || trans->arg->type == argtype;
+}
+
+static void
+vec_alloc_column(VecColumn *col, VecType type)
+{
+	col->type = type;
+	col->isnull = palloc(sizeof(bool) * VECTOR_BATCH_SIZE);
+	if (type == VEC_FLOAT8)
+		col->fvalues = palloc(sizeof(double) * VECTOR_BATCH_SIZE);
+	else if (type != VEC_ANY)
+		col->ivalues = palloc(sizeof(int64) * VECTOR_BATCH_SIZE);
+}
+
+/*
+ * ExecInitVectorAgg
+ *
+ * Set up batch-at-a-time execution of an Agg node, if it and its input can
+ * be vectorized. Returns NULL if not. Called at the end of ExecInitAgg().
+ */
+VectorAggState *
+ExecInitVectorAgg(AggState *aggstate)
+{
+	Agg		   *node = (Agg *) aggstate->ss.ps.plan;
+	PlanState  *outerstate = outerPlanState(aggstate);
+	VectorAggState *vstate;
+	List	   *quals = NIL;
+	ListCell   *lc;
+	int			i;
+
+	if (!gp_enable_vectorized_agg || !FLOAT8PASSBYVAL)
+		return NULL;
+
+	if (node->aggstrategy != AGG_PLAIN ||
+		node->groupingSets != NIL ||
+		node->chain != NIL ||
+		DO_AGGSPLIT_COMBINE(node->aggsplit) ||
+		aggstate->numtrans == 0)
+		return NULL;
+
+	if (!outerstate || !IsA(outerstate, SeqScanState) ||
+		nodeTag(outerstate->plan) != T_SeqScan ||
+		outerstate->plan->parallel_aware)
+		return NULL;
+
+	vstate = palloc0(sizeof(VectorAggState));
+	vstate->scanstate = (SeqScanState *) outerstate;
+	vstate->scanrelid = ((SeqScan *) outerstate->plan)->scanrelid;
+	vstate->scantlist = outerstate->plan->targetlist;
+
+	/* Translate the scan's quals */
+	foreach(lc, outerstate->plan->qual)
+	{
+		if (!vec_translate_qual(vstate, lfirst(lc), &quals))
+			return NULL;
+	}
+	vstate->nquals = list_length(quals);
+	vstate->quals = palloc(sizeof(VecQual) * Max(vstate->nquals, 1));
+	i = 0;
+	foreach(lc, quals)
+		vstate->quals[i++] = *(VecQual *) lfirst(lc);
+
+	/* Translate the aggregate transitions */
+	vstate->ntrans = aggstate->numtrans;
+	vstate->trans = palloc0(sizeof(VecAggTrans) * vstate->ntrans);
+	for (i = 0; i < aggstate->numtrans; i++)
+	{
+		if (!vec_translate_trans(vstate, &aggstate->pertrans[i],
+								 &vstate->trans[i]))
+			return NULL;
+	}
+
+	/* Everything can be vectorized. Allocate the batch. */
+	for (i = 0; i < vstate->batch.ncolumns; i++)
+		vec_alloc_column(&vstate->batch.columns[i],
+						 vstate->batch.columns[i].type);
+	vstate->batch.selection = palloc(sizeof(uint16) * VECTOR_BATCH_SIZE);
+
+	return vstate;
+}
+
+/*
+ * ExecVectorAggFetchBatch
+ *
+ * Fetch the next batch of rows from the scan and apply the quals to it.
+ * Returns false when the scan is exhausted.
+ */
+bool
+ExecVectorAggFetchBatch(VectorAggState *vstate)
+{
+	VectorBatch *batch = &vstate->batch;
+	Instrumentation *instr = vstate->scanstate->ss.ps.instrument;
+	int			nrows = 0;
+	int			i;
+
+	CHECK_FOR_INTERRUPTS();
+
+	if (instr)
+		InstrStartNode(instr);
+
+	while (nrows < VECTOR_BATCH_SIZE)
+	{
+		TupleTableSlot *slot = ExecSeqScanFetch(vstate->scanstate);
+
+		if (TupIsNull(slot))
+			break;
+
+		slot_getsomeattrs(slot, vstate->maxattnum);
+
+		for (i = 0; i < batch->ncolumns; i++)
+		{
+			VecColumn  *col = &batch->columns[i];
+			int			attno = batch->attnums[i] - 1;
+			Datum		value = slot->tts_values[attno];
+
+			col->isnull[nrows] = slot->tts_isnull[attno];
+			if (col->isnull[nrows])
+				continue;
+
+			switch (col->type)
+			{
+				case VEC_INT4:
+					col->ivalues[nrows] = DatumGetInt32(value);
+					break;
+				case VEC_INT8:
+					col->ivalues[nrows] = DatumGetInt64(value);
+					break;
+				case VEC_FLOAT8:
+					col->fvalues[nrows] = DatumGetFloat8(value);
+					break;
+				case VEC_ANY:
+					break;
+			}
+		}
+		nrows++;
+	}
+
+	batch->nrows = nrows;
+	for (i = 0; i < nrows; i++)
+		batch->selection[i] = i;
+	batch->nselected = nrows;
+
+	for (i = 0; i < vstate->nquals && batch->nselected > 0; i++)
+		batch->nselected = vec_filter(batch, &vstate->quals[i]);
+
+	if (instr)
+	{
+		InstrStopNode(instr, batch->nselected);
+		instr->nfiltered1 += nrows - batch->nselected;
+	}
+
+	return nrows > 0;
+}
+
+/*
+ * Evaluate an expression for the selected rows of a batch.
+ */
+static VecColumn *
+vec_eval(VectorBatch *batch, VecExpr *expr)
+{
+	uint16	   *sel = batch->selection;
+	int			nsel = batch->nselected;
+	VecColumn  *l;
+	VecColumn  *r;
+	VecColumn  *res;
+	int			i;
+
+	if (expr->kind == VEXPR_COLUMN)
+		return &batch->columns[expr->column];
+	if (expr->kind == VEXPR_CONST)
+		return &expr->result;
+
+	l = vec_eval(batch, expr->left);
+	r = vec_eval(batch, expr->right);
+	res = &expr->result;
+
+	for (i = 0; i < nsel; i++)
+		res->isnull[sel[i]] = l->isnull[sel[i]] || r->isnull[sel[i]];
+
+	switch (expr->type)
+	{
+		case VEC_INT4:
+			for (i = 0; i < nsel; i++)
+			{
+				int			row = sel[i];
+				int64		v;
+
+				if (res->isnull[row])
+					continue;
+				/* int4 operands can't overflow an int64 */
+				if (expr->op == VOP_ADD)
+					v = l->ivalues[row] + r->ivalues[row];
+				else if (expr->op == VOP_SUB)
+					v = l->ivalues[row] - r->ivalues[row];
+				else
+					v = l->ivalues[row] * r->ivalues[row];
+				if (unlikely(v < PG_INT32_MIN || v > PG_INT32_MAX))
+					ereport(ERROR,
+							(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+							 errmsg("integer out of range")));
+				res->ivalues[row] = v;
+			}
+			break;
+
+		case VEC_INT8:
+			for (i = 0; i < nsel; i++)
+			{
+				int			row = sel[i];
+				bool		overflow;
+
+				if (res->isnull[row])
+					continue;
+				if (expr->op == VOP_ADD)
+					overflow = pg_add_s64_overflow(l->ivalues[row], r->ivalues[row],
+												   &res->ivalues[row]);
+				else if (expr->op == VOP_SUB)
+					overflow = pg_sub_s64_overflow(l->ivalues[row], r->ivalues[row],
+												   &res->ivalues[row]);
+				else
+					overflow = pg_mul_s64_overflow(l->ivalues[row], r->ivalues[row],
+												   &res->ivalues[row]);
+				if (unlikely(overflow))
+					ereport(ERROR,
+							(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+							 errmsg("bigint out of range")));
+			}
+			break;
+
+		case VEC_FLOAT8:
+			for (i = 0; i < nsel; i++)
+			{
+				int			row = sel[i];
+
+				if (res->isnull[row])
+					continue;
+				if (expr->op == VOP_ADD)
+					res->fvalues[row] = float8_pl(l->fvalues[row], r->fvalues[row]);
+				else if (expr->op == VOP_SUB)
+					res->fvalues[row] = float8_mi(l->fvalues[row], r->fvalues[row]);
+				else
+					res->fvalues[row] = float8_mul(l->fvalues[row], r->fvalues[row]);
+			}
+			break;
+
+		case VEC_ANY:
+			elog(ERROR, "unexpected vector expression type");
+	}
+
+	return res;
+}
+
+/*
+ * Apply a qual clause to the selected rows of a batch, and return the number
+ * of rows that pass. The selection vector is updated in place.
+ */
+static int
+vec_filter(VectorBatch *batch, VecQual *qual)
+{
+	uint16	   *sel = batch->selection;
+	int			nsel = batch->nselected;
+	int			n = 0;
+	VecColumn  *l;
+	VecColumn  *r;
+	int			i;
+
+	l = vec_eval(batch, qual->left);
+
+	if (qual->kind != VQUAL_COMPARE)
+	{
+		bool		wantnull = (qual->kind == VQUAL_ISNULL);
+
+		for (i = 0; i < nsel; i++)
+		{
+			if (l->isnull[sel[i]] == wantnull)
+				sel[n++] = sel[i];
+		}
+		return n;
+	}
+
+	r = vec_eval(batch, qual->right);
+
+#define VEC_FILTER(cond) \
+	for (i = 0; i < nsel; i++) \
+	{ \
+		int			row = sel[i]; \
+		if (!l->isnull[row] && !r->isnull[row] && (cond)) \
+			sel[n++] = row; \
+	} \
+	break
+
+	/* int4, int8 and date are all compared as int64 */
+	if (l->type == VEC_FLOAT8)
+	{
+		double	   *lv = l->fvalues;
+		double	   *rv = r->fvalues;
+
+		switch (qual->op)
+		{
+			case VOP_EQ:
+				VEC_FILTER(float8_eq(lv[row], rv[row]));
+			case VOP_NE:
+				VEC_FILTER(float8_ne(lv[row], rv[row]));
+			case VOP_LT:
+				VEC_FILTER(float8_lt(lv[row], rv[row]));
+			case VOP_LE:
+				VEC_FILTER(float8_le(lv[row], rv[row]));
+			case VOP_GT:
+				VEC_FILTER(float8_gt(lv[row], rv[row]));
+			case VOP_GE:
+				VEC_FILTER(float8_ge(lv[row], rv[row]));
+			default:
+				elog(ERROR, "unexpected vector comparison operator");
+		}
+	}
+	else
+	{
+		int64	   *lv = l->ivalues;
+		int64	   *rv = r->ivalues;
+
+		switch (qual->op)
+		{
+			case VOP_EQ:
+				VEC_FILTER(lv[row] == rv[row]);
+			case VOP_NE:
+				VEC_FILTER(lv[row] != rv[row]);
+			case VOP_LT:
+				VEC_FILTER(lv[row] < rv[row]);
+			case VOP_LE:
+				VEC_FILTER(lv[row] <= rv[row]);
+			case VOP_GT:
+				VEC_FILTER(lv[row] > rv[row]);
+			case VOP_GE:
+				VEC_FILTER(lv[row] >= rv[row]);
+			default:
+				elog(ERROR, "unexpected vector comparison operator");
+		}
+	}
+
+#undef VEC_FILTER
+
+	return n;
+}
+
+/* Set a transition value to a non-NULL value */
+static inline void
+vec_set_trans(AggStatePerGroup pergroupstate, Datum value)
+{
+	pergroupstate->transValue = value;
+	pergroupstate->transValueIsNull = false;
+	pergroupstate->noTransValue = false;
+}
+
+/* Get the values of an array transition state, modified in place */
+static void *
+vec_trans_array(AggStatePerGroup pergroupstate, Oid elemtype, int nelems)
+{
+	ArrayType  *transarray = (ArrayType *) DatumGetPointer(pergroupstate->transValue);
+
+	if (pergroupstate->transValueIsNull ||
+		VARATT_IS_EXTENDED(transarray) ||
+		ARR_NDIM(transarray) != 1 ||
+		ARR_DIMS(transarray)[0] != nelems ||
+		ARR_HASNULL(transarray) ||
+		ARR_ELEMTYPE(transarray) != elemtype)
+		elog(ERROR, "unexpected aggregate transition state");
+
+	return ARR_DATA_PTR(transarray);
+}
+
+/*
+ * ExecVectorAggAdvance
+ *
+ * Advance the transition states in 'pergroup' with the selected rows of the
+ * current batch.
+ */
+void
+ExecVectorAggAdvance(VectorAggState *vstate, AggStatePerGroup pergroup)
+{
+	VectorBatch *batch = &vstate->batch;
+	uint16	   *sel = batch->selection;
+	int			nsel = batch->nselected;
+	int			t;
+
+	if (nsel == 0)
+		return;
+
+	for (t = 0; t < vstate->ntrans; t++)
+	{
+		VecAggTrans *trans = &vstate->trans[t];
+		AggStatePerGroup pergroupstate = &pergroup[t];
+		VecColumn  *arg = NULL;
+		int64		count = 0;
+		int64		isum = 0;
+		int			i;
+
+		if (trans->arg)
+			arg = vec_eval(batch, trans->arg);
+
+		switch (trans->kind)
+		{
+			case VAGG_COUNT:
+			case VAGG_COUNT_ANY:
+				if (trans->kind == VAGG_COUNT)
+					count = nsel;
+				else
+				{
+					for (i = 0; i < nsel; i++)
+						count += !arg->isnull[sel[i]];
+				}
+				if (pg_add_s64_overflow(DatumGetInt64(pergroupstate->transValue),
+										count, &isum))
+					ereport(ERROR,
+							(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+							 errmsg("bigint out of range")));
+				vec_set_trans(pergroupstate, Int64GetDatum(isum));
+				break;
+
+			case VAGG_SUM_INT4:
+			case VAGG_AVG_INT4:
+				for (i = 0; i < nsel; i++)
+				{
+					int			row = sel[i];
+
+					if (arg->isnull[row])
+						continue;
+					isum += arg->ivalues[row];
+					count++;
+				}
+				if (count == 0)
+					break;
+				if (trans->kind == VAGG_SUM_INT4)
+				{
+					if (!pergroupstate->transValueIsNull)
+						isum += DatumGetInt64(pergroupstate->transValue);
+					vec_set_trans(pergroupstate, Int64GetDatum(isum));
+				}
+				else
+				{
+					/* an Int8TransTypeData, see int4_avg_accum() */
+					int64	   *transdata = vec_trans_array(pergroupstate, INT8OID, 2);
+
+					transdata[0] += count;
+					transdata[1] += isum;
+				}
+				break;
+
+			case VAGG_SUM_FLOAT8:
+				{
+					bool		isnull = pergroupstate->transValueIsNull;
+					double		sum = isnull ? 0 : DatumGetFloat8(pergroupstate->transValue);
+
+					/* the transition function is strict, a NULL state stays */
+					if (isnull && !pergroupstate->noTransValue)
+						break;
+
+					/* add in the same order as float8pl() would */
+					for (i = 0; i < nsel; i++)
+					{
+						int			row = sel[i];
+
+						if (arg->isnull[row])
+							continue;
+						if (isnull)
+						{
+							sum = arg->fvalues[row];
+							isnull = false;
+						}
+						else
+							sum = float8_pl(sum, arg->fvalues[row]);
+					}
+					if (!isnull)
+						vec_set_trans(pergroupstate, Float8GetDatum(sum));
+				}
+				break;
+
+			case VAGG_ACCUM_FLOAT8:
+				{
+					/* N, Sx and Sxx, see float8_accum() */
+					double	   *transvalues = vec_trans_array(pergroupstate, FLOAT8OID, 3);
+					double		N = transvalues[0];
+					double		Sx = transvalues[1];
+					double		Sxx = transvalues[2];
+
+					for (i = 0; i < nsel; i++)
+					{
+						int			row = sel[i];
+						double		newval;
+						double		oldN;
+						double		oldSx;
+						double		tmp;
+
+						if (arg->isnull[row])
+							continue;
+
+						newval = arg->fvalues[row];
+						oldN = N;
+						oldSx = Sx;
+						N += 1.0;
+						Sx += newval;
+						if (oldN > 0.0)
+						{
+							tmp = newval * N - Sx;
+							Sxx += tmp * tmp / (N * oldN);
+
+							if (isinf(Sx) || isinf(Sxx))
+							{
+								if (!isinf(oldSx) && !isinf(newval))
+									ereport(ERROR,
+											(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+											 errmsg("value out of range: overflow")));
+
+								Sxx = get_float8_nan();
+							}
+						}
+					}
+					transvalues[0] = N;
+					transvalues[1] = Sx;
+					transvalues[2] = Sxx;
+				}
+				break;
+
+			case VAGG_MIN:
+			case VAGG_MAX:
+				{
+					bool		isnull = pergroupstate->transValueIsNull;
+					bool		ismin = (trans->kind == VAGG_MIN);
+
+					/* the transition function is strict, a NULL state stays */
+					if (isnull && !pergroupstate->noTransValue)
+						break;
+
+					if (arg->type == VEC_FLOAT8)
+					{
+						double		v = isnull ? 0 : DatumGetFloat8(pergroupstate->transValue);
+
+						/*
+						 * Like float8smaller/larger, keep the state only if it
+						 * is strictly smaller/larger, and take the new value on
+						 * ties.  That decides between -0 and 0.
+						 */
+						for (i = 0; i < nsel; i++)
+						{
+							int			row = sel[i];
+							double		newval = arg->fvalues[row];
+
+							if (arg->isnull[row])
+								continue;
+							if (isnull)
+							{
+								v = newval;
+								isnull = false;
+							}
+							else if (ismin ? !float8_lt(v, newval) : !float8_gt(v, newval))
+								v = newval;
+						}
+						if (!isnull)
+							vec_set_trans(pergroupstate, Float8GetDatum(v));
+					}
+					else
+					{
+						int64		v = 0;
+
+						if (!isnull)
+							v = (arg->type == VEC_INT8) ?
+								DatumGetInt64(pergroupstate->transValue) :
+								DatumGetInt32(pergroupstate->transValue);
+
+						for (i = 0; i < nsel; i++)
+						{
+							int			row = sel[i];
+							int64		newval = arg->ivalues[row];
+
+							if (arg->isnull[row])
+								continue;
+							if (isnull)
+							{
+								v = newval;
+								isnull = false;
+							}
+							else if (ismin ? newval < v : newval > v)
+								v = newval;
+						}
+						if (!isnull)
+							vec_set_trans(pergroupstate,
+										  (arg->type == VEC_INT8) ?
+										  Int64GetDatum(v) :
+										  Int32GetDatum((int32) v));
+					}
+				}
+				break;
+		}
+	}
+}
@@ -29,10 +29,15 @@
 
 BufferUsage pgBufferUsage;
 static BufferUsage save_pgBufferUsage;
+WorkfileUsage pgWorkfileUsage;
 
 static void BufferUsageAdd(BufferUsage *dst, const BufferUsage *add);
 static void BufferUsageAccumDiff(BufferUsage *dst,
 								 const BufferUsage *add, const BufferUsage *sub);
+static void WorkfileUsageAdd(WorkfileUsage *dst, const WorkfileUsage *add);
+static void WorkfileUsageAccumDiff(WorkfileUsage *dst,
+								   const WorkfileUsage *add,
+								   const WorkfileUsage *sub);
 
 /* GPDB specific */
 static bool shouldPickInstrInShmem(NodeTag tag);
@@ -93,6 +98,10 @@ InstrStartNode(Instrumentation *instr)
 	/* save buffer usage totals at node entry, if needed */
 	if (instr->need_bufusage)
 		instr->bufusage_start = pgBufferUsage;
+
+	/* CDB: likewise for workfile I/O */
+	if (instr->need_cdb)
+		instr->workfileusage_start = pgWorkfileUsage;
 }
 
 /* Exit from a plan node */
@@ -124,6 +133,18 @@ InstrStopNode(Instrumentation *instr, uint64 nTuples)
 		BufferUsageAccumDiff(&instr->bufusage,
 							 &pgBufferUsage, &instr->bufusage_start);
 
+	/*
+	 * CDB: Add delta of workfile I/O to the node's totals, and then take it
+	 * back out of the global counters, so that it isn't counted again in the
+	 * parent node.
+	 */
+	if (instr->need_cdb)
+	{
+		WorkfileUsageAccumDiff(&instr->workfileusage,
+							   &pgWorkfileUsage, &instr->workfileusage_start);
+		pgWorkfileUsage = instr->workfileusage_start;
+	}
+
 	/* Is this the first tuple of this cycle? */
 	if (!instr->running)
 	{
@@ -192,6 +213,9 @@ InstrAggNode(Instrumentation *dst, Instrumentation *add)
 	/* Add delta of buffer usage since entry to node's totals */
 	if (dst->need_bufusage)
 		BufferUsageAdd(&dst->bufusage, &add->bufusage);
+
+	if (dst->need_cdb)
+		WorkfileUsageAdd(&dst->workfileusage, &add->workfileusage);
 }
 
 /* note current values during parallel executor startup */
@@ -256,6 +280,28 @@ BufferUsageAccumDiff(BufferUsage *dst,
 						  add->blk_write_time, sub->blk_write_time);
 }
 
+/* dst += add */
+static void
+WorkfileUsageAdd(WorkfileUsage *dst, const WorkfileUsage *add)
+{
+	dst->bytes_written += add->bytes_written;
+	dst->bytes_read += add->bytes_read;
+	INSTR_TIME_ADD(dst->write_time, add->write_time);
+	INSTR_TIME_ADD(dst->read_time, add->read_time);
+}
+
+/* dst += add - sub */
+static void
+WorkfileUsageAccumDiff(WorkfileUsage *dst,
+					   const WorkfileUsage *add,
+					   const WorkfileUsage *sub)
+{
+	dst->bytes_written += add->bytes_written - sub->bytes_written;
+	dst->bytes_read += add->bytes_read - sub->bytes_read;
+	INSTR_TIME_ACCUM_DIFF(dst->write_time, add->write_time, sub->write_time);
+	INSTR_TIME_ACCUM_DIFF(dst->read_time, add->read_time, sub->read_time);
+}
+
 /* Calculate number slots from gp_instrument_shmem_size */
 Size
 InstrShmemNumSlots(void)
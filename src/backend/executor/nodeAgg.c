@@ -244,11 +244,16 @@
  */
 
 /*
- * GPDB_12_MERGE_FIXME: we lost the "streaming bottom" feature in the merge.
+ * GPDB: Streaming bottom
  *
- * And the detailed cdb executor instruments to print by explain.
- *
- * They were in execHHashagg.c
+ * The first stage of a multi-stage hash aggregation (a partial aggregate, or
+ * an Agg marked as 'streaming' by the planner) doesn't need to produce each
+ * group only once, because a later stage combines the groups again anyway.
+ * Such an Agg never spills. When its hash table fills up, the groups in it
+ * are emitted, the table is emptied, and aggregation continues with the rest
+ * of the input. If the groups didn't reduce the number of input rows much,
+ * the remaining input rows are instead passed through one by one, each as a
+ * group of its own, without any hashing at all. See hashagg_stream_check().
  */
 
 #include "postgres.h"
@@ -259,6 +264,7 @@
 #include "catalog/pg_proc.h"
 #include "catalog/pg_type.h"
 #include "executor/execExpr.h"
+#include "executor/execVector.h"
 #include "executor/executor.h"
 #include "executor/nodeAgg.h"
 #include "miscadmin.h"
@@ -280,6 +286,7 @@
 #include "utils/datum.h"
 
 #include "cdb/cdbexplain.h"
+#include "cdb/cdbvars.h"
 #include "lib/stringinfo.h"             /* StringInfo */
 #include "optimizer/walkers.h"
 
@@ -313,6 +320,12 @@
 #define HASHAGG_READ_BUFFER_SIZE BLCKSZ
 #define HASHAGG_WRITE_BUFFER_SIZE BLCKSZ
 
+/*
+ * GPDB: A streaming hash table checks its reduction ratio once after this
+ * many input rows, even if it hasn't filled up yet.
+ */
+#define HASHAGG_STREAM_SAMPLE_ROWS 65536
+
 /*
  * Estimate chunk overhead as a constant 16 bytes. XXX: should this be
  * improved?
@@ -453,6 +466,11 @@ static void hashagg_tapeinfo_init(AggState *aggstate);
 static void hashagg_tapeinfo_assign(HashTapeInfo *tapeinfo, int *dest,
 									int ndest);
 static void hashagg_tapeinfo_release(HashTapeInfo *tapeinfo, int tapenum);
+static bool hashagg_stream_check(AggState *aggstate);
+static void hashagg_stream_reset(AggState *aggstate);
+static TupleTableSlot *agg_retrieve_passthrough(AggState *aggstate);
+static TupleTableSlot *agg_retrieve_vectorized(AggState *aggstate);
+static void ExecAggExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 static Datum GetAggInitVal(Datum textInitVal, Oid transtype);
 static void build_pertrans_for_aggref(AggStatePerTrans pertrans,
 									  AggState *aggstate, EState *estate,
@@ -1882,7 +1900,11 @@ hash_agg_check_limits(AggState *aggstate)
 		(meta_mem + hash_mem > aggstate->hash_mem_limit ||
 		 ngroups > aggstate->hash_ngroups_limit))
 	{
-		hash_agg_enter_spill_mode(aggstate);
+		/* GPDB: a streaming hash table is emitted instead of spilled */
+		if (aggstate->hash_streaming)
+			aggstate->hash_stream_full = true;
+		else
+			hash_agg_enter_spill_mode(aggstate);
 	}
 }
 
@@ -2227,6 +2249,12 @@ ExecAgg(PlanState *pstate)
 		switch (node->phase->aggstrategy)
 		{
 			case AGG_HASHED:
+				/* GPDB: a streaming Agg may pass its input through */
+				if (node->hash_passthrough && !node->table_filled)
+				{
+					result = agg_retrieve_passthrough(node);
+					break;
+				}
 				if (!node->table_filled)
 					agg_fill_hash_table(node);
 				/* FALLTHROUGH */
@@ -2234,6 +2262,13 @@ ExecAgg(PlanState *pstate)
 				result = agg_retrieve_hash_table(node);
 				break;
 			case AGG_PLAIN:
+				/* GPDB: aggregate the input in batches, if possible */
+				if (node->vecstate)
+				{
+					result = agg_retrieve_vectorized(node);
+					break;
+				}
+				/* FALLTHROUGH */
 			case AGG_SORTED:
 				result = agg_retrieve_direct(node);
 				break;
@@ -2609,7 +2644,10 @@ agg_fill_hash_table(AggState *aggstate)
 	{
 		outerslot = fetch_input_tuple(aggstate);
 		if (TupIsNull(outerslot))
+		{
+			aggstate->input_done = true;
 			break;
+		}
 
 		/* set up for lookup_hash_entries and advance_aggregates */
 		tmpcontext->ecxt_outertuple = outerslot;
@@ -2625,6 +2663,10 @@ agg_fill_hash_table(AggState *aggstate)
 		 * hash lookups do this too
 		 */
 		ResetExprContext(aggstate->tmpcontext);
+
+		/* GPDB: emit the groups now, if a streaming hash table is done */
+		if (aggstate->hash_streaming && hashagg_stream_check(aggstate))
+			break;
 	}
 
 	/* finalize spills, if any */
@@ -2805,6 +2847,19 @@ agg_retrieve_hash_table(AggState *aggstate)
 		result = agg_retrieve_hash_table_in_memory(aggstate);
 		if (result == NULL)
 		{
+			/*
+			 * GPDB: if a streaming hash table was emitted before the end of
+			 * the input, empty it and carry on with the rest of the input.
+			 */
+			if (aggstate->hash_streaming && !aggstate->input_done)
+			{
+				hashagg_stream_reset(aggstate);
+				if (aggstate->hash_passthrough)
+					return agg_retrieve_passthrough(aggstate);
+				agg_fill_hash_table(aggstate);
+				continue;
+			}
+
 			if (!agg_refill_hash_table(aggstate))
 			{
 				aggstate->agg_done = true;
@@ -2937,6 +2992,183 @@ agg_retrieve_hash_table_in_memory(AggState *aggstate)
 	return NULL;
 }
 
+/*
+ * GPDB: Decide whether a streaming hash table should be emitted now, after an
+ * input row was added to it.
+ *
+ * The table is emitted when it has filled up. If its groups don't reduce the
+ * number of input rows enough, as set by gp_hashagg_passthrough_ratio, the
+ * rest of the input is passed through instead of hashed. The ratio is also
+ * checked once after HASHAGG_STREAM_SAMPLE_ROWS rows, so that input that
+ * doesn't group well is passed through even if the table never fills up.
+ */
+static bool
+hashagg_stream_check(AggState *aggstate)
+{
+	uint64		ninput = ++aggstate->hash_stream_input;
+	double		ratio;
+
+	aggstate->hash_stream_total_input++;
+
+	if (!aggstate->hash_stream_full && ninput != HASHAGG_STREAM_SAMPLE_ROWS)
+		return false;
+
+	ratio = (double) aggstate->hash_ngroups_current / ninput;
+	if (ratio >= gp_hashagg_passthrough_ratio)
+		aggstate->hash_passthrough = true;
+	else if (!aggstate->hash_stream_full)
+		return false;
+
+	aggstate->hash_stream_flushes++;
+	aggstate->hash_stream_groups += aggstate->hash_ngroups_current;
+
+	return true;
+}
+
+/*
+ * GPDB: Empty a streaming hash table after its groups have been emitted.
+ */
+static void
+hashagg_stream_reset(AggState *aggstate)
+{
+	hash_agg_update_metrics(aggstate, false, 0);
+
+	/* there could be residual pergroup pointers; clear them */
+	for (int setoff = 0;
+		 setoff < aggstate->maxsets + aggstate->num_hashes;
+		 setoff++)
+		aggstate->all_pergroups[setoff] = NULL;
+
+	/* free memory and reset hash tables */
+	ReScanExprContext(aggstate->hashcontext);
+	for (int setno = 0; setno < aggstate->num_hashes; setno++)
+		ResetTupleHashTable(aggstate->perhash[setno].hashtable);
+
+	aggstate->hash_ngroups_current = 0;
+	aggstate->hash_stream_input = 0;
+	aggstate->hash_stream_full = false;
+	aggstate->table_filled = false;
+}
+
+/*
+ * GPDB: ExecAgg for a plain aggregate executed a batch at a time.
+ *
+ * The input is fetched from the SeqScan below in batches, and the
+ * transition states are advanced a batch at a time, see execVector.c.
+ * Finalization and projection work as in agg_retrieve_direct().
+ */
+static TupleTableSlot *
+agg_retrieve_vectorized(AggState *aggstate)
+{
+	ExprContext *econtext = aggstate->ss.ps.ps_ExprContext;
+	AggStatePerGroup *pergroups = aggstate->pergroups;
+	TupleTableSlot *firstSlot = aggstate->ss.ss_ScanTupleSlot;
+
+	ReScanExprContext(econtext);
+	ReScanExprContext(aggstate->aggcontexts[0]);
+
+	initialize_aggregates(aggstate, pergroups, 1);
+
+	while (ExecVectorAggFetchBatch(aggstate->vecstate))
+		ExecVectorAggAdvance(aggstate->vecstate, pergroups[0]);
+
+	aggstate->agg_done = true;
+
+	/*
+	 * Not grouping, so there can't be any references to non-aggregated input
+	 * columns. Project from an empty representative tuple.
+	 */
+	ExecClearTuple(firstSlot);
+	econtext->ecxt_outertuple = firstSlot;
+	aggstate->projected_set = 0;
+
+	prepare_projection_slot(aggstate, firstSlot, 0);
+	select_current_set(aggstate, 0, false);
+	finalize_aggregates(aggstate, aggstate->peragg, pergroups[0]);
+
+	return project_aggregates(aggstate);
+}
+
+/*
+ * GPDB: ExecAgg for a streaming hash aggregate that gave up on hashing:
+ * return each input row as a group of its own.
+ *
+ * The transition states of the row are built the same way as for a new hash
+ * table entry, and the row itself serves as the representative tuple.
+ */
+static TupleTableSlot *
+agg_retrieve_passthrough(AggState *aggstate)
+{
+	ExprContext *econtext = aggstate->ss.ps.ps_ExprContext;
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	AggStatePerHash perhash = &aggstate->perhash[0];
+	AggStatePerGroup pergroup = aggstate->hash_passthrough_pergroup;
+	TupleTableSlot *firstSlot = aggstate->ss.ss_ScanTupleSlot;
+
+	Assert(aggstate->num_hashes == 1);
+
+	for (;;)
+	{
+		TupleTableSlot *outerslot;
+		TupleTableSlot *result;
+		int			i;
+
+		CHECK_FOR_INTERRUPTS();
+
+		outerslot = fetch_input_tuple(aggstate);
+		if (TupIsNull(outerslot))
+		{
+			aggstate->input_done = true;
+			aggstate->agg_done = true;
+			return NULL;
+		}
+		aggstate->hash_passthrough_rows++;
+
+		/*
+		 * The previous output row has been consumed by now, so its transition
+		 * values and output can be freed.
+		 */
+		ReScanExprContext(aggstate->hashcontext);
+		ResetExprContext(econtext);
+
+		select_current_set(aggstate, 0, true);
+		for (i = 0; i < aggstate->numtrans; i++)
+			initialize_aggregate(aggstate, &aggstate->pertrans[i], &pergroup[i]);
+		aggstate->hash_pergroup[0] = pergroup;
+
+		/* Advance the aggregates (or combine functions) */
+		tmpcontext->ecxt_outertuple = outerslot;
+		advance_aggregates(aggstate);
+		ResetExprContext(tmpcontext);
+
+		/* Build the representative tuple, like for a hash table entry */
+		slot_getallattrs(outerslot);
+
+		ExecClearTuple(firstSlot);
+		memset(firstSlot->tts_isnull, true,
+			   firstSlot->tts_tupleDescriptor->natts * sizeof(bool));
+
+		for (i = 0; i < perhash->numhashGrpCols; i++)
+		{
+			int			varNumber = perhash->hashGrpColIdxInput[i] - 1;
+
+			firstSlot->tts_values[varNumber] = outerslot->tts_values[varNumber];
+			firstSlot->tts_isnull[varNumber] = outerslot->tts_isnull[varNumber];
+		}
+		ExecStoreVirtualTuple(firstSlot);
+
+		econtext->ecxt_outertuple = firstSlot;
+
+		prepare_projection_slot(aggstate, firstSlot, 0);
+
+		finalize_aggregates(aggstate, aggstate->peragg, pergroup);
+
+		result = project_aggregates(aggstate);
+		if (result)
+			return result;
+	}
+}
+
 /*
  * Initialize HashTapeInfo
  */
@@ -3439,6 +3671,9 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
     {
         /* Allocate string buffer. */
         aggstate->ss.ps.cdbexplainbuf = makeStringInfo();
+
+        /* Request a callback at end of query. */
+        aggstate->ss.ps.cdbexplainfun = ExecAggExplainEnd;
     }
 
 	/*
@@ -4126,6 +4361,28 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		phase->evaltrans_cache[0][0] = phase->evaltrans;
 	}
 
+	/*
+	 * GPDB: A hash aggregate whose groups are combined again by a later
+	 * stage can stream its groups instead of spilling. See "Streaming
+	 * bottom" at the top of the file.
+	 */
+	if (gp_hashagg_streambottom &&
+		node->aggstrategy == AGG_HASHED &&
+		aggstate->num_hashes == 1 &&
+		(node->streaming || DO_AGGSPLIT_SKIPFINAL(node->aggsplit)))
+	{
+		aggstate->hash_streaming = true;
+		if (aggstate->numtrans > 0)
+			aggstate->hash_passthrough_pergroup = (AggStatePerGroup)
+				palloc0(sizeof(AggStatePerGroupData) * aggstate->numtrans);
+	}
+
+	/*
+	 * GPDB: A plain aggregate directly over a SeqScan may be executed a batch
+	 * at a time, if its quals and aggregates are simple enough.
+	 */
+	aggstate->vecstate = ExecInitVectorAgg(aggstate);
+
 	return aggstate;
 }
 
@@ -4602,6 +4859,31 @@ find_compatible_pertrans(AggState *aggstate, Aggref *newagg, bool shareable,
 	return -1;
 }
 
+/*
+ * ExecAggExplainEnd
+ *		Called before ExecutorEnd to finish EXPLAIN ANALYZE reporting.
+ *
+ * Reports how a hash aggregate coped with running out of memory.
+ */
+static void
+ExecAggExplainEnd(PlanState *planstate, struct StringInfoData *buf)
+{
+	AggState   *aggstate = (AggState *) planstate;
+
+	if (aggstate->hash_batches_used > 0)
+		appendStringInfo(buf, "Spilled to %d batches using " UINT64_FORMAT "kB of disk.\n",
+						 aggstate->hash_batches_used, aggstate->hash_disk_used);
+
+	if (aggstate->hash_stream_flushes > 0)
+		appendStringInfo(buf, "Streamed " UINT64_FORMAT " groups in %d flushes of the hash table.\n",
+						 aggstate->hash_stream_groups, aggstate->hash_stream_flushes);
+
+	if (aggstate->hash_passthrough_rows > 0)
+		appendStringInfo(buf, "Passed through " UINT64_FORMAT " of " UINT64_FORMAT " input rows without grouping.\n",
+						 aggstate->hash_passthrough_rows,
+						 aggstate->hash_passthrough_rows + aggstate->hash_stream_total_input);
+}
+
 void
 ExecEndAgg(AggState *node)
 {
@@ -4647,7 +4929,7 @@ ExecReScanAgg(AggState *node)
 		 * chgParam is not NULL then it will be re-scanned by ExecProcNode,
 		 * else no reason to re-scan it at all.
 		 */
-		if (!node->table_filled)
+		if (!node->table_filled && !node->hash_passthrough)
 			return;
 
 		/*
@@ -4658,6 +4940,7 @@ ExecReScanAgg(AggState *node)
 		 * again.
 		 */
 		if (outerPlan->chgParam == NULL && !node->hash_ever_spilled &&
+			node->hash_stream_flushes == 0 &&
 			!bms_overlap(node->ss.ps.chgParam, aggnode->aggParams))
 		{
 			ResetTupleHashIterator(node->perhash[0].hashtable,
@@ -4720,6 +5003,11 @@ ExecReScanAgg(AggState *node)
 		node->hash_spill_mode = false;
 		node->hash_ngroups_current = 0;
 
+		node->hash_stream_full = false;
+		node->hash_passthrough = false;
+		node->hash_stream_input = 0;
+		node->input_done = false;
+
 		ReScanExprContext(node->hashcontext);
 		/* Rebuild an empty hash table */
 		build_hash_tables(node);
@@ -521,6 +521,7 @@ ExecHashTableCreate(HashState *state, HashJoinState *hjstate,
 	hashtable->log2_nbuckets = log2_nbuckets;
 	hashtable->log2_nbuckets_optimal = log2_nbuckets;
 	hashtable->buckets.unshared = NULL;
+	hashtable->bucketTags = NULL;
 	hashtable->keepNulls = keepNulls;
 	hashtable->skewEnabled = false;
 	hashtable->skewBucket = NULL;
@@ -679,6 +680,8 @@ ExecHashTableCreate(HashState *state, HashJoinState *hjstate,
 
 		hashtable->buckets.unshared = (HashJoinTuple *)
 			palloc0(nbuckets * sizeof(HashJoinTuple));
+		hashtable->bucketTags = (HashJoinBucketTag *)
+			palloc0(nbuckets * sizeof(HashJoinBucketTag));
 
 		/*
 		 * Set up for skew optimization, if possible and there's a need for
@@ -1029,6 +1032,8 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	Size		spaceFreed = 0;
 	HashJoinTableStats *stats = hashtable->stats;
 	HashMemoryChunk oldchunks;
+	Size		bufsize;
+	int			i;
 
 	/* do nothing if we've decided to shut off growth */
 	if (!hashtable->growEnabled)
@@ -1086,6 +1091,19 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 
 	hashtable->nbatch = nbatch;
 
+	/*
+	 * GPDB: twice as many batch files have to share the same budget for
+	 * their I/O buffers, so shrink the buffers of the files written so far.
+	 */
+	bufsize = ExecHashBatchFileBufferSize(hashtable);
+	for (i = 0; i < oldnbatch; i++)
+	{
+		if (hashtable->innerBatchFile[i])
+			BufFileSetBufferSize(hashtable->innerBatchFile[i], bufsize);
+		if (hashtable->outerBatchFile[i])
+			BufFileSetBufferSize(hashtable->outerBatchFile[i], bufsize);
+	}
+
 	/*
 	 * Scan through the existing hash table entries and dump out any that are
 	 * no longer of the current batch.
@@ -1104,6 +1122,9 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 		hashtable->buckets.unshared =
 			repalloc(hashtable->buckets.unshared,
 					 sizeof(HashJoinTuple) * hashtable->nbuckets);
+		hashtable->bucketTags =
+			repalloc(hashtable->bucketTags,
+					 sizeof(HashJoinBucketTag) * hashtable->nbuckets);
 	}
 
 	/*
@@ -1113,6 +1134,8 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	 */
 	memset(hashtable->buckets.unshared, 0,
 		   sizeof(HashJoinTuple) * hashtable->nbuckets);
+	memset(hashtable->bucketTags, 0,
+		   sizeof(HashJoinBucketTag) * hashtable->nbuckets);
 	oldchunks = hashtable->chunks;
 	hashtable->chunks = NULL;
 
@@ -1148,6 +1171,7 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 				/* and add it back to the appropriate bucket */
 				copyTuple->next.unshared = hashtable->buckets.unshared[bucketno];
 				hashtable->buckets.unshared[bucketno] = copyTuple;
+				hashtable->bucketTags[bucketno] |= HJ_BUCKET_TAG(copyTuple->hashvalue);
 			}
 			else
 			{
@@ -1625,6 +1649,12 @@ ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 	memset(hashtable->buckets.unshared, 0,
 		   hashtable->nbuckets * sizeof(HashJoinTuple));
 
+	hashtable->bucketTags =
+		(HashJoinBucketTag *) repalloc(hashtable->bucketTags,
+									   hashtable->nbuckets * sizeof(HashJoinBucketTag));
+	memset(hashtable->bucketTags, 0,
+		   hashtable->nbuckets * sizeof(HashJoinBucketTag));
+
 	/* scan through all tuples in all chunks to rebuild the hash table */
 	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next.unshared)
 	{
@@ -1643,6 +1673,7 @@ ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 			/* add the tuple to the proper bucket */
 			hashTuple->next.unshared = hashtable->buckets.unshared[bucketno];
 			hashtable->buckets.unshared[bucketno] = hashTuple;
+			hashtable->bucketTags[bucketno] |= HJ_BUCKET_TAG(hashTuple->hashvalue);
 
 			/* advance index past the tuple */
 			idx += MAXALIGN(HJTUPLE_OVERHEAD +
@@ -1801,6 +1832,7 @@ ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 		/* Push it onto the front of the bucket's list */
 		hashTuple->next.unshared = hashtable->buckets.unshared[bucketno];
 		hashtable->buckets.unshared[bucketno] = hashTuple;
+		hashtable->bucketTags[bucketno] |= HJ_BUCKET_TAG(hashvalue);
 
 		/*
 		 * Increase the (optimal) number of buckets if we just exceeded the
@@ -2125,16 +2157,24 @@ ExecScanHashBucket(HashState *hashState, HashJoinState *hjstate,
 	 *
 	 * If the tuple hashed to a skew bucket then scan the skew bucket
 	 * otherwise scan the standard hashtable bucket.
+	 *
+	 * GPDB: Skip the standard bucket altogether if its tag shows that none of
+	 * its tuples can have the same hash value.
 	 */
 	if (hashTuple != NULL)
 		hashTuple = hashTuple->next.unshared;
 	else if (hjstate->hj_CurSkewBucketNo != INVALID_SKEW_BUCKET_NO)
 		hashTuple = hashtable->skewBucket[hjstate->hj_CurSkewBucketNo]->tuples;
+	else if (!(hashtable->bucketTags[hjstate->hj_CurBucketNo] & HJ_BUCKET_TAG(hashvalue)))
+		return false;
 	else
 		hashTuple = hashtable->buckets.unshared[hjstate->hj_CurBucketNo];
 
 	while (hashTuple != NULL)
 	{
+		/* start loading the next tuple of the chain while we look at this one */
+		HJ_PREFETCH(hashTuple->next.unshared);
+
 		if (hashTuple->hashvalue == hashvalue)
 		{
 			TupleTableSlot *inntuple;
@@ -2335,6 +2375,8 @@ ExecHashTableReset(HashState *hashState, HashJoinTable hashtable)
 	/* Reallocate and reinitialize the hash bucket headers. */
 	hashtable->buckets.unshared = (HashJoinTuple *)
 		palloc0(nbuckets * sizeof(HashJoinTuple));
+	hashtable->bucketTags = (HashJoinBucketTag *)
+		palloc0(nbuckets * sizeof(HashJoinBucketTag));
 
 	hashtable->spaceUsed = 0;
 	hashtable->totalTuples = 0;
@@ -2374,6 +2416,22 @@ ExecHashTableResetMatchFlags(HashJoinTable hashtable)
 	}
 }
 
+/*
+ * ExecHashBatchFileBufferSize
+ *		I/O buffer size for the batch files
+ *
+ * Batch files are written and read back sequentially, so they use a bigger
+ * I/O buffer than the default BLCKSZ. The buffers of all the batch files are
+ * kept within a fraction of the hash table's budget, though; there can be a
+ * lot of them.
+ */
+Size
+ExecHashBatchFileBufferSize(HashJoinTable hashtable)
+{
+	return Min((Size) gp_workfile_buffer_size * 1024L,
+			   hashtable->spaceAllowed / (4 * hashtable->nbatch));
+}
+
 
 void
 ExecReScanHash(HashState *node)
@@ -3059,6 +3117,7 @@ ExecHashRemoveNextSkewBucket(HashState *hashState, HashJoinTable hashtable)
 
 			copyTuple->next.unshared = hashtable->buckets.unshared[bucketno];
 			hashtable->buckets.unshared[bucketno] = copyTuple;
+			hashtable->bucketTags[bucketno] |= HJ_BUCKET_TAG(copyTuple->hashvalue);
 
 			/* We have reduced skew space, but overall space doesn't change */
 			hashtable->spaceUsedSkew -= tupleSize;
@@ -144,6 +144,11 @@ extern bool Test_print_prefetch_joinqual;
 static TupleTableSlot *ExecHashJoinOuterGetTuple(PlanState *outerNode,
 												 HashJoinState *hjstate,
 												 uint32 *hashvalue);
+static TupleTableSlot *ExecHashJoinOuterGetProbeTuple(PlanState *outerNode,
+													  HashJoinState *hjstate,
+													  uint32 *hashvalue);
+static void ExecHashJoinFillProbeBatch(PlanState *outerNode,
+									   HashJoinState *hjstate);
 static TupleTableSlot *ExecParallelHashJoinOuterGetTuple(PlanState *outerNode,
 														 HashJoinState *hjstate,
 														 uint32 *hashvalue);
@@ -853,6 +858,24 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	hjstate->hj_OuterTupleSlot = ExecInitExtraTupleSlot(estate, outerDesc,
 														ops);
 
+	/*
+	 * GPDB: slots for the outer tuples fetched ahead in the first batch, see
+	 * ExecHashJoinFillProbeBatch().
+	 */
+	if (gp_hashjoin_probe_batch_size > 1 && !node->join.plan.parallel_aware)
+	{
+		int			i;
+
+		hjstate->hj_ProbeBatchSize = gp_hashjoin_probe_batch_size;
+		hjstate->hj_ProbeSlots = (TupleTableSlot **)
+			palloc(hjstate->hj_ProbeBatchSize * sizeof(TupleTableSlot *));
+		for (i = 0; i < hjstate->hj_ProbeBatchSize; i++)
+			hjstate->hj_ProbeSlots[i] = ExecInitExtraTupleSlot(estate, outerDesc,
+															   ops);
+		hjstate->hj_ProbeHashValues = (uint32 *)
+			palloc(hjstate->hj_ProbeBatchSize * sizeof(uint32));
+	}
+
 	/*
 	 * detect whether we need only consider the first matching inner tuple
 	 */
@@ -1036,7 +1059,9 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 	HashState  *hashState = (HashState *) innerPlanState(hjstate);
 
 	/* Read tuples from outer relation only if it's the first batch */
-	if (curbatch == 0)
+	if (curbatch == 0 && hjstate->hj_ProbeBatchSize > 0)
+		return ExecHashJoinOuterGetProbeTuple(outerNode, hjstate, hashvalue);
+	else if (curbatch == 0)
 	{
 		/*
 		 * Check to see if first outer tuple was already fetched by
@@ -1121,6 +1146,126 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 	return NULL;
 }
 
+/*
+ * ExecHashJoinOuterGetProbeTuple
+ *
+ *		GPDB: get the next outer tuple of the first batch, fetching a batch
+ *		of them ahead when we run out.
+ *
+ * Probing a big hash table is bound by memory latency: finding the bucket,
+ * and then the first tuple in it, are likely cache misses that the CPU has
+ * to wait for one after another. Fetching several outer tuples ahead lets
+ * us start loading the buckets of all of them at once, so that their loads
+ * overlap, and are hopefully done by the time each tuple is probed.
+ */
+static TupleTableSlot *
+ExecHashJoinOuterGetProbeTuple(PlanState *outerNode,
+							   HashJoinState *hjstate,
+							   uint32 *hashvalue)
+{
+	int			i;
+
+	if (hjstate->hj_ProbeNext >= hjstate->hj_ProbeCount)
+	{
+		ExecHashJoinFillProbeBatch(outerNode, hjstate);
+		if (hjstate->hj_ProbeCount == 0)
+			return NULL;
+	}
+
+	i = hjstate->hj_ProbeNext++;
+	*hashvalue = hjstate->hj_ProbeHashValues[i];
+	return hjstate->hj_ProbeSlots[i];
+}
+
+/*
+ * ExecHashJoinFillProbeBatch
+ *
+ *		GPDB: fetch the next batch of outer tuples of the first batch, and
+ *		prefetch the parts of the hash table they will probe.
+ *
+ * Tuples whose join keys are NULL are discarded, like in
+ * ExecHashJoinOuterGetTuple(). The tuples are copied, since the outer plan
+ * may reuse its slot for the next tuple.
+ */
+static void
+ExecHashJoinFillProbeBatch(PlanState *outerNode, HashJoinState *hjstate)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	HashState  *hashState = (HashState *) innerPlanState(hjstate);
+	ExprContext *econtext = hjstate->js.ps.ps_ExprContext;
+	bool		keep_nulls = HJ_FILL_OUTER(hjstate) || hjstate->hj_nonequijoin;
+	int			nprobes = 0;
+	int			bucketno;
+	int			batchno;
+	int			i;
+
+	while (nprobes < hjstate->hj_ProbeBatchSize && !hjstate->hj_ProbeOuterDone)
+	{
+		TupleTableSlot *slot;
+		uint32		hashvalue;
+		bool		hashkeys_null = false;
+
+		/*
+		 * Check to see if first outer tuple was already fetched by
+		 * ExecHashJoin() and not used yet.
+		 */
+		slot = hjstate->hj_FirstOuterTupleSlot;
+		if (!TupIsNull(slot))
+			hjstate->hj_FirstOuterTupleSlot = NULL;
+		else
+			slot = ExecProcNode(outerNode);
+
+		if (TupIsNull(slot))
+		{
+			/* don't call the outer plan again after it has returned NULL */
+			hjstate->hj_ProbeOuterDone = true;
+			break;
+		}
+
+		econtext->ecxt_outertuple = slot;
+		if (!ExecHashGetHashValue(hashState, hashtable, econtext,
+								  hjstate->hj_OuterHashKeys,
+								  true,	/* outer tuple */
+								  keep_nulls,
+								  &hashvalue,
+								  &hashkeys_null))
+			continue;
+
+		/* remember outer relation is not empty for possible rescan */
+		hjstate->hj_OuterNotEmpty = true;
+
+		ExecCopySlot(hjstate->hj_ProbeSlots[nprobes], slot);
+		hjstate->hj_ProbeHashValues[nprobes] = hashvalue;
+
+		/* start loading the bucket and its tag */
+		ExecHashGetBucketAndBatch(hashtable, hashvalue, &bucketno, &batchno);
+		if (batchno == hashtable->curbatch)
+		{
+			HJ_PREFETCH(&hashtable->buckets.unshared[bucketno]);
+			HJ_PREFETCH(&hashtable->bucketTags[bucketno]);
+		}
+
+		nprobes++;
+	}
+
+	/*
+	 * By now, the first buckets have likely arrived. Start loading the first
+	 * tuple of each bucket that may hold a match.
+	 */
+	for (i = 0; i < nprobes; i++)
+	{
+		uint32		hashvalue = hjstate->hj_ProbeHashValues[i];
+
+		ExecHashGetBucketAndBatch(hashtable, hashvalue, &bucketno, &batchno);
+		if (batchno == hashtable->curbatch &&
+			(hashtable->bucketTags[bucketno] & HJ_BUCKET_TAG(hashvalue)))
+			HJ_PREFETCH(hashtable->buckets.unshared[bucketno]);
+	}
+
+	hjstate->hj_ProbeCount = nprobes;
+	hjstate->hj_ProbeNext = 0;
+}
+
 /*
  * ExecHashJoinOuterGetTuple variant for the parallel case.
  */
@@ -1535,6 +1680,7 @@ ExecHashJoinSaveTuple(PlanState *ps, MinimalTuple tuple, uint32 hashvalue,
 		file = BufFileCreateTempInSet("HashJoin", false /* interXact */,
 									  hashtable->work_set);
 		BufFilePledgeSequential(file);	/* allow compression */
+		BufFileSetBufferSize(file, ExecHashBatchFileBufferSize(hashtable));
 		*fileptr = file;
 
 		elog(gp_workfile_caching_loglevel, "create batch file %s",
@@ -1693,6 +1839,10 @@ ExecReScanHashJoin(HashJoinState *node)
 	node->hj_MatchedOuter = false;
 	node->hj_FirstOuterTupleSlot = NULL;
 
+	node->hj_ProbeCount = 0;
+	node->hj_ProbeNext = 0;
+	node->hj_ProbeOuterDone = false;
+
 	/*
 	 * if chgParam of subnode is not null then plan will be re-scanned by
 	 * first ExecProcNode.
@@ -1734,6 +1884,8 @@ ReleaseHashTable(HashJoinState *node)
 	node->hj_MatchedOuter = false;
 	node->hj_FirstOuterTupleSlot = NULL;
 
+	node->hj_ProbeCount = 0;
+	node->hj_ProbeNext = 0;
 }
 
 /* Is this an IS-NOT-DISTINCT-join qual list (as opposed the an equijoin)?
@@ -25,7 +25,6 @@
 #include "executor/execdebug.h"
 #include "executor/execUtils.h"
 #include "executor/nodeMotion.h"
-#include "lib/binaryheap.h"
 #include "utils/tuplesort.h"
 #include "miscadmin.h"
 #include "utils/memutils.h"
@@ -44,7 +43,6 @@
 #include "lib/stringinfo.h"		/* StringInfo */
 #endif
 
-
 /*=========================================================================
  * FUNCTIONS PROTOTYPES
  */
@@ -52,12 +50,17 @@ static TupleTableSlot *execMotionSender(MotionState *node);
 static TupleTableSlot *execMotionUnsortedReceiver(MotionState *node);
 static TupleTableSlot *execMotionSortedReceiver(MotionState *node);
 
-static int	CdbMergeComparator(Datum lhs, Datum rhs, void *context);
+static void storeMergeTuple(MotionState *node, int segIdx, MinimalTuple tuple);
+static bool mergeTupleBefore(MotionState *node, int lSegIdx, int rSegIdx);
+static void buildLoserTree(MotionState *node);
+static void replayLoserTree(MotionState *node, int segIdx);
 static uint32 evalHashKey(ExprContext *econtext, List *hashkeys, CdbHash *h);
 
 static void doSendEndOfStream(Motion *motion, MotionState *node);
 static void doSendTuple(Motion *motion, MotionState *node, TupleTableSlot *outerTupleSlot);
 
+static void ExecMotionExplainEnd(PlanState *planstate, struct StringInfoData *buf);
+
 
 /*=========================================================================
  */
@@ -379,7 +382,7 @@ execMotionUnsortedReceiver(MotionState *node)
  * --------------------
  *
  * The 1st time we execute, we need to pull a tuple from each of our source
- * and store them in our tupleheap.  Once that is done, we can pick the lowest
+ * and build a loser tree over them.  Once that is done, we can pick the lowest
  * (or whatever the criterion is) value from amongst all the sources.  This
  * works since each stream is sorted itself.
  *
@@ -388,22 +391,26 @@ execMotionUnsortedReceiver(MotionState *node)
  *
  * Subsequent calls to this function (after the 1st time) will start by
  * trying to receive a tuple for the slot that was emptied the previous call.
- * Then we again select the lowest value and return that tuple.
+ * Then we replay the matches on the path from that sender to the root of the
+ * loser tree, and return the new winner.
+ *
+ * A loser tree takes ceil(log2(N)) comparisons to find the next winner among
+ * N senders, about half of what sifting down a binary heap takes.  That
+ * matters on the coordinator of a large cluster, where all the comparisons
+ * of a sorted Gather Motion are done in one process.
  */
 
-/* Sorted receiver using binary heap */
+/* Sorted receiver using a loser tree */
 static TupleTableSlot *
 execMotionSortedReceiver(MotionState *node)
 {
 	TupleTableSlot *slot;
-	binaryheap *hp = node->tupleheap;
 	MinimalTuple inputTuple;
 	Motion	   *motion = (Motion *) node->ps.plan;
-	EState	   *estate = node->ps.state;
 
 	AssertState(motion->motionType == MOTIONTYPE_GATHER &&
 				motion->sendSorted &&
-				hp != NULL);
+				node->loserTree != NULL);
 
 	/* Notify senders and return EOS if caller doesn't want any more data. */
 	if (node->stopRequested)
@@ -416,13 +423,10 @@ execMotionSortedReceiver(MotionState *node)
 	}
 
 	/*
-	 * On first call, fill the priority queue with each sender's first tuple.
+	 * On first call, fill the loser tree with each sender's first tuple.
 	 */
-	if (!node->tupleheapReady)
+	if (!node->mergeReady)
 	{
-		MinimalTuple inputTuple;
-		binaryheap *hp = node->tupleheap;
-		Motion	   *motion = (Motion *) node->ps.plan;
 		int			iSegIdx;
 		ListCell   *lcProcess;
 		ExecSlice  *sendSlice = &node->ps.state->es_sliceTable->slices[motion->motionID];
@@ -431,8 +435,6 @@ execMotionSortedReceiver(MotionState *node)
 
 		foreach_with_count(lcProcess, sendSlice->primaryProcesses, iSegIdx)
 		{
-			MemoryContext oldcxt;
-
 			if (lfirst(lcProcess) == NULL)
 				continue;			/* skip this one: we are not receiving from it */
 
@@ -443,71 +445,31 @@ execMotionSortedReceiver(MotionState *node)
 			if (!inputTuple)
 				continue;			/* skip this one: received nothing */
 
-			/*
-			 * Make a slot to hold this tuple. We will reuse it to hold any
-			 * future tuples from the same sender. We initialized the result
-			 * tuple slot with the correct type earlier, so make the new slot
-			 * have the same type.
-			 */
-			oldcxt = MemoryContextSwitchTo(estate->es_query_cxt);
-			node->slots[iSegIdx] = MakeTupleTableSlot(node->ps.ps_ResultTupleSlot->tts_tupleDescriptor,
-													  &TTSOpsMinimalTuple);
-			MemoryContextSwitchTo(oldcxt);
-
-			/*
-			 * Store the tuple in the slot, and add it to the heap.
-			 *
-			 * Use slot_getsomeattrs() to materialize the columns we need for
-			 * the comparisons in the tts_values/isnull arrays. The comparator
-			 * can then peek directly into the arrays, which is cheaper than
-			 * calling slot_getattr() all the time.
-			 */
-			ExecStoreMinimalTuple(inputTuple, node->slots[iSegIdx], true);
-			slot_getsomeattrs(node->slots[iSegIdx], node->lastSortColIdx);
-			binaryheap_add_unordered(hp, iSegIdx);
-
-			node->numTuplesFromAMS++;
-
-#ifdef CDB_MOTION_DEBUG
-			if (node->numTuplesFromAMS <= 20)
-			{
-				StringInfoData buf;
-
-				initStringInfo(&buf);
-				appendStringInfo(&buf, "   motion%-3d rcv<-%-3d %5d.",
-								 motion->motionID,
-								 iSegIdx,
-								 node->numTuplesFromAMS);
-				formatTuple(&buf, node->slots[iSegIdx], node->outputFunArray);
-				elog(DEBUG3, "%s", buf.data);
-				pfree(buf.data);
-			}
-#endif
+			storeMergeTuple(node, iSegIdx, inputTuple);
 		}
 		Assert(iSegIdx == node->numInputSegs);
 
 		/*
-		 * Done adding the elements, now arrange the heap to satisfy the heap
-		 * property. This is quicker than inserting the initial elements one by
-		 * one.
+		 * Done adding the elements, now play all the matches.  This is
+		 * quicker than inserting the initial elements one by one.
 		 */
-		binaryheap_build(hp);
+		buildLoserTree(node);
 
-		node->tupleheapReady = true;
+		node->mergeReady = true;
 	}
 
 	/*
-	 * Delete from the priority queue the element that we fetched last time.
-	 * Receive and insert the next tuple from that same sender.
+	 * Receive the next tuple from the sender whose tuple we returned last
+	 * time, and let it compete for the next place.
 	 */
 	else
 	{
 		/* sanity check */
-		if (binaryheap_empty(hp))
+		if (node->mergeDone[node->loserTree[0]])
 			elog(ERROR, "sorted Gather Motion called again after already receiving all data");
 
-		/* Old element is still at the head of the pq. */
-		Assert(DatumGetInt32(binaryheap_first(hp)) == node->routeIdNext);
+		/* Old winner is still at the root of the tree. */
+		Assert(node->loserTree[0] == node->routeIdNext);
 
 		/* Receive the successor of the tuple that we returned last time. */
 		inputTuple = RecvTupleFrom(node->ps.state->motionlayer_context,
@@ -515,40 +477,20 @@ execMotionSortedReceiver(MotionState *node)
 								   motion->motionID,
 								   node->routeIdNext);
 
-		/* Substitute it in the pq for its predecessor. */
+		/* Substitute it in the tree for its predecessor. */
 		if (inputTuple)
-		{
-			ExecStoreMinimalTuple(inputTuple, node->slots[node->routeIdNext], true);
-			slot_getsomeattrs(node->slots[node->routeIdNext], node->lastSortColIdx);
-			binaryheap_replace_first(hp, Int32GetDatum(node->routeIdNext));
-
-			node->numTuplesFromAMS++;
-
-#ifdef CDB_MOTION_DEBUG
-			if (node->numTuplesFromAMS <= 20)
-			{
-				StringInfoData buf;
-
-				initStringInfo(&buf);
-				appendStringInfo(&buf, "   motion%-3d rcv<-%-3d %5d.",
-								 motion->motionID,
-								 node->routeIdNext,
-								 node->numTuplesFromAMS);
-				formatTuple(&buf, node->slots[node->routeIdNext], node->outputFunArray);
-				elog(DEBUG3, "%s", buf.data);
-				pfree(buf.data);
-			}
-#endif
-		}
+			storeMergeTuple(node, node->routeIdNext, inputTuple);
 		else
 		{
-			/* At EOS, drop this sender from the priority queue. */
-			binaryheap_remove_first(hp);
+			/* At EOS, the sender loses all its remaining matches. */
+			node->mergeDone[node->routeIdNext] = true;
 		}
+
+		replayLoserTree(node, node->routeIdNext);
 	}
 
 	/* Finished if all senders have returned EOS. */
-	if (binaryheap_empty(hp))
+	if (node->mergeDone[node->loserTree[0]])
 	{
 		Assert(node->numTuplesFromAMS == node->numTuplesToParent);
 		Assert(node->numTuplesFromChild == 0);
@@ -558,14 +500,13 @@ execMotionSortedReceiver(MotionState *node)
 
 	/*
 	 * Our next result tuple, with lowest key among all senders, is now at the
-	 * head of the priority queue.  Get it from there.
+	 * root of the loser tree.  Get it from there.
 	 *
-	 * We transfer ownership of the tuple from the pq element to our caller,
-	 * but the pq element itself will remain in place until the next time we
-	 * are called, to avoid an unnecessary rearrangement of the priority
-	 * queue.
+	 * We transfer ownership of the tuple from the sender's slot to our
+	 * caller, but the sender stays at the root until the next time we are
+	 * called, when its next tuple replaces it.
 	 */
-	node->routeIdNext = binaryheap_first(hp);
+	node->routeIdNext = node->loserTree[0];
 	slot = node->slots[node->routeIdNext];
 
 	/* Update counters. */
@@ -695,7 +636,7 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 		/* TODO: If neither sending nor receiving, don't bother to initialize. */
 	}
 
-	motionstate->tupleheapReady = false;
+	motionstate->mergeReady = false;
 	motionstate->sentEndOfStream = false;
 
 	motionstate->otherTime.tv_sec = 0;
@@ -761,6 +702,24 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 		motionstate->cdbhash = makeCdbHash(motionstate->numHashSegments,
 										   nkeys,
 										   node->hashFuncs);
+
+		/*
+		 * Heavy hitters of a skewed join key.  Start spraying them at a
+		 * different segment in each sender, so that they don't all pile up
+		 * on the first segment when there are only a few of them.
+		 */
+		if (node->hotKeyHashes != NIL && nkeys > 0)
+		{
+			ListCell   *lc;
+			int			i = 0;
+
+			motionstate->numHotKeyHashes = list_length(node->hotKeyHashes);
+			motionstate->hotKeyHashes = palloc(motionstate->numHotKeyHashes * sizeof(uint32));
+			foreach(lc, node->hotKeyHashes)
+				motionstate->hotKeyHashes[i++] = (uint32) lfirst_int(lc);
+			motionstate->nextSprayRoute =
+				Max(GpIdentity.segindex, 0) % motionstate->numHashSegments;
+		}
 	}
 
 	/*
@@ -780,6 +739,13 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 		motionstate->numSortCols = node->numSortCols;
 		motionstate->sortKeys = (SortSupport) palloc0(node->numSortCols * sizeof(SortSupportData));
 
+		/* The loser tree, and per-sender merge state */
+		motionstate->loserTree = palloc(numInputSegs * sizeof(int));
+		motionstate->mergeDone = palloc(numInputSegs * sizeof(bool));
+		motionstate->mergeAbbrevKeys = palloc0(numInputSegs * sizeof(Datum));
+		for (int i = 0; i < numInputSegs; i++)
+			motionstate->mergeDone[i] = true;
+
 		for (int i = 0; i < node->numSortCols; i++)
 		{
 			SortSupport sortKey = &motionstate->sortKeys[i];
@@ -792,6 +758,15 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 			sortKey->ssup_nulls_first = node->nullsFirst[i];
 			sortKey->ssup_attno = node->sortColIdx[i];
 
+			/*
+			 * Converting a key to its abbreviated form costs about as much
+			 * as a few comparisons, so it only pays off when each tuple
+			 * takes part in enough matches.  See
+			 * gp_motion_merge_abbrev_min_senders.
+			 */
+			sortKey->abbreviate = (i == 0 &&
+								   numInputSegs >= gp_motion_merge_abbrev_min_senders);
+
 			PrepareSortSupportFromOrderingOp(node->sortOperators[i], sortKey);
 
 			/* Also make note of the last column used in the sort key */
@@ -799,10 +774,7 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 				lastSortColIdx = node->sortColIdx[i];
 		}
 		motionstate->lastSortColIdx = lastSortColIdx;
-		motionstate->tupleheap =
-			binaryheap_allocate(motionstate->numInputSegs,
-								CdbMergeComparator,
-								motionstate);
+		motionstate->mergeAbbrevNext = 10;
 	}
 
 	/*
@@ -811,8 +783,18 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 	UpdateMotionLayerNode(motionstate->ps.state->motionlayer_context,
 						  node->motionID,
 						  node->sendSorted,
+						  node->compressTuples,
+						  node->batchSize,
 						  tupDesc);
 
+	/*
+	 * CDB: Offer extra info for EXPLAIN ANALYZE: how well the tuples
+	 * compressed, and how many were batched.
+	 */
+	if ((node->compressTuples || node->batchSize > 0) &&
+		estate->es_instrument && (estate->es_instrument & INSTRUMENT_CDB))
+		motionstate->ps.cdbexplainfun = ExecMotionExplainEnd;
+
 
 #ifdef CDB_MOTION_DEBUG
 	motionstate->outputFunArray = (Oid *) palloc(tupDesc->natts * sizeof(Oid));
@@ -905,11 +887,15 @@ ExecEndMotion(MotionState *node)
 	}
 #endif							/* MEASURE_MOTION_TIME */
 
-	/* Merge Receive: Free the priority queue and associated structures. */
-	if (node->tupleheap != NULL)
+	/* Merge Receive: Free the loser tree and associated structures. */
+	if (node->loserTree != NULL)
 	{
-		binaryheap_free(node->tupleheap);
-		node->tupleheap = NULL;
+		pfree(node->loserTree);
+		pfree(node->mergeDone);
+		pfree(node->mergeAbbrevKeys);
+		node->loserTree = NULL;
+		node->mergeDone = NULL;
+		node->mergeAbbrevKeys = NULL;
 	}
 
 	/* Free the slices and routes */
@@ -935,28 +921,147 @@ ExecEndMotion(MotionState *node)
 
 
 
+/*
+ * ExecMotionExplainEnd
+ *		Called before ExecutorEnd to finish EXPLAIN ANALYZE reporting.
+ */
+static void
+ExecMotionExplainEnd(PlanState *planstate, struct StringInfoData *buf)
+{
+	Motion	   *motion = (Motion *) planstate->plan;
+	uint64		rawBytes;
+	uint64		compressedBytes;
+	uint64		batches;
+	uint64		batchedTuples;
+
+	GetMotionCompressionStats(planstate->state->motionlayer_context,
+							  motion->motionID,
+							  &rawBytes, &compressedBytes);
+
+	if (rawBytes > 0)
+		appendStringInfo(buf,
+						 "Compressed tuples: " UINT64_FORMAT " bytes before compression, "
+						 UINT64_FORMAT " bytes after.",
+						 rawBytes, compressedBytes);
+
+	GetMotionBatchStats(planstate->state->motionlayer_context,
+						motion->motionID,
+						&batches, &batchedTuples);
+
+	if (batches > 0)
+		appendStringInfo(buf,
+						 "%sBatched tuples: " UINT64_FORMAT " tuples in "
+						 UINT64_FORMAT " batches.",
+						 rawBytes > 0 ? "  " : "",
+						 batchedTuples, batches);
+}								/* ExecMotionExplainEnd */
+
+
 /*=========================================================================
  * HELPER FUNCTIONS
  */
 
 /*
- * CdbMergeComparator:
- * Used to compare tuples for a sorted motion node.
+ * storeMergeTuple
+ *		Store the next tuple from a sender of a sorted motion in its slot.
+ *
+ * Use slot_getsomeattrs() to materialize the columns we need for the
+ * comparisons in the tts_values/isnull arrays.  mergeTupleBefore() can then
+ * peek directly into the arrays, which is cheaper than calling slot_getattr()
+ * all the time.  The abbreviated form of the first key, if any, is computed
+ * once here, like tuplesort does when a tuple is added.
  */
-static int
-CdbMergeComparator(Datum lhs, Datum rhs, void *context)
+static void
+storeMergeTuple(MotionState *node, int segIdx, MinimalTuple tuple)
 {
-	MotionState *node = (MotionState *) context;
-	int			lSegIdx = DatumGetInt32(lhs);
-	int			rSegIdx = DatumGetInt32(rhs);
+	TupleTableSlot *slot = node->slots[segIdx];
+	SortSupport ssup = &node->sortKeys[0];
+
+	/*
+	 * Make a slot to hold this tuple. We will reuse it to hold any future
+	 * tuples from the same sender. We initialized the result tuple slot with
+	 * the correct type earlier, so make the new slot have the same type.
+	 */
+	if (slot == NULL)
+	{
+		MemoryContext oldcxt = MemoryContextSwitchTo(node->ps.state->es_query_cxt);
+
+		slot = MakeTupleTableSlot(node->ps.ps_ResultTupleSlot->tts_tupleDescriptor,
+								  &TTSOpsMinimalTuple);
+		node->slots[segIdx] = slot;
+		MemoryContextSwitchTo(oldcxt);
+	}
+
+	ExecStoreMinimalTuple(tuple, slot, true);
+	slot_getsomeattrs(slot, node->lastSortColIdx);
+	node->mergeDone[segIdx] = false;
+
+	node->numTuplesFromAMS++;
+
+	if (ssup->abbrev_converter && !slot->tts_isnull[ssup->ssup_attno - 1])
+	{
+		/*
+		 * Give up on abbreviation if it doesn't look like it will tell the
+		 * keys apart.  We keep the original datums in the slots, so there's
+		 * nothing to undo.
+		 */
+		if (node->numTuplesFromAMS >= node->mergeAbbrevNext)
+		{
+			node->mergeAbbrevNext *= 2;
+			if (ssup->abbrev_abort(node->numTuplesFromAMS, ssup))
+			{
+				ssup->comparator = ssup->abbrev_full_comparator;
+				ssup->abbrev_converter = NULL;
+				ssup->abbrev_abort = NULL;
+				ssup->abbrev_full_comparator = NULL;
+			}
+		}
+
+		if (ssup->abbrev_converter)
+			node->mergeAbbrevKeys[segIdx] =
+				ssup->abbrev_converter(slot->tts_values[ssup->ssup_attno - 1],
+									   ssup);
+	}
 
-	TupleTableSlot *lslot = node->slots[lSegIdx];
-	TupleTableSlot *rslot = node->slots[rSegIdx];
+#ifdef CDB_MOTION_DEBUG
+	if (node->numTuplesFromAMS <= 20)
+	{
+		StringInfoData buf;
+
+		initStringInfo(&buf);
+		appendStringInfo(&buf, "   motion%-3d rcv<-%-3d %5d.",
+						 ((Motion *) node->ps.plan)->motionID,
+						 segIdx,
+						 node->numTuplesFromAMS);
+		formatTuple(&buf, slot, node->outputFunArray);
+		elog(DEBUG3, "%s", buf.data);
+		pfree(buf.data);
+	}
+#endif
+}
+
+/*
+ * mergeTupleBefore
+ *		Does the current tuple of one sender of a sorted motion come before
+ *		that of another?
+ *
+ * A sender that has reached end-of-stream loses to everyone.  Ties go to the
+ * lower sender, so that the tree is replayed the same way every time.
+ */
+static bool
+mergeTupleBefore(MotionState *node, int lSegIdx, int rSegIdx)
+{
+	TupleTableSlot *lslot;
+	TupleTableSlot *rslot;
 	SortSupport	sortKeys = node->sortKeys;
 	int			nkey;
 	int			compare;
 
-	Assert(lslot && rslot);
+	if (node->mergeDone[lSegIdx] || node->mergeDone[rSegIdx])
+		return node->mergeDone[rSegIdx] && !node->mergeDone[lSegIdx];
+
+	lslot = node->slots[lSegIdx];
+	rslot = node->slots[rSegIdx];
 
 	for (nkey = 0; nkey < node->numSortCols; nkey++)
 	{
@@ -968,26 +1073,105 @@ CdbMergeComparator(Datum lhs, Datum rhs, void *context)
 					isnull2;
 
 		/*
-		 * The caller has called slot_getsomeattrs() to ensure
-		 * that all the columns we need are available directly in
-		 * the values/isnull arrays.
+		 * storeMergeTuple() has called slot_getsomeattrs() to ensure that
+		 * all the columns we need are available directly in the
+		 * values/isnull arrays.
 		 */
 		datum1 = lslot->tts_values[attno - 1];
 		isnull1 = lslot->tts_isnull[attno - 1];
 		datum2 = rslot->tts_values[attno - 1];
 		isnull2 = rslot->tts_isnull[attno - 1];
 
-		compare = ApplySortComparator(datum1, isnull1,
-									  datum2, isnull2,
-									  ssup);
+		if (nkey == 0 && ssup->abbrev_converter)
+		{
+			compare = ApplySortComparator(node->mergeAbbrevKeys[lSegIdx], isnull1,
+										  node->mergeAbbrevKeys[rSegIdx], isnull2,
+										  ssup);
+			if (compare == 0)
+				compare = ApplySortAbbrevFullComparator(datum1, isnull1,
+														datum2, isnull2,
+														ssup);
+		}
+		else
+			compare = ApplySortComparator(datum1, isnull1,
+										  datum2, isnull2,
+										  ssup);
 		if (compare != 0)
+			return compare < 0;
+	}
+	return lSegIdx < rSegIdx;
+}								/* mergeTupleBefore */
+
+/*
+ * buildLoserTree
+ *		Play all the matches of the loser tree of a sorted motion.
+ *
+ * The senders are the leaves N .. 2N-1 of an implicit binary tree, where
+ * node i has children 2i and 2i+1.  Each internal node 1 .. N-1 remembers
+ * the loser of the match played there, and loserTree[0] the overall winner.
+ * This works for any N, the leaves just aren't all at the same depth.
+ */
+static void
+buildLoserTree(MotionState *node)
+{
+	int			n = node->numInputSegs;
+	int		   *winners;
+
+	Assert(n >= 1);
+	if (n == 1)
+	{
+		node->loserTree[0] = 0;
+		return;
+	}
+
+	winners = palloc(2 * n * sizeof(int));
+	for (int i = 0; i < n; i++)
+		winners[n + i] = i;
+
+	for (int i = n - 1; i >= 1; i--)
+	{
+		int			l = winners[2 * i];
+		int			r = winners[2 * i + 1];
+
+		if (mergeTupleBefore(node, l, r))
+		{
+			winners[i] = l;
+			node->loserTree[i] = r;
+		}
+		else
 		{
-			INVERT_COMPARE_RESULT(compare);
-			return compare;
+			winners[i] = r;
+			node->loserTree[i] = l;
 		}
 	}
-	return 0;
-}								/* CdbMergeComparator */
+	node->loserTree[0] = winners[1];
+
+	pfree(winners);
+}
+
+/*
+ * replayLoserTree
+ *		Let the new tuple of a sender play the matches on the path from its
+ *		leaf to the root of the loser tree.
+ */
+static void
+replayLoserTree(MotionState *node, int segIdx)
+{
+	int			n = node->numInputSegs;
+	int			winner = segIdx;
+
+	for (int i = (n + segIdx) / 2; i >= 1; i /= 2)
+	{
+		if (mergeTupleBefore(node, node->loserTree[i], winner))
+		{
+			int			loser = winner;
+
+			winner = node->loserTree[i];
+			node->loserTree[i] = loser;
+		}
+	}
+	node->loserTree[0] = winner;
+}
 
 /*
  * Experimental code that will be replaced later with new hashing mechanism
@@ -1140,6 +1324,30 @@ doSendTuple(Motion *motion, MotionState *node, TupleTableSlot *outerTupleSlot)
 		 * is passed around our system a fair amount!).
 		 */
 		Assert(targetRoute != BROADCAST_SEGIDX);
+
+		/*
+		 * A heavy hitter of a skewed join key?  On one side of the join, it
+		 * is sent round-robin to all segments, and on the other side it is
+		 * broadcast, so that the rows still meet.
+		 */
+		if (node->numHotKeyHashes > 0)
+		{
+			for (int i = 0; i < node->numHotKeyHashes; i++)
+			{
+				if (node->hotKeyHashes[i] != node->cdbhash->hash)
+					continue;
+
+				if (motion->broadcastHotKeys)
+					targetRoute = BROADCAST_SEGIDX;
+				else
+				{
+					targetRoute = node->nextSprayRoute;
+					if (++node->nextSprayRoute >= node->numHashSegments)
+						node->nextSprayRoute = 0;
+				}
+				break;
+			}
+		}
 	}
 	else if (motion->motionType == MOTIONTYPE_EXPLICIT)
 	{
@@ -1155,6 +1363,20 @@ doSendTuple(Motion *motion, MotionState *node, TupleTableSlot *outerTupleSlot)
 	else
 		elog(ERROR, "unknown motion type %d", motion->motionType);
 
+	/*
+	 * A broadcast only checks the record cache of the first connection.  A
+	 * Redistribute Motion that broadcasts heavy hitters may have sent to the
+	 * first connection before, so check them all.
+	 */
+	if (motion->motionType == MOTIONTYPE_HASH && targetRoute == BROADCAST_SEGIDX)
+	{
+		for (int16 route = 0; route < node->numHashSegments; route++)
+			CheckAndSendRecordCache(node->ps.state->motionlayer_context,
+									node->ps.state->interconnect_context,
+									motion->motionID,
+									route);
+	}
+
 	CheckAndSendRecordCache(node->ps.state->motionlayer_context,
 							node->ps.state->interconnect_context,
 							motion->motionID,
@@ -19,6 +19,7 @@
  *		ExecInitSeqScan			creates and initializes a seqscan node.
  *		ExecEndSeqScan			releases any storage allocated.
  *		ExecReScanSeqScan		rescans the relation
+ *		ExecSeqScanFetch		retrieve next tuple, without quals or projection
  *
  *		ExecSeqScanEstimate		estimates DSM space needed for parallel scan
  *		ExecSeqScanInitializeDSM initialize DSM for parallel scan
@@ -121,6 +122,20 @@ ExecSeqScan(PlanState *pstate)
 					(ExecScanRecheckMtd) SeqRecheck);
 }
 
+/* ----------------------------------------------------------------
+ *		ExecSeqScanFetch(node)
+ *
+ *		Returns the next tuple of the relation, without checking the
+ *		node's quals or projecting it. Used by the vectorized executor
+ *		(execVector.c), which evaluates the quals a batch at a time.
+ * ----------------------------------------------------------------
+ */
+TupleTableSlot *
+ExecSeqScanFetch(SeqScanState *node)
+{
+	return SeqNext(node);
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitSeqScan
  * ----------------------------------------------------------------
@@ -43,6 +43,13 @@
  * the producer when they're done reading it. The producer slice keeps the
  * underlying tuplestore open, until all the consumers have finished.
  *
+ * If the result is small, up to gp_shareinput_inmem_size, the producer
+ * doesn't write it to a file. Instead, it copies the tuples into a DSM
+ * segment, and advertises its handle along with the 'ready' flag. The
+ * consumers copy the tuples into a tuplestore in private memory, so they
+ * don't need to touch the disk at all. The producer keeps the segment
+ * attached until all the consumers have finished.
+ *
  *
  * Portions Copyright (c) 2007-2008, Greenplum inc
  * Portions Copyright (c) 2012-Present VMware, Inc. or its affiliates.
@@ -63,6 +70,7 @@
 #include "executor/nodeShareInputScan.h"
 #include "miscadmin.h"
 #include "storage/condition_variable.h"
+#include "storage/dsm.h"
 #include "storage/lwlock.h"
 #include "storage/shmem.h"
 #include "utils/faultinjector.h"
@@ -102,6 +110,8 @@ typedef struct shareinput_Xslice_state
 	int			refcount;		/* reference count of this entry */
 	bool		ready;			/* is the input fully materialized and ready to be read? */
 	int			ndone;			/* # of consumers that have finished the scan */
+	dsm_handle	inmem_handle;	/* DSM segment holding the result, or
+								 * DSM_HANDLE_INVALID if it's in a file */
 
 	/*
 	 * ready_done_cv is used for signaling when the scan becomes "ready", and
@@ -156,6 +166,16 @@ typedef struct shareinput_Xslice_reference
 static dlist_head shareinput_Xslice_refs = DLIST_STATIC_INIT(shareinput_Xslice_refs);
 static bool shareinput_resowner_callback_registered = false;
 
+/*
+ * Layout of the DSM segment holding a result that is shared in memory. The
+ * tuples are stored back to back, each one MAXALIGNed.
+ */
+typedef struct shareinput_inmem_result
+{
+	int64		ntuples;
+	char		data[FLEXIBLE_ARRAY_MEMBER];
+} shareinput_inmem_result;
+
 /*
  * For local (i.e. intra-slice) variants, we use a 'shareinput_local_state'
  * to track the status. It is analogous to 'shareinput_share_state' used for
@@ -177,6 +197,10 @@ typedef struct shareinput_local_state
 
 	/* Tuplestore that holds the result */
 	Tuplestorestate *ts_state;
+
+	/* In the producer, DSM segment holding the result, if it's in memory */
+	dsm_segment *inmem_seg;
+	Size		inmem_bytes;	/* size of the result in inmem_seg */
 } shareinput_local_state;
 
 static shareinput_Xslice_reference *get_shareinput_reference(int share_id);
@@ -186,8 +210,14 @@ static void shareinput_release_callback(ResourceReleasePhase phase,
 										bool isTopLevel,
 										void *arg);
 
-static void shareinput_writer_notifyready(shareinput_Xslice_reference *ref);
-static void shareinput_reader_waitready(shareinput_Xslice_reference *ref);
+static Tuplestorestate *materialize_xslice_tuplestore(ShareInputScanState *node);
+static Tuplestorestate *begin_xslice_tuplestore(ShareInputScanState *node);
+static Tuplestorestate *load_inmem_tuplestore(ShareInputScanState *node,
+											  shareinput_inmem_result *result);
+
+static void shareinput_writer_notifyready(shareinput_Xslice_reference *ref,
+										  dsm_handle inmem_handle);
+static dsm_handle shareinput_reader_waitready(shareinput_Xslice_reference *ref);
 static void shareinput_reader_notifydone(shareinput_Xslice_reference *ref, int nconsumers);
 static void shareinput_writer_waitdone(shareinput_Xslice_reference *ref, int nconsumers);
 
@@ -226,19 +256,14 @@ init_tuplestore_state(ShareInputScanState *node)
 			/* We are the producer */
 			if (sisc->cross_slice)
 			{
-				char		rwfile_prefix[100];
-
 				elog(DEBUG1, "SISC writer (shareid=%d, slice=%d): No tuplestore yet, creating tuplestore",
 					 sisc->share_id, currentSliceId);
 
-				ts = tuplestore_begin_heap(true, /* randomAccess */
-										   false, /* interXact */
-										   10); /* maxKBytes FIXME */
+				ts = materialize_xslice_tuplestore(node);
 
-				shareinput_create_bufname_prefix(rwfile_prefix, sizeof(rwfile_prefix), sisc->share_id);
-				tuplestore_make_shared(ts,
-									   get_shareinput_fileset(),
-									   rwfile_prefix);
+				/* Report where the result went, for EXPLAIN ANALYZE */
+				if (node->ss.ps.instrument && node->ss.ps.instrument->need_cdb)
+					node->ss.ps.cdbexplainfun = ExecShareInputScanExplainEnd;
 			}
 			else
 			{
@@ -267,20 +292,14 @@ init_tuplestore_state(ShareInputScanState *node)
 					/* Request a callback at end of query. */
 					node->ss.ps.cdbexplainfun = ExecShareInputScanExplainEnd;
 				}
-			}
 
-			for (;;)
-			{
-				outerslot = ExecProcNode(local_state->childState);
-				if (TupIsNull(outerslot))
-					break;
-				tuplestore_puttupleslot(ts, outerslot);
-			}
-
-			if (sisc->cross_slice)
-			{
-				tuplestore_freeze(ts);
-				shareinput_writer_notifyready(node->ref);
+				for (;;)
+				{
+					outerslot = ExecProcNode(local_state->childState);
+					if (TupIsNull(outerslot))
+						break;
+					tuplestore_puttupleslot(ts, outerslot);
+				}
 			}
 
 			tuplestore_rescan(ts);
@@ -291,14 +310,30 @@ init_tuplestore_state(ShareInputScanState *node)
 			 * We are a consumer slice. Wait for the producer to create the
 			 * tuplestore.
 			 */
-			char		rwfile_prefix[100];
+			dsm_handle	inmem_handle;
 
 			Assert(sisc->cross_slice);
 
-			shareinput_reader_waitready(node->ref);
+			inmem_handle = shareinput_reader_waitready(node->ref);
 
-			shareinput_create_bufname_prefix(rwfile_prefix, sizeof(rwfile_prefix), sisc->share_id);
-			ts = tuplestore_open_shared(get_shareinput_fileset(), rwfile_prefix);
+			if (inmem_handle != DSM_HANDLE_INVALID)
+			{
+				/* The result is in memory, copy it into a private tuplestore */
+				dsm_segment *seg;
+
+				seg = dsm_attach(inmem_handle);
+				if (seg == NULL)
+					elog(ERROR, "could not attach to ShareInputScan DSM segment");
+				ts = load_inmem_tuplestore(node, dsm_segment_address(seg));
+				dsm_detach(seg);
+			}
+			else
+			{
+				char		rwfile_prefix[100];
+
+				shareinput_create_bufname_prefix(rwfile_prefix, sizeof(rwfile_prefix), sisc->share_id);
+				ts = tuplestore_open_shared(get_shareinput_fileset(), rwfile_prefix);
+			}
 		}
 		local_state->ts_state = ts;
 		local_state->ready = true;
@@ -321,6 +356,182 @@ init_tuplestore_state(ShareInputScanState *node)
 }
 
 
+/*
+ * materialize_xslice_tuplestore
+ *    Materialize the result of a cross-slice share in the producer, and
+ *    tell the consumers that it's ready.
+ *
+ * The tuples are first collected in memory. If they all fit in
+ * gp_shareinput_inmem_size, they are copied into a DSM segment for the
+ * consumers. Otherwise, or if no DSM segment can be created, they go to
+ * a shared file like any larger result.
+ */
+static Tuplestorestate *
+materialize_xslice_tuplestore(ShareInputScanState *node)
+{
+	shareinput_local_state *local_state = node->local_state;
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+	Tuplestorestate *ts = NULL;
+	MemoryContext buffercxt = NULL;
+	MemoryContext oldcxt;
+	List	   *buffered = NIL;
+	Size		bufsize = 0;
+	Size		limit = (Size) gp_shareinput_inmem_size * 1024;
+	dsm_segment *seg = NULL;
+	ListCell   *lc;
+
+	if (limit > 0)
+		buffercxt = AllocSetContextCreate(CurrentMemoryContext,
+										  "ShareInputScan in-memory result",
+										  ALLOCSET_DEFAULT_SIZES);
+	else
+		ts = begin_xslice_tuplestore(node);
+
+	for (;;)
+	{
+		TupleTableSlot *outerslot;
+		MinimalTuple tuple;
+
+		outerslot = ExecProcNode(local_state->childState);
+		if (TupIsNull(outerslot))
+			break;
+
+		if (ts)
+		{
+			tuplestore_puttupleslot(ts, outerslot);
+			continue;
+		}
+
+		oldcxt = MemoryContextSwitchTo(buffercxt);
+		tuple = ExecCopySlotMinimalTuple(outerslot);
+		buffered = lappend(buffered, tuple);
+		MemoryContextSwitchTo(oldcxt);
+		bufsize += MAXALIGN(tuple->t_len);
+
+		if (bufsize > limit)
+		{
+			/* Too large to keep in memory, move what we have to a file */
+			ts = begin_xslice_tuplestore(node);
+			foreach(lc, buffered)
+			{
+				ExecStoreMinimalTuple((MinimalTuple) lfirst(lc), slot, false);
+				tuplestore_puttupleslot(ts, slot);
+			}
+			ExecClearTuple(slot);
+			MemoryContextDelete(buffercxt);
+			buffercxt = NULL;
+			buffered = NIL;
+		}
+	}
+
+	if (!ts)
+	{
+		seg = dsm_create(offsetof(shareinput_inmem_result, data) + bufsize,
+						 DSM_CREATE_NULL_IF_MAXSEGMENTS);
+		if (seg)
+		{
+			shareinput_inmem_result *result = dsm_segment_address(seg);
+			char	   *p = result->data;
+
+			result->ntuples = list_length(buffered);
+			foreach(lc, buffered)
+			{
+				MinimalTuple tuple = (MinimalTuple) lfirst(lc);
+
+				memcpy(p, tuple, tuple->t_len);
+				p += MAXALIGN(tuple->t_len);
+			}
+			local_state->inmem_seg = seg;
+			local_state->inmem_bytes = bufsize;
+
+			ts = load_inmem_tuplestore(node, result);
+		}
+		else
+		{
+			ts = begin_xslice_tuplestore(node);
+			foreach(lc, buffered)
+			{
+				ExecStoreMinimalTuple((MinimalTuple) lfirst(lc), slot, false);
+				tuplestore_puttupleslot(ts, slot);
+			}
+			ExecClearTuple(slot);
+		}
+		MemoryContextDelete(buffercxt);
+	}
+
+	if (seg)
+	{
+		elog(DEBUG1, "SISC writer (shareid=%d, slice=%d): result of %zu bytes kept in memory",
+			 ((ShareInputScan *) node->ss.ps.plan)->share_id, currentSliceId, bufsize);
+		shareinput_writer_notifyready(node->ref, dsm_segment_handle(seg));
+	}
+	else
+	{
+		tuplestore_freeze(ts);
+		shareinput_writer_notifyready(node->ref, DSM_HANDLE_INVALID);
+	}
+
+	return ts;
+}
+
+/*
+ * begin_xslice_tuplestore
+ *    Create the tuplestore of a cross-slice share, backed by a shared file.
+ */
+static Tuplestorestate *
+begin_xslice_tuplestore(ShareInputScanState *node)
+{
+	ShareInputScan *sisc = (ShareInputScan *) node->ss.ps.plan;
+	Tuplestorestate *ts;
+	char		rwfile_prefix[100];
+
+	ts = tuplestore_begin_heap(true, /* randomAccess */
+							   false, /* interXact */
+							   10); /* maxKBytes FIXME */
+
+	shareinput_create_bufname_prefix(rwfile_prefix, sizeof(rwfile_prefix), sisc->share_id);
+	tuplestore_make_shared(ts,
+						   get_shareinput_fileset(),
+						   rwfile_prefix);
+
+	return ts;
+}
+
+/*
+ * load_inmem_tuplestore
+ *    Copy a result that is shared in memory into a private tuplestore.
+ */
+static Tuplestorestate *
+load_inmem_tuplestore(ShareInputScanState *node,
+					  shareinput_inmem_result *result)
+{
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+	Tuplestorestate *ts;
+	char	   *p = result->data;
+	int64		i;
+
+	/*
+	 * The result is at most gp_shareinput_inmem_size, but the tuplestore
+	 * has some per-tuple overhead. Allow for that, so that it doesn't spill.
+	 */
+	ts = tuplestore_begin_heap(true, /* randomAccess */
+							   false, /* interXact */
+							   Max(PlanStateOperatorMemKB((PlanState *) node),
+								   2 * gp_shareinput_inmem_size));
+
+	for (i = 0; i < result->ntuples; i++)
+	{
+		MinimalTuple tuple = (MinimalTuple) p;
+
+		ExecStoreMinimalTuple(tuple, slot, false);
+		tuplestore_puttupleslot(ts, slot);
+		p += MAXALIGN(tuple->t_len);
+	}
+	ExecClearTuple(slot);
+
+	return ts;
+}
+
 /* ------------------------------------------------------------------
  * 	ExecShareInputScan
  * 	Retrieve a tuple from the ShareInputScan
@@ -475,6 +686,9 @@ ExecInitShareInputScan(ShareInputScan *node, EState *estate, int eflags)
  * Some of the cleanup that ordinarily would occur during ExecEndShareInputScan()
  * needs to be done earlier in order to report statistics to EXPLAIN ANALYZE.
  * Note that ExecEndShareInputScan() will still be during ExecutorEnd().
+ *
+ * For a cross-slice producer, reports whether the result was passed to the
+ * consumers in shared memory or in a file.
  */
 static void
 ExecShareInputScanExplainEnd(PlanState *planstate, struct StringInfoData *buf)
@@ -490,6 +704,15 @@ ExecShareInputScanExplainEnd(PlanState *planstate, struct StringInfoData *buf)
 		tuplestore_end(local_state->ts_state);
 		local_state->ts_state = NULL;
 	}
+
+	if (sisc->cross_slice && local_state && local_state->ready)
+	{
+		if (local_state->inmem_seg)
+			appendStringInfo(buf, "Passed %zu bytes to consumers in shared memory.\n",
+							 local_state->inmem_bytes);
+		else
+			appendStringInfoString(buf, "Passed result to consumers in a file.\n");
+	}
 }
 
 /* ------------------------------------------------------------------
@@ -520,6 +743,13 @@ ExecEndShareInputScan(ShareInputScanState *node)
 				if (!local_state->ready)
 					init_tuplestore_state(node);
 				shareinput_writer_waitdone(node->ref, sisc->nconsumers);
+
+				/* The consumers have copied the result, if it was in memory */
+				if (local_state->inmem_seg)
+				{
+					dsm_detach(local_state->inmem_seg);
+					local_state->inmem_seg = NULL;
+				}
 			}
 			else
 			{
@@ -787,6 +1017,7 @@ get_shareinput_reference(int share_id)
 		xslice_state->refcount = 0;
 		xslice_state->ready = false;
 		xslice_state->ndone = 0;
+		xslice_state->inmem_handle = DSM_HANDLE_INVALID;
 
 		ConditionVariableInit(&xslice_state->ready_done_cv);
 	}
@@ -870,14 +1101,16 @@ shareinput_release_callback(ResourceReleasePhase phase,
  * shareinput_reader_waitready
  *
  *  Called by the reader (consumer) to wait for the writer (producer) to produce
- *  all the tuples and write them to disk.
+ *  all the tuples and write them to disk, or to a DSM segment. Returns the
+ *  handle of the DSM segment, or DSM_HANDLE_INVALID if the tuples are on disk.
  *
  *  This is a blocking operation.
  */
-static void
+static dsm_handle
 shareinput_reader_waitready(shareinput_Xslice_reference *ref)
 {
 	shareinput_Xslice_state *state = ref->xslice_state;
+	dsm_handle	inmem_handle;
 
 	elog(DEBUG1, "SISC READER (shareid=%d, slice=%d): Waiting for producer",
 		 ref->share_id, currentSliceId);
@@ -906,26 +1139,39 @@ shareinput_reader_waitready(shareinput_Xslice_reference *ref)
 	}
 	ConditionVariableCancelSleep();
 
+	LWLockAcquire(ShareInputScanLock, LW_SHARED);
+	inmem_handle = state->inmem_handle;
+	LWLockRelease(ShareInputScanLock);
+
 	/* it's ready now */
 	elog(DEBUG1, "SISC READER (shareid=%d, slice=%d): Wait ready got writer's handshake",
 		 ref->share_id, currentSliceId);
+
+	return inmem_handle;
 }
 
 /*
  * shareinput_writer_notifyready
  *
  *  Called by the writer (producer) once it is done producing all tuples and
- *  writing them to disk. It notifies all the readers (consumers) that tuples
- *  are ready to be read from disk.
+ *  writing them to disk, or to the DSM segment 'inmem_handle'. It notifies
+ *  all the readers (consumers) that tuples are ready to be read.
  */
 static void
-shareinput_writer_notifyready(shareinput_Xslice_reference *ref)
+shareinput_writer_notifyready(shareinput_Xslice_reference *ref,
+							  dsm_handle inmem_handle)
 {
 	shareinput_Xslice_state *state = ref->xslice_state;
 
-	/* we're the only writer, so no need to acquire the lock. */
+	/*
+	 * We're the only writer, but the readers must not see 'ready' before
+	 * the handle, so set them together under the lock.
+	 */
 	Assert(!state->ready);
+	LWLockAcquire(ShareInputScanLock, LW_EXCLUSIVE);
+	state->inmem_handle = inmem_handle;
 	state->ready = true;
+	LWLockRelease(ShareInputScanLock);
 
 	ConditionVariableBroadcast(&state->ready_done_cv);
 
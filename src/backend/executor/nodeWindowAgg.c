@@ -37,6 +37,8 @@
 #include "catalog/objectaccess.h"
 #include "catalog/pg_aggregate.h"
 #include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
+#include "cdb/cdbvars.h"
 #include "executor/executor.h"
 #include "executor/nodeWindowAgg.h"
 #include "miscadmin.h"
@@ -103,6 +105,33 @@ typedef struct WindowStatePerFuncData
 	WindowObject winobj;		/* object used in window function API */
 }			WindowStatePerFuncData;
 
+/* Number of leaves allocated at first, and fewest leaves dropped at a time */
+#define WINDOW_SEGTREE_MIN_LEAVES	1024
+#define WINDOW_SEGTREE_MAX_LEVELS	64
+
+/*
+ * Segment tree over the transition states of an aggregate's input rows.
+ *
+ * Leaf i holds the transition state of the aggregate over the single row
+ * base + i.  The node at level k and index j holds the states of leaves
+ * j * 2^k to (j + 1) * 2^k - 1 merged with the aggregate's combine function.
+ * Leaves are appended as rows enter the frame, and a node is computed as
+ * soon as its right child is, so only complete nodes exist.  The state of
+ * any range of rows can then be computed with O(log n) combine calls.  Rows
+ * that fell off the frame head are dropped by rebuilding the tree, once they
+ * outnumber the rows that are left.
+ */
+typedef struct WindowSegTree
+{
+	MemoryContext cxt;			/* holds the tree and its states */
+	int64		base;			/* partition row of leaf 0 */
+	int64		nleaves;		/* number of leaves */
+	int64		capacity;		/* number of leaves allocated */
+	int			nlevels;		/* number of levels allocated */
+	Datum	   *values[WINDOW_SEGTREE_MAX_LEVELS];
+	bool	   *isnulls[WINDOW_SEGTREE_MAX_LEVELS];
+} WindowSegTree;
+
 /*
  * For plain aggregate window functions, we also have one of these.
  */
@@ -112,6 +141,7 @@ typedef struct WindowStatePerAggData
 	Oid			transfn_oid;
 	Oid			invtransfn_oid; /* may be InvalidOid */
 	Oid			finalfn_oid;	/* may be InvalidOid */
+	Oid			combinefn_oid;	/* may be InvalidOid */
 
 	/*
 	 * fmgr lookup data for transition functions --- only valid when
@@ -121,6 +151,7 @@ typedef struct WindowStatePerAggData
 	FmgrInfo	transfn;
 	FmgrInfo	invtransfn;
 	FmgrInfo	finalfn;
+	FmgrInfo	combinefn;
 
 	int			numFinalArgs;	/* number of arguments to pass to finalfn */
 
@@ -155,6 +186,14 @@ typedef struct WindowStatePerAggData
 	/* Input values accumulated for this aggregate so far. */
 	Tuplesortstate *distinctSortState;
 
+	/*
+	 * Support for evaluating the aggregate over a segment tree, see
+	 * eval_windowaggregates().
+	 */
+	Oid			transtype;
+	bool		use_segtree;
+	WindowSegTree *segtree;		/* tree of current partition, or NULL */
+
 	/*
 	 * We need the len and byval info for the agg's input, result, and
 	 * transition data types in order to know how to copy/delete values.
@@ -200,6 +239,24 @@ static void finalize_windowaggregate(WindowAggState *winstate,
 									 Datum *result, bool *isnull);
 
 static void eval_windowaggregates(WindowAggState *winstate);
+static void segtree_add_row(WindowAggState *winstate,
+							WindowStatePerFunc perfuncstate,
+							WindowStatePerAgg peraggstate,
+							int64 pos);
+static void segtree_append(WindowAggState *winstate,
+						   WindowStatePerFunc perfuncstate,
+						   WindowStatePerAgg peraggstate,
+						   WindowSegTree *tree,
+						   Datum value, bool isnull);
+static void segtree_combine(WindowAggState *winstate,
+							WindowStatePerFunc perfuncstate,
+							WindowStatePerAgg peraggstate,
+							Datum *transValue, bool *transValueIsNull,
+							Datum value, bool isnull);
+static void segtree_aggregate(WindowAggState *winstate,
+							  WindowStatePerFunc perfuncstate,
+							  WindowStatePerAgg peraggstate,
+							  int64 startpos, int64 endpos);
 static void eval_windowfunction(WindowAggState *winstate,
 								WindowStatePerFunc perfuncstate,
 								Datum *result, bool *isnull);
@@ -217,6 +274,9 @@ static void update_grouptailpos(WindowAggState *winstate);
 static WindowStatePerAggData *initialize_peragg(WindowAggState *winstate,
 												WindowFunc *wfunc,
 												WindowStatePerAgg peraggstate);
+static void initialize_peragg_segtree(WindowAggState *winstate,
+									  WindowFunc *wfunc,
+									  WindowStatePerAgg peraggstate);
 static Datum GetAggInitVal(Datum textInitVal, Oid transtype);
 
 static bool are_peers(WindowAggState *winstate, TupleTableSlot *slot1,
@@ -839,6 +899,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	int			wfuncno,
 				numaggs,
 				numaggs_restart,
+				numaggs_segtree,
 				i;
 	int64		aggregatedupto_nonrestarted;
 	MemoryContext oldContext;
@@ -885,6 +946,15 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * must perform the aggregation all over again for all tuples within the
 	 * new frame boundaries.
 	 *
+	 * Restarting costs time proportional to the frame size for every row.
+	 * GPDB: To avoid that, aggregates that have no inverse transition function
+	 * but do have a combine function are instead evaluated over a segment
+	 * tree, when the frame head moves (see initialize_peragg_segtree).  Each
+	 * row entering the frame gets a leaf holding its own transition state,
+	 * and the state of the frame is combined from O(log n) nodes of the tree.
+	 * Such aggregates never restart, and are skipped by the incremental code
+	 * below.
+	 *
 	 * If there's any exclusion clause, then we may have to aggregate over a
 	 * non-contiguous set of rows, so we punt and recalculate for every row.
 	 * (For some frame end choices, it might be that the frame is always
@@ -1007,10 +1077,16 @@ eval_windowaggregates(WindowAggState *winstate)
 	 *----------
 	 */
 	numaggs_restart = 0;
+	numaggs_segtree = 0;
 	for (i = 0; i < numaggs; i++)
 	{
 		peraggstate = &winstate->peragg[i];
-		if (winstate->currentpos == 0 ||
+		if (peraggstate->use_segtree)
+		{
+			peraggstate->restart = false;
+			numaggs_segtree++;
+		}
+		else if (winstate->currentpos == 0 ||
 			(winstate->aggregatedbase != winstate->frameheadpos &&
 			 !OidIsValid(peraggstate->invtransfn_oid)) ||
 			(winstate->frameOptions & FRAMEOPTION_EXCLUSION) ||
@@ -1032,7 +1108,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * i.e. advance_windowaggregate_base() can return false, in which case
 	 * we'll restart that aggregate below.
 	 */
-	while (numaggs_restart < numaggs &&
+	while (numaggs_restart + numaggs_segtree < numaggs &&
 		   winstate->aggregatedbase < winstate->frameheadpos)
 	{
 		/*
@@ -1055,7 +1131,7 @@ eval_windowaggregates(WindowAggState *winstate)
 			bool		ok;
 
 			peraggstate = &winstate->peragg[i];
-			if (peraggstate->restart)
+			if (peraggstate->restart || peraggstate->use_segtree)
 				continue;
 
 			wfuncno = peraggstate->wfuncno;
@@ -1183,13 +1259,23 @@ eval_windowaggregates(WindowAggState *winstate)
 		for (i = 0; i < numaggs; i++)
 		{
 			peraggstate = &winstate->peragg[i];
+			wfuncno = peraggstate->wfuncno;
+
+			/* Segment tree aggs add a leaf for each row entering the frame */
+			if (peraggstate->use_segtree)
+			{
+				segtree_add_row(winstate,
+								&winstate->perfunc[wfuncno],
+								peraggstate,
+								winstate->aggregatedupto);
+				continue;
+			}
 
 			/* Non-restarted aggs skip until aggregatedupto_nonrestarted */
 			if (!peraggstate->restart &&
 				winstate->aggregatedupto < aggregatedupto_nonrestarted)
 				continue;
 
-			wfuncno = peraggstate->wfuncno;
 			advance_windowaggregate(winstate,
 									&winstate->perfunc[wfuncno],
 									peraggstate);
@@ -1225,6 +1311,18 @@ next_tuple:
 		wfuncno = peraggstate->wfuncno;
 		result = &econtext->ecxt_aggvalues[wfuncno];
 		isnull = &econtext->ecxt_aggnulls[wfuncno];
+
+		/*
+		 * Segment tree aggs compute the frame's transition value now, without
+		 * exclusion the frame is the rows from frameheadpos to aggregatedupto.
+		 */
+		if (peraggstate->use_segtree)
+			segtree_aggregate(winstate,
+							  &winstate->perfunc[wfuncno],
+							  peraggstate,
+							  winstate->frameheadpos,
+							  winstate->aggregatedupto);
+
 		finalize_windowaggregate(winstate,
 								 &winstate->perfunc[wfuncno],
 								 peraggstate,
@@ -1252,6 +1350,347 @@ next_tuple:
 		}
 		peraggstate->resultValueIsNull = *isnull;
 	}
+
+	/* Release the segment tree aggs' transition values */
+	if (numaggs_segtree > 0)
+		ResetExprContext(winstate->tmpcontext);
+}
+
+/*
+ * segtree_add_row
+ * Add the row at position pos, which is in the frame, to the segment tree
+ *
+ * The caller must have set the row as the outer tuple of tmpcontext.  Rows
+ * that were added before are skipped.
+ */
+static void
+segtree_add_row(WindowAggState *winstate,
+				WindowStatePerFunc perfuncstate,
+				WindowStatePerAgg peraggstate,
+				int64 pos)
+{
+	WindowSegTree *tree = peraggstate->segtree;
+	MemoryContext oldContext;
+	Datum		value;
+
+	if (tree != NULL && pos < tree->base + tree->nleaves)
+		return;
+
+	/*
+	 * If rows were skipped, they are all before the frame head and will
+	 * never be in a frame again, so start over with an empty tree.
+	 */
+	if (tree != NULL && pos > tree->base + tree->nleaves)
+	{
+		MemoryContextDelete(tree->cxt);
+		peraggstate->segtree = tree = NULL;
+	}
+	if (tree == NULL)
+	{
+		MemoryContext cxt;
+
+		cxt = AllocSetContextCreate(winstate->partcontext,
+									"WindowAgg Segment Tree",
+									ALLOCSET_DEFAULT_SIZES);
+		tree = MemoryContextAllocZero(cxt, sizeof(WindowSegTree));
+		tree->cxt = cxt;
+		tree->base = pos;
+		peraggstate->segtree = tree;
+	}
+
+	/* Compute the transition state of the row alone */
+	initialize_windowaggregate(winstate, perfuncstate, peraggstate);
+	advance_windowaggregate(winstate, perfuncstate, peraggstate);
+
+	oldContext = MemoryContextSwitchTo(tree->cxt);
+	if (peraggstate->transValueIsNull)
+		value = (Datum) 0;
+	else
+		value = datumCopy(peraggstate->transValue,
+						  peraggstate->transtypeByVal,
+						  peraggstate->transtypeLen);
+	MemoryContextSwitchTo(oldContext);
+
+	segtree_append(winstate, perfuncstate, peraggstate, tree,
+				   value, peraggstate->transValueIsNull);
+}
+
+/*
+ * segtree_append
+ * Append a leaf to a segment tree, and compute the nodes it completes
+ *
+ * The leaf's value must already be allocated in the tree's context.
+ */
+static void
+segtree_append(WindowAggState *winstate,
+			   WindowStatePerFunc perfuncstate,
+			   WindowStatePerAgg peraggstate,
+			   WindowSegTree *tree,
+			   Datum value, bool isnull)
+{
+	int64		idx = tree->nleaves;
+	int			level;
+
+	if (tree->nleaves == tree->capacity)
+	{
+		int64		capacity = Max(tree->capacity * 2, WINDOW_SEGTREE_MIN_LEAVES);
+
+		for (level = 0; level < tree->nlevels; level++)
+		{
+			tree->values[level] = repalloc(tree->values[level],
+										   (capacity >> level) * sizeof(Datum));
+			tree->isnulls[level] = repalloc(tree->isnulls[level],
+											(capacity >> level) * sizeof(bool));
+		}
+		if (tree->nlevels == 0)
+		{
+			tree->values[0] = MemoryContextAlloc(tree->cxt,
+												 capacity * sizeof(Datum));
+			tree->isnulls[0] = MemoryContextAlloc(tree->cxt,
+												  capacity * sizeof(bool));
+			tree->nlevels = 1;
+		}
+		tree->capacity = capacity;
+	}
+
+	tree->values[0][idx] = value;
+	tree->isnulls[0][idx] = isnull;
+	tree->nleaves++;
+
+	/* Each right child completes its parent */
+	for (level = 0; idx & 1; level++, idx >>= 1)
+	{
+		MemoryContext oldContext;
+		Datum		transValue;
+		bool		transValueIsNull;
+
+		if (level + 1 == tree->nlevels)
+		{
+			Assert(tree->nlevels < WINDOW_SEGTREE_MAX_LEVELS);
+			tree->values[level + 1] =
+				MemoryContextAlloc(tree->cxt,
+								   (tree->capacity >> (level + 1)) * sizeof(Datum));
+			tree->isnulls[level + 1] =
+				MemoryContextAlloc(tree->cxt,
+								   (tree->capacity >> (level + 1)) * sizeof(bool));
+			tree->nlevels++;
+		}
+
+		/* Combine a copy of the left child, the combine function may scribble on it */
+		oldContext = MemoryContextSwitchTo(winstate->tmpcontext->ecxt_per_tuple_memory);
+		transValueIsNull = tree->isnulls[level][idx - 1];
+		transValue = transValueIsNull ? (Datum) 0 :
+			datumCopy(tree->values[level][idx - 1],
+					  peraggstate->transtypeByVal,
+					  peraggstate->transtypeLen);
+		segtree_combine(winstate, perfuncstate, peraggstate,
+						&transValue, &transValueIsNull,
+						tree->values[level][idx], tree->isnulls[level][idx]);
+
+		MemoryContextSwitchTo(tree->cxt);
+		tree->values[level + 1][idx >> 1] = transValueIsNull ? (Datum) 0 :
+			datumCopy(transValue,
+					  peraggstate->transtypeByVal,
+					  peraggstate->transtypeLen);
+		tree->isnulls[level + 1][idx >> 1] = transValueIsNull;
+		MemoryContextSwitchTo(oldContext);
+	}
+}
+
+/*
+ * segtree_combine
+ * Merge a transition state into *transValue with the combine function
+ *
+ * parallel to advance_combine_function in nodeAgg.c.  The result is
+ * allocated in the current memory context, and *transValue may be modified
+ * in place.
+ */
+static void
+segtree_combine(WindowAggState *winstate,
+				WindowStatePerFunc perfuncstate,
+				WindowStatePerAgg peraggstate,
+				Datum *transValue, bool *transValueIsNull,
+				Datum value, bool isnull)
+{
+	LOCAL_FCINFO(fcinfo, 2);
+	Datum		newVal;
+
+	if (peraggstate->combinefn.fn_strict)
+	{
+		/* An empty state changes nothing */
+		if (isnull)
+			return;
+
+		/* The first non-empty state is taken as is */
+		if (*transValueIsNull)
+		{
+			*transValue = datumCopy(value,
+									peraggstate->transtypeByVal,
+									peraggstate->transtypeLen);
+			*transValueIsNull = false;
+			return;
+		}
+	}
+
+	InitFunctionCallInfoData(*fcinfo, &(peraggstate->combinefn),
+							 2,
+							 perfuncstate->winCollation,
+							 (void *) winstate, NULL);
+	fcinfo->args[0].value = *transValue;
+	fcinfo->args[0].isnull = *transValueIsNull;
+	fcinfo->args[1].value = value;
+	fcinfo->args[1].isnull = isnull;
+	winstate->curaggcontext = peraggstate->aggcontext;
+	newVal = FunctionCallInvoke(fcinfo);
+	winstate->curaggcontext = NULL;
+
+	*transValue = newVal;
+	*transValueIsNull = fcinfo->isnull;
+}
+
+/*
+ * segtree_aggregate
+ * Compute the transition value over rows startpos to endpos - 1
+ *
+ * The result is left in peraggstate->transValue, allocated in tmpcontext's
+ * per-tuple memory, for finalize_windowaggregate().
+ */
+static void
+segtree_aggregate(WindowAggState *winstate,
+				  WindowStatePerFunc perfuncstate,
+				  WindowStatePerAgg peraggstate,
+				  int64 startpos, int64 endpos)
+{
+	WindowSegTree *tree = peraggstate->segtree;
+	MemoryContext oldContext;
+	int			right_level[WINDOW_SEGTREE_MAX_LEVELS];
+	int64		right_idx[WINDOW_SEGTREE_MAX_LEVELS];
+	int			nright = 0;
+	bool		empty = true;
+	Datum		transValue = (Datum) 0;
+	bool		transValueIsNull = true;
+	int64		lo,
+				hi;
+	int			level;
+
+	oldContext = MemoryContextSwitchTo(winstate->tmpcontext->ecxt_per_tuple_memory);
+
+	/*
+	 * Once more rows have fallen off the frame head than are left, rebuild
+	 * the tree without them.
+	 */
+	if (tree != NULL &&
+		startpos - tree->base >= WINDOW_SEGTREE_MIN_LEAVES &&
+		startpos - tree->base > tree->base + tree->nleaves - startpos)
+	{
+		WindowSegTree *newtree;
+		MemoryContext cxt;
+		int64		pos;
+
+		cxt = AllocSetContextCreate(winstate->partcontext,
+									"WindowAgg Segment Tree",
+									ALLOCSET_DEFAULT_SIZES);
+		newtree = MemoryContextAllocZero(cxt, sizeof(WindowSegTree));
+		newtree->cxt = cxt;
+		newtree->base = startpos;
+
+		for (pos = startpos; pos < tree->base + tree->nleaves; pos++)
+		{
+			int64		leaf = pos - tree->base;
+			Datum		value = (Datum) 0;
+
+			if (!tree->isnulls[0][leaf])
+			{
+				MemoryContextSwitchTo(cxt);
+				value = datumCopy(tree->values[0][leaf],
+								  peraggstate->transtypeByVal,
+								  peraggstate->transtypeLen);
+				MemoryContextSwitchTo(winstate->tmpcontext->ecxt_per_tuple_memory);
+			}
+			segtree_append(winstate, perfuncstate, peraggstate, newtree,
+						   value, tree->isnulls[0][leaf]);
+		}
+
+		MemoryContextDelete(tree->cxt);
+		peraggstate->segtree = tree = newtree;
+	}
+
+	if (tree != NULL && startpos < endpos)
+	{
+		Assert(startpos >= tree->base);
+		Assert(endpos <= tree->base + tree->nleaves);
+
+		/*
+		 * Walk up from the leaves, taking the nodes that cover the range.
+		 * The combine function need not be commutative, so the nodes on the
+		 * right side are merged last, in reverse order of discovery.
+		 */
+		lo = startpos - tree->base;
+		hi = endpos - tree->base;
+		for (level = 0; lo < hi; level++, lo >>= 1, hi >>= 1)
+		{
+			if (lo & 1)
+			{
+				if (empty)
+				{
+					transValueIsNull = tree->isnulls[level][lo];
+					if (!transValueIsNull)
+						transValue = datumCopy(tree->values[level][lo],
+											   peraggstate->transtypeByVal,
+											   peraggstate->transtypeLen);
+					empty = false;
+				}
+				else
+					segtree_combine(winstate, perfuncstate, peraggstate,
+									&transValue, &transValueIsNull,
+									tree->values[level][lo],
+									tree->isnulls[level][lo]);
+				lo++;
+			}
+			if (hi & 1)
+			{
+				hi--;
+				right_level[nright] = level;
+				right_idx[nright] = hi;
+				nright++;
+			}
+		}
+		while (nright > 0)
+		{
+			nright--;
+			level = right_level[nright];
+			hi = right_idx[nright];
+			if (empty)
+			{
+				transValueIsNull = tree->isnulls[level][hi];
+				if (!transValueIsNull)
+					transValue = datumCopy(tree->values[level][hi],
+										   peraggstate->transtypeByVal,
+										   peraggstate->transtypeLen);
+				empty = false;
+			}
+			else
+				segtree_combine(winstate, perfuncstate, peraggstate,
+								&transValue, &transValueIsNull,
+								tree->values[level][hi],
+								tree->isnulls[level][hi]);
+		}
+	}
+
+	/* An empty frame gets the initial value */
+	if (empty)
+	{
+		transValueIsNull = peraggstate->initValueIsNull;
+		if (!transValueIsNull)
+			transValue = datumCopy(peraggstate->initValue,
+								   peraggstate->transtypeByVal,
+								   peraggstate->transtypeLen);
+	}
+
+	peraggstate->transValue = transValue;
+	peraggstate->transValueIsNull = transValueIsNull;
+
+	MemoryContextSwitchTo(oldContext);
 }
 
 /*
@@ -1578,6 +2017,9 @@ release_partition(WindowAggState *winstate)
 	{
 		if (winstate->peragg[i].aggcontext != winstate->aggcontext)
 			MemoryContextResetAndDeleteChildren(winstate->peragg[i].aggcontext);
+
+		/* the segment trees lived in partcontext */
+		winstate->peragg[i].segtree = NULL;
 	}
 
 	if (winstate->buffer)
@@ -2834,6 +3276,27 @@ ExecInitWindowAgg(WindowAgg *node, EState *estate, int eflags)
 		!contain_var_clause(node->endOffset) &&
 		!contain_volatile_functions(node->endOffset);
 
+	/*
+	 * If the frame head moves, and the frame is contiguous and moves forward
+	 * only, aggregates without an inverse transition function can use a
+	 * segment tree instead of restarting for every row.
+	 */
+	if (gp_enable_window_segment_tree &&
+		!(frameOptions & FRAMEOPTION_START_UNBOUNDED_PRECEDING) &&
+		!(frameOptions & FRAMEOPTION_EXCLUSION) &&
+		winstate->start_offset_var_free &&
+		winstate->end_offset_var_free)
+	{
+		for (aggno = 0; aggno < winstate->numaggs; aggno++)
+		{
+			WindowStatePerAgg peraggstate = &winstate->peragg[aggno];
+
+			initialize_peragg_segtree(winstate,
+									  perfunc[peraggstate->wfuncno].wfunc,
+									  peraggstate);
+		}
+	}
+
 	winstate->all_first = true;
 	winstate->partition_spooled = false;
 	winstate->more_partitions = false;
@@ -3017,6 +3480,7 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 		aggtranstype = aggform->aggtranstype;
 		initvalAttNo = Anum_pg_aggregate_agginitval;
 	}
+	peraggstate->combinefn_oid = aggform->aggcombinefn;
 
 	/*
 	 * ExecInitWindowAgg already checked permission to call aggregate function
@@ -3086,6 +3550,7 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 											   aggtranstype,
 											   inputTypes,
 											   numArguments);
+	peraggstate->transtype = aggtranstype;
 
 	/* build expression trees using actual argument & result types */
 	build_aggregate_transfn_expr(inputTypes,
@@ -3234,6 +3699,70 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	return peraggstate;
 }
 
+/*
+ * initialize_peragg_segtree
+ * Set up evaluation of an aggregate over a segment tree, if possible
+ *
+ * Only aggregates that would otherwise restart whenever the frame head
+ * moves are considered, that is those without an inverse transition
+ * function.  The aggregate needs a combine function, and a transition type
+ * other than internal so that the states can be copied.
+ *
+ * Floating-point transition states are left out, like PostgreSQL does for
+ * moving aggregates: combining them in tree order rounds differently from
+ * accumulating the rows one at a time, and sum(float8), avg(float8) and
+ * friends would return different low-order digits depending on the plan.
+ */
+static void
+initialize_peragg_segtree(WindowAggState *winstate, WindowFunc *wfunc,
+						  WindowStatePerAgg peraggstate)
+{
+	HeapTuple	procTuple;
+	Oid			aggOwner;
+	Expr	   *combinefnexpr;
+
+	if (OidIsValid(peraggstate->invtransfn_oid) ||
+		!OidIsValid(peraggstate->combinefn_oid) ||
+		peraggstate->transtype == INTERNALOID ||
+		peraggstate->transtype == FLOAT4OID ||
+		peraggstate->transtype == FLOAT8OID ||
+		peraggstate->transtype == FLOAT4ARRAYOID ||
+		peraggstate->transtype == FLOAT8ARRAYOID ||
+		peraggstate->isDistinct)
+		return;
+
+	/* Don't fail the query if the owner can't call the combine function */
+	procTuple = SearchSysCache1(PROCOID, ObjectIdGetDatum(wfunc->winfnoid));
+	if (!HeapTupleIsValid(procTuple))
+		elog(ERROR, "cache lookup failed for function %u",
+			 wfunc->winfnoid);
+	aggOwner = ((Form_pg_proc) GETSTRUCT(procTuple))->proowner;
+	ReleaseSysCache(procTuple);
+
+	if (pg_proc_aclcheck(peraggstate->combinefn_oid, aggOwner,
+						 ACL_EXECUTE) != ACLCHECK_OK)
+		return;
+	InvokeFunctionExecuteHook(peraggstate->combinefn_oid);
+
+	build_aggregate_combinefn_expr(peraggstate->transtype,
+								   wfunc->inputcollid,
+								   peraggstate->combinefn_oid,
+								   &combinefnexpr);
+	fmgr_info(peraggstate->combinefn_oid, &peraggstate->combinefn);
+	fmgr_info_set_expr((Node *) combinefnexpr, &peraggstate->combinefn);
+
+	/*
+	 * The row states are computed in a private context, which is reset for
+	 * every row.
+	 */
+	peraggstate->aggcontext =
+		AllocSetContextCreate(CurrentMemoryContext,
+							  "WindowAgg Per Aggregate",
+							  ALLOCSET_DEFAULT_SIZES);
+	peraggstate->use_segtree = true;
+	peraggstate->segtree = NULL;
+}
+
 static Datum
 GetAggInitVal(Datum textInitVal, Oid transtype)
 {
@@ -1159,6 +1159,28 @@ gpdb::GetGPSegmentCount(void)
 	return 0;
 }
 
+bool
+gpdb::MotionCompressTuples(double rows, int width)
+{
+	GP_WRAP_START;
+	{
+		return motion_compress_tuples(rows, width);
+	}
+	GP_WRAP_END;
+	return false;
+}
+
+int
+gpdb::MotionBatchSize(int width)
+{
+	GP_WRAP_START;
+	{
+		return motion_batch_size(width);
+	}
+	GP_WRAP_END;
+	return 0;
+}
+
 bool
 gpdb::HeapAttIsNull(HeapTuple tup, int attno)
 {
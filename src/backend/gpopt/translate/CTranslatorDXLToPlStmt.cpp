@@ -2312,6 +2312,10 @@ CTranslatorDXLToPlStmt::TranslateDXLMotion(
 			return nullptr;
 	}
 
+	motion->compressTuples =
+		gpdb::MotionCompressTuples(plan->plan_rows, plan->plan_width);
+	motion->batchSize = gpdb::MotionBatchSize(plan->plan_width);
+
 	SetParamIds(plan);
 
 	return (Plan *) motion;
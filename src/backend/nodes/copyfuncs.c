@@ -1512,6 +1512,8 @@ _copyMotion(const Motion *from)
 	CopyPlanFields((Plan *) from, (Plan *) newnode);
 
 	COPY_SCALAR_FIELD(sendSorted);
+	COPY_SCALAR_FIELD(compressTuples);
+	COPY_SCALAR_FIELD(batchSize);
 	COPY_SCALAR_FIELD(motionID);
 
 	COPY_SCALAR_FIELD(motionType);
@@ -1527,6 +1529,8 @@ _copyMotion(const Motion *from)
 
 	COPY_SCALAR_FIELD(segidColIdx);
 	COPY_SCALAR_FIELD(numHashSegments);
+	COPY_NODE_FIELD(hotKeyHashes);
+	COPY_SCALAR_FIELD(broadcastHotKeys);
 
 	if (from->senderSliceInfo)
 	{
@@ -5150,6 +5154,7 @@ _copySliceTable(const SliceTable *from)
 
 	COPY_SCALAR_FIELD(instrument_options);
 	COPY_SCALAR_FIELD(ic_instance_id);
+	COPY_SCALAR_FIELD(ic_shm_nonce);
 
 	return newnode;
 }
@@ -1262,6 +1262,8 @@ _outMotion(StringInfo str, const Motion *node)
 	WRITE_ENUM_FIELD(motionType, MotionType);
 
 	WRITE_BOOL_FIELD(sendSorted);
+	WRITE_BOOL_FIELD(compressTuples);
+	WRITE_INT_FIELD(batchSize);
 
 	WRITE_NODE_FIELD(hashExprs);
 	WRITE_OID_ARRAY(hashFuncs, list_length(node->hashExprs));
@@ -1273,6 +1275,8 @@ _outMotion(StringInfo str, const Motion *node)
 	WRITE_INT_FIELD(segidColIdx);
 
 	WRITE_INT_FIELD(numHashSegments);
+	WRITE_NODE_FIELD(hotKeyHashes);
+	WRITE_BOOL_FIELD(broadcastHotKeys);
 
 	/* senderSliceInfo is intentionally omitted. It's only used during planning */
 
@@ -5082,6 +5086,7 @@ _outSliceTable(StringInfo str, const SliceTable *node)
 	WRITE_BOOL_FIELD(hasMotions);
 	WRITE_INT_FIELD(instrument_options);
 	WRITE_INT_FIELD(ic_instance_id);
+	WRITE_UINT64_FIELD(ic_shm_nonce);
 }
 
 static void
@@ -1026,6 +1026,8 @@ _readMotion(void)
 		   local_node->motionType == MOTIONTYPE_EXPLICIT);
 
 	READ_BOOL_FIELD(sendSorted);
+	READ_BOOL_FIELD(compressTuples);
+	READ_INT_FIELD(batchSize);
 
 	READ_NODE_FIELD(hashExprs);
 	READ_OID_ARRAY(hashFuncs, list_length(local_node->hashExprs));
@@ -1038,6 +1040,8 @@ _readMotion(void)
 
 	READ_INT_FIELD(segidColIdx);
 	READ_INT_FIELD(numHashSegments);
+	READ_NODE_FIELD(hotKeyHashes);
+	READ_BOOL_FIELD(broadcastHotKeys);
 
 	ReadCommonPlan(&local_node->plan);
 
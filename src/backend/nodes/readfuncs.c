@@ -4150,6 +4150,7 @@ _readSliceTable(void)
 
 	READ_INT_FIELD(instrument_options);
 	READ_INT_FIELD(ic_instance_id);
+	READ_UINT64_FIELD(ic_shm_nonce);
 
 	READ_DONE();
 }
@@ -56,6 +56,7 @@
 #include "cdb/cdbmutate.h"		/* cdbmutate_warn_ctid_without_segid */
 #include "cdb/cdbpath.h"		/* cdbpath_rows() */
 #include "cdb/cdbutil.h"
+#include "cdb/cdbvars.h"
 
 // TODO: these planner gucs need to be refactored into PlannerConfig.
 bool		gp_enable_sort_limit = false;
@@ -862,6 +863,16 @@ set_rel_consider_parallel(PlannerInfo *root, RelOptInfo *rel,
 			if (get_rel_persistence(rte->relid) == RELPERSISTENCE_TEMP)
 				return;
 
+			/*
+			 * GPDB: Parallel workers are only launched within a slice on the
+			 * segments, so only distributed tables are scanned in parallel.
+			 * Catalog tables are scanned on the QD, and a replicated table
+			 * may be scanned on the QD too, if the plan has no Motion above
+			 * it.
+			 */
+			if (!GpPolicyIsPartitioned(rel->cdbpolicy))
+				return;
+
 			/*
 			 * Table sampling can be pushed down to workers if the sample
 			 * function and its arguments are safe.
@@ -1050,8 +1061,16 @@ static void
 create_plain_partial_paths(PlannerInfo *root, RelOptInfo *rel)
 {
 	int			parallel_workers;
+	double		pages = rel->pages;
 
-	parallel_workers = compute_parallel_worker(rel, rel->pages, -1,
+	/*
+	 * GPDB: rel->pages is the total across all segments, but each segment
+	 * launches its own workers for its own share of the table.
+	 */
+	if (GpPolicyIsPartitioned(rel->cdbpolicy) && rel->cdbpolicy->numsegments > 1)
+		pages /= rel->cdbpolicy->numsegments;
+
+	parallel_workers = compute_parallel_worker(rel, pages, -1,
 											   max_parallel_workers_per_gather);
 
 	/* If any limit was set to zero, the user doesn't want a parallel scan. */
@@ -1221,8 +1240,12 @@ set_append_rel_size(PlannerInfo *root, RelOptInfo *rel,
 	 * If this is a partitioned baserel, set the consider_partitionwise_join
 	 * flag; currently, we only consider partitionwise joins with the baserel
 	 * if its targetlist doesn't contain a whole-row Var.
+	 *
+	 * GPDB: gp_enable_colocated_partitionwise also enables it, but only for
+	 * joins whose inputs are co-located. That is checked when building the
+	 * join rel.
 	 */
-	if (enable_partitionwise_join &&
+	if ((enable_partitionwise_join || gp_enable_colocated_partitionwise) &&
 		rel->reloptkind == RELOPT_BASEREL &&
 		rte->relkind == RELKIND_PARTITIONED_TABLE &&
 		rel->attr_needed[InvalidAttrNumber - rel->min_attr] == NULL)
@@ -347,9 +347,16 @@ create_index_paths(PlannerInfo *root, RelOptInfo *rel)
 										rel->lateral_relids, 1.0, 0);
 		add_path(rel, (Path *) bpath);
 
-		/* create a partial bitmap heap path */
+		/*
+		 * create a partial bitmap heap path
+		 *
+		 * GPDB: Not yet. The executor builds a streaming bitmap, which can't
+		 * be shared between parallel workers.
+		 */
+#if 0
 		if (rel->consider_parallel && rel->lateral_relids == NULL)
 			create_partial_bitmap_paths(root, rel, bitmapqual);
+#endif
 	}
 
 	/*
@@ -18,6 +18,7 @@
 
 #include "miscadmin.h"
 #include "optimizer/appendinfo.h"
+#include "optimizer/cost.h"
 #include "optimizer/joininfo.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
@@ -25,6 +26,8 @@
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 
+#include "cdb/cdbpath.h"
+
 
 static void make_rels_by_clause_joins(PlannerInfo *root,
 									  RelOptInfo *old_rel,
@@ -1413,6 +1416,18 @@ try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2,
 	Assert(joinrel->part_scheme == rel1->part_scheme &&
 		   joinrel->part_scheme == rel2->part_scheme);
 
+	/*
+	 * GPDB: If partitionwise join is only enabled for co-located inputs, and
+	 * this pair of inputs isn't co-located, leave the join relation alone.
+	 * It is only partitioned if the pair it was built from was co-located
+	 * (see build_joinrel_partition_info()), and that pair came through here
+	 * first, so the child joins have already been built from it.
+	 */
+	if (!enable_partitionwise_join &&
+		!cdbpath_join_is_colocated(root, parent_sjinfo->jointype, rel1, rel2,
+								   parent_restrictlist))
+		return;
+
 	/*
 	 * Since we allow partitionwise join only when the partition bounds of the
 	 * joining relations exactly match, the partition bounds of the join
@@ -7290,6 +7290,10 @@ make_motion(PlannerInfo *root, Plan *lefttree,
 	node->collations = collations;
 	node->nullsFirst = nullsFirst;
 
+	node->compressTuples = motion_compress_tuples(plan->plan_rows,
+												  plan->plan_width);
+	node->batchSize = motion_batch_size(plan->plan_width);
+
 #ifdef USE_ASSERT_CHECKING
 	/*
 	 * If the child node was a Sort, then surely the order the caller gave us
@@ -8266,6 +8270,14 @@ cdbpathtoplan_create_motion_plan(PlannerInfo *root,
 	else
 		elog(ERROR, "unexpected target locus type %d for Motion node", path->path.locus.locustype);
 
+	/* Heavy hitters of a skewed join key, see cdbpath_motion_for_join() */
+	if (path->hotKeyHashes)
+	{
+		Assert(motion->motionType == MOTIONTYPE_HASH);
+		motion->hotKeyHashes = list_copy(path->hotKeyHashes);
+		motion->broadcastHotKeys = path->broadcastHotKeys;
+	}
+
 	/* Remember that this subtree contains a Motion */
 	root->numMotions++;
 
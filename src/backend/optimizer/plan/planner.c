@@ -26,6 +26,7 @@
 #include "access/sysattr.h"
 #include "access/table.h"
 #include "access/xact.h"
+#include "catalog/pg_appendonly.h"
 #include "catalog/pg_constraint.h"
 #include "catalog/pg_inherits.h"
 #include "catalog/pg_proc.h"
@@ -62,6 +63,7 @@
 #include "parser/parse_agg.h"
 #include "partitioning/partdesc.h"
 #include "rewrite/rewriteManip.h"
+#include "storage/bufmgr.h"
 #include "storage/dsm_impl.h"
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
@@ -275,6 +277,9 @@ static void create_partitionwise_grouping_paths(PlannerInfo *root,
 static bool group_by_has_partkey(RelOptInfo *input_rel,
 								 List *targetList,
 								 List *groupClause);
+static bool group_by_is_colocated(RelOptInfo *input_rel,
+								  List *targetList,
+								  List *groupClause);
 static int	common_prefix_cmp(const void *a, const void *b);
 
 static Path *create_preliminary_limit_path(PlannerInfo *root, RelOptInfo *rel,
@@ -447,10 +452,16 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 	 * restriction, but for now it seems best not to have parallel workers
 	 * trying to create their own parallel workers.
 	 */
-	/* GPDB_96_MERGE_FIXME: disable parallel workers for now */
-	glob->parallelModeOK = false;
-#if 0
-	if ((cursorOptions & CURSOR_OPT_PARALLEL_OK) != 0 &&
+	/*
+	 * GPDB: Parallel workers run within a slice on the segments, under a
+	 * Gather node. Motions are never placed below a Gather: they are not
+	 * parallel safe. This is only enabled with
+	 * gp_enable_intra_segment_parallel, and only for dispatched queries;
+	 * queries planned in a QE are not parallelized.
+	 */
+	if (gp_enable_intra_segment_parallel &&
+		Gp_role == GP_ROLE_DISPATCH &&
+		(cursorOptions & CURSOR_OPT_PARALLEL_OK) != 0 &&
 		IsUnderPostmaster &&
 		parse->commandType == CMD_SELECT &&
 		!parse->hasModifyingCTE &&
@@ -467,27 +478,18 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 		glob->maxParallelHazard = PROPARALLEL_UNSAFE;
 		glob->parallelModeOK = false;
 	}
-#endif
 
 	/*
-	 * glob->parallelModeNeeded is normally set to false here and changed to
-	 * true during plan creation if a Gather or Gather Merge plan is actually
+	 * glob->parallelModeNeeded is set to false here and changed to true
+	 * during plan creation if a Gather or Gather Merge plan is actually
 	 * created (cf. create_gather_plan, create_gather_merge_plan).
 	 *
-	 * However, if force_parallel_mode = on or force_parallel_mode = regress,
-	 * then we impose parallel mode whenever it's safe to do so, even if the
-	 * final plan doesn't use parallelism.  It's not safe to do so if the
-	 * query contains anything parallel-unsafe; parallelModeOK will be false
-	 * in that case.  Note that parallelModeOK can't change after this point.
-	 * Otherwise, everything in the query is either parallel-safe or
-	 * parallel-restricted, and in either case it should be OK to impose
-	 * parallel-mode restrictions.  If that ends up breaking something, then
-	 * either some function the user included in the query is incorrectly
-	 * labelled as parallel-safe or parallel-restricted when in reality it's
-	 * parallel-unsafe, or else the query planner itself has a bug.
-	 */
-	glob->parallelModeNeeded = glob->parallelModeOK &&
-		(force_parallel_mode != FORCE_PARALLEL_OFF);
+	 * GPDB: Upstream also imposes parallel mode here whenever it's safe to
+	 * do so if force_parallel_mode is set, even if the final plan doesn't
+	 * use parallelism. force_parallel_mode is not supported in GPDB, see
+	 * below.
+	 */
+	glob->parallelModeNeeded = false;
 
 	/* Determine what fraction of the plan is likely to be scanned */
 	if (cursorOptions & CURSOR_OPT_FAST_PLAN)
@@ -563,7 +565,11 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 	/*
 	 * Optionally add a Gather node for testing purposes, provided this is
 	 * actually a safe thing to do.
+	 *
+	 * Disabled in GPDB, because the top of the plan runs on the QD, where
+	 * we don't launch parallel workers.
 	 */
+#if 0
 	if (force_parallel_mode != FORCE_PARALLEL_OFF && top_plan->parallel_safe)
 	{
 		Gather	   *gather = makeNode(Gather);
@@ -608,6 +614,7 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 
 		top_plan = &gather->plan;
 	}
+#endif
 
 	/*
 	 * If any Params were generated, run through the plan tree and compute
@@ -4511,8 +4518,12 @@ create_grouping_paths(PlannerInfo *root,
 		 * It can be disabled by the user, and for now, we don't try to
 		 * support grouping sets.  create_ordinary_grouping_paths() will check
 		 * additional conditions, such as whether input_rel is partitioned.
+		 *
+		 * GPDB: gp_enable_colocated_partitionwise also enables it, but only
+		 * for full partitionwise aggregation that needs no Motions.
 		 */
-		if (enable_partitionwise_aggregate && !parse->groupingSets)
+		if ((enable_partitionwise_aggregate ||
+			 gp_enable_colocated_partitionwise) && !parse->groupingSets)
 			extra.patype = PARTITIONWISE_AGGREGATE_FULL;
 		else
 			extra.patype = PARTITIONWISE_AGGREGATE_NONE;
@@ -4707,9 +4718,13 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 		 */
 		if (extra->patype == PARTITIONWISE_AGGREGATE_FULL &&
 			group_by_has_partkey(input_rel, extra->targetList,
-								 root->parse->groupClause))
+								 root->parse->groupClause) &&
+			(enable_partitionwise_aggregate ||
+			 group_by_is_colocated(input_rel, extra->targetList,
+								   root->parse->groupClause)))
 			patype = PARTITIONWISE_AGGREGATE_FULL;
-		else if ((extra->flags & GROUPING_CAN_PARTIAL_AGG) != 0)
+		else if (enable_partitionwise_aggregate &&
+				 (extra->flags & GROUPING_CAN_PARTIAL_AGG) != 0)
 			patype = PARTITIONWISE_AGGREGATE_PARTIAL;
 		else
 			patype = PARTITIONWISE_AGGREGATE_NONE;
@@ -7227,6 +7242,29 @@ getSimplyUpdatableRel(Query *query)
 	return InvalidOid;
 }
 
+/*
+ * Does the block directory of the given append-optimized table have any
+ * entries yet?
+ */
+static bool
+ao_blkdir_is_built(Relation rel)
+{
+	Oid			blkdirrelid;
+	Relation	blkdir;
+	bool		result;
+
+	GetAppendOnlyEntryAuxOids(RelationGetRelid(rel), NULL, NULL,
+							  &blkdirrelid, NULL, NULL, NULL);
+	if (!OidIsValid(blkdirrelid))
+		return false;
+
+	blkdir = table_open(blkdirrelid, AccessShareLock);
+	result = (RelationGetNumberOfBlocks(blkdir) != 0);
+	table_close(blkdir, AccessShareLock);
+
+	return result;
+}
+
 /*
  * plan_create_index_workers
  *		Use the planner to decide how many parallel worker processes
@@ -7309,8 +7347,12 @@ plan_create_index_workers(Oid tableOid, Oid indexOid)
 	 * Currently, parallel workers can't access the leader's temporary tables.
 	 * Furthermore, any index predicate or index expressions must be parallel
 	 * safe.
+	 *
+	 * In GPDB, the block directory of an append-optimized table is built
+	 * along with its first index, and only the leader can do that.
 	 */
 	if (heap->rd_rel->relpersistence == RELPERSISTENCE_TEMP ||
+		(RelationIsAppendOptimized(heap) && !ao_blkdir_is_built(heap)) ||
 		!is_parallel_safe(root, (Node *) RelationGetIndexExpressions(index)) ||
 		!is_parallel_safe(root, (Node *) RelationGetIndexPredicate(index)))
 	{
@@ -8626,6 +8668,36 @@ group_by_has_partkey(RelOptInfo *input_rel,
 	return true;
 }
 
+/*
+ * group_by_is_colocated
+ *
+ * Returns true, if the input relation is hashed on columns that are all part
+ * of the GROUP BY clauses, so that each partition can be grouped in place
+ * without a Motion.
+ */
+static bool
+group_by_is_colocated(RelOptInfo *input_rel,
+					  List *targetList,
+					  List *groupClause)
+{
+	Path	   *path = input_rel->cheapest_total_path;
+	List	   *group_tles = NIL;
+	ListCell   *lc;
+
+	if (!path || !CdbPathLocus_IsHashed(path->locus))
+		return false;
+
+	foreach(lc, groupClause)
+	{
+		SortGroupClause *sc = (SortGroupClause *) lfirst(lc);
+
+		group_tles = lappend(group_tles,
+							 get_sortgroupclause_tle(sc, targetList));
+	}
+
+	return cdbpathlocus_is_hashed_on_tlist(path->locus, group_tles, true);
+}
+
 static split_rollup_data *
 make_new_rollups_for_hash_grouping_set(PlannerInfo        *root,
 									   Path               *path,
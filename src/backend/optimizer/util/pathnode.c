@@ -838,8 +838,21 @@ add_partial_path(RelOptInfo *parent_rel, Path *new_path)
 	/* Check for query cancel. */
 	CHECK_FOR_INTERRUPTS();
 
-	/* Path to be added must be parallel safe. */
-	Assert(new_path->parallel_safe);
+	if (!new_path)
+		return;
+
+	/*
+	 * GPDB: The join and Append path constructors add Motions to their
+	 * inputs as needed, and a path with a Motion is not parallel safe. Such
+	 * a path can't be part of a parallel plan, so just drop it.
+	 */
+	if (!new_path->parallel_safe)
+		return;
+
+	/* See add_path() */
+	if (!CdbLocusType_IsValid(new_path->locus.locustype))
+		elog(ERROR, "path of type %u is missing distribution locus", new_path->pathtype);
+	Assert(cdbpathlocus_is_valid(new_path->locus));
 
 	/* Relation should be OK for parallelism, too. */
 	Assert(parent_rel->consider_parallel);
@@ -1395,7 +1408,11 @@ create_append_path(PlannerInfo *root,
 		Assert(bms_equal(PATH_REQ_OUTER(subpath), required_outer));
 	}
 
-	Assert(!parallel_aware || pathnode->path.parallel_safe);
+	/*
+	 * GPDB: A parallel-aware Append can become parallel unsafe here, if
+	 * set_append_path_locus() had to add Motions to the subpaths.
+	 * add_partial_path() will reject it.
+	 */
 
 	/*
 	 * If there's exactly one child path, the Append is a no-op and will be
@@ -2633,6 +2650,9 @@ create_gather_merge_path(PlannerInfo *root, RelOptInfo *rel, Path *subpath,
 	cost_gather_merge(pathnode, root, rel, pathnode->path.param_info,
 					  input_startup_cost, input_total_cost, rows);
 
+	/* See create_gather_path() */
+	pathnode->path.locus = subpath->locus;
+
 	return pathnode;
 }
 
@@ -2704,7 +2724,11 @@ create_gather_path(PlannerInfo *root, RelOptInfo *rel, Path *subpath,
 
 	cost_gather(pathnode, root, rel, pathnode->path.param_info, rows);
 
-	/* GPDB_96_MERGE_FIXME: how do data distribution locus and parallelism work together? */
+	/*
+	 * The workers run on the same segments as the leader, and a partial path
+	 * has no Motions, so together the participants produce the rows of the
+	 * subpath's locus.
+	 */
 	pathnode->path.locus = subpath->locus;
 
 	return pathnode;
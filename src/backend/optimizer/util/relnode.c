@@ -33,7 +33,9 @@
 #include "utils/hsearch.h"
 
 #include "access/sysattr.h"
+#include "cdb/cdbpath.h"
 #include "cdb/cdbutil.h"
+#include "cdb/cdbvars.h"
 
 typedef struct JoinHashEntry
 {
@@ -59,7 +61,8 @@ static List *subbuild_joinrel_joinlist(RelOptInfo *joinrel,
 static void set_foreign_rel_properties(RelOptInfo *joinrel,
 									   RelOptInfo *outer_rel, RelOptInfo *inner_rel);
 static void add_join_rel(PlannerInfo *root, RelOptInfo *joinrel);
-static void build_joinrel_partition_info(RelOptInfo *joinrel,
+static void build_joinrel_partition_info(PlannerInfo *root,
+										 RelOptInfo *joinrel,
 										 RelOptInfo *outer_rel, RelOptInfo *inner_rel,
 										 List *restrictlist, JoinType jointype);
 static void build_child_join_reltarget(PlannerInfo *root,
@@ -755,7 +758,8 @@ build_join_rel(PlannerInfo *root,
 	joinrel->has_eclass_joins = has_relevant_eclass_joinclause(root, joinrel);
 
 	/* Store the partition information. */
-	build_joinrel_partition_info(joinrel, outer_rel, inner_rel, restrictlist,
+	build_joinrel_partition_info(root, joinrel, outer_rel, inner_rel,
+								 restrictlist,
 								 sjinfo->jointype);
 
 	/*
@@ -921,7 +925,8 @@ build_child_join_rel(PlannerInfo *root, RelOptInfo *outer_rel,
 	joinrel->has_eclass_joins = parent_joinrel->has_eclass_joins;
 
 	/* Is the join between partitions itself partitioned? */
-	build_joinrel_partition_info(joinrel, outer_rel, inner_rel, restrictlist,
+	build_joinrel_partition_info(root, joinrel, outer_rel, inner_rel,
+								 restrictlist,
 								 jointype);
 
 	/* Child joinrel is parallel safe if parent is parallel safe. */
@@ -1655,16 +1660,16 @@ find_param_path_info(RelOptInfo *rel, Relids required_outer)
  *		the join relation.
  */
 static void
-build_joinrel_partition_info(RelOptInfo *joinrel, RelOptInfo *outer_rel,
-							 RelOptInfo *inner_rel, List *restrictlist,
-							 JoinType jointype)
+build_joinrel_partition_info(PlannerInfo *root, RelOptInfo *joinrel,
+							 RelOptInfo *outer_rel, RelOptInfo *inner_rel,
+							 List *restrictlist, JoinType jointype)
 {
 	int			partnatts;
 	int			cnt;
 	PartitionScheme part_scheme;
 
 	/* Nothing to do if partitionwise join technique is disabled. */
-	if (!enable_partitionwise_join)
+	if (!enable_partitionwise_join && !gp_enable_colocated_partitionwise)
 	{
 		Assert(!IS_PARTITIONED_REL(joinrel));
 		return;
@@ -1692,6 +1697,19 @@ build_joinrel_partition_info(RelOptInfo *joinrel, RelOptInfo *outer_rel,
 		return;
 	}
 
+	/*
+	 * GPDB: With only gp_enable_colocated_partitionwise, join partition by
+	 * partition only if the inputs are co-located. Otherwise each child join
+	 * would need Motions, and a slice of its own.
+	 */
+	if (!enable_partitionwise_join &&
+		!cdbpath_join_is_colocated(root, jointype, outer_rel, inner_rel,
+								   restrictlist))
+	{
+		Assert(!IS_PARTITIONED_REL(joinrel));
+		return;
+	}
+
 	part_scheme = outer_rel->part_scheme;
 
 	Assert(REL_HAS_ALL_PART_PROPS(outer_rel) &&
@@ -399,9 +399,10 @@ plan_tree_walker(Node *node,
 			break;
 
 		case T_Gather:
+		case T_GatherMerge:
 			if (walk_plan_node_fields((Plan *) node, walker, context))
 				return true;
-			/* Other fields are simple items. */
+			/* Other fields are simple items and arrays of simple items. */
 			break;
 
 		case T_Hash:
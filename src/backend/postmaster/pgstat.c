@@ -3274,6 +3274,27 @@ pgstat_progress_update_param(int index, int64 val)
 	PGSTAT_END_WRITE_ACTIVITY(beentry);
 }
 
+/*-----------
+ * pgstat_progress_incr_param() -
+ *
+ * Increment index'th member in st_progress_param[] of own backend entry.
+ *-----------
+ */
+void
+pgstat_progress_incr_param(int index, int64 incr)
+{
+	volatile PgBackendStatus *beentry = MyBEEntry;
+
+	Assert(index >= 0 && index < PGSTAT_NUM_PROGRESS_PARAM);
+
+	if (!beentry || !pgstat_track_activities)
+		return;
+
+	PGSTAT_BEGIN_WRITE_ACTIVITY(beentry);
+	beentry->st_progress_param[index] += incr;
+	PGSTAT_END_WRITE_ACTIVITY(beentry);
+}
+
 /*-----------
  * pgstat_progress_update_multi_param() -
  *
@@ -3984,6 +4005,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_DTX_RECOVERY:
 			event_name = "DtxRecovery";
 			break;
+		case WAIT_EVENT_DISPATCH_RESULT:
+			event_name = "DispatchResult";
+			break;
 			/* no default case, so that compiler will warn */
 	}
 
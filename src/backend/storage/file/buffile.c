@@ -44,6 +44,9 @@
 #ifdef USE_ZSTD
 #include <zstd.h>
 #endif
+#ifdef HAVE_LIBLZ4
+#include <lz4.h>
+#endif
 
 #include "commands/tablespace.h"
 #include "executor/instrument.h"
@@ -121,6 +124,10 @@ struct BufFile
 	off_t		pos;			/* next read/write position in buffer */
 	int64		nbytes;			/* total # of valid bytes in buffer */
 	FakeAlignedBlock buffer;	/* GPDB: PG upstream uses PGAlignedBlock */
+	int			bufsize;		/* GPDB: size of the buffer, BLCKSZ unless
+								 * changed with BufFileSetBufferSize() */
+	bool		readahead;		/* GPDB: prefetch the next bufferload when
+								 * reading a sequential file */
 
 	/*
 	 * Current stage, if this is a sequential BufFile. A sequential BufFile
@@ -138,15 +145,18 @@ struct BufFile
 		BFS_COMPRESSED_READING
 	} state;
 
-	/* ZStandard compression support */
-#ifdef USE_ZSTD
-	zstd_context *zstd_context;	/* ZStandard library handles. */
+	/* GPDB: compression method of a compressed file, WORKFILE_COMPRESSION_* */
+	int			compression;
 
 	/*
 	 * During compression, tracks of the original, uncompressed size.
 	 */
 	size_t		uncompressed_bytes;
 
+	/* ZStandard compression support */
+#ifdef USE_ZSTD
+	zstd_context *zstd_context;	/* ZStandard library handles. */
+
 	/* This holds compressed input, during decompression. */
 	ZSTD_inBuffer compressed_buffer;
 	bool		decompression_finished;
@@ -165,6 +175,9 @@ static void BufFileStartCompression(BufFile *file);
 static void BufFileDumpCompressedBuffer(BufFile *file, const void *buffer, Size nbytes);
 static void BufFileEndCompression(BufFile *file);
 static int BufFileLoadCompressedBuffer(BufFile *file, void *buffer, size_t bufsize);
+#ifdef HAVE_LIBLZ4
+static void BufFileDumpLZ4Block(BufFile *file);
+#endif
 
 /*
  * Create BufFile and perform the common initialization.
@@ -183,6 +196,8 @@ makeBufFileCommon(int nfiles)
 	file->pos = 0;
 	file->nbytes = 0;
 	file->buffer.data = palloc(BLCKSZ);
+	file->bufsize = BLCKSZ;
+	file->readahead = false;
 
 	return file;
 }
@@ -532,6 +547,8 @@ static void
 BufFileLoadBuffer(BufFile *file)
 {
 	File		thisfile;
+	instr_time	start;
+	instr_time	duration;
 
 	/*
 	 * Advance to next component file if necessary and possible.
@@ -547,9 +564,10 @@ BufFileLoadBuffer(BufFile *file)
 	 * Read whatever we can get, up to a full bufferload.
 	 */
 	thisfile = file->files[file->curFile];
+	INSTR_TIME_SET_CURRENT(start);
 	file->nbytes = FileRead(thisfile,
 							file->buffer.data,
-							BLCKSZ,
+							file->bufsize,
 							file->curOffset,
 							WAIT_EVENT_BUFFILE_READ);
 	if (file->nbytes < 0)
@@ -557,7 +575,22 @@ BufFileLoadBuffer(BufFile *file)
 	/* we choose not to advance curOffset here */
 
 	if (file->nbytes > 0)
-		pgBufferUsage.temp_blks_read++;
+	{
+		pgBufferUsage.temp_blks_read += (file->nbytes + BLCKSZ - 1) / BLCKSZ;
+		pgWorkfileUsage.bytes_read += file->nbytes;
+
+		/*
+		 * GPDB: Ask the kernel to start reading the next bufferload of a
+		 * sequential file, so that it's hopefully in the OS cache by the time
+		 * we need it.
+		 */
+		if (file->readahead && file->nbytes == file->bufsize)
+			(void) FilePrefetch(thisfile, file->curOffset + file->nbytes,
+								file->bufsize, WAIT_EVENT_BUFFILE_READ);
+	}
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start);
+	INSTR_TIME_ADD(pgWorkfileUsage.read_time, duration);
 }
 
 /*
@@ -573,6 +606,10 @@ BufFileDumpBuffer(BufFile *file)
 	int			wpos = 0;
 	int			bytestowrite;
 	File		thisfile;
+	instr_time	start;
+	instr_time	duration;
+
+	INSTR_TIME_SET_CURRENT(start);
 
 	/*
 	 * Unlike BufFileLoadBuffer, we must dump the whole buffer even if it
@@ -609,12 +646,20 @@ BufFileDumpBuffer(BufFile *file)
 								 file->curOffset,
 								 WAIT_EVENT_BUFFILE_WRITE);
 		if (bytestowrite <= 0)
-			return;				/* failed to write */
+			break;				/* failed to write */
 		file->curOffset += bytestowrite;
 		wpos += bytestowrite;
 
-		pgBufferUsage.temp_blks_written++;
+		pgBufferUsage.temp_blks_written += (bytestowrite + BLCKSZ - 1) / BLCKSZ;
+		pgWorkfileUsage.bytes_written += bytestowrite;
 	}
+
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start);
+	INSTR_TIME_ADD(pgWorkfileUsage.write_time, duration);
+
+	if (wpos < file->nbytes)
+		return;					/* failed to write */
 	file->dirty = false;
 
 	/*
@@ -773,7 +818,7 @@ BufFileWrite(BufFile *file, void *ptr, size_t size)
 
 	while (size > 0)
 	{
-		if (file->pos >= BLCKSZ)
+		if (file->pos >= file->bufsize)
 		{
 			/* Buffer full, dump it out */
 			if (file->dirty)
@@ -791,7 +836,7 @@ BufFileWrite(BufFile *file, void *ptr, size_t size)
 			}
 		}
 
-		nthistime = BLCKSZ - file->pos;
+		nthistime = file->bufsize - file->pos;
 		if (nthistime > size)
 			nthistime = size;
 		Assert(nthistime > 0);
@@ -1157,7 +1202,7 @@ BufFileResume(BufFile *buffile)
 	}
 
 	Assert(buffile->buffer.data == NULL);
-	buffile->buffer.data = palloc(BLCKSZ);
+	buffile->buffer.data = palloc(buffile->bufsize);
 
 	if (BufFileSeek(buffile, 0, 0, SEEK_SET) != 0)
 		ereport(ERROR,
@@ -1166,16 +1211,17 @@ BufFileResume(BufFile *buffile)
 }
 
 /*
- * ZStandard Compression support
+ * Compression support
  */
 
-bool gp_workfile_compression;		/* GUC */
+int			gp_workfile_compression;		/* GUC */
 
 /*
  * BufFilePledgeSequential
  *
  * Promise that the caller will only do sequential I/O on the given file.
- * This allows the BufFile to be compressed, if 'gp_workfile_compression=on'.
+ * This allows the BufFile to be compressed, with the method chosen by
+ * 'gp_workfile_compression'.
  *
  * A sequential file is used in two stages:
  *
@@ -1201,19 +1247,87 @@ BufFilePledgeSequential(BufFile *buffile)
 	if (BufFileSize(buffile) != 0)
 		elog(ERROR, "cannot pledge sequential access to a temporary file after writing it");
 
-	if (gp_workfile_compression)
+	if (gp_workfile_compression != WORKFILE_COMPRESSION_NONE)
 		BufFileStartCompression(buffile);
+	else
+		buffile->readahead = true;
+}
+
+/*
+ * BufFileSetBufferSize
+ *
+ * GPDB: Use a buffer of 'bufsize' bytes, instead of BLCKSZ. The size is
+ * rounded down to a multiple of BLCKSZ. If the file is being written, what's
+ * in the old buffer is written out first; the buffer of a file that's being
+ * read back is left alone.
+ *
+ * A bigger buffer means fewer, larger reads and writes, which is worth it
+ * for big files that are written and read sequentially, like the batch files
+ * of a hash join. For a file that is accessed in random BLCKSZ-sized blocks,
+ * like the tapes of a sort, a bigger buffer would just read more than needed.
+ */
+void
+BufFileSetBufferSize(BufFile *buffile, Size bufsize)
+{
+	switch (buffile->state)
+	{
+		case BFS_RANDOM_ACCESS:
+		case BFS_SEQUENTIAL_WRITING:
+			break;
+
+		case BFS_COMPRESSED_WRITING:
+			/* A zstd-compressed file bypasses the buffer, so don't bother */
+			if (buffile->compression != WORKFILE_COMPRESSION_LZ4)
+				return;
+			break;
+
+		case BFS_SEQUENTIAL_READING:
+		case BFS_COMPRESSED_READING:
+			return;
+	}
+
+	bufsize = Max(bufsize - bufsize % BLCKSZ, BLCKSZ);
+	if (bufsize > MAX_PHYSICAL_FILESIZE)
+		bufsize = MAX_PHYSICAL_FILESIZE;
+	if (bufsize == buffile->bufsize)
+		return;
+
+	if (buffile->state == BFS_COMPRESSED_WRITING)
+	{
+#ifdef HAVE_LIBLZ4
+		BufFileDumpLZ4Block(buffile);
+#endif
+	}
+	else if (buffile->dirty)
+	{
+		BufFileDumpBuffer(buffile);
+		if (buffile->dirty)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write to temporary file: %m")));
+	}
+	else
+	{
+		/* Forget whatever was read into the buffer */
+		buffile->curOffset += buffile->pos;
+		buffile->pos = 0;
+		buffile->nbytes = 0;
+	}
+
+	if (buffile->buffer.data)
+		buffile->buffer.data = repalloc(buffile->buffer.data, bufsize);
+	buffile->bufsize = bufsize;
 }
 
 /*
- * The rest of the code is only needed when compression support is compiled in.
+ * ZStandard compression support
  */
 #ifdef USE_ZSTD
 
 #define BUFFILE_ZSTD_COMPRESSION_LEVEL 1
 
 /*
- * Temporary buffer used during compression. It's used only within the
+ * Temporary buffer used during zstd compression. It's used only within the
  * functions, so we can allocate this once and reuse it for all files.
  */
 static char *compression_buffer;
@@ -1222,7 +1336,7 @@ static char *compression_buffer;
  * Initialize the compressor.
  */
 static void
-BufFileStartCompression(BufFile *file)
+BufFileStartZstdCompression(BufFile *file)
 {
 	ResourceOwner oldowner;
 	size_t ret;
@@ -1260,12 +1374,10 @@ BufFileStartCompression(BufFile *file)
 		elog(ERROR, "failed to initialize zstd stream: %s", ZSTD_getErrorName(ret));
 
 	CurrentResourceOwner = oldowner;
-
-	file->state = BFS_COMPRESSED_WRITING;
 }
 
 static void
-BufFileDumpCompressedBuffer(BufFile *file, const void *buffer, Size nbytes)
+BufFileDumpZstdCompressedBuffer(BufFile *file, const void *buffer, Size nbytes)
 {
 	ZSTD_inBuffer input;
 	off_t pos = 0;
@@ -1299,6 +1411,7 @@ BufFileDumpCompressedBuffer(BufFile *file, const void *buffer, Size nbytes)
 			if (wrote != output.pos)
 				elog(ERROR, "could not write %d bytes to compressed temporary file: %m", (int) output.pos);
 			pos += wrote;
+			pgWorkfileUsage.bytes_written += wrote;
 		}
 	}
 	file->curOffset += pos;
@@ -1308,7 +1421,7 @@ BufFileDumpCompressedBuffer(BufFile *file, const void *buffer, Size nbytes)
  * End compression stage. Rewind and prepare the BufFile for decompression.
  */
 static void
-BufFileEndCompression(BufFile *file)
+BufFileEndZstdCompression(BufFile *file)
 {
 	ZSTD_outBuffer output;
 	size_t		ret;
@@ -1330,6 +1443,7 @@ BufFileEndCompression(BufFile *file)
 		if (wrote != output.pos)
 			elog(ERROR, "could not write %d bytes to compressed temporary file: %m", (int) output.pos);
 		pos += wrote;
+		pgWorkfileUsage.bytes_written += wrote;
 	} while (ret > 0);
 
 	ZSTD_freeCCtx(file->zstd_context->cctx);
@@ -1358,7 +1472,7 @@ BufFileEndCompression(BufFile *file)
 }
 
 static int
-BufFileLoadCompressedBuffer(BufFile *file, void *buffer, size_t bufsize)
+BufFileLoadZstdCompressedBuffer(BufFile *file, void *buffer, size_t bufsize)
 {
 	ZSTD_outBuffer output;
 	size_t		ret;
@@ -1386,6 +1500,7 @@ BufFileLoadCompressedBuffer(BufFile *file, void *buffer, size_t bufsize)
 				elog(ERROR, "could not read from temporary file: %m");
 			}
 			pos += nb;
+			pgWorkfileUsage.bytes_read += nb;
 			file->compressed_buffer.size = nb;
 			file->compressed_buffer.pos = 0;
 
@@ -1421,34 +1536,284 @@ BufFileLoadCompressedBuffer(BufFile *file, void *buffer, size_t bufsize)
 
 	return output.pos;
 }
-#else		/* HAVE_ZSTD */
+#endif		/* USE_ZSTD */
 
 /*
- * Dummy versions of the compression functions, when the server is built
- * without libzstd. gp_workfile_compression cannot be enabled without
- * libzstd - there's a GUC assign hook to check that - so these should
- * never be called. They exists just to avoid having so many #ifdefs in
- * the code.
+ * LZ4 compression support
+ */
+#ifdef HAVE_LIBLZ4
+
+/*
+ * An LZ4-compressed file is a series of independently compressed blocks of
+ * up to one bufferload each. The uncompressed data is collected in the
+ * BufFile's own buffer, and compressed whenever the buffer fills up. Unlike
+ * with zstd, a bigger buffer means better compression.
+ */
+typedef struct BufFileLZ4BlockHeader
+{
+	int32		rawlen;			/* uncompressed length of the block */
+	int32		complen;		/* compressed length, not including header */
+} BufFileLZ4BlockHeader;
+
+/*
+ * Temporary buffer that holds one compressed block, with its header. It's
+ * used only within the functions, so it's shared by all files, and enlarged
+ * when a bigger block comes along.
+ */
+static char *lz4_buffer;
+static int	lz4_buffer_size;
+
+static char *
+BufFileGetLZ4Buffer(int size)
+{
+	if (size > lz4_buffer_size)
+	{
+		if (lz4_buffer)
+			pfree(lz4_buffer);
+		lz4_buffer = MemoryContextAlloc(TopMemoryContext, size);
+		lz4_buffer_size = size;
+	}
+	return lz4_buffer;
+}
+
+static void
+BufFileStartLZ4Compression(BufFile *file)
+{
+	/* Nothing to do, the blocks are collected in the BufFile's buffer */
+}
+
+/*
+ * Compress what's in the buffer, and write it out as one block.
+ */
+static void
+BufFileDumpLZ4Block(BufFile *file)
+{
+	BufFileLZ4BlockHeader hdr;
+	char	   *block;
+	int			bound;
+	int			wrote;
+
+	if (file->pos == 0)
+		return;
+
+	bound = LZ4_compressBound(file->pos);
+	block = BufFileGetLZ4Buffer(sizeof(hdr) + bound);
+
+	hdr.rawlen = file->pos;
+	hdr.complen = LZ4_compress_default(file->buffer.data, block + sizeof(hdr),
+									   file->pos, bound);
+	if (hdr.complen <= 0)
+		elog(ERROR, "lz4 compression failed");
+	memcpy(block, &hdr, sizeof(hdr));
+
+	wrote = FileWrite(file->files[0], block, sizeof(hdr) + hdr.complen, file->curOffset, WAIT_EVENT_BUFFILE_WRITE);
+	if (wrote != sizeof(hdr) + hdr.complen)
+		elog(ERROR, "could not write %d bytes to compressed temporary file: %m", (int) (sizeof(hdr) + hdr.complen));
+	file->curOffset += wrote;
+	pgWorkfileUsage.bytes_written += wrote;
+
+	file->pos = 0;
+}
+
+static void
+BufFileDumpLZ4CompressedBuffer(BufFile *file, const void *buffer, Size nbytes)
+{
+	const char *ptr = buffer;
+
+	file->uncompressed_bytes += nbytes;
+
+	while (nbytes > 0)
+	{
+		Size		nthistime;
+
+		if (file->pos >= file->bufsize)
+			BufFileDumpLZ4Block(file);
+
+		nthistime = Min(file->bufsize - file->pos, nbytes);
+		memcpy(file->buffer.data + file->pos, ptr, nthistime);
+		file->pos += nthistime;
+		ptr += nthistime;
+		nbytes -= nthistime;
+	}
+}
+
+/*
+ * End compression stage. Write out the last block, and rewind for reading.
+ */
+static void
+BufFileEndLZ4Compression(BufFile *file)
+{
+	Assert(file->state == BFS_COMPRESSED_WRITING);
+
+	BufFileDumpLZ4Block(file);
+
+	elog(DEBUG1, "BufFile compressed from %ld to %ld bytes",
+		 file->uncompressed_bytes, BufFileSize(file));
+
+	file->curOffset = 0;
+	file->pos = 0;
+	file->nbytes = 0;
+	file->state = BFS_COMPRESSED_READING;
+}
+
+/*
+ * Read the next block, and decompress it into the buffer. Returns false at
+ * the end of the file.
+ */
+static bool
+BufFileLoadLZ4Block(BufFile *file)
+{
+	BufFileLZ4BlockHeader hdr;
+	char	   *block;
+	int			nb;
+
+	nb = FileRead(file->files[0], (char *) &hdr, sizeof(hdr), file->curOffset, WAIT_EVENT_BUFFILE_READ);
+	if (nb < 0)
+		elog(ERROR, "could not read from temporary file: %m");
+	if (nb == 0)
+		return false;
+	if (nb != sizeof(hdr) || hdr.rawlen <= 0 || hdr.complen <= 0)
+		elog(ERROR, "unexpected end of compressed temporary file");
+	file->curOffset += nb;
+	pgWorkfileUsage.bytes_read += nb;
+
+	/* The block is bigger than the buffer, if the buffer shrank since */
+	if (hdr.rawlen > file->bufsize)
+	{
+		file->buffer.data = repalloc(file->buffer.data, hdr.rawlen);
+		file->bufsize = hdr.rawlen;
+	}
+
+	block = BufFileGetLZ4Buffer(hdr.complen);
+	nb = FileRead(file->files[0], block, hdr.complen, file->curOffset, WAIT_EVENT_BUFFILE_READ);
+	if (nb < 0)
+		elog(ERROR, "could not read from temporary file: %m");
+	if (nb != hdr.complen)
+		elog(ERROR, "unexpected end of compressed temporary file");
+	file->curOffset += nb;
+	pgWorkfileUsage.bytes_read += nb;
+
+	nb = LZ4_decompress_safe(block, file->buffer.data, hdr.complen, hdr.rawlen);
+	if (nb != hdr.rawlen)
+		elog(ERROR, "lz4 decompression failed");
+
+	file->pos = 0;
+	file->nbytes = nb;
+	return true;
+}
+
+static int
+BufFileLoadLZ4CompressedBuffer(BufFile *file, void *buffer, size_t bufsize)
+{
+	char	   *ptr = buffer;
+	size_t		nread = 0;
+
+	while (nread < bufsize)
+	{
+		size_t		nthistime;
+
+		/* Buffer used up? Decompress the next block. */
+		if (file->pos >= file->nbytes && !BufFileLoadLZ4Block(file))
+			break;
+
+		nthistime = Min(file->nbytes - file->pos, bufsize - nread);
+		memcpy(ptr + nread, file->buffer.data + file->pos, nthistime);
+		file->pos += nthistime;
+		nread += nthistime;
+	}
+
+	return nread;
+}
+#endif		/* HAVE_LIBLZ4 */
+
+/*
+ * Dispatch to the compression method of the file. gp_workfile_compression
+ * cannot be set to a method that's not compiled in - there's a GUC check
+ * hook for that - so the default cases should never be reached.
  */
 static void
 BufFileStartCompression(BufFile *file)
 {
-	elog(ERROR, "zstandard compression not supported by this build");
+	file->compression = gp_workfile_compression;
+
+	switch (file->compression)
+	{
+#ifdef USE_ZSTD
+		case WORKFILE_COMPRESSION_ZSTD:
+			BufFileStartZstdCompression(file);
+			break;
+#endif
+#ifdef HAVE_LIBLZ4
+		case WORKFILE_COMPRESSION_LZ4:
+			BufFileStartLZ4Compression(file);
+			break;
+#endif
+		default:
+			elog(ERROR, "workfile compression method %d not supported by this build",
+				 file->compression);
+	}
+
+	file->state = BFS_COMPRESSED_WRITING;
 }
+
 static void
 BufFileDumpCompressedBuffer(BufFile *file, const void *buffer, Size nbytes)
 {
-	elog(ERROR, "zstandard compression not supported by this build");
+	switch (file->compression)
+	{
+#ifdef USE_ZSTD
+		case WORKFILE_COMPRESSION_ZSTD:
+			BufFileDumpZstdCompressedBuffer(file, buffer, nbytes);
+			break;
+#endif
+#ifdef HAVE_LIBLZ4
+		case WORKFILE_COMPRESSION_LZ4:
+			BufFileDumpLZ4CompressedBuffer(file, buffer, nbytes);
+			break;
+#endif
+		default:
+			elog(ERROR, "workfile compression method %d not supported by this build",
+				 file->compression);
+	}
 }
+
 static void
 BufFileEndCompression(BufFile *file)
 {
-	elog(ERROR, "zstandard compression not supported by this build");
+	switch (file->compression)
+	{
+#ifdef USE_ZSTD
+		case WORKFILE_COMPRESSION_ZSTD:
+			BufFileEndZstdCompression(file);
+			break;
+#endif
+#ifdef HAVE_LIBLZ4
+		case WORKFILE_COMPRESSION_LZ4:
+			BufFileEndLZ4Compression(file);
+			break;
+#endif
+		default:
+			elog(ERROR, "workfile compression method %d not supported by this build",
+				 file->compression);
+	}
 }
+
 static int
 BufFileLoadCompressedBuffer(BufFile *file, void *buffer, size_t bufsize)
 {
-	elog(ERROR, "zstandard compression not supported by this build");
+	switch (file->compression)
+	{
+#ifdef USE_ZSTD
+		case WORKFILE_COMPRESSION_ZSTD:
+			return BufFileLoadZstdCompressedBuffer(file, buffer, bufsize);
+#endif
+#ifdef HAVE_LIBLZ4
+		case WORKFILE_COMPRESSION_LZ4:
+			return BufFileLoadLZ4CompressedBuffer(file, buffer, bufsize);
+#endif
+		default:
+			elog(ERROR, "workfile compression method %d not supported by this build",
+				 file->compression);
+	}
+	return 0;					/* keep compiler quiet */
 }
-
-#endif		/* HAVE_ZSTD */
@@ -1521,12 +1521,10 @@ LockCheckConflicts(LockMethod lockMethodTable,
 	}
 
 	/*
-	 * GPDB_96_MERGE_FIXME:
-	 * We do not support parallel execution yet, so it is fine to just
-	 * handle mpp session and single process separately.
-	 * 
-	 * After parallel execution feature is in, mpp session part should
-	 * change.
+	 * In an MPP session, the locks held by the other processes of the session
+	 * don't conflict with ours. Outside of one, fall back to the upstream
+	 * check, which knows about lock groups. The MPP session check treats the
+	 * members of our lock group like the processes of our session.
 	 */
 	 mppSessionId = proclock->tag.myProc->mppSessionId;
 	 if (mppSessionId == InvalidGpSessionId)
@@ -1631,10 +1629,13 @@ LockCheckConflicts(LockMethod lockMethodTable,
 				PGPROC	   *otherProc = otherProclock->tag.myProc;
 
 				/*
-				 * If processes in my session are holding the lock, mask
-				 * it out so that we won't be blocked by them.
+				 * If processes in my session, or in my lock group, are
+				 * holding the lock, mask it out so that we won't be blocked
+				 * by them. The parallel workers of a backend are in its lock
+				 * group, but not necessarily in its MPP session.
 				 */
-				if (otherProc->mppSessionId == mppSessionId &&
+				if ((otherProc->mppSessionId == mppSessionId ||
+					 otherProclock->groupLeader == proclock->groupLeader) &&
 					otherProclock->holdMask & LOCKBIT_ON(i))
 					ourHolding++;
 
@@ -93,8 +93,10 @@
 #include "cdb/cdbtm.h"
 #include "cdb/cdbdtxcontextinfo.h"
 #include "cdb/cdbdisp_query.h"
+#include "cdb/cdbdisp_plancache.h"
 #include "cdb/cdbdispatchresult.h"
 #include "cdb/cdbgang.h"
+#include "cdb/cdbgang_async.h"
 #include "cdb/ml_ipc.h"
 #include "utils/guc.h"
 #include "access/twophase.h"
@@ -242,6 +244,7 @@ static int	errdetail_execute(List *raw_parsetree_list);
 static int	errdetail_params(ParamListInfo params);
 static int	errdetail_abort(void);
 static int	errdetail_recovery_conflict(void);
+static void prewarm_idle_gangs(void);
 static void start_xact_command(void);
 static void finish_xact_command(void);
 static bool IsTransactionExitStmt(Node *parsetree);
@@ -1110,6 +1113,7 @@ pg_plan_queries(List *querytrees, int cursorOptions, ParamListInfo boundParams)
  *
  * query_string -- optional query text (C string).
  * serializedPlantree[len] -- PlannedStmt node, or (NULL,0) if query provided.
+ * planKey -- if its fingerprint is not 0, get the PlannedStmt from the plan cache.
  * serializedQueryDispatchDesc[len] -- QueryDispatchDesc node, or (NULL,0) if query provided.
  *
  * Caller may supply either a Query (representing utility command) or
@@ -1118,6 +1122,7 @@ pg_plan_queries(List *querytrees, int cursorOptions, ParamListInfo boundParams)
 static void
 exec_mpp_query(const char *query_string,
 			   const char * serializedPlantree, int serializedPlantreelen,
+			   const DispatchPlanKey *planKey,
 			   const char * serializedQueryDispatchDesc, int serializedQueryDispatchDesclen)
 {
 	CommandDest dest = whereToSendOutput;
@@ -1178,8 +1183,12 @@ exec_mpp_query(const char *query_string,
 
  	/*
      * Deserialize the query execution plan (a PlannedStmt node), if there is one.
+     * A plan with a key has been put in the plan cache already, see
+     * cdbdisp_plancache.c.
      */
-	if (serializedPlantree != NULL && serializedPlantreelen > 0)
+	if (planKey->fingerprint != 0)
+		plan = qePlanCacheFetch(planKey);
+	else if (serializedPlantree != NULL && serializedPlantreelen > 0)
 	{
 		plan = (PlannedStmt *) deserializeNode(serializedPlantree,serializedPlantreelen);
 		if (!plan || !IsA(plan, PlannedStmt))
@@ -3296,6 +3305,46 @@ exec_describe_portal_message(const char *portal_name)
 }
 
 
+/*
+ * Start connecting QEs from an idle session, in a transaction of its own.
+ *
+ * The pre-warmed QEs are only an optimization, so a failure is logged rather
+ * than reported to the client.  We abort the transaction, drop any
+ * half-started connections, and don't try again: the QEs are connected the
+ * usual way when the next query needs them.
+ */
+static void
+prewarm_idle_gangs(void)
+{
+	MemoryContext oldcontext = CurrentMemoryContext;
+
+	PG_TRY();
+	{
+		StartTransactionCommand();
+		cdbgang_prewarm();
+		CommitTransactionCommand();
+	}
+	PG_CATCH();
+	{
+		ErrorData  *edata;
+
+		MemoryContextSwitchTo(oldcontext);
+		edata = CopyErrorData();
+		FlushErrorState();
+
+		AbortCurrentTransaction();
+		DisconnectAndDestroyAllGangs(false);
+		NeedGangPrewarm = false;
+
+		ereport(LOG,
+				(errmsg("could not pre-warm QE connections: %s", edata->message)));
+		FreeErrorData(edata);
+	}
+	PG_END_TRY();
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
 /*
  * Convenience routines for starting/committing a single command.
  */
@@ -3307,6 +3356,13 @@ start_xact_command(void)
 		StartTransactionCommand();
 
 		xact_started = true;
+
+		/*
+		 * Start connecting QEs now if they were released while the session
+		 * was idle, so that it overlaps with parsing and planning.
+		 */
+		if (NeedGangPrewarm && Gp_role == GP_ROLE_DISPATCH)
+			cdbgang_prewarm();
 	}
 
 	/*
@@ -5135,6 +5191,17 @@ PostgresMain(int argc, char *argv[],
 				pgstat_report_activity(STATE_IDLE, NULL);
 			}
 
+			/*
+			 * At session start, connect QEs while the client is still
+			 * composing its first query.  Do it before ReadyForQuery, so
+			 * that a failure can't be reported while the client isn't
+			 * waiting for a response.
+			 */
+			if (Gp_role == GP_ROLE_DISPATCH && NeedGangPrewarm &&
+				gp_gang_prewarm_size > 0 &&
+				!IsTransactionOrTransactionBlock())
+				prewarm_idle_gangs();
+
 			ReadyForQuery(whereToSendOutput);
 			send_ready_for_query = false;
 		}
@@ -5273,6 +5340,7 @@ PostgresMain(int argc, char *argv[],
 					int query_string_len = 0;
 					int serializedDtxContextInfolen = 0;
 					int serializedPlantreelen = 0;
+					DispatchPlanKey planKey;
 					int serializedQueryDispatchDesclen = 0;
 					int resgroupInfoLen = 0;
 					TimestampTz statementStart;
@@ -5308,6 +5376,9 @@ PostgresMain(int argc, char *argv[],
 					statementStart = pq_getmsgint64(&input_message);
 					query_string_len = pq_getmsgint(&input_message, 4);
 					serializedPlantreelen = pq_getmsgint(&input_message, 4);
+					planKey.fingerprint = pq_getmsgint64(&input_message);
+					planKey.check = pq_getmsgint(&input_message, 4);
+					planKey.length = pq_getmsgint(&input_message, 4);
 					serializedQueryDispatchDesclen = pq_getmsgint(&input_message, 4);
 					serializedDtxContextInfolen = pq_getmsgint(&input_message, 4);
 
@@ -5360,6 +5431,14 @@ PostgresMain(int argc, char *argv[],
 
 					pq_getmsgend(&input_message);
 
+					/*
+					 * Update the plan cache right away.  The QD assumes that
+					 * we did, even if we fail before running the plan.
+					 */
+					if (planKey.fingerprint != 0)
+						qePlanCacheReceive(&planKey,
+										   serializedPlantree, serializedPlantreelen);
+
 					elog((Debug_print_full_dtm ? LOG : DEBUG5), "MPP dispatched stmt from QD: %s.",query_string);
 
 					if (IsResGroupActivated() && resgroupInfoLen > 0)
@@ -5382,7 +5461,7 @@ PostgresMain(int argc, char *argv[],
 					if (cuid > 0)
 						SetUserIdAndContext(cuid, false); /* Set current userid */
 
-					if (serializedPlantreelen==0)
+					if (serializedPlantreelen==0 && planKey.fingerprint == 0)
 					{
 						if (strncmp(query_string, "BEGIN", 5) == 0)
 						{
@@ -5412,6 +5491,7 @@ PostgresMain(int argc, char *argv[],
 					else
 						exec_mpp_query(query_string,
 									   serializedPlantree, serializedPlantreelen,
+									   &planKey,
 									   serializedQueryDispatchDesc, serializedQueryDispatchDesclen);
 
 					SetUserIdAndContext(GetOuterUserId(), false);
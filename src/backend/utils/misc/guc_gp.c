@@ -41,6 +41,7 @@
 #include "postmaster/syslogger.h"
 #include "postmaster/fts.h"
 #include "replication/walsender.h"
+#include "storage/buffile.h"
 #include "storage/proc.h"
 #include "tcop/idle_resource_cleaner.h"
 #include "utils/builtins.h"
@@ -79,7 +80,7 @@ static bool check_optimizer(bool *newval, void **extra, GucSource source);
 static bool check_verify_gpfdists_cert(bool *newval, void **extra, GucSource source);
 static bool check_dispatch_log_stats(bool *newval, void **extra, GucSource source);
 static bool check_gp_hashagg_default_nbatches(int *newval, void **extra, GucSource source);
-static bool check_gp_workfile_compression(bool *newval, void **extra, GucSource source);
+static bool check_gp_workfile_compression(int *newval, void **extra, GucSource source);
 
 /* Helper function for guc setter */
 bool gpvars_check_gp_resqueue_priority_default_value(char **newval,
@@ -491,6 +492,24 @@ static const struct config_enum_entry gp_autostats_modes[] = {
 	{NULL, 0}
 };
 
+/*
+ * Accept all the likely variants of "on" and "off", as
+ * gp_workfile_compression used to be a boolean.
+ */
+static const struct config_enum_entry gp_workfile_compression_options[] = {
+	{"off", WORKFILE_COMPRESSION_NONE, false},
+	{"zstd", WORKFILE_COMPRESSION_ZSTD, false},
+	{"lz4", WORKFILE_COMPRESSION_LZ4, false},
+	{"on", WORKFILE_COMPRESSION_DEFAULT, false},
+	{"true", WORKFILE_COMPRESSION_DEFAULT, true},
+	{"yes", WORKFILE_COMPRESSION_DEFAULT, true},
+	{"1", WORKFILE_COMPRESSION_DEFAULT, true},
+	{"false", WORKFILE_COMPRESSION_NONE, true},
+	{"no", WORKFILE_COMPRESSION_NONE, true},
+	{"0", WORKFILE_COMPRESSION_NONE, true},
+	{NULL, 0, false}
+};
+
 static const struct config_enum_entry gp_interconnect_fc_methods[] = {
 	{"loss", INTERCONNECT_FC_METHOD_LOSS},
 	{"capacity", INTERCONNECT_FC_METHOD_CAPACITY},
@@ -610,6 +629,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		false,
 		NULL, NULL, NULL
 	},
+	{
+		{"gp_dispatch_cache_plans", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Cache dispatched plans on the segments."),
+			gettext_noop("When a plan is dispatched again to segments that "
+						 "have it cached, only its fingerprint is sent.")
+		},
+		&gp_dispatch_cache_plans,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"gp_enable_direct_dispatch", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enable dispatch for single-row-insert targetted mirror-pairs."),
@@ -678,6 +707,70 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_enable_vectorized_agg", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables batch-at-a-time execution of plain aggregates over sequential scans."),
+			gettext_noop("Only simple quals and aggregates on int4, int8, float8 and date columns are executed in batches.")
+		},
+		&gp_enable_vectorized_agg,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_enable_radix_sort", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables radix sort of in-memory sorts and sort runs."),
+			gettext_noop("Used when the leading sort key is an integer, date, timestamp or abbreviated key."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_enable_radix_sort,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_enable_window_segment_tree", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables segment trees for window aggregates over frames with a moving start."),
+			gettext_noop("Used for aggregates that have a combine function but no inverse transition function, and no floating-point transition state."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_enable_window_segment_tree,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_enable_colocated_partitionwise", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables partitionwise join and aggregation of co-located partitioned tables."),
+			gettext_noop("Only used where the partitions can be joined or grouped without Motions.")
+		},
+		&gp_enable_colocated_partitionwise,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_enable_intra_segment_parallel", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables parallel query within each segment."),
+			gettext_noop("Parallel scans, joins and partial aggregates run in parallel "
+						 "workers under a Gather node, in the same slice. The number "
+						 "of workers is limited by max_parallel_workers_per_gather.")
+		},
+		&gp_enable_intra_segment_parallel,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_hashagg_streambottom", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Allows the first stage of a multi-stage hash aggregation to emit its groups instead of spilling them."),
+			gettext_noop("Rows that don't group well are passed through, see gp_hashagg_passthrough_ratio.")
+		},
+		&gp_hashagg_streambottom,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_enable_preunique", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enable 2-phase duplicate removal."),
@@ -937,16 +1030,6 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, assign_gp_write_shared_snapshot, NULL
 	},
 
-	{
-		{"gp_workfile_compression", PGC_USERSET, RESOURCES_DISK,
-			gettext_noop("Enables compression of temporary files."),
-			NULL
-		},
-		&gp_workfile_compression,
-		false,
-		check_gp_workfile_compression, NULL, NULL
-	},
-
 	{
 		{"gp_reraise_signal", PGC_SUSET, DEVELOPER_OPTIONS,
 			gettext_noop("Do we attempt to dump core when a serious problem occurs."),
@@ -1010,6 +1093,29 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_interconnect_collect_stats", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Collect cumulative interconnect statistics."),
+			gettext_noop("Every interconnect teardown adds its counters and timings "
+						 "to totals in shared memory, for benchmarking the interconnect."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_interconnect_collect_stats,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_interconnect_local_shm", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Use shared memory for UDP interconnect connections within a host."),
+			gettext_noop("Packets between a sender and a receiver on the same host "
+						 "go through a shared-memory ring instead of the network stack.")
+		},
+		&gp_interconnect_local_shm,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"resource_scheduler", PGC_POSTMASTER, RESOURCES_MGM,
 			gettext_noop("Enable resource scheduling."),
@@ -3026,6 +3132,30 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_workfile_buffer_size", PGC_USERSET, RESOURCES_DISK,
+			gettext_noop("Sets the maximum size of the I/O buffer of a sequentially accessed workfile."),
+			gettext_noop("Larger buffers mean fewer, larger reads and writes when spilling "
+						 "hash join batches. Each batch file gets a share of work_mem, up to this size."),
+			GUC_UNIT_KB
+		},
+		&gp_workfile_buffer_size,
+		128, BLCKSZ / 1024, 1024 * 1024,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_shareinput_inmem_size", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the maximum size of a cross-slice shared scan result that is passed in shared memory."),
+			gettext_noop("Larger results are written to a file that the consumers read. "
+						 "A value of 0 always uses a file."),
+			GUC_UNIT_KB
+		},
+		&gp_shareinput_inmem_size,
+		1024, 0, 1024 * 1024,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_vmem_idle_resource_timeout", PGC_USERSET, CLIENT_CONN_OTHER,
 			gettext_noop("Sets the time a session can be idle (in milliseconds) before we release gangs on the segment DBs to free resources."),
@@ -3529,6 +3659,18 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_gang_prewarm_size", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the number of segment workers per segment to connect ahead of the first query."),
+			gettext_noop("Connections are started at session start and after idle segment workers are released. "
+						 "A value of zero disables pre-warming."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_gang_prewarm_size,
+		0, 0, 64,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_session_id", PGC_BACKEND, CLIENT_CONN_OTHER,
 			gettext_noop("Global ID used to uniquely identify a particular session in an Greenplum Database array"),
@@ -3540,6 +3682,37 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_motion_batch_size", PGC_USERSET, QUERY_TUNING_COST,
+			gettext_noop("Sets the maximum number of narrow tuples a Motion packs column-wise into one message."),
+			gettext_noop("If 0, tuples are sent one at a time.")
+		},
+		&gp_motion_batch_size,
+		0, 0, 8192,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_motion_compress_min_width", PGC_USERSET, QUERY_TUNING_COST,
+			gettext_noop("Sets the minimum estimated row width, in bytes, for a Motion to compress its tuples."),
+			gettext_noop("If 0, tuples are never compressed on the interconnect.")
+		},
+		&gp_motion_compress_min_width,
+		0, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_motion_merge_abbrev_min_senders", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Sets the minimum number of senders for a sorted Motion to merge them with abbreviated keys."),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&gp_motion_merge_abbrev_min_senders,
+		16, 1, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_segments_for_planner", PGC_USERSET, QUERY_TUNING_COST,
 			gettext_noop("If >0, number of segment dbs for the planner to assume in its cost and size estimates."),
@@ -3561,6 +3734,17 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_hashjoin_probe_batch_size", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Number of outer tuples a Hashjoin fetches ahead to prefetch their hash buckets."),
+			gettext_noop("Values below 2 probe one outer tuple at a time."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_hashjoin_probe_batch_size,
+		16, 0, 1024,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_hashagg_groups_per_bucket", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Target density of hashtable used by Hashagg during execution"),
@@ -4014,6 +4198,28 @@ struct config_real ConfigureNamesReal_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_motion_skew_factor", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Sets how many times a segment's fair share of the rows a join key "
+						 "value must have for a redistribute motion to spread it out."),
+			gettext_noop("If 0, redistribute motions always send equal keys to the same segment.")
+		},
+		&gp_motion_skew_factor,
+		0, 0, DBL_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_hashagg_passthrough_ratio", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Sets the ratio of groups to input rows above which a streaming hash aggregation "
+						 "passes its input rows through without grouping them."),
+			NULL
+		},
+		&gp_hashagg_passthrough_ratio,
+		0.8, 0.0, 1.0,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_selectivity_damping_factor", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Factor used in selectivity damping."),
@@ -4437,6 +4643,17 @@ struct config_enum ConfigureNamesEnum_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_workfile_compression", PGC_USERSET, RESOURCES_DISK,
+			gettext_noop("Sets the method used to compress temporary files."),
+			gettext_noop("Valid values are \"off\", \"zstd\", \"lz4\" and \"on\", "
+						 "which picks the method the server was built with.")
+		},
+		&gp_workfile_compression,
+		WORKFILE_COMPRESSION_NONE, gp_workfile_compression_options,
+		check_gp_workfile_compression, NULL, NULL
+	},
+
 	{
 		{"gp_interconnect_fc_method", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Sets the flow control method used for UDP interconnect."),
@@ -4859,12 +5076,20 @@ lookup_autostats_mode_by_value(GpAutoStatsModeValue val)
 
 
 static bool
-check_gp_workfile_compression(bool *newval, void **extra, GucSource source)
+check_gp_workfile_compression(int *newval, void **extra, GucSource source)
 {
 #ifndef USE_ZSTD
-	if (*newval)
+	if (*newval == WORKFILE_COMPRESSION_ZSTD)
+	{
+		GUC_check_errmsg("workfile compresssion is not supported by this build");
+		return false;
+	}
+#endif
+#ifndef HAVE_LIBLZ4
+	if (*newval == WORKFILE_COMPRESSION_LZ4)
 	{
 		GUC_check_errmsg("workfile compresssion is not supported by this build");
+		GUC_check_errdetail("This build does not support LZ4 compression.");
 		return false;
 	}
 #endif
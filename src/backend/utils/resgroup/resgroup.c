@@ -2858,6 +2858,26 @@ SwitchResGroupOnSegment(const char *buf, int len)
 	ResGroupOps_AssignGroup(self->groupId, &(self->caps), MyProcPid);
 }
 
+/*
+ * Add a parallel worker to the cgroup of its leader's resource group.
+ *
+ * 'buf' is the leader's resource group information, as serialized by
+ * SerializeResGroupInfo(). Only the CPU usage of the worker is limited this
+ * way. The worker doesn't occupy a slot, and its memory is not accounted to
+ * the group.
+ */
+void
+ResGroupAssignParallelWorker(const char *buf, int len)
+{
+	Oid			groupId;
+	ResGroupCaps caps;
+
+	DeserializeResGroupInfo(&caps, &groupId, buf, len);
+
+	if (groupId != InvalidOid)
+		ResGroupOps_AssignGroup(groupId, &caps, MyProcPid);
+}
+
 /*
  * Wait on the queue of resource group
  */
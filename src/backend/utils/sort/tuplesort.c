@@ -114,6 +114,7 @@
 #include "utils/sortsupport.h"
 #include "utils/tuplesort.h"
 
+#include "cdb/cdbvars.h"
 #include "utils/faultinjector.h"
 
 
@@ -225,6 +226,19 @@ typedef enum
 #define TAPE_BUFFER_OVERHEAD		BLCKSZ
 #define MERGE_BUFFER_SIZE			(BLCKSZ * 32)
 
+/*
+ * Parameters of the radix sort, see radix_sort_tuple().  Below
+ * RADIX_SORT_MIN_TUPLES tuples, quicksort is about as fast, and buckets
+ * smaller than RADIX_QSORT_THRESHOLD are finished with quicksort.
+ */
+#define RADIX_SORT_MIN_TUPLES	1024
+#define RADIX_QSORT_THRESHOLD	64
+
+/* shift of the most significant byte of the leading key, in radix sort */
+#define RADIX_SORT_FIRST_SHIFT(state) \
+	((state)->sortKeys->comparator == ssup_datum_int32_cmp ? 24 : \
+	 (SIZEOF_DATUM * BITS_PER_BYTE - BITS_PER_BYTE))
+
 typedef int (*SortTupleComparator) (const SortTuple *a, const SortTuple *b,
 									Tuplesortstate *state);
 
@@ -290,9 +304,10 @@ struct Tuplesortstate
 	/*
 	 * This array holds the tuples now in sort memory.  If we are in state
 	 * INITIAL, the tuples are in no particular order; if we are in state
-	 * SORTEDINMEM, the tuples are in final sorted order; in states BUILDRUNS
-	 * and FINALMERGE, the tuples are organized in "heap" order per Algorithm
-	 * H.  In state SORTEDONTAPE, the array is not used.
+	 * SORTEDINMEM, the tuples are in final sorted order; in state BOUNDED,
+	 * the tuples are organized in "heap" order per Algorithm H.  During merge
+	 * passes, including state FINALMERGE, they are the leaves of the tree of
+	 * losers.  In state SORTEDONTAPE, the array is not used.
 	 */
 	SortTuple  *memtuples;		/* array of SortTuple structs */
 	int			memtupcount;	/* number of tuples currently present */
@@ -361,6 +376,13 @@ struct Tuplesortstate
 	 */
 	bool	   *mergeactive;	/* active input run source? */
 
+	/*
+	 * The tree of losers used to merge, see tuplesort_merge_build().  The
+	 * leaves are memtuples[0..mergeLeaves-1].
+	 */
+	int		   *mergeLosers;	/* loser of each match; [0] is the winner */
+	int			mergeLeaves;	/* number of leaves in the tree */
+
 	/*
 	 * Variables for Algorithm D.  Note that destTape is a "logical" tape
 	 * number, ie, an index into the tp_xxx[] arrays.  Be careful to keep
@@ -528,6 +550,7 @@ struct Sharedsort
 #define COPYTUP(state,stup,tup) ((*(state)->copytup) (state, stup, tup))
 #define WRITETUP(state,tape,stup)	((*(state)->writetup) (state, tape, stup))
 #define READTUP(state,stup,tape,len) ((*(state)->readtup) (state, stup, tape, len))
+#define MERGE_TOP(state)	(&(state)->memtuples[(state)->mergeLosers[0]])
 #define LACKMEM(state)		((state)->availMem < 0 && !(state)->slabAllocatorUsed)
 #define USEMEM(state,amt)	((state)->availMem -= (amt))
 #define FREEMEM(state,amt)	((state)->availMem += (amt))
@@ -610,6 +633,12 @@ static void tuplesort_sort_memtuples(Tuplesortstate *state);
 static void tuplesort_heap_insert(Tuplesortstate *state, SortTuple *tuple);
 static void tuplesort_heap_replace_top(Tuplesortstate *state, SortTuple *tuple);
 static void tuplesort_heap_delete_top(Tuplesortstate *state);
+static void tuplesort_merge_build(Tuplesortstate *state);
+static void tuplesort_merge_replace_top(Tuplesortstate *state, SortTuple *tuple);
+static void tuplesort_merge_delete_top(Tuplesortstate *state);
+static bool radix_sort_usable(Tuplesortstate *state);
+static void radix_sort_tuple(Tuplesortstate *state, SortTuple *begin,
+							 size_t n, int shift);
 static void reversedirection(Tuplesortstate *state);
 static unsigned int getlen(Tuplesortstate *state, int tapenum, bool eofOK);
 static void markrunend(Tuplesortstate *state, int tapenum);
@@ -2094,10 +2123,10 @@ tuplesort_gettuple_common(Tuplesortstate *state, bool forward,
 			 */
 			if (state->memtupcount > 0)
 			{
-				int			srcTape = state->memtuples[0].tupindex;
+				int			srcTape = MERGE_TOP(state)->tupindex;
 				SortTuple	newtup;
 
-				*stup = state->memtuples[0];
+				*stup = *MERGE_TOP(state);
 
 				/*
 				 * Remember the tuple we return, so that we can recycle its
@@ -2107,15 +2136,15 @@ tuplesort_gettuple_common(Tuplesortstate *state, bool forward,
 
 				/*
 				 * Pull next tuple from tape, and replace the returned tuple
-				 * at top of the heap with it.
+				 * at the top of the merge tree with it.
 				 */
 				if (!mergereadnext(state, srcTape, &newtup))
 				{
 					/*
 					 * If no more data, we've reached end of run on this tape.
-					 * Remove the top node from the heap.
+					 * Remove its leaf from the merge tree.
 					 */
-					tuplesort_heap_delete_top(state);
+					tuplesort_merge_delete_top(state);
 
 					/*
 					 * Rewind to free the read buffer.  It'd go away at the
@@ -2126,7 +2155,7 @@ tuplesort_gettuple_common(Tuplesortstate *state, bool forward,
 					return true;
 				}
 				newtup.tupindex = srcTape;
-				tuplesort_heap_replace_top(state, &newtup);
+				tuplesort_merge_replace_top(state, &newtup);
 				return true;
 			}
 			return false;
@@ -2475,6 +2504,7 @@ inittapestate(Tuplesortstate *state, int maxTapes)
 	PrepareTempTablespaces();
 
 	state->mergeactive = (bool *) palloc0(maxTapes * sizeof(bool));
+	state->mergeLosers = (int *) palloc0(maxTapes * sizeof(int));
 	state->tp_fib = (int *) palloc0(maxTapes * sizeof(int));
 	state->tp_runs = (int *) palloc0(maxTapes * sizeof(int));
 	state->tp_dummy = (int *) palloc0(maxTapes * sizeof(int));
@@ -2818,43 +2848,43 @@ mergeonerun(Tuplesortstate *state)
 
 	/*
 	 * Start the merge by loading one tuple from each active source tape into
-	 * the heap.  We can also decrease the input run/dummy run counts.
+	 * the merge tree.  We can also decrease the input run/dummy run counts.
 	 */
 	beginmerge(state);
 
 	/*
-	 * Execute merge by repeatedly extracting lowest tuple in heap, writing it
-	 * out, and replacing it with next tuple from same tape (if there is
-	 * another one).
+	 * Execute merge by repeatedly extracting lowest tuple in the tree,
+	 * writing it out, and replacing it with next tuple from same tape (if
+	 * there is another one).
 	 */
 	while (state->memtupcount > 0)
 	{
+		SortTuple  *top = MERGE_TOP(state);
 		SortTuple	stup;
 
 		/* write the tuple to destTape */
-		srcTape = state->memtuples[0].tupindex;
-		WRITETUP(state, destTape, &state->memtuples[0]);
+		srcTape = top->tupindex;
+		WRITETUP(state, destTape, top);
 
 		/* recycle the slot of the tuple we just wrote out, for the next read */
-		if (state->memtuples[0].tuple)
-			RELEASE_SLAB_SLOT(state, state->memtuples[0].tuple);
+		if (top->tuple)
+			RELEASE_SLAB_SLOT(state, top->tuple);
 
 		/*
 		 * pull next tuple from the tape, and replace the written-out tuple in
-		 * the heap with it.
+		 * the tree with it.
 		 */
 		if (mergereadnext(state, srcTape, &stup))
 		{
 			stup.tupindex = srcTape;
-			tuplesort_heap_replace_top(state, &stup);
-
+			tuplesort_merge_replace_top(state, &stup);
 		}
 		else
-			tuplesort_heap_delete_top(state);
+			tuplesort_merge_delete_top(state);
 	}
 
 	/*
-	 * When the heap empties, we're done.  Write an end-of-run marker on the
+	 * When the tree empties, we're done.  Write an end-of-run marker on the
 	 * output tape, and increment its count of real runs.
 	 */
 	markrunend(state, destTape);
@@ -2871,8 +2901,8 @@ mergeonerun(Tuplesortstate *state)
  * beginmerge - initialize for a merge pass
  *
  * We decrease the counts of real and dummy runs for each tape, and mark
- * which tapes contain active input runs in mergeactive[].  Then, fill the
- * merge heap with the first tuple from each active tape.
+ * which tapes contain active input runs in mergeactive[].  Then, build the
+ * merge tree from the first tuple of each active tape.
  */
 static void
 beginmerge(Tuplesortstate *state)
@@ -2881,7 +2911,7 @@ beginmerge(Tuplesortstate *state)
 	int			tapenum;
 	int			srcTape;
 
-	/* Heap should be empty here */
+	/* Merge tree should be empty here */
 	Assert(state->memtupcount == 0);
 
 	/* Adjust run counts and mark the active tapes */
@@ -2904,17 +2934,19 @@ beginmerge(Tuplesortstate *state)
 	Assert(activeTapes > 0);
 	state->activeTapes = activeTapes;
 
-	/* Load the merge heap with the first tuple from each input tape */
+	/* Load the merge tree with the first tuple from each input tape */
 	for (srcTape = 0; srcTape < state->maxTapes; srcTape++)
 	{
 		SortTuple	tup;
 
 		if (mergereadnext(state, srcTape, &tup))
 		{
+			Assert(state->memtupcount < state->memtupsize);
 			tup.tupindex = srcTape;
-			tuplesort_heap_insert(state, &tup);
+			state->memtuples[state->memtupcount++] = tup;
 		}
 	}
+	tuplesort_merge_build(state);
 }
 
 /*
@@ -3331,9 +3363,11 @@ sort_bounded_heap(Tuplesortstate *state)
 }
 
 /*
- * Sort all memtuples using specialized qsort() routines.
+ * Sort all memtuples using specialized qsort() routines, or a radix sort.
  *
  * Quicksort is used for small in-memory sorts, and external sort runs.
+ * When the leading key is an integer-like Datum or abbreviated key, and
+ * there are enough tuples, a radix sort is used instead.
  */
 static void
 tuplesort_sort_memtuples(Tuplesortstate *state)
@@ -3342,8 +3376,56 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 
 	if (state->memtupcount > 1)
 	{
+		if (radix_sort_usable(state))
+		{
+			SortTuple  *memtuples = state->memtuples;
+			size_t		n = state->memtupcount;
+			size_t		nnulls = 0;
+			size_t		i;
+
+			/*
+			 * Radix sort only knows about the leading key's Datum, so move
+			 * the NULLs to where they belong first.  They are all equal as
+			 * far as the leading key is concerned.
+			 */
+			if (state->sortKeys->ssup_nulls_first)
+			{
+				for (i = 0; i < n; i++)
+				{
+					if (memtuples[i].isnull1)
+					{
+						SortTuple	tmp = memtuples[nnulls];
+
+						memtuples[nnulls++] = memtuples[i];
+						memtuples[i] = tmp;
+					}
+				}
+				if (nnulls > 1 && state->onlyKey == NULL)
+					qsort_tuple(memtuples, nnulls, state->comparetup, state);
+				radix_sort_tuple(state, memtuples + nnulls, n - nnulls,
+								 RADIX_SORT_FIRST_SHIFT(state));
+			}
+			else
+			{
+				for (i = n; i > 0; i--)
+				{
+					if (memtuples[i - 1].isnull1)
+					{
+						SortTuple	tmp = memtuples[n - nnulls - 1];
+
+						memtuples[n - ++nnulls] = memtuples[i - 1];
+						memtuples[i - 1] = tmp;
+					}
+				}
+				if (nnulls > 1 && state->onlyKey == NULL)
+					qsort_tuple(memtuples + n - nnulls, nnulls,
+								state->comparetup, state);
+				radix_sort_tuple(state, memtuples, n - nnulls,
+								 RADIX_SORT_FIRST_SHIFT(state));
+			}
+		}
 		/* Can we use the single-key sort function? */
-		if (state->onlyKey != NULL)
+		else if (state->onlyKey != NULL)
 			qsort_ssup(state->memtuples, state->memtupcount,
 					   state->onlyKey);
 		else
@@ -3457,6 +3539,272 @@ tuplesort_heap_replace_top(Tuplesortstate *state, SortTuple *tuple)
 	memtuples[i] = *tuple;
 }
 
+/*
+ * Build the tree of losers for a merge pass, from the first tuple of each
+ * input run in memtuples[0..memtupcount-1].
+ *
+ * This is Knuth's "tree of losers" (Section 5.4.1).  The leaves are the
+ * memtuples[] entries, and each internal node remembers the leaf that lost
+ * the match played there, while the winner moves on to the next match up.
+ * mergeLosers[0] is the overall winner.  The tree is laid out like a binary
+ * heap, with the internal nodes at 1..n-1 and leaf j at position n + j, so
+ * the parent of position p is p / 2.
+ *
+ * When the winner is replaced by the next tuple from its run, only the
+ * matches on the path from its leaf to the root need to be replayed, against
+ * the losers stored there: one comparison per level, where sifting down a
+ * binary heap takes two.  A leaf whose run is exhausted has tupindex -1 and
+ * loses every match.
+ */
+static void
+tuplesort_merge_build(Tuplesortstate *state)
+{
+	int			n = state->memtupcount;
+	int		   *losers = state->mergeLosers;
+	int		   *winners;
+	int			i;
+
+	state->mergeLeaves = n;
+	losers[0] = 0;
+	if (n <= 1)
+		return;
+
+	/* Play the matches bottom-up, remembering the winner of each */
+	winners = (int *) palloc(2 * n * sizeof(int));
+	for (i = 0; i < n; i++)
+		winners[n + i] = i;
+	for (i = n - 1; i >= 1; i--)
+	{
+		int			left = winners[2 * i];
+		int			right = winners[2 * i + 1];
+
+		if (COMPARETUP(state, &state->memtuples[right],
+					   &state->memtuples[left]) < 0)
+		{
+			winners[i] = right;
+			losers[i] = left;
+		}
+		else
+		{
+			winners[i] = left;
+			losers[i] = right;
+		}
+	}
+	losers[0] = winners[1];
+	pfree(winners);
+}
+
+/* Does leaf 'a' of the merge tree win against leaf 'b'? */
+static inline bool
+merge_leaf_wins(Tuplesortstate *state, int a, int b)
+{
+	SortTuple  *memtuples = state->memtuples;
+
+	if (memtuples[a].tupindex < 0)
+		return false;
+	if (memtuples[b].tupindex < 0)
+		return true;
+	return COMPARETUP(state, &memtuples[a], &memtuples[b]) < 0;
+}
+
+/* Replay the matches on the path from the winner's leaf to the root */
+static void
+tuplesort_merge_replay(Tuplesortstate *state)
+{
+	int		   *losers = state->mergeLosers;
+	int			winner = losers[0];
+	int			node;
+
+	CHECK_FOR_INTERRUPTS();
+
+	for (node = (state->mergeLeaves + winner) >> 1; node > 0; node >>= 1)
+	{
+		if (merge_leaf_wins(state, losers[node], winner))
+		{
+			int			tmp = losers[node];
+
+			losers[node] = winner;
+			winner = tmp;
+		}
+	}
+	losers[0] = winner;
+}
+
+/*
+ * Replace the winning tuple of the merge tree with the next tuple from the
+ * same run.
+ */
+static void
+tuplesort_merge_replace_top(Tuplesortstate *state, SortTuple *tuple)
+{
+	Assert(state->memtupcount >= 1);
+
+	*MERGE_TOP(state) = *tuple;
+	tuplesort_merge_replay(state);
+}
+
+/*
+ * Remove the winning tuple from the merge tree, when its run is exhausted.
+ *
+ * The caller has already free'd the tuple the top node points to,
+ * if necessary.
+ */
+static void
+tuplesort_merge_delete_top(Tuplesortstate *state)
+{
+	Assert(state->memtupcount >= 1);
+
+	MERGE_TOP(state)->tupindex = -1;
+	if (--state->memtupcount > 0)
+		tuplesort_merge_replay(state);
+}
+
+/*
+ * Radix sort.
+ *
+ * When the comparator of the leading key is one of the generic integer
+ * comparators in sortsupport.c, the order of the tuples by datum1 is the
+ * order of an unsigned integer derived from it (see radix_sort_key()).  We
+ * can then sort by that integer one byte at a time, starting with the most
+ * significant byte, distributing the tuples in place into 256 buckets
+ * ("American flag sort"), and recursing into each bucket with the next
+ * byte.  That needs no comparator calls at all, until a bucket is small
+ * enough to finish off with quicksort.
+ *
+ * Tuples that are equal on datum1 but may differ on the other keys, or on
+ * the authoritative value of an abbreviated key, are sorted with quicksort
+ * once they've been gathered into one bucket.
+ */
+static bool
+radix_sort_usable(Tuplesortstate *state)
+{
+	SortSupport sortKey = state->sortKeys;
+
+	if (!gp_enable_radix_sort || state->memtupcount < RADIX_SORT_MIN_TUPLES)
+		return false;
+
+	/*
+	 * The hash index case has no sortKeys, and in the CLUSTER case datum1 is
+	 * not set when the leading key is an expression.
+	 */
+	if (sortKey == NULL || state->comparetup == comparetup_cluster)
+		return false;
+
+	return (sortKey->comparator == ssup_datum_unsigned_cmp ||
+#ifdef USE_FLOAT8_BYVAL
+			sortKey->comparator == ssup_datum_signed_cmp ||
+#endif
+			sortKey->comparator == ssup_datum_int32_cmp);
+}
+
+/* Map a non-NULL datum1 to an unsigned integer with the same sort order */
+static inline uint64
+radix_sort_key(Datum datum, SortSupport ssup)
+{
+	uint64		key;
+
+	if (ssup->comparator == ssup_datum_int32_cmp)
+		key = (uint32) DatumGetInt32(datum) ^ ((uint32) 1 << 31);
+#ifdef USE_FLOAT8_BYVAL
+	else if (ssup->comparator == ssup_datum_signed_cmp)
+		key = (uint64) DatumGetInt64(datum) ^ (UINT64CONST(1) << 63);
+#endif
+	else
+		key = (uint64) datum;
+
+	if (ssup->ssup_reverse)
+		key = ~key;
+	return key;
+}
+
+static void
+radix_sort_tuple(Tuplesortstate *state, SortTuple *begin, size_t n, int shift)
+{
+	SortSupport ssup = state->sortKeys;
+	size_t		counts[256];
+	size_t		next[256];
+	size_t		ends[256];
+	size_t		i;
+	size_t		pos;
+	int			b;
+
+	if (n < 2)
+		return;
+
+	/*
+	 * Small buckets are quicker to finish with quicksort, which also deals
+	 * with the remaining keys.
+	 */
+	if (n < RADIX_QSORT_THRESHOLD)
+	{
+		if (state->onlyKey != NULL)
+			qsort_ssup(begin, n, state->onlyKey);
+		else
+			qsort_tuple(begin, n, state->comparetup, state);
+		return;
+	}
+
+	CHECK_FOR_INTERRUPTS();
+
+	/* Count the tuples in each bucket */
+	memset(counts, 0, sizeof(counts));
+	for (i = 0; i < n; i++)
+		counts[(radix_sort_key(begin[i].datum1, ssup) >> shift) & 0xFF]++;
+
+	pos = 0;
+	for (b = 0; b < 256; b++)
+	{
+		next[b] = pos;
+		pos += counts[b];
+		ends[b] = pos;
+	}
+
+	/*
+	 * Permute the tuples into their buckets, unless they all fall into the
+	 * same one already.
+	 */
+	if (counts[(radix_sort_key(begin[0].datum1, ssup) >> shift) & 0xFF] != n)
+	{
+		for (b = 0; b < 256; b++)
+		{
+			while (next[b] < ends[b])
+			{
+				SortTuple	tup = begin[next[b]];
+				int			tb = (radix_sort_key(tup.datum1, ssup) >> shift) & 0xFF;
+
+				while (tb != b)
+				{
+					SortTuple	tmp = begin[next[tb]];
+
+					begin[next[tb]++] = tup;
+					tup = tmp;
+					tb = (radix_sort_key(tup.datum1, ssup) >> shift) & 0xFF;
+				}
+				begin[next[b]++] = tup;
+			}
+		}
+	}
+
+	/* Sort each bucket by the next byte */
+	pos = 0;
+	for (b = 0; b < 256; b++)
+	{
+		size_t		count = counts[b];
+
+		if (count > 1)
+		{
+			if (shift > 0)
+				radix_sort_tuple(state, begin + pos, count, shift - BITS_PER_BYTE);
+			else if (state->onlyKey == NULL)
+			{
+				/* Equal on datum1, tie-break on the rest */
+				qsort_tuple(begin + pos, count, state->comparetup, state);
+			}
+		}
+		pos += count;
+	}
+}
+
 /*
  * Function to reverse the sort direction from its current state
  *
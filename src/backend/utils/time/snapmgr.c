@@ -251,6 +251,8 @@ typedef struct SerializedSnapshotData
 	CommandId	curcid;
 	TimestampTz whenTaken;
 	XLogRecPtr	lsn;
+	bool		haveDistribSnapshot;	/* GPDB: distributed snapshot follows */
+	int32		distribXcnt;
 } SerializedSnapshotData;
 
 Size
@@ -2153,6 +2155,15 @@ EstimateSnapshotSpace(Snapshot snap)
 		size = add_size(size,
 						mul_size(snap->subxcnt, sizeof(TransactionId)));
 
+	/*
+	 * GPDB: Parallel workers in a QE must see the same distributed snapshot
+	 * as their leader. The local xid mapping cache is not passed on; the
+	 * workers build their own.
+	 */
+	if (snap->haveDistribSnapshot)
+		size = add_size(size,
+						DistributedSnapshot_SerializeSize(&snap->distribSnapshotWithLocalMapping.ds));
+
 	return size;
 }
 
@@ -2178,6 +2189,9 @@ SerializeSnapshot(Snapshot snapshot, char *start_address)
 	serialized_snapshot.curcid = snapshot->curcid;
 	serialized_snapshot.whenTaken = snapshot->whenTaken;
 	serialized_snapshot.lsn = snapshot->lsn;
+	serialized_snapshot.haveDistribSnapshot = snapshot->haveDistribSnapshot;
+	serialized_snapshot.distribXcnt = snapshot->haveDistribSnapshot ?
+		snapshot->distribSnapshotWithLocalMapping.ds.count : 0;
 
 	/*
 	 * Ignore the SubXID array if it has overflowed, unless the snapshot was
@@ -2211,6 +2225,16 @@ SerializeSnapshot(Snapshot snapshot, char *start_address)
 		memcpy((TransactionId *) (start_address + subxipoff),
 			   snapshot->subxip, snapshot->subxcnt * sizeof(TransactionId));
 	}
+
+	/* Copy the distributed snapshot */
+	if (serialized_snapshot.haveDistribSnapshot)
+	{
+		Size		dsoff = sizeof(SerializedSnapshotData) +
+		(snapshot->xcnt + serialized_snapshot.subxcnt) * sizeof(TransactionId);
+
+		DistributedSnapshot_Serialize(&snapshot->distribSnapshotWithLocalMapping.ds,
+									  start_address + dsoff);
+	}
 }
 
 /*
@@ -2227,6 +2251,7 @@ RestoreSnapshot(char *start_address)
 	Size		size;
 	Snapshot	snapshot;
 	TransactionId *serialized_xids;
+	Size		dsoff;
 
 	memcpy(&serialized_snapshot, start_address,
 		   sizeof(SerializedSnapshotData));
@@ -2237,6 +2262,9 @@ RestoreSnapshot(char *start_address)
 	size = sizeof(SnapshotData)
 		+ serialized_snapshot.xcnt * sizeof(TransactionId)
 		+ serialized_snapshot.subxcnt * sizeof(TransactionId);
+	dsoff = size = MAXALIGN(size);
+	size += serialized_snapshot.distribXcnt *
+		(sizeof(DistributedTransactionId) + sizeof(TransactionId));
 
 	/* Copy all required fields */
 	snapshot = (Snapshot) MemoryContextAlloc(TopTransactionContext, size);
@@ -2270,6 +2298,29 @@ RestoreSnapshot(char *start_address)
 			   serialized_snapshot.subxcnt * sizeof(TransactionId));
 	}
 
+	/* Copy the distributed snapshot, if present, with an empty mapping cache. */
+	snapshot->haveDistribSnapshot = serialized_snapshot.haveDistribSnapshot;
+	snapshot->distribSnapshotWithLocalMapping.ds.inProgressXidArray = NULL;
+	snapshot->distribSnapshotWithLocalMapping.inProgressMappedLocalXids = NULL;
+	snapshot->distribSnapshotWithLocalMapping.minCachedLocalXid = InvalidTransactionId;
+	snapshot->distribSnapshotWithLocalMapping.maxCachedLocalXid = InvalidTransactionId;
+	snapshot->distribSnapshotWithLocalMapping.currentLocalXidsCount = 0;
+	if (serialized_snapshot.haveDistribSnapshot)
+	{
+		if (serialized_snapshot.distribXcnt > 0)
+		{
+			snapshot->distribSnapshotWithLocalMapping.ds.inProgressXidArray =
+				(DistributedTransactionId *) ((char *) snapshot + dsoff);
+			snapshot->distribSnapshotWithLocalMapping.inProgressMappedLocalXids =
+				(TransactionId *) ((char *) snapshot + dsoff +
+								   serialized_snapshot.distribXcnt * sizeof(DistributedTransactionId));
+		}
+		DistributedSnapshot_Deserialize((char *) (serialized_xids +
+												  serialized_snapshot.xcnt +
+												  serialized_snapshot.subxcnt),
+										&snapshot->distribSnapshotWithLocalMapping.ds);
+	}
+
 	/* Set the copied flag so that the caller will set refcounts correctly. */
 	snapshot->regd_count = 0;
 	snapshot->active_count = 0;
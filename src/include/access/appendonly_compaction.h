@@ -21,6 +21,18 @@
 
 #define APPENDONLY_COMPACTION_SEGNO_INVALID (-1)
 
+/*
+ * I/O done so far while compacting one segment file. Used to drive the
+ * VACUUM progress counters and the cost-based vacuum delay.
+ */
+typedef struct AppendOnlyCompactionIO
+{
+	int64		bytesRead;		/* segfile data scanned */
+	int64		bytesWritten;	/* estimated data moved to the insert segfile */
+	int64		blksRead;		/* bytesRead already accounted for, in BLCKSZ */
+	int64		blksWritten;	/* bytesWritten already accounted for */
+} AppendOnlyCompactionIO;
+
 extern void AppendOnlyRecycleDeadSegments(Relation aorel);
 extern void AppendOnlyCompact(Relation aorel,
 							  int compaction_segno,
@@ -35,5 +47,8 @@ extern bool AppendOnlyCompaction_ShouldCompact(
 								   Snapshot appendOnlyMetaDataSnapshot);
 extern void AppendOnlyThrowAwayTuple(Relation rel, TupleTableSlot *slot);
 extern void AppendOnlyTruncateToEOF(Relation aorel);
+extern void AppendOnlyCompaction_AccountIO(AppendOnlyCompactionIO *io,
+										   int64 bytesRead,
+										   int64 bytesWritten);
 
 #endif
@@ -123,6 +123,12 @@ bool AppendOnlyVisimapEntry_IsVisible(
 								 AppendOnlyVisimapEntry *visiMapEntry,
 								 AOTupleId *aoTupleId);
 
+int AppendOnlyVisimapEntry_GetVisibleRows(
+									  AppendOnlyVisimapEntry *visiMapEntry,
+									  int64 rowNum,
+									  int nrows,
+									  bool *visible);
+
 TM_Result AppendOnlyVisimapEntry_HideTuple(
 								 AppendOnlyVisimapEntry *visiMapEntry,
 								 AOTupleId *aoTupleId);
@@ -35,10 +35,30 @@ typedef struct MemTupleAttrBinding
 	unsigned char null_mask;		/* null bit mask */
 } MemTupleAttrBinding;
 
+/*
+ * One step of the deform program of a binding. There is one step for each
+ * attribute, in the physical order of the attributes in the memtuple, so that
+ * memtuple_deform() can accumulate the space saved by NULLs as it goes,
+ * instead of recomputing it from the null bitmap for every attribute.
+ */
+typedef struct MemTupleDeformStep
+{
+	int attnum;				/* attribute number, 0 based */
+	int offset;				/* offset of attr in memtuple, if no NULLs */
+	short len;				/* space saved when NULL */
+	short len_aligned;		/* same, using the aligned length */
+	short offset_len;		/* size of the offset of a varlen attr, 2 or 4 */
+	int16 attlen;			/* attlen of the attribute */
+	MemTupleBindFlag flag;	/* binding flag */
+	int null_byte;			/* which byte holds the null flag for the attr */
+	unsigned char null_mask;	/* null bit mask */
+} MemTupleDeformStep;
+
 typedef struct MemTupleBindingCols
 {
 	uint32 var_start; 	/* varlen fields start */
 	MemTupleAttrBinding *bindings; /* bindings for attrs (cols) */
+	MemTupleDeformStep *deform_steps;	/* deform program, in physical order */
 	short *null_saves;				/* saved space from each attribute when null */
 	short *null_saves_aligned;		/* saved space from each attribute when null - uses aligned length */
 	bool has_null_saves_alignment_mismatch;		/* true if one or more attributes has mismatching alignment and length  */
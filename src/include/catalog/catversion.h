@@ -56,6 +56,6 @@
  */
 
 /*							3yyymmddN */
-#define CATALOG_VERSION_NO	302104151
+#define CATALOG_VERSION_NO	302610193
 
 #endif
@@ -291,10 +291,14 @@ typedef AOCSAddColumnDescData *AOCSAddColumnDesc;
  */
 
 extern AOCSScanDesc aocs_beginscan(Relation relation, Snapshot snapshot,
+								   ParallelTableScanDesc pscan,
 								   bool *proj, uint32 flags);
 extern AOCSScanDesc aocs_beginrangescan(Relation relation, Snapshot snapshot,
 										Snapshot appendOnlyMetaDataSnapshot,
 										int *segfile_no_arr, int segfile_count);
+extern void aocs_scan_restrict_blockrange(AOCSScanDesc scan,
+										  BlockNumber start_blockno,
+										  BlockNumber numblocks);
 
 extern void aocs_rescan(AOCSScanDesc scan);
 extern void aocs_endscan(AOCSScanDesc scan);
@@ -307,6 +311,7 @@ static inline void aocs_insert(AOCSInsertDesc idesc, TupleTableSlot *slot)
 	slot_getallattrs(slot);
 	aocs_insert_values(idesc, slot->tts_values, slot->tts_isnull, (AOTupleId *) &slot->tts_tid);
 }
+extern void aocs_insert_multi(AOCSInsertDesc idesc, TupleTableSlot **slots, int ntuples);
 extern void aocs_insert_finish(AOCSInsertDesc idesc);
 extern AOCSFetchDesc aocs_fetch_init(Relation relation,
 									 Snapshot snapshot,
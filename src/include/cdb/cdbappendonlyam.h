@@ -152,6 +152,14 @@ typedef struct AppendOnlyExecutorReadBlock
 	
 	uint8			*singleRow;
 	int32			singleRowLen;
+
+	/*
+	 * Visibility of each row of the current block, looked up from the
+	 * visibility map when the block is read. NULL if the scan doesn't
+	 * filter out invisible rows that way.
+	 */
+	bool			*visibleRows;
+	int				visibleRowsLen;	/* allocated length of visibleRows */
 } AppendOnlyExecutorReadBlock;
 
 /*
@@ -225,6 +233,13 @@ typedef struct AppendOnlyScanDescData
 	 */ 
 	AppendOnlyVisimap visibilityMap;
 
+	/*
+	 * If true, the visibility of all the rows of a block is looked up when
+	 * the block is read, and invisible rows are skipped without deforming
+	 * them. See AppendOnlyVisimap_GetVisibleRows().
+	 */
+	bool		filterInvisibleRows;
+
 	/*
 	 * Only used by `analyze`
 	 */
@@ -239,6 +254,23 @@ typedef struct AppendOnlyScanDescData
 
 typedef AppendOnlyScanDescData *AppendOnlyScanDesc;
 
+/*
+ * Shared state of a parallel scan of an append-optimized table, row or
+ * column oriented.
+ *
+ * Segment files are the unit of work. Every participant builds the same,
+ * segno-ordered, array of segment files from the scan's snapshot, and claims
+ * the next segment file that no one has scanned yet from 'next_segfile'.
+ */
+typedef struct ParallelAppendOnlyScanDescData
+{
+	ParallelTableScanDescData base;
+
+	pg_atomic_uint32 next_segfile;	/* index of the next segfile to scan */
+} ParallelAppendOnlyScanDescData;
+
+typedef struct ParallelAppendOnlyScanDescData *ParallelAppendOnlyScanDesc;
+
 /*
  * Statistics on the latest fetch.
  */
@@ -363,6 +395,9 @@ extern AppendOnlyScanDesc appendonly_beginrangescan(Relation relation,
 		Snapshot appendOnlyMetaDataSnapshot, 
 		int *segfile_no_arr, int segfile_count,
 		int nkeys, ScanKey keys);
+extern void appendonly_scan_restrict_blockrange(AppendOnlyScanDesc scan,
+												BlockNumber start_blockno,
+												BlockNumber numblocks);
 
 extern TableScanDesc appendonly_beginscan(Relation relation,
 										  Snapshot snapshot,
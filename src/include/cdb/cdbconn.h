@@ -16,6 +16,7 @@
 #ifndef CDBCONN_H
 #define CDBCONN_H
 
+#include "cdb/cdbdisp_plancache.h"
 
 /* --------------------------------------------------------------------------------------------------
  * Structure for segment database definition and working values
@@ -53,6 +54,21 @@ typedef struct SegmentDatabaseDescriptor
     char                   *whoami;         /* QE identifier for msgs */
 	bool					isWriter;
 	int						identifier;		/* unique identifier in the cdbcomponent segment pool */
+
+	/*
+	 * True if the connection was started ahead of time by cdbgang_prewarm()
+	 * and has not been completed yet; prewarmPollStatus is the last result
+	 * of PQconnectPoll() on it.
+	 */
+	bool					prewarming;
+	PostgresPollingStatusType prewarmPollStatus;
+
+	/*
+	 * Keys of the plans that the QE has cached, most recently used first.
+	 * See cdbdisp_plancache.c.
+	 */
+	DispatchPlanKey			cachedPlans[DISPATCH_PLAN_CACHE_SIZE];
+	int						numCachedPlans;
 } SegmentDatabaseDescriptor;
 
 SegmentDatabaseDescriptor *
@@ -17,6 +17,7 @@
 #define CDBDISP_H
 
 #include "cdb/cdbtm.h"
+#include "portability/instr_time.h"
 #include "utils/resowner.h"
 
 #define CDB_MOTION_LOST_CONTACT_STRING "Interconnect error master lost contact with segment."
@@ -59,6 +60,7 @@ typedef struct DispatcherInternalFuncs
 	void (*checkResults)(struct CdbDispatcherState *ds, DispatchWaitMode waitMode);
 	void (*dispatchToGang)(struct CdbDispatcherState *ds, struct Gang *gp, int sliceIndex);
 	void (*waitDispatchFinish)(struct CdbDispatcherState *ds);
+	void (*destroyDispatchParams)(struct CdbDispatcherState *ds);
 
 }DispatcherInternalFuncs;
 
@@ -192,4 +194,6 @@ void AtSubAbort_DispatcherState(void);
 char *
 segmentsToContentStr(List *segments);
 
+extern double cdbdisp_elapsedMs(instr_time end, instr_time start);
+
 #endif   /* CDBDISP_H */
@@ -0,0 +1,65 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbdisp_plancache.h
+ *	  Caching of dispatched plans on the QEs.
+ *
+ * Portions Copyright (c) 2012-Present VMware, Inc. or its affiliates.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/cdb/cdbdisp_plancache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef CDBDISP_PLANCACHE_H
+#define CDBDISP_PLANCACHE_H
+
+struct PlannedStmt;
+struct SegmentDatabaseDescriptor;
+
+/* Number of dispatched plans each QE caches */
+#define DISPATCH_PLAN_CACHE_SIZE	16
+
+/*
+ * Identifies a dispatched plan in the plan caches.  Two plans are only
+ * considered the same if their fingerprints, check hashes and lengths all
+ * match.
+ */
+typedef struct DispatchPlanKey
+{
+	uint64		fingerprint;	/* hash of the serialized plan; 0 if none */
+	uint32		check;			/* CRC-32C of the serialized plan */
+	int32		length;			/* length of the serialized plan */
+} DispatchPlanKey;
+
+/*
+ * Largest plan, before compression, that is cached on the QEs.
+ */
+#define DISPATCH_PLAN_CACHE_MAX_SIZE	(256 * 1024)
+
+/*
+ * A QE that doesn't have the plan it was sent the key of asks the QD for it
+ * with a NOTIFY on this channel, and the QD replies with a message of this
+ * type holding the serialized plan.
+ */
+#define DISPATCH_PLAN_REQUEST_CHANNEL	"dispatch_plan"
+#define DISPATCH_PLAN_RESPONSE			'='
+
+/* QD side */
+extern void cdbdisp_planKey(const char *splan, int splan_len,
+							DispatchPlanKey *key);
+extern bool cdbdisp_segdbHasPlan(struct SegmentDatabaseDescriptor *segdbDesc,
+								 const DispatchPlanKey *key);
+extern void cdbdisp_segdbRememberPlan(struct SegmentDatabaseDescriptor *segdbDesc,
+									  const DispatchPlanKey *key);
+extern void cdbdisp_segdbForgetPlans(struct SegmentDatabaseDescriptor *segdbDesc);
+extern void cdbdisp_sendRequestedPlan(struct SegmentDatabaseDescriptor *segdbDesc,
+									  const char *splan, int splan_len,
+									  const char *request);
+
+/* QE side */
+extern void qePlanCacheReceive(const DispatchPlanKey *key,
+							   const char *splan, int splan_len);
+extern struct PlannedStmt *qePlanCacheFetch(const DispatchPlanKey *key);
+
+#endif							/* CDBDISP_PLANCACHE_H */
@@ -17,6 +17,7 @@
 
 #include "cdb/cdbdisp.h"
 #include "commands/tablecmds.h"
+#include "portability/instr_time.h"
 #include "utils/hsearch.h"
 
 struct pg_result;                   /* PGresult ... #include "libpq-fe.h" */
@@ -40,6 +41,12 @@ typedef struct CdbDispatchResults_SliceInfo
 {
     int resultBegin;
     int resultEnd;
+
+    /* time spent handing the slice's command to its QEs */
+    instr_time dispatchTime;
+
+    /* bytes of command sent to the slice's QEs, all of them together */
+    uint64 dispatchBytes;
 } CdbDispatchResults_SliceInfo;
 
 /*
@@ -109,6 +116,16 @@ typedef struct CdbDispatchResult
 
 	/* num rows completed in COPY FROM ON SEGMENT */
 	int	numrowscompleted;
+
+	/*
+	 * When the command was handed to libpq, when the first result data
+	 * arrived and when the QE was done; and the time spent processing
+	 * its results.
+	 */
+	instr_time sendTime;
+	instr_time firstResultTime;
+	instr_time finishTime;
+	instr_time processTime;
 } CdbDispatchResult;
 
 /*
@@ -155,6 +172,27 @@ typedef struct CdbDispatchResults
 	
 	/* num of slots in sliceMap */
 	int sliceCapacity;
+
+	/*
+	 * Dispatch timing, shown by EXPLAIN (ANALYZE, DISPATCH) and, if
+	 * saveStats is set, by the gp_stat_dispatch view.
+	 */
+	instr_time startTime;		/* when the results were set up */
+	instr_time flushTime;		/* waiting for the commands to be sent */
+	instr_time waitTime;		/* blocked waiting for QE results */
+	instr_time processTime;		/* reading and processing QE results */
+	int numWakeups;				/* waits that returned ready QEs */
+	bool saveStats;
+
+	/* only the key of the plan was sent, see cdbdisp_plancache.c */
+	bool planCached;
+
+	/*
+	 * With planCached, the serialized plan that was not sent, for a QE that
+	 * asks for it after all.  In DispatcherContext.
+	 */
+	char *cachedPlan;
+	int cachedPlanLen;
 } CdbDispatchResults;
 
 
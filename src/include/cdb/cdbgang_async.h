@@ -17,6 +17,9 @@
 
 #include "cdb/cdbgang.h"
 
+extern bool NeedGangPrewarm;
+
 extern Gang *cdbgang_createGang_async(List *segments, SegmentType segmentType);
+extern void cdbgang_prewarm(void);
 
 #endif
@@ -33,6 +33,8 @@ struct SliceTable;                          /* #include "nodes/execnodes.h" */
 struct EState;                              /* #include "nodes/execnodes.h" */
 /* TODO: move "src/backend/cdb/motion/ic_proxy_backend.h" into public include folder*/
 struct ICProxyBackendContext;
+/* #include "src/backend/cdb/motion/ic_shm.h" */
+struct ICShmRing;
 
 typedef struct icpkthdr
 {
@@ -283,6 +285,12 @@ struct MotionConn
 	int			pkt_q_tail;
 	uint8		**pkt_q;
 
+	/*
+	 * If the peer is on the same host, and gp_interconnect_local_shm is on,
+	 * the packets go through this shared-memory ring instead of UDP.
+	 */
+	struct ICShmRing *shmRing;
+
 	uint64 stat_total_ack_time;
 	uint64 stat_count_acks;
 	uint64 stat_max_ack_time;
@@ -344,6 +352,9 @@ typedef struct ChunkTransportStateEntry
 
 	bool		sendingEos;
 
+	/* number of connections that use a shared-memory ring */
+	int			numShmConns;
+
 	/* Statistics info for this motion on the interconnect level */
 	uint64 stat_total_ack_time;
 	uint64 stat_count_acks;
@@ -414,6 +425,13 @@ typedef struct MotionNodeEntry
 	 */
 	SerTupInfo      ser_tup_info;
 
+	/*
+	 * If ser_tup_info.batchSize > 0, the batches of tuples being accumulated
+	 * for each route, with the broadcast batch last.  Allocated on first use.
+	 */
+	TupleBatch    **send_batches;
+	int             num_send_batches;
+
 	/*
 	 * If preserve_order is false, this is used to hold completed tuples that
 	 * have not yet been consumed.  If preserve_order is true, this is NULL.
@@ -485,13 +503,13 @@ typedef struct MotionLayerState
 	/*
 	 * GLOBAL MOTION-LAYER STATISTICS
 	 */
-	uint32		stat_total_chunks_sent; /* Tuple-chunks sent. */
-	uint32		stat_total_bytes_sent;	/* Bytes sent, including headers. */
-	uint32		stat_tuple_bytes_sent;	/* Bytes of pure tuple-data sent. */
+	uint64		stat_total_chunks_sent; /* Tuple-chunks sent. */
+	uint64		stat_total_bytes_sent;	/* Bytes sent, including headers. */
+	uint64		stat_tuple_bytes_sent;	/* Bytes of pure tuple-data sent. */
 
-	uint32		stat_total_chunks_recvd;/* Tuple-chunks received. */
-	uint32		stat_total_bytes_recvd; /* Bytes received, including headers. */
-	uint32		stat_tuple_bytes_recvd; /* Bytes of pure tuple-data received. */
+	uint64		stat_total_chunks_recvd;/* Tuple-chunks received. */
+	uint64		stat_total_bytes_recvd; /* Bytes received, including headers. */
+	uint64		stat_tuple_bytes_recvd; /* Bytes of pure tuple-data received. */
 
 	uint32		stat_total_chunkproc_calls;		/* Calls to processIncomingChunks() */
 
@@ -52,7 +52,7 @@ extern MotionLayerState *createMotionLayerState(int maxMotNodeID);
 
 /* Initialization of each motion node in execution plan. */
 extern void UpdateMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool preserveOrder,
-								  TupleDesc tupDesc);
+								  bool compressTuples, int batchSize, TupleDesc tupDesc);
 
 /* Cleanup of each motion node in execution plan (normal termination). */
 extern void EndMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool flushCommLayer);
@@ -129,6 +129,20 @@ extern void SendStopMessage(MotionLayerState *mlStates,
 extern void UpdateMotionExpectedReceivers(MotionLayerState *mlStates,
 										  struct SliceTable *sliceTable);
 
+/*
+ * Get the total size of the tuples that a motion node compressed or
+ * decompressed so far, before and after compression.
+ */
+extern void GetMotionCompressionStats(MotionLayerState *mlStates, int16 motNodeID,
+									  uint64 *rawBytes, uint64 *compressedBytes);
+
+/*
+ * Get the number of tuple batches that a motion node sent or received so
+ * far, and the number of tuples in them.
+ */
+extern void GetMotionBatchStats(MotionLayerState *mlStates, int16 motNodeID,
+								uint64 *batches, uint64 *batchedTuples);
+
 /*
  * Return a pointer to the internal "end-of-stream" message
  */
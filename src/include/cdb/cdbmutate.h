@@ -34,6 +34,9 @@ extern Plan *make_explicit_motion(PlannerInfo *root,
 								  Plan *lefttree,
 								  AttrNumber segidColIdx);
 
+extern bool motion_compress_tuples(double rows, int width);
+extern int	motion_batch_size(int width);
+
 void 
 cdbmutate_warn_ctid_without_segid(struct PlannerInfo *root, struct RelOptInfo *rel);
 
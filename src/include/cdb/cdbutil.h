@@ -175,6 +175,7 @@ void cdbcomponent_cleanupIdleQEs(bool includeWriter);
 CdbComponentDatabaseInfo * cdbcomponent_getComponentInfo(int contentId);
 
 struct SegmentDatabaseDescriptor * cdbcomponent_allocateIdleQE(int contentId, SegmentType segmentType);
+struct SegmentDatabaseDescriptor * cdbcomponent_createIdleQE(int contentId);
 
 void cdbcomponent_recycleIdleQE(struct SegmentDatabaseDescriptor *segdbDesc, bool forceDestroy);
 
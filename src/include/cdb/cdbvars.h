@@ -254,6 +254,7 @@ extern int  gp_dtx_recovery_prepared_period;
 
 extern int gp_gang_creation_retry_count; /* How many retries ? */
 extern int gp_gang_creation_retry_timer; /* How long between retries */
+extern int gp_gang_prewarm_size; /* QEs per segment to connect ahead of time */
 
 /*
  * Parameter Gp_max_packet_size
@@ -355,6 +356,22 @@ extern bool gp_interconnect_log_stats;
 
 extern bool gp_interconnect_cache_future_packets;
 
+/*
+ * Parameter gp_interconnect_collect_stats
+ *
+ * Add the counters of every interconnect teardown to the cumulative
+ * interconnect statistics in shared memory, see AddInterconnectStats().
+ */
+extern bool gp_interconnect_collect_stats;
+
+/*
+ * Parameter gp_interconnect_local_shm
+ *
+ * Send the packets of UDP interconnect connections between processes on the
+ * same host through shared-memory rings, instead of through the kernel.
+ */
+extern bool gp_interconnect_local_shm;
+
 #define UNDEF_SEGMENT -2
 
 /*
@@ -464,6 +481,40 @@ extern int gp_log_interconnect;
  */
 extern double   gp_motion_cost_per_row;
 
+/*
+ * "gp_motion_compress_min_width"
+ *
+ * If >0, Motions whose estimated row width is at least this many bytes
+ * compress their tuples on the wire.  0 disables motion compression.
+ */
+extern int      gp_motion_compress_min_width;
+
+/*
+ * "gp_motion_batch_size"
+ *
+ * If >1, Motions of narrow rows pack up to this many tuples column-wise
+ * into one message.  0 sends tuples one at a time.
+ */
+extern int      gp_motion_batch_size;
+
+/*
+ * "gp_motion_skew_factor"
+ *
+ * If >0, a join key value whose share of the rows of a redistributed join
+ * input is more than this many times a segment's fair share is a heavy
+ * hitter.  Its rows are sprayed across the segments instead of hashed, and
+ * the matching rows of the other input are broadcast.  0 disables this.
+ */
+extern double   gp_motion_skew_factor;
+
+/*
+ * "gp_motion_merge_abbrev_min_senders"
+ *
+ * A sorted motion receiver uses abbreviated keys when it merges at least
+ * this many senders.  Only for testing, the default suits real clusters.
+ */
+extern int      gp_motion_merge_abbrev_min_senders;
+
 /*
  * "gp_segments_for_planner"
  *
@@ -502,8 +553,47 @@ extern bool gp_adjust_selectivity_for_outerjoins;
  * Target density for hash-node (HJ).
  */
 extern int gp_hashjoin_tuples_per_bucket;
+extern int gp_hashjoin_probe_batch_size;
 extern int gp_hashagg_groups_per_bucket;
 
+/*
+ * Let the first stage of a multi-stage hash aggregation emit its groups
+ * instead of spilling, and pass rows through if they don't group well.
+ */
+extern bool gp_hashagg_streambottom;
+extern double gp_hashagg_passthrough_ratio;
+
+/*
+ * Execute plain aggregates over sequential scans a batch of rows at a time,
+ * when the quals and aggregates are simple enough.
+ */
+extern bool gp_enable_vectorized_agg;
+
+/*
+ * Sort with a radix sort instead of quicksort, when the leading sort key is
+ * an integer-like value or abbreviated key.
+ */
+extern bool gp_enable_radix_sort;
+
+/*
+ * Evaluate window aggregates without an inverse transition function over a
+ * segment tree of transition states, when the frame start moves.
+ */
+extern bool gp_enable_window_segment_tree;
+
+/*
+ * Join and aggregate co-partitioned tables partition by partition, when the
+ * partitions can be processed in place without Motions, even if
+ * enable_partitionwise_join and enable_partitionwise_aggregate are off.
+ */
+extern bool gp_enable_colocated_partitionwise;
+
+/*
+ * Plan parallel scans, joins and partial aggregates under a Gather within a
+ * slice, so that each segment can use several processes for a query.
+ */
+extern bool gp_enable_intra_segment_parallel;
+
 /*
  * Damping of selectivities of clauses which pertain to the same base
  * relation; compensates for undetected correlation
@@ -611,6 +701,9 @@ extern int gp_segworker_relative_priority;
 /*  Max size of dispatched plans; 0 if no limit */
 extern int gp_max_plan_size;
 
+/* Let QEs cache dispatched plans, and send only a fingerprint for repeats */
+extern bool gp_dispatch_cache_plans;
+
 /* The default number of batches to use when the hybrid hashed aggregation
  * algorithm (re-)spills in-memory groups to disk.
  */
@@ -639,6 +732,13 @@ extern bool dml_ignore_target_partition_check;
 
 extern int gp_workfile_limit_per_segment;
 extern int gp_workfile_limit_per_query;
+extern int gp_workfile_buffer_size;
+
+/*
+ * Results of cross-slice ShareInputScans up to this size, in kB, are passed
+ * to the consumers in a DSM segment instead of a file.
+ */
+extern int gp_shareinput_inmem_size;
 extern int gp_workfile_limit_files_per_query;
 extern int gp_workfile_caching_loglevel;
 extern int gp_sessionstate_loglevel;
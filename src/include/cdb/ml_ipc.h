@@ -76,6 +76,43 @@ extern void CleanUpMotionLayerIPC(void);
  */
 extern void WaitInterconnectQuit(void);
 
+/*
+ * Cumulative interconnect statistics of all backends of this segment, since
+ * startup.  They are meant for benchmarking the interconnect, see
+ * src/test/modules/test_interconnect, and are only collected while
+ * gp_interconnect_collect_stats is on.  GetBackendInterconnectStats()
+ * returns the statistics of the current backend's interconnects alone.
+ *
+ * The CPU time is that of the backends while they had an interconnect set
+ * up, which includes the executor's work of producing and consuming the
+ * tuples.
+ */
+typedef struct InterconnectStats
+{
+	uint64		teardowns;		/* interconnects torn down */
+	uint64		chunksSent;		/* tuple chunks sent */
+	uint64		bytesSent;		/* tuple chunk bytes sent, with headers */
+	uint64		chunksRecvd;	/* tuple chunks received */
+	uint64		bytesRecvd;		/* tuple chunk bytes received */
+	uint64		pktsSent;		/* UDP data packets sent */
+	uint64		pktsRecvd;		/* UDP data packets received */
+	uint64		retransmits;	/* UDP data packets retransmitted */
+	uint64		crcErrors;		/* UDP packets with CRC errors */
+	uint64		duplicatedPkts; /* duplicate UDP packets received */
+	uint64		cpuUsecs;		/* CPU time, see above */
+	uint64		elapsedUsecs;	/* wall-clock time of the interconnects */
+} InterconnectStats;
+
+extern Size InterconnectStatsShmemSize(void);
+extern void InterconnectStatsShmemInit(void);
+extern void AddInterconnectStats(const InterconnectStats *stats);
+extern void GetInterconnectStats(InterconnectStats *stats);
+extern void GetBackendInterconnectStats(InterconnectStats *stats);
+
+/* registry of the shared-memory rings of motion connections, see ic_shm.c */
+extern Size InterconnectShmRingsShmemSize(void);
+extern void InterconnectShmRingsShmemInit(void);
+
 /*
  * checkForCancelFromQD
  * 		Check for cancel from QD.
@@ -18,6 +18,7 @@
 #include "cdb/tupchunklist.h"
 #include "lib/stringinfo.h"
 #include "cdb/tupleremap.h"
+#include "storage/gp_compress.h"
 
 
 typedef struct MotionConn MotionConn;
@@ -43,6 +44,27 @@ typedef struct SerAttrInfo
 	bool		typbyval;
 }	SerAttrInfo;
 
+/*
+ * A batch of tuples accumulated for one route, column by column, before it
+ * is sent as a single message.  See SerializeTupleBatch() for the format.
+ */
+typedef struct TupleBatchColumn
+{
+	bool		hasnulls;		/* any NULLs in this column? */
+	bits8	   *nullbitmap;		/* bit set = not null, like heap tuples */
+	char	   *values;			/* fixed-width: maxtuples * typlen bytes */
+	int32	   *offsets;		/* varlena: start offset of each value */
+	StringInfoData data;		/* varlena: the values, back to back */
+}	TupleBatchColumn;
+
+typedef struct TupleBatch
+{
+	int			ntuples;
+	int			maxtuples;
+	int			nbytes;			/* approximate serialized size */
+	TupleBatchColumn *columns;
+}	TupleBatch;
+
 /* The information for sending and receiving tuples that match a particular
  * description.
  */
@@ -60,6 +82,37 @@ typedef struct SerTupInfo
 
 	/* true if tupdesc contains record types */
 	bool		has_record_types;
+
+	/* Compress wide tuples on the wire?  Only used when sending. */
+	bool		compress;
+
+	/* Scratch space for compressed tuple bodies */
+	char	   *compressBuf;
+	int			compressBufLen;
+
+#ifdef USE_ZSTD
+	/* Compression/decompression handles, created on first use */
+	zstd_context *zstd;
+#endif
+
+	/* Sizes of the compressed tuples sent or received, for EXPLAIN ANALYZE */
+	uint64		rawBytes;
+	uint64		compressedBytes;
+
+	/*
+	 * If >0, send tuples in column-wise batches of up to this many tuples.
+	 * Only used when sending; any receiver can decode a batch.
+	 */
+	int			batchSize;
+
+	/* Tuples decoded from the last batch received, see CvtChunksToTup() */
+	MinimalTuple *recvTuples;
+	int			nrecvTuples;
+	int			recvTuplesLen;
+
+	/* Number of batches, and tuples in them, sent or received */
+	uint64		batches;
+	uint64		batchedTuples;
 }	SerTupInfo;
 
 /*
@@ -84,8 +137,21 @@ extern void SerializeRecordCacheIntoChunks(SerTupInfo *pSerInfo,
 /* Convert a tuple into chunks directly in a set of transport buffers */
 extern int SerializeTuple(TupleTableSlot *tuple, SerTupInfo *pSerInfo, struct directTransportBuffer *b, TupleChunkList tcList, int16 targetRoute);
 
+/* Can tuples of this description be sent in column-wise batches? */
+extern bool SerTupInfoCanBatch(SerTupInfo *pSerInfo);
+
+/* Create an empty batch of tuples of the given description */
+extern TupleBatch *CreateTupleBatch(SerTupInfo *pSerInfo);
+
+/* Add a tuple to a batch.  Returns true if the batch is now full. */
+extern bool AddTupleToBatch(TupleBatch *batch, TupleTableSlot *slot, SerTupInfo *pSerInfo);
+
+/* Convert a batch of tuples into chunks ready to send out, and empty it */
+extern void SerializeTupleBatch(TupleBatch *batch, SerTupInfo *pSerInfo, TupleChunkList tcList);
+
 /* Convert a sequence of chunks containing serialized tuple data into a
- * MinimalTuple.
+ * MinimalTuple.  If the chunks carry a batch of tuples, NULL is returned and
+ * the tuples are left in pSerInfo->recvTuples.
  */
 extern MinimalTuple CvtChunksToTup(TupleChunkList tclist, SerTupInfo *pSerInfo, TupleRemapper *remapper);
 
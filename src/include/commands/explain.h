@@ -35,6 +35,7 @@ typedef struct ExplainState
 	bool		buffers;		/* print buffer usage */
 	bool		dxl;			/* CDB: print DXL */
 	bool		slicetable;		/* CDB: print slice table */
+	bool		dispatch;		/* CDB: print dispatch timing */
 	bool		memory_detail;	/* CDB: print per-node memory usage */
 	bool		timing;			/* print detailed node timing */
 	bool		summary;		/* print total planning and execution timing */
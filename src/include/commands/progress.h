@@ -34,6 +34,15 @@
 #define PROGRESS_VACUUM_PHASE_TRUNCATE			5
 #define PROGRESS_VACUUM_PHASE_FINAL_CLEANUP		6
 
+/*
+ * GPDB: Phases of vacuum of append-optimized tables. For these, the heap_blks_*
+ * counters are measured in BLCKSZ units of segment file data (see
+ * vacuum_ao.c).
+ */
+#define PROGRESS_VACUUM_PHASE_AO_PRE_CLEANUP	7
+#define PROGRESS_VACUUM_PHASE_AO_COMPACT		8
+#define PROGRESS_VACUUM_PHASE_AO_POST_CLEANUP	9
+
 /* Progress parameters for cluster */
 #define PROGRESS_CLUSTER_COMMAND				0
 #define PROGRESS_CLUSTER_PHASE					1
@@ -0,0 +1,66 @@
+/*-------------------------------------------------------------------------
+ * execVector.h
+ *	  Batch-at-a-time execution of simple aggregates over sequential scans.
+ *
+ * Portions Copyright (c) 2012-Present VMware, Inc. or its affiliates.
+ *
+ * src/include/executor/execVector.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef EXECVECTOR_H
+#define EXECVECTOR_H
+
+#include "nodes/execnodes.h"
+
+/* Number of rows in a batch */
+#define VECTOR_BATCH_SIZE	1024
+
+/*
+ * Data type of a column vector. Integer and date values are kept as int64,
+ * and float8 values as double. VEC_ANY is a column whose values aren't
+ * needed, only whether they are NULL.
+ */
+typedef enum VecType
+{
+	VEC_INT4,
+	VEC_INT8,
+	VEC_FLOAT8,
+	VEC_ANY
+} VecType;
+
+/*
+ * A column vector: the values of one column or expression for each row of
+ * a batch. Only the entries of rows in the batch's selection vector are
+ * valid.
+ */
+typedef struct VecColumn
+{
+	VecType		type;
+	int64	   *ivalues;		/* VEC_INT4 and VEC_INT8 */
+	double	   *fvalues;		/* VEC_FLOAT8 */
+	bool	   *isnull;
+} VecColumn;
+
+/*
+ * A batch of up to VECTOR_BATCH_SIZE rows, in column-major format. The
+ * selection vector lists the rows that passed the quals.
+ */
+typedef struct VectorBatch
+{
+	int			ncolumns;
+	VecColumn  *columns;
+	AttrNumber *attnums;		/* table column of each vector */
+	int			nrows;
+	int			nselected;
+	uint16	   *selection;
+} VectorBatch;
+
+typedef struct VectorAggState VectorAggState;
+
+extern VectorAggState *ExecInitVectorAgg(AggState *aggstate);
+extern bool ExecVectorAggFetchBatch(VectorAggState *vstate);
+extern void ExecVectorAggAdvance(VectorAggState *vstate,
+								 AggStatePerGroup pergroup);
+
+#endif							/* EXECVECTOR_H */
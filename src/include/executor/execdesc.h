@@ -159,6 +159,8 @@ typedef struct SliceTable
 
 	int			instrument_options;	/* OR of InstrumentOption flags */
 	uint32		ic_instance_id;
+	uint64		ic_shm_nonce;	/* random part of the names of the
+								 * interconnect shared-memory rings */
 } SliceTable;
 
 
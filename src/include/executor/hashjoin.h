@@ -87,6 +87,30 @@ typedef struct HashJoinTupleData
 #define HJTUPLE_MINTUPLE(hjtup)  \
 	((MinimalTuple) ((char *) (hjtup) + HJTUPLE_OVERHEAD))
 
+/*
+ * GPDB: Each bucket of a private (non-parallel) hash table has a 16-bit tag
+ * next to it in the bucket directory. Each tuple in the bucket sets one bit
+ * of the tag, chosen by the top four bits of its hash value. A probe whose
+ * bit isn't set in the tag can't match any tuple in the bucket, and skips
+ * the walk through its chain, which would likely miss the cache on every
+ * tuple.
+ *
+ * The top bits of the hash value are used, because the low bits pick the
+ * bucket and the next ones the batch. In a join with enough buckets and
+ * batches to reach the top bits, all tuples of a batch agree on some of
+ * those bits, which makes the tags less selective but still correct.
+ */
+typedef uint16 HashJoinBucketTag;
+
+#define HJ_BUCKET_TAG(hashvalue)	((HashJoinBucketTag) (1 << ((hashvalue) >> 28)))
+
+/* Hint the CPU to start loading a cache line, if the compiler supports it */
+#if defined(__GNUC__)
+#define HJ_PREFETCH(addr)	__builtin_prefetch(addr)
+#else
+#define HJ_PREFETCH(addr)	((void) 0)
+#endif
+
 /*
  * If the outer relation's distribution is sufficiently nonuniform, we attempt
  * to optimize the join by treating the hash values corresponding to the outer
@@ -335,6 +359,9 @@ typedef struct HashJoinTableData
 		dsa_pointer_atomic *shared;
 	}			buckets;
 
+	/* GPDB: tag of each bucket, for private hash tables only */
+	HashJoinBucketTag *bucketTags;
+
 	bool		keepNulls;		/* true to store unmatchable NULL tuples */
 
 	bool		skewEnabled;	/* are we using skew optimization? */
@@ -38,6 +38,19 @@ typedef struct BufferUsage
 	instr_time	blk_write_time; /* time spent writing */
 } BufferUsage;
 
+/*
+ * GPDB: I/O on workfiles (BufFiles used to spill to disk). Unlike
+ * BufferUsage, this is attributed to the plan node that does the I/O only,
+ * not to its ancestors.
+ */
+typedef struct WorkfileUsage
+{
+	int64		bytes_written;	/* # of bytes written to workfiles */
+	int64		bytes_read;		/* # of bytes read from workfiles */
+	instr_time	write_time;		/* time spent writing */
+	instr_time	read_time;		/* time spent reading */
+} WorkfileUsage;
+
 /* Flag bits included in InstrAlloc's instrument_options bitmask */
 typedef enum InstrumentOption
 {
@@ -85,6 +98,8 @@ typedef struct Instrumentation
 	const char *sortMethod;		/* CDB: Type of sort */
 	const char *sortSpaceType;	/* CDB: Sort space type (Memory / Disk) */
 	long		sortSpaceUsed;	/* CDB: Memory / Disk used by sort(KBytes) */
+	WorkfileUsage workfileusage_start;	/* CDB: workfile I/O at start */
+	WorkfileUsage workfileusage;	/* CDB: workfile I/O done by this node */
 	struct CdbExplain_NodeSummary *cdbNodeSummary;	/* stats from all qExecs */
 } Instrumentation;
 
@@ -95,6 +110,7 @@ typedef struct WorkerInstrumentation
 } WorkerInstrumentation;
 
 extern PGDLLIMPORT BufferUsage pgBufferUsage;
+extern PGDLLIMPORT WorkfileUsage pgWorkfileUsage;
 
 extern Instrumentation *InstrAlloc(int n, int instrument_options);
 extern void InstrInit(Instrumentation *instr, int instrument_options);
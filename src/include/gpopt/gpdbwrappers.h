@@ -341,6 +341,12 @@ char *GetTypeName(Oid typid);
 // number of GP segments
 int GetGPSegmentCount(void);
 
+// should a motion of the given rows and width compress its tuples
+bool MotionCompressTuples(double rows, int width);
+
+// number of tuples a motion of the given width should send in one batch
+int MotionBatchSize(int width);
+
 // heap attribute is null
 bool HeapAttIsNull(HeapTuple tup, int attnum);
 
@@ -2156,6 +2156,17 @@ typedef struct HashJoinState
 	/* set if the operator created workfiles */
 	bool workfiles_created;
 	bool reuse_hashtable; /* Do we need to preserve hash table to support rescan */
+
+	/*
+	 * GPDB: outer tuples of the first batch fetched ahead, so that their
+	 * buckets can be prefetched before they are probed.
+	 */
+	int			hj_ProbeBatchSize;	/* 0 if not fetching ahead */
+	TupleTableSlot **hj_ProbeSlots;
+	uint32	   *hj_ProbeHashValues;
+	int			hj_ProbeCount;	/* # of tuples fetched ahead */
+	int			hj_ProbeNext;	/* next one to return */
+	bool		hj_ProbeOuterDone;	/* outer plan returned NULL */
 } HashJoinState;
 
 
@@ -2345,6 +2356,26 @@ typedef struct AggState
 
 	/* if input tuple has an AggExprId, save the Attribute Number */
 	Index       AggExprId_AttrNum;
+
+	/*
+	 * GPDB: "streaming bottom" of a multi-stage hash aggregation. Instead of
+	 * spilling, the hash table is emitted whenever it fills up, and if the
+	 * groups don't reduce the input much, the remaining input rows are
+	 * passed through as groups of one.
+	 */
+	bool		hash_streaming;	/* emit groups early instead of spilling */
+	bool		hash_stream_full;	/* hit the memory limit, emit the groups */
+	bool		hash_passthrough;	/* pass each input row through */
+	AggStatePerGroup hash_passthrough_pergroup; /* transition states for the
+												 * passed-through row */
+	uint64		hash_stream_input;	/* input rows since the table was emptied */
+	uint64		hash_stream_total_input;	/* input rows in total */
+	uint64		hash_stream_groups;	/* groups emitted early */
+	int			hash_stream_flushes;	/* times the table was emitted early */
+	uint64		hash_passthrough_rows;	/* rows passed through */
+
+	/* GPDB: batch-at-a-time execution, NULL if not vectorized */
+	struct VectorAggState *vecstate;
 } AggState;
 
 typedef struct TupleSplitState
@@ -2735,18 +2766,25 @@ typedef struct MotionState
 	List	   *hashExprs;		/* state struct used for evaluating the hash expressions */
 	struct CdbHash *cdbhash;	/* hash api object */
 	int			numHashSegments;	/* number of segments to use when calculating hash */
+	uint32	   *hotKeyHashes;	/* cdbhash() values of heavy hitters */
+	int			numHotKeyHashes;
+	int			nextSprayRoute;	/* next route for a sprayed heavy hitter */
 
 	/* For Motion recv */
 	int			routeIdNext;	/* for a sorted motion node, the routeId to get next (same as
 								 * the routeId last returned ) */
-	bool		tupleheapReady; /* for a sorted motion node, false until we have a tuple from
+	bool		mergeReady;		/* for a sorted motion node, false until we have a tuple from
 								 * each source segindex */
 
 	/* For sorted Motion recv */
 	int			numSortCols;
 	SortSupport sortKeys;
 	TupleTableSlot **slots;
-	struct binaryheap *tupleheap; /* binary heap of slot indices */
+	int		   *loserTree;		/* loser tree of slot indices */
+	bool	   *mergeDone;		/* per slot: has the sender reached EOS? */
+	Datum	   *mergeAbbrevKeys;	/* per slot: abbreviated first key */
+	int64		mergeAbbrevNext;	/* tuple # at which to next check
+									 * abbreviation */
 	int			lastSortColIdx;
 
 	/* The following can be used for debugging, usage stats, etc.  */
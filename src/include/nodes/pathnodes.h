@@ -1608,6 +1608,10 @@ typedef struct CdbMotionPath
 	bool		is_explicit_motion;
 
 	GpPolicy   *policy;
+
+	/* for a redistribute of a skewed join input, see cdbpath_skew_hot_keys() */
+	List	   *hotKeyHashes;
+	bool		broadcastHotKeys;
 } CdbMotionPath;
 
 /*
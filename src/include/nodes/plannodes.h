@@ -1329,12 +1329,16 @@ typedef struct Motion
 
 	MotionType  motionType;
 	bool		sendSorted;			/* if true, output should be sorted */
+	bool		compressTuples;		/* if true, compress wide tuples on the wire */
+	int			batchSize;			/* if >0, send tuples in column-wise batches */
 	int			motionID;			/* required by AMS  */
 
 	/* For Hash */
 	List		*hashExprs;			/* list of hash expressions */
 	Oid			*hashFuncs;			/* corresponding hash functions */
 	int         numHashSegments;	/* the module number of the hash function */
+	List	   *hotKeyHashes;		/* cdbhash() values of heavy hitters */
+	bool		broadcastHotKeys;	/* broadcast heavy hitters, or spray them? */
 
 	/* For Explicit */
 	AttrNumber segidColIdx;			/* index of the segid column in the target list */
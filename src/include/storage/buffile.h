@@ -37,6 +37,21 @@ typedef struct BufFile BufFile;
 
 struct workfile_set;
 
+/* Values of gp_workfile_compression */
+typedef enum WorkfileCompression
+{
+	WORKFILE_COMPRESSION_NONE = 0,
+	WORKFILE_COMPRESSION_ZSTD,
+	WORKFILE_COMPRESSION_LZ4
+} WorkfileCompression;
+
+/* The method that gp_workfile_compression=on stands for */
+#if defined(HAVE_LIBLZ4) && !defined(USE_ZSTD)
+#define WORKFILE_COMPRESSION_DEFAULT WORKFILE_COMPRESSION_LZ4
+#else
+#define WORKFILE_COMPRESSION_DEFAULT WORKFILE_COMPRESSION_ZSTD
+#endif
+
 /*
  * prototypes for functions in buffile.c
  */
@@ -65,8 +80,9 @@ extern const char *BufFileGetFilename(BufFile *buffile);
 extern void BufFileSuspend(BufFile *buffile);
 extern void BufFileResume(BufFile *buffile);
 
-extern bool gp_workfile_compression;
+extern int	gp_workfile_compression;
 extern void BufFilePledgeSequential(BufFile *buffile);
+extern void BufFileSetBufferSize(BufFile *buffile, Size bufsize);
 extern void BufFileSetIsTempFile(BufFile *file, bool isTempFile);
 
 #endif							/* BUFFILE_H */
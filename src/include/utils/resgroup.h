@@ -167,6 +167,7 @@ extern bool ShouldUnassignResGroup(void);
 extern void AssignResGroupOnMaster(void);
 extern void UnassignResGroup(bool releaseSlot);
 extern void SwitchResGroupOnSegment(const char *buf, int len);
+extern void ResGroupAssignParallelWorker(const char *buf, int len);
 
 extern bool ResGroupIsAssigned(void);
 
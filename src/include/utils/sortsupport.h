@@ -273,4 +273,16 @@ extern void PrepareSortSupportFromOrderingOp(Oid orderingOp, SortSupport ssup);
 extern void PrepareSortSupportFromIndexRel(Relation indexRel, int16 strategy,
 										   SortSupport ssup);
 
+/*
+ * Comparators for datatypes whose Datums (or abbreviated keys) compare like
+ * plain integers.  Datatypes should use these rather than equivalent
+ * comparators of their own, because tuplesort.c recognizes them, and can
+ * sort such keys with a radix sort instead of comparisons.
+ */
+extern int	ssup_datum_unsigned_cmp(Datum x, Datum y, SortSupport ssup);
+#ifdef USE_FLOAT8_BYVAL
+extern int	ssup_datum_signed_cmp(Datum x, Datum y, SortSupport ssup);
+#endif
+extern int	ssup_datum_int32_cmp(Datum x, Datum y, SortSupport ssup);
+
 #endif							/* SORTSUPPORT_H */
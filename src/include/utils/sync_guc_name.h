@@ -17,18 +17,26 @@
 		"gp_debug_linger",
 		"gp_default_storage_options",
 		"gp_disable_tuple_hints",
+		"gp_enable_radix_sort",
 		"gp_enable_segment_copy_checking",
+		"gp_enable_vectorized_agg",
+		"gp_enable_window_segment_tree",
 		"gp_external_enable_filter_pushdown",
 		"gp_hashagg_default_nbatches",
 		"gp_hashagg_groups_per_bucket",
+		"gp_hashagg_passthrough_ratio",
+		"gp_hashagg_streambottom",
+		"gp_hashjoin_probe_batch_size",
 		"gp_hashjoin_tuples_per_bucket",
 		"gp_ignore_error_table",
 		"gp_indexcheck_insert",
 		"gp_initial_bad_row_limit",
 		"gp_interconnect_debug_retry_interval",
+		"gp_interconnect_collect_stats",
 		"gp_interconnect_default_rtt",
 		"gp_interconnect_fc_method",
 		"gp_interconnect_full_crc",
+		"gp_interconnect_local_shm",
 		"gp_interconnect_log_stats",
 		"gp_interconnect_min_retries_before_timeout",
 		"gp_interconnect_min_rto",
@@ -47,6 +55,7 @@
 		"gp_log_stack_trace_lines",
 		"gp_max_packet_size",
 		"gp_max_slices",
+		"gp_motion_merge_abbrev_min_senders",
 		"gp_motion_slice_noop",
 		"gp_resgroup_memory_policy_auto_fixed_mem",
 		"gp_resgroup_print_operator_memory_limits",
@@ -54,6 +63,7 @@
 		"gp_resqueue_print_operator_memory_limits",
 		"gp_select_invisible",
 		"gp_sessionstate_loglevel",
+		"gp_shareinput_inmem_size",
 		"gp_snapshotadd_timeout",
 		"gp_udp_bufsize_k",
 		"gp_udpic_dropacks_percent",
@@ -63,6 +73,7 @@
 		"gp_udpic_fault_inject_percent",
 		"gp_udpic_network_disable_ipv6",
 		"gp_vmem_idle_resource_timeout",
+		"gp_workfile_buffer_size",
 		"gp_workfile_caching_loglevel",
 		"gp_workfile_compression",
 		"gp_workfile_limit_files_per_query",
@@ -89,12 +100,14 @@
 		"log_min_messages",
 		"log_statement_stats",
 		"maintenance_work_mem",
+		"max_parallel_maintenance_workers",
 		"max_parallel_workers_per_gather",
 		"max_statement_mem",
 		"memory_profiler_dataset_id",
 		"memory_profiler_dataset_size",
 		"memory_profiler_query_id",
 		"memory_profiler_run_id",
+		"min_parallel_table_scan_size",
 		"optimize_bounded_sort",
 		"optimizer_cte_inlining_bound",
 		"optimizer_mdcache_size",
@@ -167,6 +167,7 @@
 		"gp_dbid",
 		"gp_debug_pgproc",
 		"gp_debug_resqueue_priority",
+		"gp_dispatch_cache_plans",
 		"gp_distinct_grouping_sets_threshold",
 		"gp_dtx_recovery_interval",
 		"gp_dtx_recovery_prepared_period",
@@ -174,6 +175,7 @@
 		"gp_eager_two_phase_agg",
 		"gp_enable_agg_distinct",
 		"gp_enable_agg_distinct_pruning",
+		"gp_enable_colocated_partitionwise",
 		"gp_enable_direct_dispatch",
 		"gp_enable_explain_allstat",
 		"gp_enable_fast_sri",
@@ -181,6 +183,7 @@
 		"gp_enable_groupext_distinct_gather",
 		"gp_enable_groupext_distinct_pruning",
 		"gp_enable_hashjoin_size_heuristic",
+		"gp_enable_intra_segment_parallel",
 		"gp_enable_interconnect_aggressive_retry",
 		"gp_enable_minmax_optimization",
 		"gp_enable_motion_deadlock_sanity",
@@ -202,6 +205,7 @@
 		"gp_fts_replication_attempt_count",
 		"gp_gang_creation_retry_count",
 		"gp_gang_creation_retry_timer",
+		"gp_gang_prewarm_size",
 		"gp_global_deadlock_detector_period",
 		"gp_gxid_prefetch_num",
 		"gp_heap_require_relhasoids_match",
@@ -217,7 +221,10 @@
 		"gp_maintenance_conn",
 		"gp_max_local_distributed_cache",
 		"gp_max_plan_size",
+		"gp_motion_batch_size",
+		"gp_motion_compress_min_width",
 		"gp_motion_cost_per_row",
+		"gp_motion_skew_factor",
 		"gp_qd_hostname",
 		"gp_qd_port",
 		"gp_recursive_cte",
@@ -320,7 +327,6 @@
 		"max_index_keys",
 		"max_locks_per_transaction",
 		"max_logical_replication_workers",
-		"max_parallel_maintenance_workers",
 		"max_parallel_workers",
 		"max_pred_locks_per_page",
 		"max_pred_locks_per_relation",
@@ -338,7 +344,6 @@
 		"max_worker_processes",
 		"memory_spill_ratio",
 		"min_parallel_index_scan_size",
-		"min_parallel_table_scan_size",
 		"min_wal_size",
 		"old_snapshot_threshold",
 		"operator_precedence_warning",
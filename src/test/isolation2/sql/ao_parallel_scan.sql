@@ -0,0 +1,55 @@
+-- Parallel scans and index builds of append-optimized tables, split by
+-- segment file.
+
+CREATE TABLE par_scan_ao (a int, b int) WITH (appendonly=true) DISTRIBUTED BY (a);
+CREATE TABLE par_scan_aocs (a int, b int) WITH (appendonly=true, orientation=column) DISTRIBUTED BY (a);
+
+-- Concurrent inserts write to different segment files.
+1: BEGIN;
+2: BEGIN;
+3: BEGIN;
+1: INSERT INTO par_scan_ao SELECT i, i % 10 FROM generate_series(1, 30000) i;
+2: INSERT INTO par_scan_ao SELECT i, i % 10 FROM generate_series(30001, 60000) i;
+3: INSERT INTO par_scan_ao SELECT i, i % 10 FROM generate_series(60001, 90000) i;
+1: INSERT INTO par_scan_aocs SELECT i, i % 10 FROM generate_series(1, 30000) i;
+2: INSERT INTO par_scan_aocs SELECT i, i % 10 FROM generate_series(30001, 60000) i;
+3: INSERT INTO par_scan_aocs SELECT i, i % 10 FROM generate_series(60001, 90000) i;
+1: COMMIT;
+2: COMMIT;
+3: COMMIT;
+ANALYZE par_scan_ao;
+ANALYZE par_scan_aocs;
+
+SELECT segno, sum(tupcount) FROM gp_toolkit.__gp_aoseg('par_scan_ao') GROUP BY segno ORDER BY segno;
+SELECT segno, sum(tupcount) FROM gp_toolkit.__gp_aocsseg('par_scan_aocs') WHERE column_num = 0 GROUP BY segno ORDER BY segno;
+
+-- Every row is returned exactly once, whichever participant reads its
+-- segment file.
+1: SET optimizer = off;
+1: SET gp_enable_intra_segment_parallel = on;
+1: SET parallel_setup_cost = 0;
+1: SET parallel_tuple_cost = 0;
+1: SET min_parallel_table_scan_size = 0;
+1: SET max_parallel_workers_per_gather = 2;
+1: EXPLAIN (COSTS OFF) SELECT count(*), sum(a), sum(b) FROM par_scan_ao;
+1: SELECT count(*), sum(a), sum(b) FROM par_scan_ao;
+1: EXPLAIN (COSTS OFF) SELECT count(*), sum(a), sum(b) FROM par_scan_aocs;
+1: SELECT count(*), sum(a), sum(b) FROM par_scan_aocs;
+
+-- Once the block directory has been filled in by the first index, CREATE
+-- INDEX builds in parallel on the segments. Each participant indexes the
+-- segment files it claims.
+1: SET max_parallel_maintenance_workers = 2;
+1: SET maintenance_work_mem = '256MB';
+1: CREATE INDEX par_scan_ao_a ON par_scan_ao (a);
+1: CREATE INDEX par_scan_ao_b ON par_scan_ao (b);
+1: CREATE INDEX par_scan_aocs_a ON par_scan_aocs (a);
+1: CREATE INDEX par_scan_aocs_b ON par_scan_aocs (b);
+2: SET enable_seqscan = off;
+2: SELECT count(*), sum(a) FROM par_scan_ao WHERE b = 3;
+2: SELECT count(*) FROM par_scan_ao WHERE a BETWEEN 1000 AND 1999;
+2: SELECT count(*), sum(a) FROM par_scan_aocs WHERE b = 3;
+2: SELECT count(*) FROM par_scan_aocs WHERE a BETWEEN 1000 AND 1999;
+
+DROP TABLE par_scan_ao;
+DROP TABLE par_scan_aocs;
@@ -0,0 +1,31 @@
+-- Parallel workers within a segment must see the same rows as their leader
+-- QE, which depends on the distributed snapshot and not only on the local
+-- one.
+
+CREATE TABLE par_dsnap (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO par_dsnap SELECT i, i FROM generate_series(1, 100000) i;
+ANALYZE par_dsnap;
+
+1: SET optimizer = off;
+1: SET gp_enable_intra_segment_parallel = on;
+1: SET parallel_setup_cost = 0;
+1: SET parallel_tuple_cost = 0;
+1: SET min_parallel_table_scan_size = 0;
+1: SET max_parallel_workers_per_gather = 2;
+1: EXPLAIN (COSTS OFF) SELECT count(*) FROM par_dsnap;
+
+-- The rows of a concurrent transaction are invisible until it commits.
+2: BEGIN;
+2: INSERT INTO par_dsnap SELECT i, i FROM generate_series(100001, 101000) i;
+1: SELECT count(*) FROM par_dsnap;
+
+-- A repeatable read transaction keeps its distributed snapshot, so rows
+-- committed after it was taken stay invisible to the workers too.
+1: BEGIN ISOLATION LEVEL REPEATABLE READ;
+1: SELECT count(*) FROM par_dsnap;
+2: COMMIT;
+1: SELECT count(*) FROM par_dsnap;
+1: COMMIT;
+1: SELECT count(*) FROM par_dsnap;
+
+DROP TABLE par_dsnap;
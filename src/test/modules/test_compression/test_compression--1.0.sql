@@ -0,0 +1,54 @@
+/* src/test/modules/test_compression/test_compression--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_compression" to load this file. \quit
+
+CREATE FUNCTION compression_benchmark(rel regclass,
+	compresstype text,
+	compresslevel int4 DEFAULT 1,
+	blocksize int4 DEFAULT 32768,
+	loops int4 DEFAULT 10,
+	OUT segid int4,
+	OUT attname name,
+	OUT nblocks int8,
+	OUT raw_bytes int8,
+	OUT compressed_bytes int8,
+	OUT ratio float8,
+	OUT compress_mb_per_sec float8,
+	OUT decompress_mb_per_sec float8)
+RETURNS SETOF record STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C
+EXECUTE ON ALL SEGMENTS;
+
+-- Run the benchmark with every block compressor in pg_compression, and sum
+-- up the results of all segments.
+CREATE FUNCTION compression_benchmark_all(rel regclass,
+	blocksize int4 DEFAULT 32768,
+	loops int4 DEFAULT 10,
+	OUT compresstype name,
+	OUT attname name,
+	OUT raw_bytes numeric,
+	OUT compressed_bytes numeric,
+	OUT ratio float8,
+	OUT compress_mb_per_sec float8,
+	OUT decompress_mb_per_sec float8)
+RETURNS SETOF record STRICT
+AS $$
+DECLARE
+	comp name;
+BEGIN
+	FOR comp IN SELECT compname FROM pg_catalog.pg_compression
+				WHERE compname NOT IN ('none', 'rle_type')
+				ORDER BY compname
+	LOOP
+		RETURN QUERY
+			SELECT comp, b.attname,
+				   sum(b.raw_bytes), sum(b.compressed_bytes),
+				   (sum(b.raw_bytes) / greatest(sum(b.compressed_bytes), 1))::float8,
+				   avg(b.compress_mb_per_sec), avg(b.decompress_mb_per_sec)
+			FROM compression_benchmark(rel, comp, 1, blocksize, loops) b
+			GROUP BY b.attname
+			ORDER BY b.attname;
+	END LOOP;
+END;
+$$ LANGUAGE plpgsql;
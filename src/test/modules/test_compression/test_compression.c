@@ -0,0 +1,403 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_compression.c
+ *		Benchmark the append-optimized storage block compressors.
+ *
+ * The data to compress is taken from an existing table, and packed into
+ * datum stream blocks the same way as an AOCS table with the same columns
+ * would store it, so that the measurements reflect what the compressors see
+ * when they compress the blocks of a real column-oriented table.
+ *
+ * Portions Copyright (c) 2026-Present VMware, Inc. or its affiliates.
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_compression/test_compression.c
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/table.h"
+#include "access/tableam.h"
+#include "catalog/pg_compression.h"
+#include "cdb/cdbappendonlyam.h"
+#include "cdb/cdbvars.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "portability/instr_time.h"
+#include "storage/gp_compress.h"
+#include "utils/builtins.h"
+#include "utils/datumstream.h"
+#include "utils/datumstreamblock.h"
+#include "utils/lsyscache.h"
+#include "utils/rel.h"
+#include "utils/snapmgr.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(compression_benchmark);
+
+/*
+ * Don't collect more than this many bytes of blocks per column, to keep the
+ * memory usage in check with big tables.
+ */
+#define MAX_BYTES_PER_COLUMN	(64 * 1024 * 1024)
+
+#define COMPRESSION_BENCHMARK_COLS	8
+
+/* The datum stream blocks collected for one column. */
+typedef struct ColumnBlocks
+{
+	DatumStreamTypeInfo typeInfo;
+	DatumStreamBlockWrite blockWrite;
+
+	uint8	  **blocks;
+	int32	   *blockLens;
+	int			nblocks;
+	int			maxblocks;
+	int64		totalBytes;
+	bool		full;			/* reached MAX_BYTES_PER_COLUMN? */
+} ColumnBlocks;
+
+static int
+benchmark_errcallback(void *arg)
+{
+	return 0;
+}
+
+static void
+add_block(ColumnBlocks *col, int32 blocksize)
+{
+	uint8	   *buffer = palloc(blocksize);
+	int64		len;
+
+	len = DatumStreamBlockWrite_Block(&col->blockWrite, buffer);
+	DatumStreamBlockWrite_GetReady(&col->blockWrite);
+
+	if (col->nblocks == col->maxblocks)
+	{
+		col->maxblocks *= 2;
+		col->blocks = repalloc(col->blocks, col->maxblocks * sizeof(uint8 *));
+		col->blockLens = repalloc(col->blockLens, col->maxblocks * sizeof(int32));
+	}
+	col->blocks[col->nblocks] = buffer;
+	col->blockLens[col->nblocks] = (int32) len;
+	col->nblocks++;
+	col->totalBytes += len;
+
+	if (col->totalBytes >= MAX_BYTES_PER_COLUMN)
+		col->full = true;
+}
+
+/*
+ * Pack the values of every column of 'rel' into datum stream blocks.
+ *
+ * Like for AOCS tables, datums that don't fit in a block by themselves are
+ * stored as large objects, which are left out here.
+ */
+static ColumnBlocks *
+collect_blocks(Relation rel, int32 blocksize)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	int			natts = tupdesc->natts;
+	ColumnBlocks *cols = palloc0(natts * sizeof(ColumnBlocks));
+	int32		maxDataBlockSize;
+	TableScanDesc scan;
+	TupleTableSlot *slot;
+	int			ncolsfull = 0;
+
+	maxDataBlockSize = blocksize - AoHeader_Size(false /* isLong */ ,
+												 true /* hasChecksum */ ,
+												 true /* hasFirstRowNum */ );
+
+	for (int i = 0; i < natts; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+		ColumnBlocks *col = &cols[i];
+
+		col->typeInfo.datumlen = attr->attlen;
+		col->typeInfo.typid = attr->atttypid;
+		col->typeInfo.align = attr->attalign;
+		col->typeInfo.byval = attr->attbyval;
+
+		DatumStreamBlockWrite_Init(&col->blockWrite,
+								   &col->typeInfo,
+								   DatumStreamVersion_Original,
+								   false /* rle_want_compression */ ,
+								   false /* delta_want_compression */ ,
+								   MAXDATUM_PER_AOCS_ORIG_BLOCK,
+								   MAXDATUM_PER_AOCS_ORIG_BLOCK,
+								   maxDataBlockSize,
+								   benchmark_errcallback, NULL,
+								   benchmark_errcallback, NULL);
+
+		col->maxblocks = 64;
+		col->blocks = palloc(col->maxblocks * sizeof(uint8 *));
+		col->blockLens = palloc(col->maxblocks * sizeof(int32));
+
+		if (attr->attisdropped)
+		{
+			col->full = true;
+			ncolsfull++;
+		}
+	}
+
+	slot = table_slot_create(rel, NULL);
+	scan = table_beginscan(rel, GetActiveSnapshot(), 0, NULL);
+
+	while (ncolsfull < natts &&
+		   table_scan_getnextslot(scan, ForwardScanDirection, slot))
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		slot_getallattrs(slot);
+
+		for (int i = 0; i < natts; i++)
+		{
+			ColumnBlocks *col = &cols[i];
+			void	   *toFree;
+			int			err;
+
+			if (col->full)
+				continue;
+
+			err = DatumStreamBlockWrite_Put(&col->blockWrite,
+											slot->tts_values[i],
+											slot->tts_isnull[i],
+											&toFree);
+			if (err < 0)
+			{
+				Datum		datum = slot->tts_values[i];
+
+				if (toFree != NULL)
+					datum = PointerGetDatum(toFree);
+
+				if (DatumStreamBlockWrite_Nth(&col->blockWrite) > 0)
+					add_block(col, blocksize);
+
+				if (!col->full)
+				{
+					void	   *toFree2;
+
+					/* If it still doesn't fit, it's a large object. */
+					(void) DatumStreamBlockWrite_Put(&col->blockWrite,
+													 datum,
+													 slot->tts_isnull[i],
+													 &toFree2);
+					Assert(toFree2 == NULL);
+				}
+			}
+			if (toFree != NULL)
+				pfree(toFree);
+
+			if (col->full)
+				ncolsfull++;
+		}
+	}
+
+	table_endscan(scan);
+	ExecDropSingleTupleTableSlot(slot);
+
+	for (int i = 0; i < natts; i++)
+	{
+		ColumnBlocks *col = &cols[i];
+
+		if (!col->full && DatumStreamBlockWrite_Nth(&col->blockWrite) > 0)
+			add_block(col, blocksize);
+		DatumStreamBlockWrite_Finish(&col->blockWrite);
+	}
+
+	return cols;
+}
+
+static double
+mb_per_sec(int64 bytes, instr_time elapsed)
+{
+	double		secs = INSTR_TIME_GET_DOUBLE(elapsed);
+
+	if (secs <= 0)
+		return 0;
+	return (double) bytes / (1024.0 * 1024.0) / secs;
+}
+
+/*
+ * compression_benchmark(rel, compresstype, compresslevel, blocksize, loops)
+ *
+ * Compresses and decompresses the datum stream blocks of every column of
+ * 'rel' 'loops' times, and returns the compression ratio and the compression
+ * and decompression throughput of each column, on each segment.
+ *
+ * As in AO tables, a block whose compressed size isn't smaller than its
+ * uncompressed size is stored uncompressed, and not decompressed.
+ */
+Datum
+compression_benchmark(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	char	   *compresstype = text_to_cstring(PG_GETARG_TEXT_PP(1));
+	int32		compresslevel = PG_GETARG_INT32(2);
+	int32		blocksize = PG_GETARG_INT32(3);
+	int32		loops = PG_GETARG_INT32(4);
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext oldcontext;
+	PGFunction *compfuncs;
+	CompressionState *compressState;
+	CompressionState *decompressState;
+	StorageAttributes sa;
+	Relation	rel;
+	ColumnBlocks *cols;
+	uint8	   *compressed;
+	uint8	   *decompressed;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not allowed in this context")));
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	if (blocksize < MIN_APPENDONLY_BLOCK_SIZE ||
+		blocksize > MAX_APPENDONLY_BLOCK_SIZE ||
+		blocksize % MIN_APPENDONLY_BLOCK_SIZE != 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("block size must be between 8KB and 2MB and be an 8KB multiple, got %d", blocksize)));
+	if (loops < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("loops must be at least 1")));
+
+	compfuncs = GetCompressionImplementation(compresstype);
+
+	oldcontext = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+	MemoryContextSwitchTo(oldcontext);
+
+	rel = table_open(relid, AccessShareLock);
+	cols = collect_blocks(rel, blocksize);
+
+	sa.comptype = compresstype;
+	sa.complevel = compresslevel;
+	sa.blocksize = blocksize;
+	sa.typid = InvalidOid;
+	compressState = callCompressionConstructor(compfuncs[COMPRESSION_CONSTRUCTOR],
+											   NULL, &sa, true);
+	decompressState = callCompressionConstructor(compfuncs[COMPRESSION_CONSTRUCTOR],
+												 NULL, &sa, false);
+
+	compressed = palloc(blocksize);
+	decompressed = palloc(blocksize);
+
+	for (int i = 0; i < RelationGetNumberOfAttributes(rel); i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(RelationGetDescr(rel), i);
+		ColumnBlocks *col = &cols[i];
+		int32	   *compressedLens;
+		int64		compressedBytes = 0;
+		int64		decompressedBytes = 0;
+		instr_time	compressTime;
+		instr_time	decompressTime;
+		instr_time	start;
+		instr_time	end;
+		Datum		values[COMPRESSION_BENCHMARK_COLS];
+		bool		nulls[COMPRESSION_BENCHMARK_COLS];
+
+		if (attr->attisdropped)
+			continue;
+
+		compressedLens = palloc(Max(col->nblocks, 1) * sizeof(int32));
+		INSTR_TIME_SET_ZERO(compressTime);
+		INSTR_TIME_SET_ZERO(decompressTime);
+
+		for (int loop = 0; loop < loops; loop++)
+		{
+			INSTR_TIME_SET_CURRENT(start);
+			for (int b = 0; b < col->nblocks; b++)
+			{
+				CHECK_FOR_INTERRUPTS();
+
+				gp_trycompress(col->blocks[b], col->blockLens[b],
+							   compressed, col->blockLens[b],
+							   &compressedLens[b],
+							   compfuncs[COMPRESSION_COMPRESS],
+							   compressState);
+			}
+			INSTR_TIME_SET_CURRENT(end);
+			INSTR_TIME_ACCUM_DIFF(compressTime, end, start);
+
+			/*
+			 * Decompress the blocks that compressed. We need the compressed
+			 * data of each block for that, so compress it again, outside the
+			 * timed section.
+			 */
+			for (int b = 0; b < col->nblocks; b++)
+			{
+				CHECK_FOR_INTERRUPTS();
+
+				if (compressedLens[b] >= col->blockLens[b])
+					continue;
+
+				gp_trycompress(col->blocks[b], col->blockLens[b],
+							   compressed, col->blockLens[b],
+							   &compressedLens[b],
+							   compfuncs[COMPRESSION_COMPRESS],
+							   compressState);
+
+				INSTR_TIME_SET_CURRENT(start);
+				gp_decompress(compressed, compressedLens[b],
+							  decompressed, col->blockLens[b],
+							  compfuncs[COMPRESSION_DECOMPRESS],
+							  decompressState,
+							  b);
+				INSTR_TIME_SET_CURRENT(end);
+				INSTR_TIME_ACCUM_DIFF(decompressTime, end, start);
+
+				if (loop == 0 &&
+					memcmp(decompressed, col->blocks[b], col->blockLens[b]) != 0)
+					elog(ERROR, "block %d of column \"%s\" did not survive compression with %s",
+						 b, NameStr(attr->attname), compresstype);
+
+				decompressedBytes += col->blockLens[b];
+			}
+		}
+
+		for (int b = 0; b < col->nblocks; b++)
+			compressedBytes += Min(compressedLens[b], col->blockLens[b]);
+
+		values[0] = Int32GetDatum(GpIdentity.segindex);
+		values[1] = NameGetDatum(&attr->attname);
+		values[2] = Int64GetDatum(col->nblocks);
+		values[3] = Int64GetDatum(col->totalBytes);
+		values[4] = Int64GetDatum(compressedBytes);
+		values[5] = Float8GetDatum(compressedBytes > 0 ?
+								   (double) col->totalBytes / compressedBytes : 1.0);
+		values[6] = Float8GetDatum(mb_per_sec(col->totalBytes * loops, compressTime));
+		values[7] = Float8GetDatum(mb_per_sec(decompressedBytes, decompressTime));
+		memset(nulls, 0, sizeof(nulls));
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+
+		for (int b = 0; b < col->nblocks; b++)
+			pfree(col->blocks[b]);
+		pfree(compressedLens);
+	}
+
+	callCompressionDestructor(compfuncs[COMPRESSION_DESTRUCTOR], compressState);
+	callCompressionDestructor(compfuncs[COMPRESSION_DESTRUCTOR], decompressState);
+
+	table_close(rel, AccessShareLock);
+
+	return (Datum) 0;
+}
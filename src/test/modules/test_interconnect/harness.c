@@ -0,0 +1,792 @@
+/*--------------------------------------------------------------------------
+ *
+ * harness.c
+ *		Drive the interconnect with simulated senders and receivers.
+ *
+ * interconnect_harness() starts a background worker on the coordinator for
+ * every sender and receiver.  The workers build a two-slice table by hand,
+ * with the receivers in the root slice and the senders in its child, and
+ * move tuples with SetupInterconnect(), SendTuple(), RecvTupleFrom() and
+ * TeardownInterconnect(), like the Motions of a query do, but without the
+ * planner, the dispatcher or the executor in the way.  That measures the
+ * transports in isolation, on one host.
+ *
+ * Portions Copyright (c) 2026-Present VMware, Inc. or its affiliates.
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_interconnect/harness.c
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <netdb.h>
+
+#include "access/htup_details.h"
+#include "catalog/pg_type.h"
+#include "cdb/cdbgang.h"
+#include "cdb/cdbmotion.h"
+#include "cdb/cdbvars.h"
+#include "cdb/ml_ipc.h"
+#include "cdb/tupchunk.h"
+#include "executor/executor.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/postmaster.h"
+#include "storage/barrier.h"
+#include "storage/dsm.h"
+#include "storage/proc.h"
+#include "tcop/tcopprot.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/guc_tables.h"
+#include "utils/resowner.h"
+#include "utils/timestamp.h"
+
+PG_FUNCTION_INFO_V1(interconnect_harness);
+
+extern PGDLLEXPORT void interconnect_harness_main(Datum main_arg);
+
+#define INTERCONNECT_HARNESS_COLS	10
+
+/* Motion node of the senders, which is the index of their slice */
+#define HARNESS_MOTION_ID		1
+
+/* Latency samples kept per receiver */
+#define HARNESS_MAX_SAMPLES		10000
+
+typedef enum HarnessPattern
+{
+	HARNESS_GATHER,				/* all tuples to a single receiver */
+	HARNESS_REDISTRIBUTE,		/* each tuple to one of the receivers */
+	HARNESS_BROADCAST			/* each tuple to every receiver */
+} HarnessPattern;
+
+/*
+ * A sender or receiver.  The worker fills in its interconnect address at
+ * startup, and its results when it's done.
+ */
+typedef struct HarnessProc
+{
+	char		listenerAddr[NI_MAXHOST];
+	int			listenerPort;
+	int			pid;
+	int			dbid;
+
+	bool		done;
+	TimestampTz startTime;		/* when a sender started sending */
+	TimestampTz endTime;		/* when a receiver got the last EOS */
+	uint64		tuples;			/* tuples sent or received */
+	int			nsamples;		/* latency samples of a receiver */
+	InterconnectStats stats;
+} HarnessProc;
+
+/*
+ * The shared memory segment of a run.  The interconnect settings of the
+ * caller, as name and value pairs of C strings, and the latency samples of
+ * the receivers follow the procs.
+ */
+typedef struct HarnessShared
+{
+	HarnessPattern pattern;
+	int			nsenders;
+	int			nreceivers;
+	int			tupleWidth;
+	int64		ntuples;		/* per sender */
+	int			sessionId;
+	uint64		shmNonce;
+	Oid			database;
+	Oid			authenticatedUser;
+	Size		settingsOffset;
+	Size		samplesOffset;
+	Barrier		barrier;
+	HarnessProc procs[FLEXIBLE_ARRAY_MEMBER];	/* receivers, then senders */
+} HarnessShared;
+
+typedef struct HarnessWorkers
+{
+	int			nworkers;
+	BackgroundWorkerHandle *handle[FLEXIBLE_ARRAY_MEMBER];
+} HarnessWorkers;
+
+static void collectSettings(StringInfo buf, int dropPercent);
+static void appendSetting(StringInfo buf, const char *name, const char *value);
+static HarnessWorkers *startWorkers(dsm_segment *seg, int nworkers);
+static void terminateWorkers(dsm_segment *seg, Datum arg);
+static void waitForWorkers(HarnessWorkers *workers, HarnessShared *shared);
+static int	compareInt64(const void *a, const void *b);
+static double percentile(const int64 *sorted, int n, double fraction);
+static SliceTable *makeSliceTable(HarnessShared *shared, int localSlice);
+static TupleDesc makeTupleDesc(void);
+static void runSender(HarnessShared *shared, int senderIndex, EState *estate,
+					  TupleDesc tupdesc);
+static void runReceiver(HarnessShared *shared, int receiverIndex, EState *estate,
+						TupleDesc tupdesc);
+
+/*
+ * interconnect_harness(pattern, senders, receivers, tuple_width, ntuples,
+ *						drop_percent)
+ *
+ * Move 'ntuples' tuples from each of 'senders' workers to 'receivers'
+ * workers, and report how it went.
+ */
+Datum
+interconnect_harness(PG_FUNCTION_ARGS)
+{
+	char	   *patternName = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	int32		nsenders = PG_GETARG_INT32(1);
+	int32		nreceivers = PG_GETARG_INT32(2);
+	int32		tupleWidth = PG_GETARG_INT32(3);
+	int64		ntuples = PG_GETARG_INT64(4);
+	int32		dropPercent = PG_GETARG_INT32(5);
+	HarnessPattern pattern;
+	StringInfoData settings;
+	Size		size;
+	Size		settingsOffset;
+	Size		samplesOffset;
+	int			nworkers;
+	dsm_segment *seg;
+	HarnessShared *shared;
+	HarnessWorkers *workers;
+	TupleDesc	tupdesc;
+	Datum		values[INTERCONNECT_HARNESS_COLS];
+	bool		nulls[INTERCONNECT_HARNESS_COLS];
+	uint64		tuples = 0;
+	uint64		expected;
+	uint64		bytes = 0;
+	uint64		packets = 0;
+	uint64		retransmits = 0;
+	uint64		cpuUsecs = 0;
+	TimestampTz startTime = 0;
+	TimestampTz endTime = 0;
+	int64	   *samples;
+	int			nsamples = 0;
+	double		mbytes;
+	double		seconds;
+	int			i;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	if (tupdesc->natts != INTERCONNECT_HARNESS_COLS)
+		elog(ERROR, "incorrect number of output arguments");
+
+	/*
+	 * The workers rely on the interconnect listener that background workers
+	 * on the coordinator set up at startup.
+	 */
+	if (Gp_role != GP_ROLE_DISPATCH)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("interconnect_harness() can only be run on the coordinator")));
+
+	if (strcmp(patternName, "gather") == 0)
+	{
+		pattern = HARNESS_GATHER;
+		nreceivers = 1;
+	}
+	else if (strcmp(patternName, "redistribute") == 0)
+		pattern = HARNESS_REDISTRIBUTE;
+	else if (strcmp(patternName, "broadcast") == 0)
+		pattern = HARNESS_BROADCAST;
+	else
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("unknown traffic pattern \"%s\"", patternName),
+				 errhint("Valid patterns are \"gather\", \"redistribute\" and \"broadcast\".")));
+
+	if (nsenders < 1 || nreceivers < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("senders and receivers must be at least 1")));
+	if (tupleWidth < 1 || ntuples < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("tuple_width and ntuples must be at least 1")));
+	if (dropPercent < 0 || dropPercent > 100)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("drop_percent must be between 0 and 100")));
+	if (dropPercent > 0)
+	{
+		if (GetConfigOption("gp_udpic_dropxmit_percent", true, false) == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("simulating packet loss requires a server built with --enable-cassert")));
+		if (Gp_interconnect_type != INTERCONNECT_TYPE_UDPIFC)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("simulating packet loss requires gp_interconnect_type = udpifc")));
+	}
+
+	nworkers = nreceivers + nsenders;
+
+	initStringInfo(&settings);
+	collectSettings(&settings, dropPercent);
+
+	settingsOffset = MAXALIGN(add_size(offsetof(HarnessShared, procs),
+									   mul_size(nworkers, sizeof(HarnessProc))));
+	samplesOffset = MAXALIGN(add_size(settingsOffset, settings.len));
+	size = add_size(samplesOffset,
+					mul_size(mul_size(nreceivers, HARNESS_MAX_SAMPLES), sizeof(int64)));
+
+	seg = dsm_create(size, 0);
+	shared = dsm_segment_address(seg);
+	memset(shared, 0, samplesOffset);
+	shared->pattern = pattern;
+	shared->nsenders = nsenders;
+	shared->nreceivers = nreceivers;
+	shared->tupleWidth = tupleWidth;
+	shared->ntuples = ntuples;
+	shared->database = MyDatabaseId;
+	shared->authenticatedUser = GetAuthenticatedUserId();
+	shared->settingsOffset = settingsOffset;
+	shared->samplesOffset = samplesOffset;
+	memcpy((char *) shared + settingsOffset, settings.data, settings.len);
+	BarrierInit(&shared->barrier, nworkers);
+
+	/*
+	 * The interconnect only talks to peers of the same session, so the
+	 * workers pretend to be the QEs of a new one.
+	 */
+	ProcNewMppSessionId(&shared->sessionId);
+	if (!pg_strong_random(&shared->shmNonce, sizeof(shared->shmNonce)))
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("could not generate random interconnect shared memory ring name")));
+
+	workers = startWorkers(seg, nworkers);
+	waitForWorkers(workers, shared);
+
+	samples = palloc(mul_size(mul_size(nreceivers, HARNESS_MAX_SAMPLES), sizeof(int64)));
+	for (i = 0; i < nworkers; i++)
+	{
+		HarnessProc *proc = &shared->procs[i];
+
+		if (i < nreceivers)
+		{
+			int64	   *procSamples;
+
+			procSamples = (int64 *) ((char *) shared + samplesOffset) +
+				i * HARNESS_MAX_SAMPLES;
+			memcpy(samples + nsamples, procSamples, proc->nsamples * sizeof(int64));
+			nsamples += proc->nsamples;
+
+			tuples += proc->tuples;
+			bytes += proc->stats.bytesRecvd;
+			if (proc->endTime > endTime)
+				endTime = proc->endTime;
+		}
+		else
+		{
+			packets += proc->stats.pktsSent;
+			retransmits += proc->stats.retransmits;
+			if (startTime == 0 || proc->startTime < startTime)
+				startTime = proc->startTime;
+		}
+		cpuUsecs += proc->stats.cpuUsecs;
+	}
+
+	dsm_detach(seg);
+
+	expected = (uint64) nsenders * ntuples;
+	if (pattern == HARNESS_BROADCAST)
+		expected *= nreceivers;
+	if (tuples != expected)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("the receivers got " UINT64_FORMAT " tuples, expected " UINT64_FORMAT,
+						tuples, expected)));
+
+	mbytes = (double) bytes / (1024 * 1024);
+	seconds = (double) Max(endTime - startTime, 1) / USECS_PER_SEC;
+
+	memset(nulls, 0, sizeof(nulls));
+	i = 0;
+	values[i++] = Int64GetDatum((int64) tuples);
+	values[i++] = Float8GetDatum(mbytes);
+	values[i++] = Float8GetDatum(seconds);
+	values[i++] = Float8GetDatum(mbytes / seconds);
+	if (nsamples > 0)
+	{
+		qsort(samples, nsamples, sizeof(int64), compareInt64);
+		values[i++] = Float8GetDatum(percentile(samples, nsamples, 0.5) / 1000);
+		values[i++] = Float8GetDatum(percentile(samples, nsamples, 0.9) / 1000);
+		values[i++] = Float8GetDatum(percentile(samples, nsamples, 0.99) / 1000);
+	}
+	else
+	{
+		nulls[i++] = true;
+		nulls[i++] = true;
+		nulls[i++] = true;
+	}
+	values[i++] = Int64GetDatum((int64) packets);
+	values[i++] = Int64GetDatum((int64) retransmits);
+	if (mbytes > 0)
+		values[i++] = Float8GetDatum(cpuUsecs / mbytes);
+	else
+		nulls[i++] = true;
+	Assert(i == INTERCONNECT_HARNESS_COLS);
+
+	tupdesc = BlessTupleDesc(tupdesc);
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+/*
+ * Collect the caller's interconnect settings, so that the workers run with
+ * the same ones as a query would.
+ */
+static void
+collectSettings(StringInfo buf, int dropPercent)
+{
+	struct config_generic **gucs = get_guc_variables();
+	int			ngucs = GetNumConfigOptions();
+	int			i;
+
+	for (i = 0; i < ngucs; i++)
+	{
+		struct config_generic *conf = gucs[i];
+
+		if (conf->context != PGC_USERSET && conf->context != PGC_BACKEND)
+			continue;
+		if (strncmp(conf->name, "gp_interconnect_", strlen("gp_interconnect_")) != 0 &&
+			strncmp(conf->name, "gp_udpic_", strlen("gp_udpic_")) != 0 &&
+			strcmp(conf->name, "gp_max_packet_size") != 0 &&
+			strcmp(conf->name, "gp_log_interconnect") != 0)
+			continue;
+
+		appendSetting(buf, conf->name, GetConfigOption(conf->name, false, false));
+	}
+
+	/* later settings override earlier ones */
+	appendSetting(buf, "gp_interconnect_collect_stats", "on");
+	if (dropPercent > 0)
+	{
+		char		value[16];
+
+		snprintf(value, sizeof(value), "%d", dropPercent);
+		appendSetting(buf, "gp_udpic_dropxmit_percent", value);
+	}
+
+	/* an empty name ends the list */
+	appendStringInfoChar(buf, '\0');
+}
+
+static void
+appendSetting(StringInfo buf, const char *name, const char *value)
+{
+	appendBinaryStringInfo(buf, name, strlen(name) + 1);
+	appendBinaryStringInfo(buf, value, strlen(value) + 1);
+}
+
+/*
+ * Register the workers, the receivers first.  They're terminated if we
+ * error out before they're done.
+ */
+static HarnessWorkers *
+startWorkers(dsm_segment *seg, int nworkers)
+{
+	BackgroundWorker worker;
+	HarnessWorkers *workers;
+	int			i;
+
+	/* The on_dsm_detach callback needs these until the end of transaction */
+	workers = MemoryContextAlloc(TopTransactionContext,
+								 offsetof(HarnessWorkers, handle) +
+								 sizeof(BackgroundWorkerHandle *) * nworkers);
+	workers->nworkers = 0;
+	on_dsm_detach(seg, terminateWorkers, PointerGetDatum(workers));
+
+	memset(&worker, 0, sizeof(worker));
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS | BGWORKER_BACKEND_DATABASE_CONNECTION;
+	worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+	worker.bgw_restart_time = BGW_NEVER_RESTART;
+	sprintf(worker.bgw_library_name, "test_interconnect");
+	sprintf(worker.bgw_function_name, "interconnect_harness_main");
+	snprintf(worker.bgw_type, BGW_MAXLEN, "interconnect harness");
+	worker.bgw_main_arg = UInt32GetDatum(dsm_segment_handle(seg));
+	/* set bgw_notify_pid, so we can detect if the worker stops */
+	worker.bgw_notify_pid = MyProcPid;
+
+	for (i = 0; i < nworkers; i++)
+	{
+		snprintf(worker.bgw_name, BGW_MAXLEN, "interconnect harness worker %d", i);
+		memcpy(worker.bgw_extra, &i, sizeof(i));
+
+		if (!RegisterDynamicBackgroundWorker(&worker,
+											 &workers->handle[workers->nworkers]))
+			ereport(ERROR,
+					(errcode(ERRCODE_INSUFFICIENT_RESOURCES),
+					 errmsg("could not register background process"),
+					 errhint("You may need to increase max_worker_processes.")));
+		workers->nworkers++;
+	}
+
+	return workers;
+}
+
+static void
+terminateWorkers(dsm_segment *seg, Datum arg)
+{
+	HarnessWorkers *workers = (HarnessWorkers *) DatumGetPointer(arg);
+
+	while (workers->nworkers > 0)
+	{
+		workers->nworkers--;
+		TerminateBackgroundWorker(workers->handle[workers->nworkers]);
+	}
+}
+
+/*
+ * Wait until all the workers have exited.  If one of them exits without
+ * finishing, the others would wait for it forever, so give up.
+ */
+static void
+waitForWorkers(HarnessWorkers *workers, HarnessShared *shared)
+{
+	for (;;)
+	{
+		int			nstopped = 0;
+		int			i;
+
+		for (i = 0; i < workers->nworkers; i++)
+		{
+			BgwHandleStatus status;
+			pid_t		pid;
+
+			status = GetBackgroundWorkerPid(workers->handle[i], &pid);
+			if (status == BGWH_POSTMASTER_DIED)
+				ereport(FATAL,
+						(errcode(ERRCODE_ADMIN_SHUTDOWN),
+						 errmsg("postmaster exited during the interconnect harness run")));
+			if (status != BGWH_STOPPED)
+				continue;
+			if (!shared->procs[i].done)
+				ereport(ERROR,
+						(errcode(ERRCODE_INTERNAL_ERROR),
+						 errmsg("interconnect harness worker %d failed", i),
+						 errhint("The server log has the error.")));
+			nstopped++;
+		}
+
+		if (nstopped == workers->nworkers)
+			break;
+
+		(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH, 0,
+						 PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+static int
+compareInt64(const void *a, const void *b)
+{
+	int64		x = *(const int64 *) a;
+	int64		y = *(const int64 *) b;
+
+	if (x < y)
+		return -1;
+	if (x > y)
+		return 1;
+	return 0;
+}
+
+/*
+ * The given percentile of sorted values, interpolating between the closest
+ * two like percentile_cont() does.
+ */
+static double
+percentile(const int64 *sorted, int n, double fraction)
+{
+	double		pos = fraction * (n - 1);
+	int			lo = (int) pos;
+	int			hi = Min(lo + 1, n - 1);
+
+	return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - lo);
+}
+
+/*
+ * Main entry point of a sender or receiver worker.
+ */
+void
+interconnect_harness_main(Datum main_arg)
+{
+	dsm_segment *seg;
+	HarnessShared *shared;
+	HarnessProc *me;
+	int			myIndex;
+	bool		isSender;
+	char	   *setting;
+	TupleDesc	tupdesc;
+	EState	   *estate;
+
+	memcpy(&myIndex, MyBgworkerEntry->bgw_extra, sizeof(myIndex));
+
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	seg = dsm_attach(DatumGetUInt32(main_arg));
+	if (seg == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not map dynamic shared memory segment")));
+	shared = dsm_segment_address(seg);
+	me = &shared->procs[myIndex];
+	isSender = (myIndex >= shared->nreceivers);
+
+	/*
+	 * Apply the caller's interconnect settings before connecting, because
+	 * the interconnect listener is set up as part of that.
+	 */
+	setting = (char *) shared + shared->settingsOffset;
+	while (*setting != '\0')
+	{
+		char	   *value = setting + strlen(setting) + 1;
+
+		SetConfigOption(setting, value, PGC_BACKEND, PGC_S_CLIENT);
+		setting = value + strlen(value) + 1;
+	}
+
+	BackgroundWorkerInitializeConnectionByOid(shared->database,
+											  shared->authenticatedUser, 0);
+
+	if (Gp_listener_port == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("the interconnect is not set up in this background worker")));
+
+	/*
+	 * From here on, this is a QE of the harness' session as far as the
+	 * interconnect is concerned.  There's no QD to watch for cancellation,
+	 * and the interconnect runs outside of a transaction.
+	 */
+	Gp_role = GP_ROLE_EXECUTE;
+	gp_session_id = shared->sessionId;
+	CurrentResourceOwner = ResourceOwnerCreate(NULL, "interconnect harness");
+
+	/* Tell the others where to find us */
+	strlcpy(me->listenerAddr, interconnect_address, sizeof(me->listenerAddr));
+	if (Gp_interconnect_type == INTERCONNECT_TYPE_UDPIFC)
+		me->listenerPort = (Gp_listener_port >> 16) & 0x0ffff;
+	else
+		me->listenerPort = Gp_listener_port & 0x0ffff;
+	me->pid = MyProcPid;
+	me->dbid = GpIdentity.dbid;
+
+	BarrierArriveAndWait(&shared->barrier, PG_WAIT_EXTENSION);
+
+	tupdesc = makeTupleDesc();
+	estate = CreateExecutorState();
+	MemoryContextSwitchTo(estate->es_query_cxt);
+	estate->es_sliceTable = makeSliceTable(shared, isSender ? HARNESS_MOTION_ID : 0);
+	estate->motionlayer_context = createMotionLayerState(HARNESS_MOTION_ID);
+	UpdateMotionLayerNode(estate->motionlayer_context, HARNESS_MOTION_ID,
+						  false, false, 0, tupdesc);
+
+	PG_TRY();
+	{
+		SetupInterconnect(estate);
+		UpdateMotionExpectedReceivers(estate->motionlayer_context,
+									  estate->es_sliceTable);
+
+		/* Everyone is set up, start all at once */
+		BarrierArriveAndWait(&shared->barrier, PG_WAIT_EXTENSION);
+
+		if (isSender)
+			runSender(shared, myIndex - shared->nreceivers, estate, tupdesc);
+		else
+			runReceiver(shared, myIndex, estate, tupdesc);
+
+		TeardownInterconnect(estate->interconnect_context, false);
+		estate->interconnect_context = NULL;
+	}
+	PG_CATCH();
+	{
+		if (estate->interconnect_context)
+			TeardownInterconnect(estate->interconnect_context, true);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	EndMotionLayerNode(estate->motionlayer_context, HARNESS_MOTION_ID, false);
+	RemoveMotionLayer(estate->motionlayer_context);
+
+	GetBackendInterconnectStats(&me->stats);
+	me->done = true;
+
+	dsm_detach(seg);
+}
+
+/*
+ * The slice table of a run.  Slice 0 holds the receivers, and its child,
+ * slice 1, the senders.
+ */
+static SliceTable *
+makeSliceTable(HarnessShared *shared, int localSlice)
+{
+	SliceTable *sliceTable = makeNode(SliceTable);
+	ExecSlice  *recvSlice;
+	ExecSlice  *sendSlice;
+	int			i;
+
+	sliceTable->localSlice = localSlice;
+	sliceTable->numSlices = 2;
+	sliceTable->slices = palloc0(2 * sizeof(ExecSlice));
+	sliceTable->hasMotions = true;
+	sliceTable->ic_instance_id = 1;
+	sliceTable->ic_shm_nonce = shared->shmNonce;
+
+	recvSlice = &sliceTable->slices[0];
+	recvSlice->sliceIndex = 0;
+	recvSlice->rootIndex = 0;
+	recvSlice->parentIndex = -1;
+	recvSlice->planNumSegments = shared->nreceivers;
+	recvSlice->children = list_make1_int(HARNESS_MOTION_ID);
+	recvSlice->gangType = GANGTYPE_PRIMARY_READER;
+
+	sendSlice = &sliceTable->slices[HARNESS_MOTION_ID];
+	sendSlice->sliceIndex = HARNESS_MOTION_ID;
+	sendSlice->rootIndex = 0;
+	sendSlice->parentIndex = 0;
+	sendSlice->planNumSegments = shared->nsenders;
+	sendSlice->gangType = GANGTYPE_PRIMARY_READER;
+
+	for (i = 0; i < shared->nreceivers + shared->nsenders; i++)
+	{
+		HarnessProc *proc = &shared->procs[i];
+		ExecSlice  *slice = (i < shared->nreceivers) ? recvSlice : sendSlice;
+		CdbProcess *cdbProc = makeNode(CdbProcess);
+
+		cdbProc->listenerAddr = pstrdup(proc->listenerAddr);
+		cdbProc->listenerPort = proc->listenerPort;
+		cdbProc->pid = proc->pid;
+		cdbProc->contentid = GpIdentity.segindex;
+		cdbProc->dbid = proc->dbid;
+
+		slice->primaryProcesses = lappend(slice->primaryProcesses, cdbProc);
+		slice->segments = lappend_int(slice->segments, GpIdentity.segindex);
+	}
+
+	return sliceTable;
+}
+
+/*
+ * The tuples carry the time they were sent at, for measuring latency, and
+ * a payload of the requested width.
+ */
+static TupleDesc
+makeTupleDesc(void)
+{
+	TupleDesc	tupdesc = CreateTemplateTupleDesc(2);
+
+	TupleDescInitBuiltinEntry(tupdesc, (AttrNumber) 1, "sent_at", INT8OID, -1, 0);
+	TupleDescInitBuiltinEntry(tupdesc, (AttrNumber) 2, "payload", BYTEAOID, -1, 0);
+
+	return tupdesc;
+}
+
+static void
+runSender(HarnessShared *shared, int senderIndex, EState *estate,
+		  TupleDesc tupdesc)
+{
+	HarnessProc *me = &shared->procs[shared->nreceivers + senderIndex];
+	TupleTableSlot *slot = MakeSingleTupleTableSlot(tupdesc, &TTSOpsVirtual);
+	bytea	   *payload;
+	int64		i;
+
+	payload = palloc(VARHDRSZ + shared->tupleWidth);
+	SET_VARSIZE(payload, VARHDRSZ + shared->tupleWidth);
+	memset(VARDATA(payload), 'x', shared->tupleWidth);
+
+	me->startTime = GetCurrentTimestamp();
+
+	for (i = 0; i < shared->ntuples; i++)
+	{
+		int16		route;
+
+		CHECK_FOR_INTERRUPTS();
+
+		ExecClearTuple(slot);
+		slot->tts_values[0] = Int64GetDatum(GetCurrentTimestamp());
+		slot->tts_isnull[0] = false;
+		slot->tts_values[1] = PointerGetDatum(payload);
+		slot->tts_isnull[1] = false;
+		ExecStoreVirtualTuple(slot);
+
+		switch (shared->pattern)
+		{
+			case HARNESS_GATHER:
+				route = 0;
+				break;
+			case HARNESS_REDISTRIBUTE:
+				route = (senderIndex + i) % shared->nreceivers;
+				break;
+			case HARNESS_BROADCAST:
+			default:
+				route = BROADCAST_SEGIDX;
+				break;
+		}
+
+		if (SendTuple(estate->motionlayer_context, estate->interconnect_context,
+					  HARNESS_MOTION_ID, slot, route) == STOP_SENDING)
+			break;
+		me->tuples++;
+	}
+
+	SendEndOfStream(estate->motionlayer_context, estate->interconnect_context,
+					HARNESS_MOTION_ID);
+
+	ExecDropSingleTupleTableSlot(slot);
+}
+
+static void
+runReceiver(HarnessShared *shared, int receiverIndex, EState *estate,
+			TupleDesc tupdesc)
+{
+	HarnessProc *me = &shared->procs[receiverIndex];
+	TupleTableSlot *slot = MakeSingleTupleTableSlot(tupdesc, &TTSOpsMinimalTuple);
+	int64	   *samples;
+	uint64		expected;
+	uint64		sampleEvery;
+
+	samples = (int64 *) ((char *) shared + shared->samplesOffset) +
+		receiverIndex * HARNESS_MAX_SAMPLES;
+
+	/* Spread the latency samples over the whole run */
+	expected = (uint64) shared->nsenders * shared->ntuples;
+	if (shared->pattern == HARNESS_REDISTRIBUTE)
+		expected /= shared->nreceivers;
+	sampleEvery = expected / HARNESS_MAX_SAMPLES + 1;
+
+	for (;;)
+	{
+		MinimalTuple tuple;
+
+		tuple = RecvTupleFrom(estate->motionlayer_context,
+							  estate->interconnect_context,
+							  HARNESS_MOTION_ID, ANY_ROUTE);
+		if (tuple == NULL)
+			break;
+
+		if (me->tuples % sampleEvery == 0 && me->nsamples < HARNESS_MAX_SAMPLES)
+		{
+			TimestampTz now = GetCurrentTimestamp();
+			bool		isnull;
+			Datum		sentAt;
+
+			ExecStoreMinimalTuple(tuple, slot, false);
+			sentAt = slot_getattr(slot, 1, &isnull);
+			samples[me->nsamples++] = now - DatumGetInt64(sentAt);
+			ExecClearTuple(slot);
+		}
+		pfree(tuple);
+		me->tuples++;
+	}
+
+	me->endTime = GetCurrentTimestamp();
+
+	ExecDropSingleTupleTableSlot(slot);
+}
@@ -0,0 +1,34 @@
+CREATE EXTENSION test_interconnect;
+
+-- Every pattern moves the expected number of tuples, and the counters see
+-- them go by.
+SELECT tuples, mbytes > 0 AS moved_data, seconds > 0 AS timed,
+       latency_p50_ms <= latency_p99_ms AS latencies, retransmits >= 0 AS counted
+FROM interconnect_benchmark('gather', 32, 1000, 2);
+SELECT tuples, mbytes > 0 AS moved_data, seconds > 0 AS timed,
+       latency_p50_ms <= latency_p99_ms AS latencies, retransmits >= 0 AS counted
+FROM interconnect_benchmark('redistribute', 32, 1000, 2);
+SELECT tuples, mbytes > 0 AS moved_data, seconds > 0 AS timed,
+       latency_p50_ms <= latency_p99_ms AS latencies, retransmits >= 0 AS counted
+FROM interconnect_benchmark('broadcast', 32, 1000, 2);
+
+-- The generated queries are replayable, and compute the right answers.
+SELECT interconnect_traffic_query('gather', 8, 10);
+SET gp_enable_multiphase_agg = off;
+SELECT count(*), sum(length(s.payload)) FROM (SELECT g.i, rpad(g.i::text, 8, 'x') AS payload FROM gp_dist_random('gp_id'), generate_series(1, 10::int8) g(i) OFFSET 0) s;
+RESET gp_enable_multiphase_agg;
+
+SELECT interconnect_traffic_query('scatter', 8, 10);
+
+-- The harness moves tuples between simulated senders and receivers, through
+-- the transport alone.
+SELECT tuples, mbytes > 0 AS moved_data, seconds > 0 AS timed,
+       latency_p50_ms <= latency_p99_ms AS latencies, retransmits >= 0 AS counted
+FROM interconnect_harness('gather', 2, 1, 32, 1000);
+SELECT tuples, mbytes > 0 AS moved_data, seconds > 0 AS timed,
+       latency_p50_ms <= latency_p99_ms AS latencies, retransmits >= 0 AS counted
+FROM interconnect_harness('redistribute', 2, 2, 32, 1000);
+SELECT tuples, mbytes > 0 AS moved_data, seconds > 0 AS timed,
+       latency_p50_ms <= latency_p99_ms AS latencies, retransmits >= 0 AS counted
+FROM interconnect_harness('broadcast', 2, 2, 32, 1000);
+SELECT tuples FROM interconnect_harness('scatter');
@@ -0,0 +1,234 @@
+/* src/test/modules/test_interconnect/test_interconnect--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_interconnect" to load this file. \quit
+
+CREATE FUNCTION interconnect_coordinator_stats(
+	OUT segid int4,
+	OUT teardowns int8,
+	OUT chunks_sent int8,
+	OUT bytes_sent int8,
+	OUT chunks_recvd int8,
+	OUT bytes_recvd int8,
+	OUT pkts_sent int8,
+	OUT pkts_recvd int8,
+	OUT retransmits int8,
+	OUT crc_errors int8,
+	OUT duplicated_pkts int8,
+	OUT cpu_usecs int8,
+	OUT elapsed_usecs int8)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'interconnect_stats' LANGUAGE C VOLATILE
+EXECUTE ON COORDINATOR;
+
+CREATE FUNCTION interconnect_segment_stats(
+	OUT segid int4,
+	OUT teardowns int8,
+	OUT chunks_sent int8,
+	OUT bytes_sent int8,
+	OUT chunks_recvd int8,
+	OUT bytes_recvd int8,
+	OUT pkts_sent int8,
+	OUT pkts_recvd int8,
+	OUT retransmits int8,
+	OUT crc_errors int8,
+	OUT duplicated_pkts int8,
+	OUT cpu_usecs int8,
+	OUT elapsed_usecs int8)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'interconnect_stats' LANGUAGE C VOLATILE
+EXECUTE ON ALL SEGMENTS;
+
+CREATE VIEW interconnect_stats AS
+	SELECT * FROM interconnect_coordinator_stats()
+	UNION ALL
+	SELECT * FROM interconnect_segment_stats();
+
+-- Generate the text of a query that moves 'ntuples' tuples of 'tuple_width'
+-- bytes from every segment, with the given fan-out pattern.  The OFFSET 0
+-- keeps the planner from pulling up the subquery, so that the payload is
+-- formed below the Motion.  The query is deterministic, so it can be saved
+-- and replayed with interconnect_replay().
+CREATE FUNCTION interconnect_traffic_query(pattern text, tuple_width int4, ntuples int8)
+RETURNS text STRICT IMMUTABLE
+AS $$
+DECLARE
+	source text;
+BEGIN
+	IF tuple_width < 1 OR ntuples < 1 THEN
+		RAISE EXCEPTION 'tuple_width and ntuples must be at least 1';
+	END IF;
+
+	source := format('SELECT g.i, rpad(g.i::text, %s, ''x'') AS payload '
+					 'FROM gp_dist_random(''gp_id''), generate_series(1, %s::int8) g(i) '
+					 'OFFSET 0', tuple_width, ntuples);
+
+	CASE pattern
+		WHEN 'gather' THEN
+			-- all rows to the coordinator
+			RETURN format('SELECT count(*), sum(length(s.payload)) FROM (%s) s',
+						  source);
+		WHEN 'redistribute' THEN
+			-- all rows hashed by i, then one row per group to the coordinator
+			RETURN format('SELECT count(*), sum(r.n) FROM '
+						  '(SELECT s.i, sum(length(s.payload)) AS n FROM (%s) s GROUP BY s.i) r',
+						  source);
+		WHEN 'broadcast' THEN
+			-- all rows to every segment, for a correlated subquery
+			RETURN format('SELECT sum(x.c) FROM '
+						  '(SELECT (SELECT count(*) FROM (%s) s WHERE s.i > o.dbid - 32768) AS c '
+						  'FROM gp_dist_random(''gp_id'') o) x',
+						  source);
+		ELSE
+			RAISE EXCEPTION 'unknown traffic pattern "%"', pattern
+				USING HINT = 'Valid patterns are "gather", "redistribute" and "broadcast".';
+	END CASE;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Run a query 'loops' times, optionally dropping 'drop_percent' percent of
+-- the UDP data packets, and report what it cost the interconnect.  The
+-- counters are cluster-wide, so concurrent queries skew the results, and
+-- only those that run with gp_interconnect_collect_stats on add to them.
+CREATE FUNCTION interconnect_replay(query text,
+	loops int4 DEFAULT 10,
+	drop_percent int4 DEFAULT 0,
+	OUT mbytes float8,
+	OUT seconds float8,
+	OUT mb_per_sec float8,
+	OUT latency_p50_ms float8,
+	OUT latency_p90_ms float8,
+	OUT latency_p99_ms float8,
+	OUT packets int8,
+	OUT retransmits int8,
+	OUT cpu_usec_per_mb float8)
+RETURNS record STRICT
+AS $$
+DECLARE
+	old_drop_percent text;
+	elapsed float8[] := '{}';
+	t0 timestamptz;
+	before record;
+	after record;
+BEGIN
+	IF loops < 1 THEN
+		RAISE EXCEPTION 'loops must be at least 1';
+	END IF;
+
+	IF drop_percent > 0 THEN
+		old_drop_percent := current_setting('gp_udpic_dropxmit_percent', true);
+		IF old_drop_percent IS NULL THEN
+			RAISE EXCEPTION 'simulating packet loss requires a server built with --enable-cassert';
+		END IF;
+		IF current_setting('gp_interconnect_type') <> 'udpifc' THEN
+			RAISE EXCEPTION 'simulating packet loss requires gp_interconnect_type = udpifc';
+		END IF;
+		PERFORM set_config('gp_udpic_dropxmit_percent', drop_percent::text, true);
+	END IF;
+	PERFORM set_config('gp_interconnect_collect_stats', 'on', true);
+
+	SELECT sum(s.bytes_sent) AS bytes, sum(s.pkts_sent) AS pkts,
+		   sum(s.retransmits) AS retransmits, sum(s.cpu_usecs) AS cpu
+	INTO before FROM interconnect_stats s;
+
+	FOR i IN 1..loops LOOP
+		t0 := clock_timestamp();
+		EXECUTE query;
+		elapsed := elapsed || extract(epoch FROM clock_timestamp() - t0)::float8;
+	END LOOP;
+
+	IF drop_percent > 0 THEN
+		PERFORM set_config('gp_udpic_dropxmit_percent', old_drop_percent, true);
+	END IF;
+
+	SELECT sum(s.bytes_sent) AS bytes, sum(s.pkts_sent) AS pkts,
+		   sum(s.retransmits) AS retransmits, sum(s.cpu_usecs) AS cpu
+	INTO after FROM interconnect_stats s;
+
+	mbytes := (after.bytes - before.bytes) / (1024.0 * 1024.0);
+	packets := after.pkts - before.pkts;
+	retransmits := after.retransmits - before.retransmits;
+	IF mbytes > 0 THEN
+		cpu_usec_per_mb := (after.cpu - before.cpu) / mbytes;
+	END IF;
+
+	SELECT sum(u.e),
+		   percentile_cont(0.5) WITHIN GROUP (ORDER BY u.e) * 1000,
+		   percentile_cont(0.9) WITHIN GROUP (ORDER BY u.e) * 1000,
+		   percentile_cont(0.99) WITHIN GROUP (ORDER BY u.e) * 1000
+	INTO seconds, latency_p50_ms, latency_p90_ms, latency_p99_ms
+	FROM unnest(elapsed) AS u(e);
+
+	IF seconds > 0 THEN
+		mb_per_sec := mbytes / seconds;
+	END IF;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Generate traffic with interconnect_traffic_query(), and replay it with
+-- interconnect_replay().  'tuples' is the number of tuples that crossed the
+-- interconnect, in all loops.  The planner settings keep the plan shapes
+-- that interconnect_traffic_query() expects.
+CREATE FUNCTION interconnect_benchmark(pattern text,
+	tuple_width int4 DEFAULT 64,
+	ntuples int8 DEFAULT 100000,
+	loops int4 DEFAULT 10,
+	drop_percent int4 DEFAULT 0,
+	OUT tuples int8,
+	OUT mbytes float8,
+	OUT seconds float8,
+	OUT mb_per_sec float8,
+	OUT latency_p50_ms float8,
+	OUT latency_p90_ms float8,
+	OUT latency_p99_ms float8,
+	OUT packets int8,
+	OUT retransmits int8,
+	OUT cpu_usec_per_mb float8)
+RETURNS record STRICT
+AS $$
+DECLARE
+	nsegs int8;
+BEGIN
+	SELECT count(*) INTO nsegs FROM gp_segment_configuration
+	WHERE role = 'p' AND content >= 0;
+
+	tuples := ntuples * nsegs * loops;
+	IF pattern = 'broadcast' THEN
+		tuples := tuples * nsegs;
+	END IF;
+
+	SELECT r.mbytes, r.seconds, r.mb_per_sec,
+		   r.latency_p50_ms, r.latency_p90_ms, r.latency_p99_ms,
+		   r.packets, r.retransmits, r.cpu_usec_per_mb
+	INTO mbytes, seconds, mb_per_sec,
+		 latency_p50_ms, latency_p90_ms, latency_p99_ms,
+		 packets, retransmits, cpu_usec_per_mb
+	FROM interconnect_replay(interconnect_traffic_query(pattern, tuple_width, ntuples),
+							 loops, drop_percent) r;
+END;
+$$ LANGUAGE plpgsql
+SET optimizer = off
+SET gp_enable_multiphase_agg = off;
+
+-- Move 'ntuples' tuples from each of 'senders' simulated senders to
+-- 'receivers' simulated receivers, with the given fan-out pattern, through
+-- the transport alone.  See harness.c.
+CREATE FUNCTION interconnect_harness(pattern text,
+	senders int4 DEFAULT 2,
+	receivers int4 DEFAULT 2,
+	tuple_width int4 DEFAULT 64,
+	ntuples int8 DEFAULT 100000,
+	drop_percent int4 DEFAULT 0,
+	OUT tuples int8,
+	OUT mbytes float8,
+	OUT seconds float8,
+	OUT mb_per_sec float8,
+	OUT latency_p50_ms float8,
+	OUT latency_p90_ms float8,
+	OUT latency_p99_ms float8,
+	OUT packets int8,
+	OUT retransmits int8,
+	OUT cpu_usec_per_mb float8)
+RETURNS record STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C VOLATILE
+EXECUTE ON COORDINATOR;
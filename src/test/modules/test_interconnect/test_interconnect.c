@@ -0,0 +1,93 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_interconnect.c
+ *		Expose the cumulative interconnect statistics, for benchmarking.
+ *
+ * The traffic generator and the benchmark driver for real queries are
+ * written in SQL, see test_interconnect--1.0.sql, and the harness that
+ * drives the transports without a query is in harness.c.  This file only
+ * provides the counters to measure them with.
+ *
+ * Portions Copyright (c) 2026-Present VMware, Inc. or its affiliates.
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_interconnect/test_interconnect.c
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "cdb/cdbvars.h"
+#include "cdb/ml_ipc.h"
+#include "fmgr.h"
+#include "funcapi.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(interconnect_stats);
+
+#define INTERCONNECT_STATS_COLS	13
+
+/*
+ * Return the cumulative interconnect statistics of this segment, as a
+ * single row.  It's a set-returning function, so that it can be declared
+ * EXECUTE ON ALL SEGMENTS.
+ */
+Datum
+interconnect_stats(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			elog(ERROR, "return type must be a row type");
+		if (tupdesc->natts != INTERCONNECT_STATS_COLS)
+			elog(ERROR, "incorrect number of output arguments");
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+		funcctx->max_calls = 1;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		InterconnectStats stats;
+		Datum		values[INTERCONNECT_STATS_COLS];
+		bool		nulls[INTERCONNECT_STATS_COLS];
+		HeapTuple	tuple;
+		int			i = 0;
+
+		GetInterconnectStats(&stats);
+
+		memset(nulls, 0, sizeof(nulls));
+		values[i++] = Int32GetDatum(GpIdentity.segindex);
+		values[i++] = Int64GetDatum((int64) stats.teardowns);
+		values[i++] = Int64GetDatum((int64) stats.chunksSent);
+		values[i++] = Int64GetDatum((int64) stats.bytesSent);
+		values[i++] = Int64GetDatum((int64) stats.chunksRecvd);
+		values[i++] = Int64GetDatum((int64) stats.bytesRecvd);
+		values[i++] = Int64GetDatum((int64) stats.pktsSent);
+		values[i++] = Int64GetDatum((int64) stats.pktsRecvd);
+		values[i++] = Int64GetDatum((int64) stats.retransmits);
+		values[i++] = Int64GetDatum((int64) stats.crcErrors);
+		values[i++] = Int64GetDatum((int64) stats.duplicatedPkts);
+		values[i++] = Int64GetDatum((int64) stats.cpuUsecs);
+		values[i++] = Int64GetDatum((int64) stats.elapsedUsecs);
+		Assert(i == INTERCONNECT_STATS_COLS);
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
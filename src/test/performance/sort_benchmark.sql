@@ -0,0 +1,86 @@
+--
+-- Time sorts with and without radix sort (gp_enable_radix_sort).
+--
+-- Each query sorts one column on every segment, with a Sort and Unique
+-- under the count. The column types cover the ways a leading sort key
+-- can be radix sorted: int4, int8 and timestamp by value, and text by
+-- its abbreviated key.
+-- The int4 column is also sorted with a small statement_mem, where the
+-- runs are radix sorted and merged with the tree of losers.
+--
+-- Usage: psql -X -v rows=10000000 -f sort_benchmark.sql
+--
+\if :{?rows}
+\else
+\set rows 10000000
+\endif
+
+SET optimizer = off;
+SET enable_hashagg = off;
+
+DROP TABLE IF EXISTS sort_perf_int4, sort_perf_int8, sort_perf_timestamp, sort_perf_text;
+
+-- Multiplying by a prime and taking the remainder visits every key once,
+-- in an order that is far from sorted.
+CREATE TABLE sort_perf_int4 AS
+  SELECT ((i::int8 * 7919) % :rows)::int4 AS k
+  FROM generate_series(1, :rows) i DISTRIBUTED BY (k);
+CREATE TABLE sort_perf_int8 AS
+  SELECT (i::int8 * 2654435761) % 1000000007 AS k
+  FROM generate_series(1, :rows) i DISTRIBUTED BY (k);
+CREATE TABLE sort_perf_timestamp AS
+  SELECT timestamp '2000-01-01' + ((i::int8 * 7919) % :rows) * interval '1 second' AS k
+  FROM generate_series(1, :rows) i DISTRIBUTED BY (k);
+CREATE TABLE sort_perf_text AS
+  SELECT md5(i::text) AS k
+  FROM generate_series(1, :rows) i DISTRIBUTED BY (k);
+ANALYZE sort_perf_int4;
+ANALYZE sort_perf_int8;
+ANALYZE sort_perf_timestamp;
+ANALYZE sort_perf_text;
+
+-- Sort in memory. Each query runs twice, the first run warms the cache.
+SET statement_mem = '1GB';
+\timing on
+
+\echo in-memory sort, radix sort on
+SET gp_enable_radix_sort = on;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_int4) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_int4) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_int8) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_int8) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_timestamp) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_timestamp) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_text) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_text) s;
+
+\echo in-memory sort, radix sort off
+SET gp_enable_radix_sort = off;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_int4) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_int4) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_int8) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_int8) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_timestamp) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_timestamp) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_text) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_text) s;
+
+-- Sort on disk.
+SET statement_mem = '16MB';
+
+\echo external sort, radix sort on
+SET gp_enable_radix_sort = on;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_int4) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_int4) s;
+
+\echo external sort, radix sort off
+SET gp_enable_radix_sort = off;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_int4) s;
+SELECT count(*) FROM (SELECT DISTINCT k FROM sort_perf_int4) s;
+
+\timing off
+RESET gp_enable_radix_sort;
+RESET statement_mem;
+RESET enable_hashagg;
+RESET optimizer;
+DROP TABLE sort_perf_int4, sort_perf_int8, sort_perf_timestamp, sort_perf_text;
@@ -0,0 +1,43 @@
+--
+-- Parallel CREATE INDEX on append-optimized tables. The QD has no data, and
+-- builds its indexes serially; the segments build theirs in parallel.
+--
+-- start_matchignore
+-- m/^DEBUG:  (?!building index)/
+-- m/^DEBUG:  building index "pg_aoblkdir_\d+_index"/
+-- end_matchignore
+SET maintenance_work_mem = '128MB';
+SET max_parallel_maintenance_workers = 1;
+SET min_parallel_table_scan_size = 0;
+
+CREATE TABLE par_index_ao (a int, b int) WITH (appendonly=true) DISTRIBUTED BY (a);
+CREATE TABLE par_index_aocs (a int, b int) WITH (appendonly=true, orientation=column) DISTRIBUTED BY (a);
+INSERT INTO par_index_ao SELECT i, i % 1000 FROM generate_series(1, 30000) i;
+INSERT INTO par_index_aocs SELECT i, i % 1000 FROM generate_series(1, 30000) i;
+
+-- The first index also fills in the block directory, which only the leader
+-- can write to. It is built serially.
+SET client_min_messages = debug1;
+CREATE INDEX par_index_ao_a ON par_index_ao (a);
+CREATE INDEX par_index_aocs_a ON par_index_aocs (a);
+RESET client_min_messages;
+
+-- The next ones are built in parallel.
+SET client_min_messages = debug1;
+CREATE INDEX par_index_ao_b ON par_index_ao (b);
+CREATE INDEX par_index_aocs_b ON par_index_aocs (b);
+RESET client_min_messages;
+
+-- The indexes find every row.
+SET enable_seqscan = off;
+SELECT count(*), sum(a) FROM par_index_ao WHERE b = 7;
+SELECT count(*) FROM par_index_ao WHERE a BETWEEN 100 AND 200;
+SELECT count(*), sum(a) FROM par_index_aocs WHERE b = 7;
+SELECT count(*) FROM par_index_aocs WHERE a BETWEEN 100 AND 200;
+RESET enable_seqscan;
+
+DROP TABLE par_index_ao;
+DROP TABLE par_index_aocs;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_maintenance_workers;
+RESET maintenance_work_mem;
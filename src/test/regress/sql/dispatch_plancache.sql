@@ -0,0 +1,46 @@
+--
+-- Test caching of dispatched plans on the segments
+--
+create extension if not exists gp_inject_fault;
+create table dispatch_plancache (a int, b int) distributed by (a);
+insert into dispatch_plancache select i, i from generate_series(1, 100) i;
+set gp_dispatch_cache_plans = on;
+-- The same plan is dispatched repeatedly, and then only its fingerprint.
+prepare dispatch_plancache_q(int) as
+  select count(*), sum(b) from dispatch_plancache where b < $1;
+execute dispatch_plancache_q(10);
+execute dispatch_plancache_q(10);
+execute dispatch_plancache_q(10);
+execute dispatch_plancache_q(20);
+execute dispatch_plancache_q(10);
+-- A multi-slice plan
+prepare dispatch_plancache_join as
+  select count(*) from dispatch_plancache t1 join dispatch_plancache t2 on t1.a = t2.b + 1;
+execute dispatch_plancache_join;
+execute dispatch_plancache_join;
+-- A changed table gets a new plan, which must not be mixed up with the old.
+prepare dispatch_plancache_sum as select sum(b) from dispatch_plancache;
+execute dispatch_plancache_sum;
+-- plan_cached shows whether only the key of the plan was dispatched.
+select bool_or(plan_cached) from gp_stat_dispatch;
+execute dispatch_plancache_sum;
+select bool_and(plan_cached) from gp_stat_dispatch;
+alter table dispatch_plancache drop column b;
+alter table dispatch_plancache add column b int default 7;
+execute dispatch_plancache_sum;
+select bool_or(plan_cached) from gp_stat_dispatch;
+execute dispatch_plancache_sum;
+select bool_and(plan_cached) from gp_stat_dispatch;
+-- If a segment doesn't have a plan that the dispatcher thinks it has, the
+-- segment asks the dispatcher for it, and the query still succeeds.
+prepare dispatch_plancache_cnt as select count(*) from dispatch_plancache;
+select gp_inject_fault('qe_plan_cache_receive', 'skip', 2);
+execute dispatch_plancache_cnt;
+execute dispatch_plancache_cnt;
+select bool_and(plan_cached) from gp_stat_dispatch;
+select gp_inject_fault('qe_plan_cache_receive', 'reset', 2);
+execute dispatch_plancache_cnt;
+select bool_and(plan_cached) from gp_stat_dispatch;
+deallocate all;
+reset gp_dispatch_cache_plans;
+drop table dispatch_plancache;
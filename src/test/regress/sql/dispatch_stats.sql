@@ -0,0 +1,41 @@
+--
+-- Test the dispatch timing statistics
+--
+create table dispatch_stats (a int, b int) distributed by (a);
+insert into dispatch_stats select i, i from generate_series(1, 100) i;
+-- gp_stat_dispatch shows one row for each QE of the last dispatched plan.
+select count(*) from dispatch_stats t1 join dispatch_stats t2 on t1.a = t2.b;
+select count(distinct slice_id) > 0 as has_slices,
+       bool_and(send_time >= 0) as sent,
+       bool_and(finish_latency >= first_result_latency) as finished_after_first
+  from gp_stat_dispatch;
+-- DISPATCH needs ANALYZE
+explain (dispatch) select count(*) from dispatch_stats;
+-- Show the dispatch statistics of EXPLAIN ANALYZE, with the times, byte
+-- counts, wakeups and segment numbers masked. The QE counts are kept.
+create function dispatch_stats_explain() returns setof text language plpgsql as
+$$
+declare
+  ln text;
+  in_stats bool := false;
+begin
+  for ln in explain (analyze, dispatch, costs off, timing off, summary off)
+            select count(*) from dispatch_stats
+  loop
+    if ln like 'Dispatch statistics:%' then
+      in_stats := true;
+    elsif in_stats and ln not like '  %' then
+      in_stats := false;
+    end if;
+    if in_stats then
+      ln := regexp_replace(ln, '[0-9]+\.[0-9]+ ms', 'N ms', 'g');
+      ln := regexp_replace(ln, '[0-9]+ (bytes|wakeups)', 'N \1', 'g');
+      ln := regexp_replace(ln, '\(seg[0-9]+\)', '(segN)', 'g');
+      return next ln;
+    end if;
+  end loop;
+end
+$$;
+select * from dispatch_stats_explain();
+drop function dispatch_stats_explain();
+drop table dispatch_stats;
@@ -0,0 +1,27 @@
+--
+-- Test connecting QEs ahead of the first query, with gp_gang_prewarm_size.
+--
+create extension if not exists gp_inject_fault;
+
+-- Without pre-warming, a query only connects the QEs it needs, one per segment.
+\c -reuse-previous=on "dbname=regression options='-c gp_gang_prewarm_size=0'"
+select gp_segment_id, count(*) from gp_dist_random('pg_stat_activity')
+where sess_id = current_setting('gp_session_id')::int group by 1 order by 1;
+
+-- With pre-warming, the QD starts connecting gp_gang_prewarm_size QEs per
+-- segment before the session is ready for its first query.  The query uses
+-- one of them, and the other one is left idle.
+\c -reuse-previous=on "dbname=regression options='-c gp_gang_prewarm_size=2'"
+-- give the idle QEs time to finish starting up
+select pg_sleep(1);
+select gp_segment_id, count(*) from gp_dist_random('pg_stat_activity')
+where sess_id = current_setting('gp_session_id')::int group by 1 order by 1;
+
+-- A failure to pre-warm is only logged, and doesn't break the session: the
+-- QEs are connected the usual way when the first query needs them.
+select gp_inject_fault('cdbgang_prewarm', 'error', 1);
+\c -reuse-previous=on "dbname=regression options='-c gp_gang_prewarm_size=2'"
+select gp_wait_until_triggered_fault('cdbgang_prewarm', 1, 1);
+select gp_segment_id, count(*) from gp_dist_random('pg_stat_activity')
+where sess_id = current_setting('gp_session_id')::int group by 1 order by 1;
+select gp_inject_fault('cdbgang_prewarm', 'reset', 1);
@@ -140,3 +140,62 @@ HAVING max(c) = '31'
 $$ AS qry \gset
 EXPLAIN (COSTS OFF, VERBOSE) :qry;
 :qry;
+
+--
+-- Test the streaming bottom of a two-stage hash aggregation. The groups of
+-- hashagg_stream are spread across segments, so the partial aggregate gives
+-- up on grouping and passes its input through. The groups of
+-- hashagg_stream_pairs are on one segment each, so the partial aggregate
+-- keeps grouping, and emits its groups whenever it runs out of memory.
+-- Streaming is off by default, turn it on for these tests.
+--
+create table hashagg_stream (a int, b int, c int) distributed by (a);
+insert into hashagg_stream select i, i % 150000, i from generate_series(1, 300000) i;
+create table hashagg_stream_pairs (a int, b int, c int) distributed by (a);
+insert into hashagg_stream_pairs select i % 150000, i % 150000, i from generate_series(1, 300000) i;
+analyze hashagg_stream;
+analyze hashagg_stream_pairs;
+set gp_eager_two_phase_agg = on;
+set enable_sort = off;
+set statement_mem = '1000kB';
+set gp_hashagg_streambottom = on;
+select count(*), sum(cnt), sum(s), sum(av)::bigint from
+  (select b, count(*) cnt, sum(c) s, avg(c) av from hashagg_stream group by b) g;
+select count(*), sum(cnt), sum(s), sum(av)::bigint from
+  (select b, count(*) cnt, sum(c) s, avg(c) av from hashagg_stream_pairs group by b) g;
+-- EXPLAIN ANALYZE reports what the streaming partial aggregate did. All
+-- rows of hashagg_stream_one are on one segment, in insertion order, so that
+-- only one segment reports. Grouping by the distinct column passes most rows
+-- through; grouping by the paired column streams groups in several flushes.
+-- start_matchsubs
+-- m/\(actual rows=\d+ loops=\d+\)/
+-- s/\(actual rows=\d+ loops=\d+\)/(actual rows=### loops=#)/
+-- m/\(seg\d+\)/
+-- s/\(seg\d+\)/(seg#)/
+-- m/Streamed \d+ groups in \d+ flushes/
+-- s/Streamed \d+ groups in \d+ flushes/Streamed ### groups in ### flushes/
+-- m/Passed through \d+ of \d+ input rows/
+-- s/Passed through \d+ of \d+ input rows/Passed through ### of ### input rows/
+-- end_matchsubs
+create table hashagg_stream_one (k int, uniq int, pair int) distributed by (k);
+insert into hashagg_stream_one select 1, i, i / 2 from generate_series(1, 300000) i;
+analyze hashagg_stream_one;
+set optimizer = off;
+explain (analyze, costs off, timing off, summary off)
+select uniq, count(*) from hashagg_stream_one group by uniq;
+explain (analyze, costs off, timing off, summary off)
+select pair, count(*) from hashagg_stream_one group by pair;
+reset optimizer;
+drop table hashagg_stream_one;
+-- The same without streaming
+set gp_hashagg_streambottom = off;
+select count(*), sum(cnt), sum(s), sum(av)::bigint from
+  (select b, count(*) cnt, sum(c) s, avg(c) av from hashagg_stream group by b) g;
+select count(*), sum(cnt), sum(s), sum(av)::bigint from
+  (select b, count(*) cnt, sum(c) s, avg(c) av from hashagg_stream_pairs group by b) g;
+reset gp_hashagg_streambottom;
+reset statement_mem;
+reset enable_sort;
+reset gp_eager_two_phase_agg;
+drop table hashagg_stream;
+drop table hashagg_stream_pairs;
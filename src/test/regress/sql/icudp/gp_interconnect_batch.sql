@@ -0,0 +1,30 @@
+-- 
+-- @description Interconnect test case: data packets are sent and received in batches
+-- @tags executor
+
+-- Create a table with rows that take many packets to redistribute
+CREATE TEMP TABLE batch_table(dkey INT, jkey INT, tval TEXT) DISTRIBUTED BY (dkey);
+INSERT INTO batch_table SELECT i, i % 100, repeat(md5(i::text), 32) FROM generate_series(1, 10000) i;
+
+CREATE TEMP TABLE batch_start AS SELECT now() AS t DISTRIBUTED RANDOMLY;
+SET gp_interconnect_log_stats = on;
+
+-- Redistribute
+CREATE TEMP TABLE batch_copy AS SELECT * FROM batch_table DISTRIBUTED BY (jkey);
+SELECT COUNT(*) AS count, SUM(length(tval)) AS sum_len_tval FROM batch_copy;
+DROP TABLE batch_copy;
+
+-- Send one packet per syscall on seg0, as builds without sendmmsg() do
+SELECT gp_inject_fault('interconnect_send_batch_fallback', 'skip', 2);
+CREATE TEMP TABLE batch_copy AS SELECT * FROM batch_table DISTRIBUTED BY (jkey);
+SELECT gp_wait_until_triggered_fault('interconnect_send_batch_fallback', 1, 2);
+SELECT gp_inject_fault('interconnect_send_batch_fallback', 'reset', 2);
+SELECT COUNT(*) AS count, SUM(length(tval)) AS sum_len_tval FROM batch_copy;
+
+RESET gp_interconnect_log_stats;
+
+-- The segments reported their syscalls per MB at teardown
+SELECT COUNT(*) > 0 AS logged FROM gp_toolkit.__gp_log_segment_ext
+  WHERE logsession = 'con' || current_setting('gp_session_id')
+    AND logtime >= (SELECT t FROM batch_start)
+    AND logmessage LIKE 'Interconnect State:%snd_syscalls_per_mb%recv_syscalls_per_mb%';
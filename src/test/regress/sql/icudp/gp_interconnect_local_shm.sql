@@ -0,0 +1,37 @@
+-- 
+-- @description Interconnect test case: motions between processes on the same host go through shared memory
+-- @tags executor
+
+-- Create a table
+CREATE TEMP TABLE shm_table(dkey INT, jkey INT, tval TEXT default 'abcdefghijklmnopqrstuvwxyz') DISTRIBUTED BY (dkey);
+
+-- Generate some data
+INSERT INTO shm_table SELECT i, i % 100 FROM generate_series(1, 10000) i;
+
+SET gp_interconnect_local_shm = on;
+SHOW gp_interconnect_local_shm;
+
+-- Gather, with a receiver that stops early
+SELECT dkey, jkey FROM shm_table ORDER BY dkey LIMIT 5;
+
+-- Redistribute
+SELECT jkey, COUNT(*) AS count, SUM(length(tval)) AS sum_len_tval
+  FROM shm_table
+  GROUP BY jkey
+  ORDER BY jkey
+  LIMIT 3;
+
+SELECT COUNT(*) AS count, SUM(a.dkey) AS sum_dkey
+  FROM shm_table a JOIN shm_table b ON a.jkey = b.dkey;
+
+SELECT COUNT(*) AS count FROM shm_table WHERE dkey IN (SELECT jkey FROM shm_table);
+
+-- The packets did go through a ring: seg0 publishes to the rings of its
+-- redistribute motion.
+SELECT gp_inject_fault('interconnect_shm_publish', 'skip', 2);
+SELECT COUNT(*) AS count, SUM(a.dkey) AS sum_dkey
+  FROM shm_table a JOIN shm_table b ON a.jkey = b.dkey;
+SELECT gp_wait_until_triggered_fault('interconnect_shm_publish', 1, 2);
+SELECT gp_inject_fault('interconnect_shm_publish', 'reset', 2);
+
+RESET gp_interconnect_local_shm;
@@ -768,3 +768,28 @@ full join ( select r.id1, r.id2 from t_issue_10315 r group by r.id1, r.id2 ) tq_
 on (coalesce(t.id1) = tq_all.id1  and t.id2 = tq_all.id2) ;
 
 drop table t_issue_10315;
+
+-- Probe the hash table with outer tuples fetched ahead in batches, or one at
+-- a time. The results must be the same.
+create table hj_probe_inner (a int, b int) distributed by (a);
+create table hj_probe_outer (a int, b int) distributed by (a);
+insert into hj_probe_inner select i, i % 10 from generate_series(1, 1000) i;
+insert into hj_probe_outer select i % 1500, i from generate_series(1, 3000) i;
+insert into hj_probe_outer values (null, 0);
+analyze hj_probe_inner;
+analyze hj_probe_outer;
+set enable_nestloop = off;
+set enable_mergejoin = off;
+set gp_hashjoin_probe_batch_size = 0;
+select count(*), count(i.a), sum(o.b) from hj_probe_outer o left join hj_probe_inner i on o.a = i.a;
+select count(*) from hj_probe_outer o join hj_probe_inner i on o.b % 10 = i.b;
+set gp_hashjoin_probe_batch_size = 3;
+select count(*), count(i.a), sum(o.b) from hj_probe_outer o left join hj_probe_inner i on o.a = i.a;
+select count(*) from hj_probe_outer o join hj_probe_inner i on o.b % 10 = i.b;
+reset gp_hashjoin_probe_batch_size;
+select count(*), count(i.a), sum(o.b) from hj_probe_outer o left join hj_probe_inner i on o.a = i.a;
+select count(*) from hj_probe_outer o join hj_probe_inner i on o.b % 10 = i.b;
+reset enable_nestloop;
+reset enable_mergejoin;
+drop table hj_probe_inner;
+drop table hj_probe_outer;
@@ -0,0 +1,47 @@
+--
+-- Test compression of wide tuples on the wire.
+--
+-- Tuples are compressed with zstd. If the server is built without it
+-- (configure --without-zstd), the Motions never compress, and
+-- motion_compress_1.out is the expected output.
+--
+
+-- Does EXPLAIN ANALYZE of the query show the Motions compressing their
+-- tuples to less than a quarter of their size?
+create function motion_compressed_well(query text) returns bool
+language plpgsql as
+$$
+declare
+  ln text;
+  m text[];
+  raw_bytes bigint := 0;
+  compressed_bytes bigint := 0;
+begin
+  for ln in execute 'explain (analyze, costs off, timing off, summary off) ' || query
+  loop
+    m := regexp_match(ln, 'Compressed tuples: (\d+) bytes before compression, (\d+) bytes after');
+    if m is not null then
+      raw_bytes := raw_bytes + m[1]::bigint;
+      compressed_bytes := compressed_bytes + m[2]::bigint;
+    end if;
+  end loop;
+  return raw_bytes > 0 and compressed_bytes * 4 < raw_bytes;
+end
+$$;
+
+-- The join redistributes or broadcasts the wide rows, and they must arrive
+-- intact.
+set gp_motion_compress_min_width = 100;
+create table motion_compress (id int, t text) distributed by (id);
+insert into motion_compress select i, repeat(md5(i::text), 32) from generate_series(1, 20000) i;
+analyze motion_compress;
+select count(*), sum(length(b.t)), bool_and(b.t = repeat(md5(b.id::text), 32))
+from motion_compress a join motion_compress b on a.t = b.t;
+select motion_compressed_well('select count(*) from motion_compress a join motion_compress b on a.t = b.t');
+
+-- Compression is off by default
+reset gp_motion_compress_min_width;
+select motion_compressed_well('select count(*) from motion_compress a join motion_compress b on a.t = b.t');
+
+drop table motion_compress;
+drop function motion_compressed_well(text);
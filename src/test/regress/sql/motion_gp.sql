@@ -98,3 +98,58 @@ $$) order by id;
 CREATE TABLE motion_noatts ();
 INSERT INTO motion_noatts SELECT;
 SELECT * FROM motion_noatts;
+
+-- Test column-wise batching of narrow tuples, with NULLs in fixed-width and
+-- varlena columns. Batches are redistributed by the join and aggregation,
+-- and merged in order by the ORDER BY.
+set gp_motion_batch_size = 64;
+create table motion_batch (id int, b bigint, t text, n numeric) distributed by (id);
+insert into motion_batch
+  select i, i * 2,
+         case when i % 7 = 0 then null else i::text end,
+         case when i % 5 = 0 then null else i * 0.5 end
+  from generate_series(1, 10000) i;
+analyze motion_batch;
+select count(*), count(a.t), sum(a.b), sum(a.n)
+from motion_batch a join motion_batch b on a.t = b.t;
+select count(*) from (select t, count(*) from motion_batch group by t) s;
+select id, b, t, n from motion_batch order by id limit 5 offset 95;
+reset gp_motion_batch_size;
+
+-- Test splitting heavy hitters of a skewed join key. The rows of the larger
+-- side with a hot key are spread across the segments, and the matching rows
+-- of the other side are broadcast, so the join must still find all matches.
+-- The tables are sized so that the inner join redistributes both sides rather
+-- than broadcasting one; the plan shows how each motion routes the hot key.
+set gp_motion_skew_factor = 1;
+create table motion_skew_large (id int, k int) distributed by (id);
+create table motion_skew_small (id int, k int) distributed by (id);
+insert into motion_skew_large select i, case when i % 2 = 0 then 1 else i end from generate_series(1, 20000) i;
+insert into motion_skew_small select i, i from generate_series(1, 15000) i;
+analyze motion_skew_large;
+analyze motion_skew_small;
+set optimizer = off;
+explain (costs off)
+select count(*), sum(s.k) from motion_skew_large l join motion_skew_small s on l.k = s.k;
+reset optimizer;
+select count(*), sum(s.k) from motion_skew_large l join motion_skew_small s on l.k = s.k;
+select count(*), count(s.k) from motion_skew_large l left join motion_skew_small s on l.k = s.k;
+select count(*) from motion_skew_small s where exists (select 1 from motion_skew_large l where l.k = s.k);
+reset gp_motion_skew_factor;
+
+-- Test merging sorted streams with abbreviated keys. The receiver only uses
+-- them with many senders, so lower the threshold. Half of the keys share a
+-- prefix longer than the abbreviated key, so ties between abbreviated keys
+-- must be broken by the full comparison. The keys that all share it make the
+-- receiver give up on abbreviation part way through.
+set gp_motion_merge_abbrev_min_senders = 1;
+create table motion_merge_abbrev (id int, t text) distributed by (id);
+insert into motion_merge_abbrev
+  select i, case when i % 2 = 0 then 'shared prefix ' || (i % 500) else (i % 500)::text end
+  from generate_series(1, 1000) i;
+select t from motion_merge_abbrev order by t collate "C" limit 8 offset 496;
+select (select array_agg(t) from (select t from motion_merge_abbrev order by t collate "C") s) =
+       (select array_agg(t order by t collate "C") from motion_merge_abbrev) as merged_in_order;
+select (select array_agg(t) from (select t from motion_merge_abbrev where t like 'shared%' order by t collate "C") s) =
+       (select array_agg(t order by t collate "C") from motion_merge_abbrev where t like 'shared%') as merged_in_order;
+reset gp_motion_merge_abbrev_min_senders;
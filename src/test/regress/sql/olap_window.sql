@@ -1628,3 +1628,44 @@ explain (costs off)
 select unnest(array[a,a]), rank() over (order by a) from generate_series(2,3) a;
 
 select unnest(array[a,a]), rank() over (order by a) from generate_series(2,3) a;
+
+-- Aggregates without an inverse transition function over frames with a
+-- moving start are evaluated over a segment tree of transition states.
+select i, v,
+       max(v) over (order by i rows between 2 preceding and current row),
+       min(v) over (order by i rows between 1 following and 2 following)
+from (select i, case when i = 3 then null else (i * 37) % 10 end as v
+      from generate_series(1, 8) i) s
+order by i;
+
+create table win_segtree (g int, o int, v int, t text, f float8) distributed by (g);
+insert into win_segtree
+  select i % 3, i, case when i % 17 = 0 then null else (i * 7919) % 1000 end,
+         'x' || ((i * 31) % 997), ((i * 7919) % 1000) / 7.0::float8
+  from generate_series(1, 5000) i;
+
+-- Floating-point sums and averages are not evaluated over the tree, as
+-- combining them in a different order would change the low-order digits.
+create temp view win_segtree_v as
+  select g, o,
+         max(v) over (partition by g order by o rows between 100 preceding and current row) as rmax,
+         min(t) over (partition by g order by o rows between 100 preceding and current row) as rmin,
+         max(v) over (partition by g order by o range between 50 preceding and 10 following) as gmax,
+         min(v) over (partition by g order by o rows between 5 following and 20 following) as fmin,
+         max(v) over (partition by g order by o groups between 2000 preceding and 1 preceding) as lmax,
+         sum(f) over (partition by g order by o rows between 100 preceding and current row) as fsum,
+         avg(f) over (partition by g order by o range between 50 preceding and 10 following) as favg
+  from win_segtree;
+
+create temp table win_segtree_on as select * from win_segtree_v distributed by (g);
+set gp_enable_window_segment_tree = off;
+create temp table win_segtree_off as select * from win_segtree_v distributed by (g);
+reset gp_enable_window_segment_tree;
+
+select count(*) from win_segtree_on;
+(select * from win_segtree_on except select * from win_segtree_off)
+union all
+(select * from win_segtree_off except select * from win_segtree_on);
+
+drop view win_segtree_v;
+drop table win_segtree_on, win_segtree_off, win_segtree;
@@ -447,3 +447,46 @@ ANALYZE prt2;
 
 EXPLAIN (COSTS OFF)
 SELECT t1.a, t1.c, t2.b, t2.c FROM prt1 t1, prt2 t2 WHERE t1.a = t2.b AND t1.b = 0 ORDER BY t1.a, t2.b;
+
+--
+-- GPDB: gp_enable_colocated_partitionwise joins and aggregates partitions
+-- pairwise, but only when the tables are co-located so that no Motions are
+-- needed.
+--
+RESET enable_partitionwise_join;
+RESET enable_nestloop;
+RESET enable_mergejoin;
+SET gp_enable_colocated_partitionwise TO on;
+CREATE TABLE orders_pw (o_id int, o_day int, amount int)
+DISTRIBUTED BY (o_id) PARTITION BY RANGE (o_day) (START (0) END (4) EVERY (1));
+CREATE TABLE items_pw (o_id int, o_day int, qty int)
+DISTRIBUTED BY (o_id) PARTITION BY RANGE (o_day) (START (0) END (4) EVERY (1));
+INSERT INTO orders_pw SELECT i, i % 4, i FROM generate_series(1, 1000) i;
+INSERT INTO items_pw SELECT i, i % 4, q FROM generate_series(1, 1000) i, generate_series(1, 2) q;
+ANALYZE orders_pw;
+ANALYZE items_pw;
+
+-- each pair of partitions is joined in place, without Motions
+EXPLAIN (COSTS OFF)
+SELECT count(*), sum(o.amount * i.qty)
+FROM orders_pw o JOIN items_pw i ON o.o_id = i.o_id AND o.o_day = i.o_day;
+SELECT count(*), sum(o.amount * i.qty)
+FROM orders_pw o JOIN items_pw i ON o.o_id = i.o_id AND o.o_day = i.o_day;
+SELECT count(*), sum(o.amount * i.qty)
+FROM orders_pw o JOIN items_pw i ON o.o_id = i.o_id AND o.o_day = i.o_day
+WHERE o.o_day = 1;
+SELECT count(*)
+FROM orders_pw o LEFT JOIN items_pw i ON o.o_id = i.o_id AND o.o_day = i.o_day AND i.qty = 1;
+-- grouped on the partition and distribution keys, so each partition is
+-- aggregated in place
+EXPLAIN (COSTS OFF)
+SELECT o_id, o_day, count(*) FROM items_pw GROUP BY o_id, o_day;
+SELECT o_id, o_day, count(*) FROM items_pw GROUP BY o_id, o_day ORDER BY o_id LIMIT 3;
+-- not grouped on the distribution key, so not partitionwise
+EXPLAIN (COSTS OFF)
+SELECT o_day, count(*) FROM items_pw GROUP BY o_day;
+SELECT o_day, count(*) FROM items_pw GROUP BY o_day ORDER BY o_day;
+
+DROP TABLE orders_pw;
+DROP TABLE items_pw;
+RESET gp_enable_colocated_partitionwise;
@@ -450,3 +450,77 @@ SELECT 1 FROM tenk1_vw_sec
 
 rollback;
 
+
+-- Parallel scans, joins and partial aggregates within each segment
+set optimizer = off;
+set gp_enable_intra_segment_parallel = on;
+set parallel_setup_cost=0;
+set parallel_tuple_cost=0;
+set min_parallel_table_scan_size=0;
+set max_parallel_workers_per_gather=2;
+explain (costs off)
+  select count(*) from tenk1;
+select count(*) from tenk1;
+explain (costs off)
+  select count(*) from tenk1 t1 join tenk2 t2 on t1.unique1 = t2.unique1;
+select count(*) from tenk1 t1 join tenk2 t2 on t1.unique1 = t2.unique1;
+explain (costs off)
+  select four, count(*), sum(unique1) from tenk1 group by four order by four;
+select four, count(*), sum(unique1) from tenk1 group by four order by four;
+
+-- The workers are launched by the QEs, and EXPLAIN ANALYZE shows how many.
+create function explain_gather_workers(query text) returns setof text
+language plpgsql as
+$$
+declare ln text;
+begin
+    for ln in
+        execute 'explain (analyze, costs off, timing off, summary off) ' || query
+    loop
+        if ln ~ 'Workers' then
+            return next trim(ln);
+        end if;
+    end loop;
+end;
+$$;
+select * from explain_gather_workers('select count(*) from tenk1');
+
+-- AO and AOCS tables are scanned in parallel a segment file at a time
+create table par_ao (a int, b int) with (appendonly=true) distributed by (a);
+create table par_aocs (a int, b int) with (appendonly=true, orientation=column) distributed by (a);
+insert into par_ao select i, i % 10 from generate_series(1, 100000) i;
+insert into par_aocs select * from par_ao;
+analyze par_ao;
+analyze par_aocs;
+explain (costs off)
+  select count(*), sum(b) from par_ao;
+select count(*), sum(b) from par_ao;
+explain (costs off)
+  select count(*), sum(b) from par_aocs;
+select count(*), sum(b) from par_aocs;
+select * from explain_gather_workers('select count(*) from par_aocs');
+
+-- A reader QE sees the changes of its writer QE's transaction, but its
+-- workers would not, so it runs without workers once the writer has a
+-- transaction ID.  The join redistributes t2, so that it is scanned in a
+-- reader QE.
+create table par_heap (a int, b int) distributed by (a);
+insert into par_heap select i, i from generate_series(1, 100000) i;
+analyze par_heap;
+explain (costs off)
+  select count(*) from par_heap t1 join par_heap t2 on t1.a = t2.b;
+begin;
+insert into par_heap select i, i from generate_series(100001, 101000) i;
+select count(*) from par_heap t1 join par_heap t2 on t1.a = t2.b;
+select * from explain_gather_workers(
+  'select count(*) from par_heap t1 join par_heap t2 on t1.a = t2.b') order by 1;
+rollback;
+
+drop function explain_gather_workers(text);
+drop table par_ao, par_aocs, par_heap;
+reset optimizer;
+reset gp_enable_intra_segment_parallel;
+reset parallel_setup_cost;
+reset parallel_tuple_cost;
+reset min_parallel_table_scan_size;
+reset max_parallel_workers_per_gather;
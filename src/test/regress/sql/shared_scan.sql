@@ -34,3 +34,45 @@ SELECT *,
         SELECT 1 FROM cte c1, cte c2
         )
         FROM bar;
+
+-- Cross-slice shares pass small results in shared memory, and larger ones
+-- in a file. Check that both, and falling back from one to the other in
+-- the middle of the result, give the same answer.
+RESET statement_timeout;
+SET gp_cte_sharing = on;
+CREATE TABLE sisc_mem (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO sisc_mem SELECT i, i % 100 FROM generate_series(1, 20000) i;
+ANALYZE sisc_mem;
+
+-- EXPLAIN ANALYZE reports where the producer left the result.
+CREATE FUNCTION sisc_result_location() RETURNS SETOF text LANGUAGE plpgsql AS
+$$
+DECLARE
+  ln text;
+BEGIN
+  FOR ln IN EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF)
+            WITH cte AS (SELECT * FROM sisc_mem)
+            SELECT count(*), sum(c1.a) FROM cte c1 JOIN cte c2 ON c1.b = c2.a
+  LOOP
+    ln := substring(ln FROM 'Passed .* to consumers .*');
+    IF ln IS NOT NULL THEN
+      RETURN NEXT regexp_replace(ln, '[0-9]+ bytes', 'N bytes');
+    END IF;
+  END LOOP;
+END
+$$;
+
+WITH cte AS (SELECT * FROM sisc_mem)
+SELECT count(*), sum(c1.a) FROM cte c1 JOIN cte c2 ON c1.b = c2.a;
+SELECT DISTINCT * FROM sisc_result_location();
+SET gp_shareinput_inmem_size = 64;
+WITH cte AS (SELECT * FROM sisc_mem)
+SELECT count(*), sum(c1.a) FROM cte c1 JOIN cte c2 ON c1.b = c2.a;
+SELECT DISTINCT * FROM sisc_result_location();
+SET gp_shareinput_inmem_size = 0;
+WITH cte AS (SELECT * FROM sisc_mem)
+SELECT count(*), sum(c1.a) FROM cte c1 JOIN cte c2 ON c1.b = c2.a;
+SELECT DISTINCT * FROM sisc_result_location();
+RESET gp_shareinput_inmem_size;
+DROP FUNCTION sisc_result_location();
+RESET gp_cte_sharing;
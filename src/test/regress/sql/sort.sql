@@ -130,3 +130,38 @@ with t as (
 select count(*) from t;
 
 reset enable_hashjoin;
+
+--
+-- Radix sort of integer and abbreviated keys must produce the same order as
+-- the comparison sort, including NULLs, DESC and NULLS FIRST.
+--
+create table radixsort (i int4, b int8, t text) distributed randomly;
+insert into radixsort
+  select case when g % 97 = 0 then null else (g * 7919) % 5003 - 2500 end,
+         case when g % 89 = 0 then null else (g::int8 * 104729) % 1000003 - 500000 end,
+         'k' || ((g * 31) % 7001)
+  from generate_series(1, 20000) g;
+create table radixsort_result (radix bool, i_asc text, i_desc text, b_nf text, t_asc text, ib text) distributed randomly;
+
+set gp_enable_radix_sort = on;
+insert into radixsort_result select true,
+  md5(string_agg(coalesce(i::text, 'N'), ',' order by i)),
+  md5(string_agg(coalesce(i::text, 'N'), ',' order by i desc)),
+  md5(string_agg(coalesce(b::text, 'N'), ',' order by b nulls first)),
+  md5(string_agg(t, ',' order by t collate "C")),
+  md5(string_agg(coalesce(i::text, 'N') || ':' || coalesce(b::text, 'N'), ',' order by i desc nulls last, b))
+from radixsort;
+set gp_enable_radix_sort = off;
+insert into radixsort_result select false,
+  md5(string_agg(coalesce(i::text, 'N'), ',' order by i)),
+  md5(string_agg(coalesce(i::text, 'N'), ',' order by i desc)),
+  md5(string_agg(coalesce(b::text, 'N'), ',' order by b nulls first)),
+  md5(string_agg(t, ',' order by t collate "C")),
+  md5(string_agg(coalesce(i::text, 'N') || ':' || coalesce(b::text, 'N'), ',' order by i desc nulls last, b))
+from radixsort;
+reset gp_enable_radix_sort;
+
+select count(distinct i_asc) as i_asc, count(distinct i_desc) as i_desc,
+       count(distinct b_nf) as b_nf, count(distinct t_asc) as t_asc,
+       count(distinct ib) as ib
+from radixsort_result;
@@ -0,0 +1,64 @@
+--
+-- Test batch-at-a-time execution of plain aggregates
+--
+create table vec_agg (a int4, b int8, c float8, d date, t text)
+  with (appendonly=true, orientation=column) distributed by (a);
+insert into vec_agg
+  select i, i * 10, i * 0.25, date '2020-01-01' + i % 100,
+         case when i % 7 = 0 then null else 'x' end
+  from generate_series(1, 10000) i;
+insert into vec_agg values (null, null, null, null, null);
+analyze vec_agg;
+
+create function vec_agg_vectorized(query text) returns boolean language plpgsql as
+$$
+declare
+  ln text;
+begin
+  for ln in execute 'explain (costs off) ' || query
+  loop
+    if ln like '%Vectorized: true%' then
+      return true;
+    end if;
+  end loop;
+  return false;
+end
+$$;
+
+set gp_enable_vectorized_agg = on;
+
+-- Only simple quals and aggregates are vectorized
+select vec_agg_vectorized('select count(*), sum(a) from vec_agg where b > 10');
+select vec_agg_vectorized('select sum(b) from vec_agg');
+select vec_agg_vectorized('select count(*) from vec_agg where t = ''x''');
+select vec_agg_vectorized('select count(*) from vec_agg group by a');
+
+-- The results must be the same with and without it
+select count(*), count(a), count(t), sum(a), sum(c) from vec_agg;
+select avg(a), avg(c), min(b), max(b), min(c), max(c), max(d) - min(d) as days from vec_agg;
+select count(*), sum(a), sum(c * 4::float8), min(a), max(b) from vec_agg
+  where a > 5000 and b <= 90000 and t is not null;
+select count(*), sum(a), min(c), avg(a) from vec_agg where a < 0;
+select count(*), count(b) from vec_agg where a is null;
+select count(*) from vec_agg where b > 50000 and a <= 7000;
+select count(*) from vec_agg where d >= date '2020-04-01';
+select count(*) from vec_agg where c < 10::float8;
+select count(*) from vec_agg where a * 10 = b;
+
+set gp_enable_vectorized_agg = off;
+
+select vec_agg_vectorized('select count(*), sum(a) from vec_agg where b > 10');
+select count(*), count(a), count(t), sum(a), sum(c) from vec_agg;
+select avg(a), avg(c), min(b), max(b), min(c), max(c), max(d) - min(d) as days from vec_agg;
+select count(*), sum(a), sum(c * 4::float8), min(a), max(b) from vec_agg
+  where a > 5000 and b <= 90000 and t is not null;
+select count(*), sum(a), min(c), avg(a) from vec_agg where a < 0;
+select count(*), count(b) from vec_agg where a is null;
+select count(*) from vec_agg where b > 50000 and a <= 7000;
+select count(*) from vec_agg where d >= date '2020-04-01';
+select count(*) from vec_agg where c < 10::float8;
+select count(*) from vec_agg where a * 10 = b;
+
+reset gp_enable_vectorized_agg;
+drop function vec_agg_vectorized(text);
+drop table vec_agg;
@@ -53,6 +53,28 @@ select avg(i3) from (SELECT t1.* FROM test_hj_spill AS t1 RIGHT JOIN test_hj_spi
 select * from hashjoin_spill.is_workfile_created('explain (analyze, verbose) SELECT t1.* FROM test_hj_spill AS t1 RIGHT JOIN test_hj_spill AS t2 ON t1.i1=t2.i2');
 select * from hashjoin_spill.is_workfile_created('explain (analyze, verbose) SELECT t1.* FROM test_hj_spill AS t1 RIGHT JOIN test_hj_spill AS t2 ON t1.i1=t2.i2 LIMIT 15000;');
 
+-- The workfile I/O of the spilling join is reported by EXPLAIN ANALYZE, and
+-- the result doesn't depend on the I/O buffer size of the batch files.
+create or replace function hashjoin_spill.workfile_io_reported(explain_query text)
+returns bool as
+$$
+import re
+rv = plpy.execute(explain_query)
+p = re.compile('.*Workfile I/O: written (\d+)kB.*, read (\d+)kB')
+for i in range(len(rv)):
+    m = p.match(rv[i]['QUERY PLAN'])
+    if m and int(m.group(1)) > 0 and int(m.group(2)) > 0:
+        return True
+return False
+$$
+language plpython3u;
+select hashjoin_spill.workfile_io_reported('explain (analyze, verbose) SELECT t1.* FROM test_hj_spill AS t1 RIGHT JOIN test_hj_spill AS t2 ON t1.i1=t2.i2');
+set gp_workfile_buffer_size = '32kB';
+select avg(i3) from (SELECT t1.* FROM test_hj_spill AS t1 RIGHT JOIN test_hj_spill AS t2 ON t1.i1=t2.i2) foo;
+set gp_workfile_buffer_size = '1MB';
+select avg(i3) from (SELECT t1.* FROM test_hj_spill AS t1 RIGHT JOIN test_hj_spill AS t2 ON t1.i1=t2.i2) foo;
+reset gp_workfile_buffer_size;
+
 -- Test with a larger data set, so that all the operations don't fit in a
 -- single compression buffer.
 set gp_workfile_compression = on;
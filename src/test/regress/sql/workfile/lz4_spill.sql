@@ -0,0 +1,50 @@
+-- Test LZ4 compression of temporary files.
+--
+-- This needs a server built with LZ4 support (configure --with-lz4).
+-- Without it, gp_workfile_compression cannot be set to lz4, and the output
+-- matches lz4_spill_1.out instead.
+create schema lz4_spill;
+set search_path to lz4_spill;
+
+-- start_ignore
+create language plpython3u;
+-- end_ignore
+
+-- Kilobytes of workfiles written by a query, as reported by EXPLAIN ANALYZE.
+create or replace function lz4_spill.workfile_kb_written(explain_query text)
+returns int as
+$$
+import re
+rv = plpy.execute(explain_query)
+p = re.compile('.*Workfile I/O: written (\d+)kB')
+written = 0
+for i in range(len(rv)):
+    m = p.match(rv[i]['QUERY PLAN'])
+    if m:
+        written += int(m.group(1))
+return written
+$$
+language plpython3u;
+
+create table test_lz4_spill (i1 int, i2 int, i3 int, i4 int) distributed by (i1);
+insert into test_lz4_spill select i, i, i % 1000, i from generate_series(1, 45000) i;
+set statement_mem = 1024;
+
+set gp_workfile_compression = lz4;
+show gp_workfile_compression;
+select avg(i3) from (select t1.* from test_lz4_spill t1 right join test_lz4_spill t2 on t1.i1 = t2.i2) foo;
+
+-- The batch files are compressed, so less is written than without compression.
+select lz4_spill.workfile_kb_written('explain (analyze, verbose) select t1.* from test_lz4_spill t1 right join test_lz4_spill t2 on t1.i1 = t2.i2') as lz4_kb \gset
+set gp_workfile_compression = off;
+select lz4_spill.workfile_kb_written('explain (analyze, verbose) select t1.* from test_lz4_spill t1 right join test_lz4_spill t2 on t1.i1 = t2.i2') > :lz4_kb as compressed;
+
+-- The inner side is underestimated, so the number of batches grows at
+-- runtime, and the batch files written so far get smaller buffers.
+set gp_workfile_compression = lz4;
+set gp_workfile_buffer_size = '1MB';
+select count(1) from generate_series(1, 1000000) t1 left join generate_series(1, 50000) t2 on t1 = t2;
+reset gp_workfile_buffer_size;
+reset gp_workfile_compression;
+
+drop schema lz4_spill cascade;